@@ -43,6 +43,7 @@
 #include "qblist.h"
 #include "qbs.h"
 #include "rounding.h"
+#include "screenimage.h"
 #include "shell.h"
 #include "thread.h"
 
@@ -873,6 +874,7 @@ int32 width_lprint = 80;
 // forward refs
 int32 autodisplay = 1;
 void key_update();
+void text_glyph_atlas_invalidate();
 int32 key_display_state = 0;
 int32 key_display = 0;
 int32 key_display_redraw = 0;
@@ -4041,6 +4043,40 @@ int32 imgnew(int32 x, int32 y, int32 bpp) {
     return i;
 }
 
+// reserves an image handle for an image that is still being created (eg. by an asynchronous _LOADIMAGE)
+// the handle stays invalid until image_new_from_buffer() fills it or image_release_handle() returns it
+int32 image_reserve_handle() {
+    auto i = newimg();
+    img[i].valid = 0;
+    return -i;
+}
+
+void image_release_handle(int32 handle) {
+    auto i = -handle;
+    img[i].valid = 1;
+    freeimg(i);
+}
+
+// creates an image that takes ownership of a malloc()'d pixel buffer (no copy is made)
+// if handle is a reserved handle, the image is created there, else a new handle is allocated
+// returns -1 on failure (the buffer is not freed)
+int32 image_new_from_buffer(void *buffer, int32 x, int32 y, int32 bpp, int32 handle) {
+    if (bpp == 32 && !cblend)
+        init_blend();
+    auto i = imgframe((uint8 *)buffer, x, y, bpp);
+    if (!i)
+        return -1;
+    img[i].flags |= IMG_FREEMEM;
+    if (handle) {
+        // nothing references the new image yet, so it can simply be moved to the reserved slot
+        auto i2 = -handle;
+        img[i2] = img[i];
+        freeimg(i);
+        i = i2;
+    }
+    return -i;
+}
+
 void sub__font(int32 f, int32 i, int32 passed); // forward def
 
 void flush_old_hardware_commands() {
@@ -5206,6 +5242,16 @@ put_8_32_stretch:
     // plot rect
     yy = h;
     fy = fsy1;
+    if (!mirror && mx == 1.0 && fsx1 == std::floor(fsx1)) {
+        // unscaled rows map to contiguous source pixels, so they can be expanded in one go
+        x = qbr_double_to_long(fsx1);
+        do {
+            image_expand_palette(s->offset + sw * qbr_double_to_long(fy) + x, doff32, w, pal);
+            doff32 += w + dskip;
+            fy += my;
+        } while (--yy);
+        return;
+    }
     fsx1 -= mx; // prev value is moved on from
     doff32 -= xdir;
     do {
@@ -5522,15 +5568,12 @@ put_8_32:
         soff = s->offset + (sy1 * sw + sx1);
         sskip = sw - w;
     }
-    // plot rect
+    // plot rect (each row is expanded in one go)
     h = dy2 - dy1 + 1;
     do {
-        xx = w;
-        do {
-            *doff32++ = pal[*soff++];
-        } while (--xx);
-        soff += sskip;
-        doff32 += dskip;
+        image_expand_palette(soff, doff32, w, pal);
+        soff += w + sskip;
+        doff32 += w + dskip;
     } while (--h);
     return;
 
@@ -19052,12 +19095,27 @@ int32 func__copyimage(int32 i, int32 mode, int32 passed) {
 
     if (passed & 1) {
         if (mode != s->compatible_mode) {
-            if (mode != 33 || s->compatible_mode != 32) {
+            if (mode != 33 || s->text || (s->compatible_mode != 32 && s->bytes_per_pixel != 1)) {
                 error(5);
                 return -1;
             }
-            // create new buffered hardware image
-            i2 = new_hardware_img(s->width, s->height, (uint32 *)s->offset32, NEW_HARDWARE_IMG__BUFFER_CONTENT | NEW_HARDWARE_IMG__DUPLICATE_PROVIDED_BUFFER);
+            if (s->compatible_mode == 32) {
+                // create new buffered hardware image
+                i2 = new_hardware_img(s->width, s->height, (uint32 *)s->offset32, NEW_HARDWARE_IMG__BUFFER_CONTENT | NEW_HARDWARE_IMG__DUPLICATE_PROVIDED_BUFFER);
+            } else {
+                // palette based image; expand it to 32bpp and let the hardware image take ownership of the buffer
+                auto pixels = (uint32 *)malloc(s->width * s->height * sizeof(uint32));
+                if (!pixels)
+                    return -1;
+                image_expand_palette(s->offset, pixels, s->width * s->height, s->pal);
+                if (s->transparent_color != -1) {
+                    for (i = 0; i < s->width * s->height; i++) {
+                        if (s->offset[i] == s->transparent_color)
+                            pixels[i] &= 0x00FFFFFF;
+                    }
+                }
+                i2 = new_hardware_img(s->width, s->height, pixels, NEW_HARDWARE_IMG__BUFFER_CONTENT);
+            }
             return i2 + HARDWARE_IMG_HANDLE_OFFSET;
         }
     }
@@ -19140,6 +19198,10 @@ void sub__freeimage(int32 i, int32 passed) {
                 return;
             }
             if (!img[i].valid) {
+#ifdef DEPENDENCY_IMAGE_CODEC
+                if (image_async_cancel(-i))
+                    return; // the image was still loading
+#endif
                 error(258);
                 return;
             }
@@ -19159,6 +19221,9 @@ void sub__freeimage(int32 i, int32 passed) {
         free(img[i].offset); // free pixel data (potential crash here)
     if (img[i].flags & IMG_FREEPAL)
         free(img[i].pal); // free palette
+#ifdef DEPENDENCY_IMAGE_CODEC
+    image_vector_release(-i); // forget the SVG document the image was loaded from
+#endif
     freeimg(i);
 }
 
@@ -20205,22 +20270,6 @@ int32_t func__loadfont(const qbs *qbsFileName, int32_t size, const qbs *qbsRequi
         font_index = 0;
     }
 
-    uint8_t *content;
-    int32_t bytes;
-
-    if (isLoadFromMemory) {
-        content = qbsFileName->chr; // we should not free this!!!
-        bytes = qbsFileName->len;
-        image_log_trace("Loading font from memory. Size = %i", bytes);
-    } else {
-        std::string fileName(reinterpret_cast<char *>(qbsFileName->chr), qbsFileName->len);
-        content = FontLoadFileToMemory(filepath_fix_directory(fileName), &bytes); // this we must free!!!
-        image_log_trace("Loading font from file %s", fileName.c_str());
-    }
-
-    if (!content)
-        return INVALID_FONT_HANDLE; // Return invalid handle if loading the image failed
-
     // open the font
     // get free font handle
     int32_t i;
@@ -20240,10 +20289,17 @@ int32_t func__loadfont(const qbs *qbsFileName, int32_t size, const qbs *qbsRequi
     i = lastfont;
 
 got_font_index:
-    auto h = FontLoad(content, bytes, size, font_index, options);
+    int32_t h;
 
-    if (!isLoadFromMemory)
-        free(content); // free font memory if it was loaded from a file
+    if (isLoadFromMemory) {
+        image_log_trace("Loading font from memory. Size = %i", qbsFileName->len);
+        h = FontLoad(qbsFileName->chr, qbsFileName->len, size, font_index, options);
+    } else {
+        // Fonts that are already loaded from the same file share the file contents, so the file is only read once
+        std::string fileName(reinterpret_cast<char *>(qbsFileName->chr), qbsFileName->len);
+        image_log_trace("Loading font from file %s", fileName.c_str());
+        h = FontLoadFile(filepath_fix_directory(fileName), size, font_index, options);
+    }
 
     if (!h)
         return INVALID_FONT_HANDLE;
@@ -20310,10 +20366,12 @@ void sub__font(int32 f, int32 i, int32 passed) {
         if (im->flags & IMG_SCREEN) {
             // lock display
             if (autodisplay) {
-                if (lock_display == 0)
-                    lock_display = 1; // request lock
-                while (lock_display != 2)
-                    Sleep(0);
+                if (lock_display_required) {
+                    if (lock_display == 0)
+                        lock_display = 1; // request lock
+                    while (lock_display != 2)
+                        Sleep(0);
+                }
             }
             // force update of data
             screen_last_valid = 0; // ignore cache used to update the screen on next update
@@ -20452,6 +20510,7 @@ void sub__freefont(int32 f) {
     // remove font
     FontFree(font[f]);
     font[f] = NULL;
+    text_glyph_atlas_invalidate();
 }
 
 void sub__printmode(int32 mode, int32 i, int32 passed) {
@@ -20513,50 +20572,26 @@ int32 func__printmode(int32 i, int32 passed) {
     return img[i].print_mode;
 }
 
+/// @brief Returns the closest color index of a palette based image using the Manhattan distance (ties resolve to the lowest index)
+/// @param r The red color component
+/// @param g The green color component
+/// @param b The blue color component
+/// @param im The palette based image
+/// @return The palette index
+static uint32 matchcol(int32 r, int32 g, int32 b, const img_struct *im) {
+    static ImagePaletteLookupCache lookupCache(image_get_rgb_manhattan_dist);
+
+    lookupCache.Validate(im->pal, im->text ? 16 : im->mask + 1);
+
+    return lookupCache.FindClosest(r, g, b);
+}
+
 uint32 matchcol(int32 r, int32 g, int32 b) {
-    static int32 v, v2, n, n2, best, c;
-    static int32 *p;
-    p = (int32 *)write_page->pal;
-    if (write_page->text)
-        n2 = 16;
-    else
-        n2 = write_page->mask + 1;
-    v = 1000;
-    best = 0;
-    for (n = 0; n < n2; n++) {
-        c = *p++;
-        v2 = abs(b - (c & 0xFF)) + abs(g - (c >> 8 & 0xFF)) + abs(r - (c >> 16 & 0xFF));
-        if (v2 < v) {
-            if (!v2)
-                return n; // perfect match
-            v = v2;
-            best = n;
-        }
-    } // n
-    return best;
+    return matchcol(r, g, b, write_page);
 }
 
 uint32 matchcol(int32 r, int32 g, int32 b, int32 i) {
-    static int32 v, v2, n, n2, best, c;
-    static int32 *p;
-    p = (int32 *)img[i].pal;
-    if (img[i].text)
-        n2 = 16;
-    else
-        n2 = img[i].mask + 1;
-    v = 1000;
-    best = 0;
-    for (n = 0; n < n2; n++) {
-        c = *p++;
-        v2 = abs(b - (c & 0xFF)) + abs(g - (c >> 8 & 0xFF)) + abs(r - (c >> 16 & 0xFF));
-        if (v2 < v) {
-            if (!v2)
-                return n; // perfect match
-            v = v2;
-            best = n;
-        }
-    } // n
-    return best;
+    return matchcol(r, g, b, &img[i]);
 }
 
 uint32 func__rgb(int32 r, int32 g, int32 b, int32 i, int32 passed) {
@@ -24119,6 +24154,39 @@ int32 func__screenimage(int32 x1, int32 y1, int32 x2, int32 y2, int32 passed) {
     sub__dest(i2);
 
     ReleaseDC(NULL, hdc);
+    return i;
+#    elif defined(QB64_LINUX)
+
+    int32_t x, y, w, h;
+
+    // No X server, nothing to capture
+    if (!screenimage_get_desktop_size(&x, &y))
+        return func__newimage(func__desktopwidth(), func__desktopheight(), 32, 1);
+
+    if (passed) {
+        if (x1 < 0)
+            x1 = 0;
+        if (y1 < 0)
+            y1 = 0;
+        if (x2 > x - 1)
+            x2 = x - 1;
+        if (y2 > y - 1)
+            y2 = y - 1;
+        w = x2 - x1 + 1;
+        h = y2 - y1 + 1;
+    } else {
+        x1 = 0;
+        y1 = 0;
+        w = x;
+        h = y;
+    }
+
+    auto i = func__newimage(w, h, 32, 1);
+    if (i < -1) {
+        // The image is left blank if the capture fails
+        screenimage_capture(x1, y1, w, h, img[-i].offset32);
+    }
+
     return i;
 #    else
     return func__newimage(func__desktopwidth(), func__desktopheight(), 32, 1);
@@ -25992,6 +26060,10 @@ void sub__console(int32 onoff) { // on=1 off=2
 }
 
 void sub__screenshow() {
+    // Headless programs stay hidden
+    if (libqb_is_headless())
+        return;
+
 #ifdef QB64_GLUT
     screen_hide = 0;
     // $SCREENHIDE programs will not have the window running
@@ -28707,7 +28779,7 @@ int main(int argc, char *argv[]) {
     queue->lastIndex = 65535;
     queue->queue = (mouse_message *)calloc(1, sizeof(mouse_message) * (queue->lastIndex + 1));
 
-    if (screen_hide_startup)
+    if (screen_hide_startup || libqb_is_headless())
         screen_hide = 1;
 
 #ifdef QB64_WINDOWS
@@ -29009,7 +29081,8 @@ int main(int argc, char *argv[]) {
     struct libqb_thread *timer = libqb_thread_new();
     libqb_thread_start(timer, TIMERTHREAD, NULL);
 
-    lock_display_required = 1;
+    // Nothing is ever displayed by headless programs, so changing the screen never has to wait for display()
+    lock_display_required = !libqb_is_headless();
 
     libqb_start_main_thread(argc, argv);
 
@@ -29221,6 +29294,88 @@ void swap_paldata_BGRA_with_RGBA() {
     }
 }
 
+// Pre-rasterized SCREEN 0 glyphs for the font currently used by the display page
+// Each glyph is stored as one byte per pixel (non-zero = foreground) and is already expanded for double-width fonts
+// This means display() only has to do a foreground/background select for a changed cell instead of walking the
+// built-in font bitmaps or calling the FreeType renderer for every cell
+struct TextGlyphAtlas {
+    int32 font = -1;                  // font index the atlas was built for (-1 = empty)
+    int32 width = 0;                  // glyph width in pixels
+    int32 height = 0;                 // glyph height in pixels
+    std::vector<uint8> pixels;        // 256 glyphs of width * height bytes each
+    std::vector<uint8> glyphIsCached; // one entry per codepoint
+};
+
+static TextGlyphAtlas textGlyphAtlas;
+
+/// @brief Discards the SCREEN 0 glyph atlas. This must be called when a font handle is freed so that a reused handle is not matched
+void text_glyph_atlas_invalidate() {
+    textGlyphAtlas.font = -1;
+}
+
+/// @brief Returns the pre-rasterized glyph for a character in a text mode font
+/// @param f The font index (builtin or custom)
+/// @param chr The CP437 character
+/// @return A pointer to fontwidth[f] * fontheight[f] bytes
+static const uint8 *text_glyph_atlas_get(int32 f, uint8 chr) {
+    auto &atlas = textGlyphAtlas;
+
+    if (atlas.font != f || atlas.width != fontwidth[f] || atlas.height != fontheight[f]) {
+        atlas.font = f;
+        atlas.width = fontwidth[f];
+        atlas.height = fontheight[f];
+        atlas.pixels.assign(size_t(atlas.width) * atlas.height * 256, 0);
+        atlas.glyphIsCached.assign(256, false);
+    }
+
+    auto glyphSize = size_t(atlas.width) * atlas.height;
+    auto dst = &atlas.pixels[glyphSize * chr];
+
+    if (atlas.glyphIsCached[chr])
+        return dst;
+
+    if (f >= 32) { // custom font
+        char32_t chr_utf32 = codepage437_to_unicode16[chr];
+        uint8 *rt_data = nullptr;
+        int32 rt_w, rt_h;
+
+        if (FontRenderTextUTF32(font[f], &chr_utf32, 1, FONT_RENDER_MONOCHROME, &rt_data, &rt_w, &rt_h) && rt_data) {
+            auto w = std::min(rt_w, atlas.width);
+            auto h = std::min(rt_h, atlas.height);
+            for (auto y = 0; y < h; y++)
+                memcpy(dst + y * atlas.width, rt_data + y * rt_w, w);
+        }
+
+        free(rt_data);
+    } else { // default font
+        const uint8 *src = nullptr;
+        auto doubleWidth = (f & 1) != 0;
+
+        switch (f & ~1) {
+        case 8:
+            src = &charset8x8[chr][0][0];
+            break;
+        case 14:
+            src = &charset8x16[chr][1][0];
+            break;
+        case 16:
+            src = &charset8x16[chr][0][0];
+            break;
+        }
+
+        if (src) {
+            for (auto y = 0; y < atlas.height; y++) {
+                for (auto x = 0; x < atlas.width; x++)
+                    dst[y * atlas.width + x] = src[y * 8 + (doubleWidth ? x >> 1 : x)];
+            }
+        }
+    }
+
+    atlas.glyphIsCached[chr] = true;
+
+    return dst;
+}
+
 // display updates the visual page onto the visible window/monitor
 void display() {
 
@@ -29327,7 +29482,7 @@ void display() {
             static uint8 chr, col, chr_last, col_last;
             static int32 qbg_y_offset;
 
-            static int32 f, f_pitch, f_width, f_height; // font info
+            static int32 f, f_width, f_height; // font info
             f = display_page->font;
             f_width = fontwidth[f];
             f_height = fontheight[f];
@@ -29501,48 +29656,9 @@ void display() {
                     *cp_last = col;
                     cp_last++;
 
-                    // set cp2 to the character's data
-                    z2 = 0; // double-width if set
-
-                    if (f >= 32) { // custom font
-
-                        static uint32 chr_utf32;
-                        chr_utf32 = codepage437_to_unicode16[chr];
-
-                        static uint8 *rt_data_last = NULL;
-                        static int32 render_option;
-                        static int32 ok;
-                        static uint8 *rt_data;
-                        static int32 rt_w, rt_h;
-                        render_option = 1;
-                        if (rt_data_last)
-                            free(rt_data_last);
-                        ok = FontRenderTextUTF32(font[f], (char32_t *)&chr_utf32, 1, render_option, &rt_data, &rt_w, &rt_h);
-                        rt_data_last = rt_data;
-                        cp2 = rt_data;
-                        f_pitch = 0;
-
-                    } else { // default font
-                        f_pitch = 0;
-                        if (f == 8)
-                            cp2 = &charset8x8[chr][0][0];
-                        if (f == 14)
-                            cp2 = &charset8x16[chr][1][0];
-                        if (f == 16)
-                            cp2 = &charset8x16[chr][0][0];
-                        if (f == (8 + 1)) {
-                            cp2 = &charset8x8[chr][0][0];
-                            z2 = 1;
-                        }
-                        if (f == (14 + 1)) {
-                            cp2 = &charset8x16[chr][1][0];
-                            z2 = 1;
-                        }
-                        if (f == (16 + 1)) {
-                            cp2 = &charset8x16[chr][0][0];
-                            z2 = 1;
-                        }
-                    }
+                    // fetch the pre-rasterized character (see text_glyph_atlas_get())
+                    cp2 = (uint8 *)text_glyph_atlas_get(f, chr);
+
                     c = col & 0xF; // foreground col
                     if (H3C0_blink_enable) {
                         c2 = (col >> 4) & 7; // background col
@@ -29555,25 +29671,13 @@ void display() {
                     i2 = paldata[c];
                     i3 = paldata[c2];
                     lp = display_surface_offset + qbg_y_offset + y2 * x_monitor + x2;
-                    z = x_monitor - fontwidth[display_page->font];
 
                     // inner loop
                     for (y3 = 0; y3 < f_height; y3++) {
-                        for (x3 = 0; x3 < f_width; x3++) {
-                            if (*cp2)
-                                *lp = i2;
-                            else
-                                *lp = i3;
-                            if (z2) {
-                                if (x3 & z2)
-                                    cp2++;
-                            } else {
-                                cp2++;
-                            }
-                            lp++;
-                        }
-                        lp += z;
-                        cp2 += f_pitch;
+                        for (x3 = 0; x3 < f_width; x3++)
+                            lp[x3] = cp2[x3] ? i2 : i3;
+                        lp += x_monitor;
+                        cp2 += f_width;
                     } // y3,x3
 
                     // draw cursor
@@ -29919,18 +30023,7 @@ void display() {
 
         if (BGRA_to_RGBA)
             swap_paldata_BGRA_with_RGBA();
-        static uint8 *cp;
-        static uint32 *lp2;
-        static uint32 c;
-        cp = pixeldata;
-        lp2 = display_surface_offset;
-        x2 = display_page->width;
-        y2 = display_page->height;
-        for (y = 0; y < y2; y++) {
-            for (x = 0; x < x2; x++) {
-                *lp2++ = paldata[*cp++];
-            } // x
-        } // y
+        image_expand_palette(pixeldata, display_surface_offset, i, paldata);
         if (BGRA_to_RGBA)
             swap_paldata_BGRA_with_RGBA();
 
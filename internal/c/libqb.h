@@ -26,6 +26,9 @@ void sub_cls(int32 method, uint32 use_color, int32 passed);
 void qbs_print(qbs *, int32);
 int32 func__copyimage(int32 i, int32 mode, int32 passed);
 void sub__freeimage(int32 i, int32 passed);
+int32 image_reserve_handle();
+void image_release_handle(int32 handle);
+int32 image_new_from_buffer(void *buffer, int32 x, int32 y, int32 bpp, int32 handle);
 int32 func__dest();
 int32 func__display();
 void qbg_sub_view_print(int32, int32, int32);
@@ -38,6 +38,7 @@ void sub__wave(uint32_t voice, void *waveDefinition, uint32_t frameCount, int32_
 
 int32_t func__sndrate();
 int32_t func__sndopen(qbs *qbsFileName, qbs *qbsRequirements, int32_t passed);
+int32_t func__sndready(int32_t handle);
 void sub__sndclose(int32_t handle);
 int32_t func__sndcopy(int32_t src_handle);
 void sub__sndplay(int32_t handle);
@@ -49,6 +50,7 @@ int32_t func__sndpaused(int32_t handle);
 void sub__sndvol(int32_t handle, float volume);
 void sub__sndloop(int32_t handle);
 void sub__sndbal(int32_t handle, float x, float y, float z, int32_t channel, int32_t passed);
+void sub__sndeffect(int32_t handle, int32_t slot, int32_t type, float param1, float param2, float param3, int32_t passed);
 double func__sndlen(int32_t handle);
 double func__sndgetpos(int32_t handle);
 void sub__sndsetpos(int32_t handle, double seconds);
@@ -67,8 +69,10 @@ static inline void sub__sndrawdone(int32_t handle, int32_t passed) {
 
 double func__sndrawlen(int32_t handle, int32_t passed);
 
-mem_block func__memsound(int32_t handle, int32_t targetChannel, int32_t passed);
+mem_block func__memsound(int32_t handle, int32_t targetChannel, int64_t startFrame, int64_t frameCount, int32_t passed);
 int32_t func__sndnew(uint32_t frames, int32_t channels, int32_t bits, uint32_t sampleRate, int32_t passed);
+int32_t func__sndrender(uint32_t frames);
+int64_t func__sndstat(int32_t statistic, int32_t index, int32_t passed);
 void sub__midisoundbank(qbs *qbsFileName, qbs *qbsRequirements, int32_t passed);
 
 void snd_update();
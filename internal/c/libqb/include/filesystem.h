@@ -5,12 +5,14 @@
 #pragma once
 
 #include <stdint.h>
+#include <string>
 
 struct qbs;
 
 void FS_SaveStartDirectory();
 bool FS_DirectoryExists(const char *path);
 bool FS_FileExists(const char *path);
+std::string FS_GetFQN(const char *path);
 
 qbs *func__cwd();
 qbs *func__dir(qbs *qbsContext);
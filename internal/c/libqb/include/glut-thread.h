@@ -15,6 +15,12 @@ void libqb_start_glut_thread();
 // do any GLUT-related stuff
 bool libqb_is_glut_up();
 
+// Indicates whether the program runs without a window. Headless programs never
+// start GLUT (not even via _ScreenShow), all drawing happens in software.
+// Requested at runtime via the QB64PE_HEADLESS environment variable, and always
+// true for $Console:Only programs.
+bool libqb_is_headless();
+
 // Called at consistent intervals from a GLUT callback
 void libqb_process_glut_queue();
 
@@ -7,6 +7,7 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <limits>
 
 inline constexpr auto IMAGE_8BPP_MAX_COLORS = std::size_t{1} << std::numeric_limits<uint8_t>::digits;
@@ -200,6 +201,8 @@ double func__hue32(uint32_t argb);
 double func__sat32(uint32_t argb);
 double func__bri32(uint32_t argb);
 
+void image_expand_palette(const uint8_t *src, uint32_t *dst, size_t count, const uint32_t *palette);
+
 void sub__depthbuffer(int32_t options, int32_t dst, int32_t passed);
 void sub__maptriangle(int32_t cull_options, float sx1, float sy1, float sx2, float sy2, float sx3, float sy3, int32_t si, float dx1, float dy1, float dz1,
                       float dx2, float dy2, float dz2, float dx3, float dy3, float dz3, int32_t di, int32_t smooth_options, int32_t passed);
@@ -386,3 +389,62 @@ static inline uint32_t image_find_closest_palette_color(uint32_t color, const ui
     return image_find_closest_palette_color(image_get_bgra_red(color), image_get_bgra_green(color), image_get_bgra_blue(color), palette, distanceFunction,
                                             paletteColors);
 }
+
+/// @brief A direct-mapped cache of closest palette color lookups. Results are identical to image_find_closest_palette_color() because only exact RGB
+/// matches are served from the cache. This is used by _RGB / _RGBA on palette based images and by the 8bpp image conversion code.
+/// @tparam DistFunc The distance function to use (see above).
+template <typename DistFunc> class ImagePaletteLookupCache {
+  public:
+    explicit ImagePaletteLookupCache(DistFunc distanceFunction) : distanceFunction(distanceFunction) {
+        Clear();
+    }
+
+    /// @brief Uses a new palette. This must be called whenever the palette contents change.
+    /// @param palette The palette to search (an array of 32-bit colors).
+    /// @param paletteColors The number of colors in the palette.
+    void Reset(const uint32_t *palette, uint32_t paletteColors = IMAGE_8BPP_MAX_COLORS) {
+        colors = std::min<uint32_t>(paletteColors, IMAGE_8BPP_MAX_COLORS);
+        std::memcpy(this->palette, palette, colors * sizeof(uint32_t));
+        Clear();
+    }
+
+    /// @brief Calls Reset() only if the palette is different from the one that is cached. This is for callers that cannot track palette changes.
+    /// @param palette The palette to search (an array of 32-bit colors).
+    /// @param paletteColors The number of colors in the palette.
+    void Validate(const uint32_t *palette, uint32_t paletteColors = IMAGE_8BPP_MAX_COLORS) {
+        if (paletteColors != colors || std::memcmp(this->palette, palette, colors * sizeof(uint32_t)))
+            Reset(palette, paletteColors);
+    }
+
+    /// @brief Finds the closest color index in the cached palette.
+    /// @param r The red color component.
+    /// @param g The green color component.
+    /// @param b The blue color component.
+    /// @return The index of the closest color in the palette.
+    uint32_t FindClosest(uint8_t r, uint8_t g, uint8_t b) {
+        auto key = (uint32_t(r) << 16) | (uint32_t(g) << 8) | uint32_t(b);
+        auto slot = (key * 2654435761u) >> (32 - CACHE_BITS); // Fibonacci hashing
+
+        if (keys[slot] != key) {
+            keys[slot] = key;
+            values[slot] = uint8_t(image_find_closest_palette_color(r, g, b, palette, distanceFunction, colors));
+        }
+
+        return values[slot];
+    }
+
+  private:
+    static constexpr auto CACHE_BITS = 14;
+    static constexpr auto CACHE_SIZE = size_t{1} << CACHE_BITS;
+    static constexpr auto EMPTY_KEY = uint32_t{0xFFFFFFFFu}; // never a valid 24-bit RGB key
+
+    void Clear() {
+        std::fill(keys, keys + CACHE_SIZE, EMPTY_KEY);
+    }
+
+    DistFunc distanceFunction;
+    uint32_t palette[IMAGE_8BPP_MAX_COLORS] = {};
+    uint32_t colors = 0;
+    uint32_t keys[CACHE_SIZE];
+    uint8_t values[CACHE_SIZE];
+};
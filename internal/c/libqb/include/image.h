@@ -42,4 +42,8 @@
 struct qbs;
 
 int32_t func__loadimage(qbs *qbsFileName, int32_t bpp, qbs *qbsRequirements, int32_t passed);
+int32_t func__imageready(int32_t handle, int32_t wait, int32_t passed);
+int32_t func__scaleimage(int32_t imageHandle, qbs *qbsScaler, int32_t width, int32_t height, int32_t passed);
+bool image_async_cancel(int32_t handle);
+void image_vector_release(int32_t handle);
 void sub__saveimage(qbs *qbsFileName, int32_t imageHandle, qbs *qbsRequirements, int32_t passed);
@@ -0,0 +1,22 @@
+//----------------------------------------------------------------------------------------------------------------------
+// QB64-PE desktop capture support (_SCREENIMAGE)
+//----------------------------------------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+
+/// @brief Gets the size of the desktop that can be captured.
+/// @param width Receives the desktop width.
+/// @param height Receives the desktop height.
+/// @return False if the desktop can't be accessed (for example, no X server is available).
+bool screenimage_get_desktop_size(int32_t *width, int32_t *height);
+
+/// @brief Captures a region of the desktop.
+/// @param x The left edge of the region. The region must lie within the desktop.
+/// @param y The top edge of the region.
+/// @param width The width of the region.
+/// @param height The height of the region.
+/// @param dst Receives width * height 32bpp BGRA pixels with full alpha (the img_struct layout).
+/// @return False if the capture failed.
+bool screenimage_capture(int32_t x, int32_t y, int32_t width, int32_t height, uint32_t *dst);
@@ -740,7 +740,7 @@ static uint64_t FS_GetFreeDiskSpace(const char *path) {
 /// @brief Gets the fully qualified name (FQN).
 /// @param path The path name to get the FQN for.
 /// @return The FQN.
-static std::string FS_GetFQN(const char *path) {
+std::string FS_GetFQN(const char *path) {
     std::string FQN = path; // fallback
 
 #ifdef QB64_WINDOWS
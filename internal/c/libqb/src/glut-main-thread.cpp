@@ -117,7 +117,7 @@ static struct completion glut_thread_starter;
 static struct completion *glut_thread_initialized;
 
 void libqb_start_glut_thread() {
-    if (glut_is_started)
+    if (glut_is_started || libqb_is_headless())
         return;
 
     struct completion init;
@@ -136,7 +136,26 @@ bool libqb_is_glut_up() {
     return glut_is_started;
 }
 
+bool libqb_is_headless() {
+    // Read once, the first call happens from main() before any other thread is started
+    static int headless = -1;
+
+    if (headless == -1) {
+        const char *env = getenv("QB64PE_HEADLESS");
+
+        headless = env && *env && strcmp(env, "0") != 0;
+    }
+
+    return headless;
+}
+
 void libqb_glut_presetup(int argc, char **argv) {
+    if (libqb_is_headless()) {
+        libqb_log_info("Running headless, no window will be created");
+        screen_hide = 1;
+        return;
+    }
+
     if (!screen_hide) {
         initialize_glut(argc, argv); // Initialize GLUT if the screen isn't hidden
         glut_is_started = true;
@@ -146,6 +165,12 @@ void libqb_glut_presetup(int argc, char **argv) {
 }
 
 void libqb_start_main_thread(int argc, char **argv) {
+    // Headless programs never use GLUT, so like Console-Only programs we can
+    // just run MAIN_LOOP without creating a new thread for it.
+    if (libqb_is_headless()) {
+        MAIN_LOOP(NULL);
+        return;
+    }
 
     // Start the 'MAIN_LOOP' in a separate thread, as GLUT has to run on the
     // initial thread.
@@ -10,6 +10,11 @@
 #include <cstring>
 #include <limits>
 
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#    define GRAPHICS_HAS_AVX2_KERNELS
+#    include <immintrin.h>
+#endif
+
 // External functions. These should be moved here in the future.
 void flush_old_hardware_commands();
 void validatepage(int32_t pageNumber);
@@ -191,6 +196,56 @@ double func__bri32(uint32_t argb) {
     return hsb.b * 100.0;
 }
 
+/// @brief Scalar palette expansion. Used when AVX2 is not available and for the tail of the AVX2 kernel
+static void image_expand_palette_scalar(const uint8_t *src, uint32_t *dst, size_t count, const uint32_t *palette) {
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        dst[i] = palette[src[i]];
+        dst[i + 1] = palette[src[i + 1]];
+        dst[i + 2] = palette[src[i + 2]];
+        dst[i + 3] = palette[src[i + 3]];
+    }
+
+    for (; i < count; i++)
+        dst[i] = palette[src[i]];
+}
+
+#ifdef GRAPHICS_HAS_AVX2_KERNELS
+/// @brief AVX2 palette expansion. This gathers 8 palette entries per iteration
+__attribute__((target("avx2"))) static void image_expand_palette_avx2(const uint8_t *src, uint32_t *dst, size_t count, const uint32_t *palette) {
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        auto indices = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        auto lo = _mm256_i32gather_epi32(reinterpret_cast<const int *>(palette), _mm256_cvtepu8_epi32(indices), 4);
+        auto hi = _mm256_i32gather_epi32(reinterpret_cast<const int *>(palette), _mm256_cvtepu8_epi32(_mm_srli_si128(indices, 8)), 4);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 8), hi);
+    }
+
+    image_expand_palette_scalar(src + i, dst + i, count - i, palette);
+}
+#endif
+
+/// @brief Converts 8bpp (or 4bpp stored as 8bpp) palette indices to 32bpp BGRA colors. This is shared by display(), _PUTIMAGE & _COPYIMAGE
+/// @param src The source palette indices
+/// @param dst The destination 32bpp pixels. This must not overlap src
+/// @param count The number of pixels to convert
+/// @param palette A 256 entry palette
+void image_expand_palette(const uint8_t *src, uint32_t *dst, size_t count, const uint32_t *palette) {
+#ifdef GRAPHICS_HAS_AVX2_KERNELS
+    static const auto hasAVX2 = __builtin_cpu_supports("avx2");
+
+    if (hasAVX2) {
+        image_expand_palette_avx2(src, dst, count, palette);
+        return;
+    }
+#endif
+
+    image_expand_palette_scalar(src, dst, count, palette);
+}
+
 void sub__depthbuffer(int32_t options, int32_t dst, int32_t passed) {
     //                    {ON|OFF|LOCK|_CLEAR}
 
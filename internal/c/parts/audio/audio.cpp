@@ -19,15 +19,27 @@
 #include "filesystem.h"
 #include "framework.h"
 #include "memblock.h"
+#include "condvar.h"
 #include "mutex.h"
 #include "qbs.h"
+#include "thread.h"
+#include <chrono>
+#include <deque>
 
 /// @brief The top-level class that implements the QB64-PE audio engine.
 class AudioEngine {
     /// @brief A class that can manage a list of buffers using unique keys.
+    /// Buffers loaded from files are also indexed by path, so that opening the same file again skips reading and hashing it. The buffer key doubles as the
+    /// resource manager file name, so sounds using the same key share one decoded PCM copy inside miniaudio. The map is accessed by the program thread and
+    /// by the resource manager job threads (through the VFS), so it is mutex protected.
     class BufferMap {
       public:
-        BufferMap() = default;
+        BufferMap() {
+            m = libqb_mutex_new();
+        }
+        ~BufferMap() {
+            libqb_mutex_free(m);
+        }
         BufferMap(const BufferMap &) = delete;
         BufferMap &operator=(const BufferMap &) = delete;
         BufferMap(BufferMap &&) = delete;
@@ -41,6 +53,8 @@ class AudioEngine {
         /// @return True if successful.
         bool AddBuffer(const void *data, size_t size, uint64_t key) {
             if (data && size) {
+                libqb_mutex_guard lock(m);
+
                 auto it = buffers.find(key);
 
                 if (it == buffers.end()) {
@@ -62,6 +76,8 @@ class AudioEngine {
         /// @return True if successful.
         bool AddBuffer(std::vector<uint8_t> &&buffer, uint64_t key) {
             if (!buffer.empty()) {
+                libqb_mutex_guard lock(m);
+
                 auto it = buffers.find(key);
 
                 if (it == buffers.end()) {
@@ -79,6 +95,8 @@ class AudioEngine {
         /// @brief Decrements the buffer reference count and frees the buffer if the reference count reaches zero.
         /// @param key The unique key for the buffer.
         void ReleaseBuffer(uint64_t key) {
+            libqb_mutex_guard lock(m);
+
             auto it = buffers.find(key);
 
             if (it != buffers.end()) {
@@ -96,6 +114,8 @@ class AudioEngine {
         /// @param key The unique key for the buffer.
         /// @return An std::pair of the buffer raw pointer and size.
         std::pair<const void *, size_t> GetBuffer(uint64_t key) const {
+            libqb_mutex_guard lock(m);
+
             auto it = buffers.find(key);
 
             if (it != buffers.end()) {
@@ -107,6 +127,47 @@ class AudioEngine {
             return {nullptr, 0};
         }
 
+        /// @brief Remembers that a file was loaded into the buffer with the given key. Files that were modified very recently are not remembered, because
+        /// the file system timestamp may not change if they are written again right away (the buffer is still shared through the content key).
+        /// @param path The absolute file path.
+        /// @param info The file identity when it was loaded.
+        /// @param key The buffer key.
+        void SetFileKey(const std::string &path, const AudioFileInfo &info, uint64_t key) {
+            auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+            libqb_mutex_guard lock(m);
+
+            if (now - info.modifiedTime < FILE_TIME_GRANULARITY_NS) {
+                files.erase(path);
+                return;
+            }
+
+            files[path] = {key, info};
+        }
+
+        /// @brief Looks up the buffer of an unchanged file that is still loaded and increases its reference count.
+        /// @param path The absolute file path.
+        /// @param info The current file identity.
+        /// @return The buffer key or 0 if the file has to be loaded.
+        uint64_t AcquireFileBuffer(const std::string &path, const AudioFileInfo &info) {
+            libqb_mutex_guard lock(m);
+
+            auto file = files.find(path);
+            if (file == files.end()) {
+                return 0;
+            }
+
+            auto it = buffers.find(file->second.key);
+            if (it == buffers.end() || file->second.info != info) {
+                files.erase(file); // the buffer was released or the file has changed
+                return 0;
+            }
+
+            it->second.refCount++;
+
+            return it->first;
+        }
+
       private:
         /// @brief A buffer that is made up of std::vector of bytes and reference count.
         struct ManagedBuffer {
@@ -122,7 +183,17 @@ class AudioEngine {
             ManagedBuffer(std::vector<uint8_t> &&src) : data(std::move(src)), refCount(1) {}
         };
 
+        /// @brief The buffer and the state of a file when it was loaded.
+        struct FileEntry {
+            uint64_t key;
+            AudioFileInfo info;
+        };
+
+        static const int64_t FILE_TIME_GRANULARITY_NS = 2000000000; // the coarsest common file system timestamp resolution (FAT)
+
         std::unordered_map<uint64_t, ManagedBuffer> buffers;
+        std::unordered_map<std::string, FileEntry> files;
+        libqb_mutex *m;
     };
 
     /// @brief miniaudio virtual file system class
@@ -383,21 +454,36 @@ class AudioEngine {
     };
 
     /// @brief A miniaudio raw audio stream datasource.
+    /// Sample frames travel from the program thread to the miniaudio thread through a fixed-capacity lock-free single-producer / single-consumer ring
+    /// buffer. The ring capacity sets the stream latency. Anything that does not fit in the ring (e.g. a whole PLAY string in background mode) is parked in
+    /// a producer-side backlog that is moved to the ring as space frees up. The miniaudio thread never touches the backlog or its mutex.
     struct RawStream {
+        static constexpr auto DEFAULT_LATENCY_MS = 250; // default ring buffer capacity in milliseconds
+        static constexpr auto MIN_LATENCY_MS = 50;      // this must comfortably exceed the Update() interval (~16 ms)
+        static constexpr auto MAX_LATENCY_MS = 10000;
+
         ma_data_source_base maDataSource;         // miniaudio data source (this must be the first member of our struct)
         ma_data_source_config maDataSourceConfig; // config struct for the data source
         ma_engine *maEngine;                      // pointer to a ma_engine object that was passed while creating the data source
         ma_sound *maSound;                        // pointer to a ma_sound object that was passed while creating the data source
 
-        struct Buffer {                       // we'll give this a name that we'll use below
-            std::vector<SampleFrameF32> data; // this holds the actual sample frames
-            size_t cursor;                    // the read cursor (in frames) in the stream
-        } buffer[2];                          // we need two of these to do a proper ping-pong
+        std::vector<SampleFrameF32> ring;           // the ring buffer storage (the size is always a power of 2)
+        size_t ringMask;                            // ring.size() - 1
+        alignas(64) std::atomic<size_t> writeIndex; // total frames ever written (only modified by the producer)
+        alignas(64) std::atomic<size_t> readIndex;  // total frames ever read (only modified by the miniaudio thread)
+
+        std::vector<SampleFrameF32> backlog; // sample frames waiting for space in the ring
+        size_t backlogCursor;                // the read cursor (in frames) in the backlog
+        std::atomic_bool hasBacklog;         // true when the backlog is not empty (written with backlogMutex held)
+        libqb_mutex *backlogMutex;           // serializes the program thread and Update() when the backlog is in use
 
-        Buffer *consumer;        // this is what the miniaudio thread will use to pull data from
-        Buffer *producer;        // this is what the main thread will use to push data to
-        libqb_mutex *m;          // we'll use a mutex to give exclusive access to resources used by both threads
-        bool stop;               // set this to true to stop supply of samples completely (including silent samples)
+        std::atomic<uint64_t> underruns;      // the number of times the stream ran dry while it was playing
+        std::atomic<uint64_t> underrunFrames; // the number of silent frames inserted because of underruns
+        bool isStarved;                       // used by the miniaudio thread to count each underrun once
+        std::atomic<uint64_t> overruns;       // the number of times the ring filled up and the producer had to spill into the backlog
+        std::atomic<uint64_t> overrunFrames;  // the number of frames that were spilled into the backlog
+
+        std::atomic_bool stop;   // set this to true to stop supply of samples completely (including silent samples)
         std::atomic_bool pause_; // set this to true to pause the stream (only silence samples will be sent to miniaudio)
 
         // Delete default, copy and move constructors and assignments.
@@ -407,21 +493,57 @@ class AudioEngine {
         RawStream &operator=(RawStream &&) = delete;
         RawStream(RawStream &&) = delete;
 
-        /// @brief Sets up the vectors, mutex and set some defaults.
+        /// @brief Sets up the ring buffer, mutex and set some defaults.
         RawStream(ma_engine *pmaEngine, ma_sound *pmaSound) {
-            maSound = pmaSound;                      // Save the pointer to the ma_sound object (this is basically from a QB64-PE sound handle)
-            maEngine = pmaEngine;                    // Save the pointer to the ma_engine object (this should come from the QB64-PE sound engine)
-            buffer[0].cursor = buffer[1].cursor = 0; // reset the cursors
-            consumer = &buffer[0];                   // set default consumer
-            producer = &buffer[1];                   // set default producer
-            stop = false;                            // we will send silent samples to keep the playback going by default
-            Pause(false);                            // the steam will not be paused by default
-            m = libqb_mutex_new();
+            maSound = pmaSound;   // Save the pointer to the ma_sound object (this is basically from a QB64-PE sound handle)
+            maEngine = pmaEngine; // Save the pointer to the ma_engine object (this should come from the QB64-PE sound engine)
+
+            size_t capacity = 1;
+            auto latencyFrames = size_t(GetLatency()) * ma_engine_get_sample_rate(maEngine) / 1000;
+            while (capacity < latencyFrames) {
+                capacity <<= 1;
+            }
+            ring.resize(capacity);
+            ringMask = capacity - 1;
+            writeIndex.store(0, std::memory_order_relaxed);
+            readIndex.store(0, std::memory_order_relaxed);
+
+            backlogCursor = 0;
+            hasBacklog.store(false, std::memory_order_relaxed);
+            backlogMutex = libqb_mutex_new();
+
+            underruns.store(0, std::memory_order_relaxed);
+            underrunFrames.store(0, std::memory_order_relaxed);
+            isStarved = true; // nothing was played yet
+            overruns.store(0, std::memory_order_relaxed);
+            overrunFrames.store(0, std::memory_order_relaxed);
+
+            stop = false; // we will send silent samples to keep the playback going by default
+            Pause(false); // the steam will not be paused by default
         }
 
         /// @brief We use this to destroy the mutex.
         ~RawStream() {
-            libqb_mutex_free(m);
+            libqb_mutex_free(backlogMutex);
+        }
+
+        /// @brief Returns the raw stream latency (ring buffer capacity) in milliseconds. This can be changed using the QB64PE_SNDRAW_LATENCY environment
+        /// variable.
+        /// @return The latency in milliseconds.
+        static int GetLatency() {
+            static int latency = 0;
+
+            if (!latency) {
+                latency = DEFAULT_LATENCY_MS;
+
+                auto value = getenv("QB64PE_SNDRAW_LATENCY");
+                if (value && *value) {
+                    latency = std::clamp(atoi(value), MIN_LATENCY_MS, MAX_LATENCY_MS);
+                    audio_log_info("Raw stream latency set to %i ms", latency);
+                }
+            }
+
+            return latency;
         }
 
         /// @brief Pauses or resumes the stream.
@@ -430,54 +552,144 @@ class AudioEngine {
             pause_.store(state, std::memory_order_relaxed);
         }
 
-        /// @brief Pushes a sample frame at the end of the queue. This is mutex protected and called by the main thread.
+        /// @brief Writes sample frames to the ring buffer. Only the producer can call this.
+        /// @param frames The number of frames to write.
+        /// @param getFrame A callable returning the sample frame for a given index.
+        /// @return The number of frames that were written. This can be less than frames if the ring is full.
+        template <typename F> size_t WriteRing(size_t frames, F &&getFrame) {
+            auto write = writeIndex.load(std::memory_order_relaxed);
+            auto freeFrames = ring.size() - (write - readIndex.load(std::memory_order_acquire));
+            frames = std::min(frames, freeFrames);
+
+            // Copy in up to two contiguous spans so that the loops stay simple enough to be vectorized
+            auto start = write & ringMask;
+            auto first = std::min(frames, ring.size() - start);
+            auto dst = ring.data() + start;
+
+            for (size_t i = 0; i < first; i++) {
+                dst[i] = getFrame(i);
+            }
+
+            dst = ring.data();
+            for (size_t i = first; i < frames; i++) {
+                dst[i - first] = getFrame(i);
+            }
+
+            writeIndex.store(write + frames, std::memory_order_release);
+
+            return frames;
+        }
+
+        /// @brief Moves as much of the backlog to the ring as possible. backlogMutex must be held.
+        void FlushBacklogLocked() {
+            auto pending = backlog.size() - backlogCursor;
+            if (pending) {
+                auto src = backlog.data() + backlogCursor;
+                backlogCursor += WriteRing(pending, [src](size_t i) { return src[i]; });
+            }
+
+            if (backlogCursor == backlog.size()) {
+                backlog.clear();
+                backlogCursor = 0;
+                hasBacklog.store(false, std::memory_order_release); // the producer can write directly to the ring again
+            }
+        }
+
+        /// @brief Moves as much of the backlog to the ring as possible. This is called by the main thread to keep the ring fed.
+        void FlushBacklog() {
+            if (hasBacklog.load(std::memory_order_acquire)) {
+                libqb_mutex_guard lock(backlogMutex);
+
+                FlushBacklogLocked();
+            }
+        }
+
+        /// @brief Queues sample frames. The ring buffer is used directly when possible and the backlog is used otherwise. This is called by the program
+        /// thread.
+        /// @param frames The number of frames to push.
+        /// @param getFrame A callable returning the sample frame for a given index.
+        template <typename F> void Push(size_t frames, F &&getFrame) {
+            size_t written = 0;
+
+            if (!hasBacklog.load(std::memory_order_acquire)) {
+                // Fast path: the backlog is empty, so nobody else can be writing to the ring
+                written = WriteRing(frames, getFrame);
+
+                if (written == frames) {
+                    return;
+                }
+            }
+
+            libqb_mutex_guard lock(backlogMutex);
+
+            // Make room in the ring first so that frames are played in order
+            FlushBacklogLocked();
+
+            if (!hasBacklog.load(std::memory_order_relaxed)) {
+                written += WriteRing(frames - written, [&getFrame, written](size_t i) { return getFrame(written + i); });
+            }
+
+            if (written < frames) {
+                // Count each run of spilling once, just like underruns
+                if (!hasBacklog.load(std::memory_order_relaxed)) {
+                    overruns.fetch_add(1, std::memory_order_relaxed);
+                }
+                overrunFrames.fetch_add(frames - written, std::memory_order_relaxed);
+
+                auto offset = backlog.size();
+                backlog.resize(offset + frames - written);
+
+                auto dst = backlog.data() + offset;
+                for (auto i = written; i < frames; i++) {
+                    dst[i - written] = getFrame(i);
+                }
+
+                hasBacklog.store(true, std::memory_order_release);
+            }
+        }
+
+        /// @brief Pushes a sample frame at the end of the queue. This is called by the main thread.
         /// @param l Sample frame left channel data.
         /// @param r Sample frame right channel data.
         void PushSampleFrame(float l, float r) {
-            libqb_mutex_guard lock(m); // lock the mutex before accessing the vectors
-
-            producer->data.push_back({l, r}); // push the sample frame to the back of the producer queue
+            Push(1, [l, r](size_t) { return SampleFrameF32{l, r}; });
         }
 
-        /// @brief Pushes a whole buffer of stereo sample frames to the queue. This is mutex protected and called by the main thread.
+        /// @brief Pushes a whole buffer of stereo sample frames to the queue. This is called by the main thread.
         /// @param buffer The buffer containing the stereo sample frames. This cannot be NULL.
         /// @param frames The total number of frames in the buffer.
         void PushSampleFrames(SampleFrameF32 *buffer, ma_uint64 frames) {
-            libqb_mutex_guard lock(m); // lock the mutex before accessing the vectors
-
-            std::copy(buffer, buffer + frames, std::back_inserter(producer->data));
+            Push(size_t(frames), [buffer](size_t i) { return buffer[i]; });
         }
 
-        /// @brief Pushes a whole buffer of mono sample frames to the queue. This is mutex protected and called by the main thread.
+        /// @brief Pushes a whole buffer of mono sample frames to the queue. This is called by the main thread.
         /// @param buffer The buffer containing the sample frames. This cannot be NULL.
         /// @param frames The total number of frames in the buffer.
         /// @param gainLeft Left channel gain value (0.0 to 1.0).
         /// @param gainRight Right channel gain value (0.0 to 1.0).
         void PushSampleFrames(float *buffer, ma_uint64 frames, float gainLeft, float gainRight) {
-            libqb_mutex_guard lock(m); // lock the mutex before accessing the vectors
-
-            for (ma_uint64 i = 0; i < frames; i++) {
-                producer->data.push_back({buffer[i] * gainLeft, buffer[i] * gainRight});
-            }
+            Push(size_t(frames), [buffer, gainLeft, gainRight](size_t i) { return SampleFrameF32{buffer[i] * gainLeft, buffer[i] * gainRight}; });
         }
 
-        /// @brief Pushes a whole buffer of mono sample frames to the queue (no FP panning math). This is mutex protected and called by the main thread.
+        /// @brief Pushes a whole buffer of mono sample frames to the queue (no FP panning math). This is called by the main thread.
         /// @param buffer The buffer containing the sample frames. This cannot be NULL.
         /// @param frames The total number of frames in the buffer.
         void PushSampleFrames(float *buffer, ma_uint64 frames) {
-            libqb_mutex_guard lock(m); // lock the mutex before accessing the vectors
-
-            for (ma_uint64 i = 0; i < frames; i++) {
-                producer->data.push_back({buffer[i], buffer[i]});
-            }
+            Push(size_t(frames), [buffer](size_t i) { return SampleFrameF32{buffer[i], buffer[i]}; });
         }
 
         /// @brief Returns the length, in sample frames of sound queued.
         /// @return The length left to play in sample frames.
         ma_uint64 GetSampleFramesRemaining() {
-            libqb_mutex_guard lock(m); // lock the mutex before accessing the vectors
+            if (hasBacklog.load(std::memory_order_acquire)) {
+                libqb_mutex_guard lock(backlogMutex); // Update() may be moving frames from the backlog to the ring
 
-            return (consumer->data.size() - consumer->cursor) + (producer->data.size() - producer->cursor); // sum of producer and consumer sample frames
+                FlushBacklogLocked();
+
+                return (writeIndex.load(std::memory_order_relaxed) - readIndex.load(std::memory_order_acquire)) + (backlog.size() - backlogCursor);
+            }
+
+            return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire);
         }
 
         /// @brief Returns the length, in seconds of sound queued.
@@ -487,6 +699,7 @@ class AudioEngine {
         }
 
         /// @brief Callback function used by miniaudio to pull a chunk of raw sample frames to play. The samples being read is removed from the queue.
+        /// This runs on the miniaudio thread and is lock-free.
         /// @param pDataSource Pointer to the raw stream data source (cast to RawStream type).
         /// @param pFramesOut The sample frames sent to miniaudio.
         /// @param frameCount The sample frame count requested by miniaudio.
@@ -516,32 +729,44 @@ class AudioEngine {
                 std::fill(maBuffer, maBuffer + frameCount, SampleFrameF32{SILENCE_SAMPLE_F32, SILENCE_SAMPLE_F32});
                 sampleFramesRead = frameCount;
             } else {
-                sampleFramesRead = pRawStream->consumer->data.size() - pRawStream->consumer->cursor; // total amount of samples we need to send to miniaudio
-
-                // Swap buffers if we do not have anything left to play
-                if (!sampleFramesRead) {
-                    pRawStream->consumer->cursor = 0;                                                    // reset the cursor
-                    pRawStream->consumer->data.clear();                                                  // clear the consumer vector
-                    std::swap(pRawStream->consumer, pRawStream->producer);                               // quickly swap the Buffer pointers
-                    sampleFramesRead = pRawStream->consumer->data.size() - pRawStream->consumer->cursor; // get the total number of samples again
-                }
+                auto read = pRawStream->readIndex.load(std::memory_order_relaxed);
+                auto available = pRawStream->writeIndex.load(std::memory_order_acquire) - read;
 
-                sampleFramesRead = std::min(sampleFramesRead, frameCount); // we'll always send lower of what miniaudio wants or what we have
+                sampleFramesRead = std::min<ma_uint64>(available, frameCount); // we'll always send lower of what miniaudio wants or what we have
 
                 if (sampleFramesRead) {
                     // Now send the samples to miniaudio
-                    std::copy(pRawStream->consumer->data.data() + pRawStream->consumer->cursor,
-                              pRawStream->consumer->data.data() + pRawStream->consumer->cursor + sampleFramesRead, maBuffer);
+                    auto start = read & pRawStream->ringMask;
+                    auto first = std::min<size_t>(sampleFramesRead, pRawStream->ring.size() - start);
 
-                    pRawStream->consumer->cursor += sampleFramesRead; // increment the read cursor
-                } else {
-                    if (pRawStream->stop) {
-                        // End of stream was signalled
-                        result = MA_AT_END;
+                    std::copy(pRawStream->ring.data() + start, pRawStream->ring.data() + start + first, maBuffer);
+                    std::copy(pRawStream->ring.data(), pRawStream->ring.data() + (sampleFramesRead - first), maBuffer + first);
+
+                    pRawStream->readIndex.store(read + sampleFramesRead, std::memory_order_release); // hand the space back to the producer
+                    pRawStream->isStarved = false;
+                }
+
+                if (sampleFramesRead < frameCount) {
+                    if (pRawStream->stop.load(std::memory_order_relaxed) && !pRawStream->hasBacklog.load(std::memory_order_acquire)) {
+                        // End of stream was signalled and everything was played
+                        if (!sampleFramesRead) {
+                            result = MA_AT_END;
+                        }
                     } else {
                         // To keep the stream going, play silence if there are no frames to play
-                        std::fill(maBuffer, maBuffer + frameCount, SampleFrameF32{SILENCE_SAMPLE_F32, SILENCE_SAMPLE_F32});
+                        auto silentFrames = frameCount - sampleFramesRead;
+
+                        std::fill(maBuffer + sampleFramesRead, maBuffer + frameCount, SampleFrameF32{SILENCE_SAMPLE_F32, SILENCE_SAMPLE_F32});
                         sampleFramesRead = frameCount;
+
+                        // Running dry after playing something is an underrun. An idle stream is not
+                        if (!pRawStream->isStarved) {
+                            pRawStream->isStarved = true;
+                            pRawStream->underruns.fetch_add(1, std::memory_order_relaxed);
+                            pRawStream->underrunFrames.fetch_add(silentFrames, std::memory_order_relaxed);
+                        } else if (pRawStream->hasBacklog.load(std::memory_order_relaxed)) {
+                            pRawStream->underrunFrames.fetch_add(silentFrames, std::memory_order_relaxed); // still waiting for the backlog
+                        }
                     }
                 }
             }
@@ -598,8 +823,9 @@ class AudioEngine {
         /// @brief Creates, initializes and sets up a raw stream for playback.
         /// @param pmaEngine A pointer to a QB64-PE sound engine object. This cannot be NULL.
         /// @param pmaSound A pointer to an ma_sound object from a QB64-PE sound handle. This cannot be NULL.
+        /// @param pmaGroup The sound group that the sound will be attached to (NULL attaches it to the engine endpoint).
         /// @return Returns a pointer to a data source if successful, NULL otherwise.
-        static RawStream *Create(ma_engine *pmaEngine, ma_sound *pmaSound) {
+        static RawStream *Create(ma_engine *pmaEngine, ma_sound *pmaSound, ma_sound_group *pmaGroup) {
             if (!pmaEngine || !pmaSound) { // these should not be NULL
                 audio_log_warn("Invalid arguments");
 
@@ -626,7 +852,7 @@ class AudioEngine {
                 return nullptr;
             }
 
-            result = ma_sound_init_from_data_source(pmaEngine, &pRawStream->maDataSource, MA_SOUND_FLAG_NO_PITCH | MA_SOUND_FLAG_NO_SPATIALIZATION, NULL,
+            result = ma_sound_init_from_data_source(pmaEngine, &pRawStream->maDataSource, MA_SOUND_FLAG_NO_PITCH | MA_SOUND_FLAG_NO_SPATIALIZATION, pmaGroup,
                                                     pmaSound); // attach data source to the ma_sound
             if (result != MA_SUCCESS) {
                 audio_log_warn("Error %i: failed to initialize sound from data source", result);
@@ -647,7 +873,7 @@ class AudioEngine {
                 return nullptr;
             }
 
-            audio_log_trace("Raw sound stream created");
+            audio_log_trace("Raw sound stream created, ring buffer capacity: %zu frames", pRawStream->ring.size());
 
             return pRawStream;
         }
@@ -659,6 +885,18 @@ class AudioEngine {
                 auto result = ma_sound_stop(pRawStream->maSound); // stop playback
                 AUDIO_DEBUG_CHECK(result == MA_SUCCESS);
 
+                if (pRawStream->underruns.load(std::memory_order_relaxed)) {
+                    audio_log_trace("Raw sound stream had %llu underrun(s), %llu silent frame(s) inserted",
+                                   (unsigned long long)pRawStream->underruns.load(std::memory_order_relaxed),
+                                   (unsigned long long)pRawStream->underrunFrames.load(std::memory_order_relaxed));
+                }
+
+                if (pRawStream->overruns.load(std::memory_order_relaxed)) {
+                    audio_log_trace("Raw sound stream had %llu overrun(s), %llu frame(s) spilled into the backlog",
+                                    (unsigned long long)pRawStream->overruns.load(std::memory_order_relaxed),
+                                    (unsigned long long)pRawStream->overrunFrames.load(std::memory_order_relaxed));
+                }
+
                 ma_sound_uninit(pRawStream->maSound); // delete the ma_sound object
 
                 delete pRawStream; // delete the raw stream object
@@ -672,7 +910,22 @@ class AudioEngine {
     class PSG {
       public:
         /// @brief Various types of waveform that can be generated.
-        enum class WaveformType { NONE, SQUARE, SAWTOOTH, TRIANGLE, SINE, NOISE_WHITE, NOISE_PINK, NOISE_BROWNIAN, NOISE_LFSR, PULSE, CUSTOM, COUNT };
+        enum class WaveformType {
+            NONE,
+            SQUARE,
+            SAWTOOTH,
+            TRIANGLE,
+            SINE,
+            NOISE_WHITE,
+            NOISE_PINK,
+            NOISE_BROWNIAN,
+            NOISE_LFSR,
+            PULSE,
+            CUSTOM,
+            SQUARE_BANDLIMITED,
+            SAWTOOTH_BANDLIMITED,
+            COUNT
+        };
 
         static constexpr auto PAN_LEFT = -1.0f;                  // left-most pan position
         static constexpr auto PAN_RIGHT = 1.0f;                  // right-most pan position
@@ -760,38 +1013,52 @@ class AudioEngine {
                 UpdateEnvelope();
             }
 
-            double GetVolume(ma_uint64 currentFrame) const {
-                if (currentFrame < attackFrames) {
-                    return double(currentFrame) / double(attackFrames);
-                }
-
-                currentFrame -= attackFrames;
-
-                if (currentFrame < decayFrames) {
-                    return 1.0 - (1.0 - sustain) * (double(currentFrame) / double(decayFrames));
-                }
-
-                currentFrame -= decayFrames;
-
-                if (currentFrame < sustainFrames) {
-                    return sustain;
-                }
-
-                currentFrame -= sustainFrames;
-
-                if (currentFrame < releaseFrames) {
-                    return sustain * (1.0 - (double(currentFrame) / double(releaseFrames)));
-                }
-
-                return 0.0; // after the release phase the volume is zero
-            }
-
             void SetSampleFrames(ma_uint64 sampleFrames) {
                 this->sampleFrames = sampleFrames;
                 UpdateEnvelope();
             }
 
+            /// @brief Applies the envelope to a whole note. Each stage is a linear volume ramp, so the stage lookup is done once per stage instead of once
+            /// per sample. This leaves simple loops that the compiler can vectorize.
+            /// @param input The note samples (SetSampleFrames() frames).
+            /// @param output The destination buffer.
+            /// @param mix Mixes to output instead of overwriting it.
+            void Apply(const float *input, float *output, bool mix) const {
+                ma_uint64 frame = 0;
+
+                ApplyStage(input, output, frame, attackFrames, 0.0f, attackFrames ? 1.0f / float(attackFrames) : 0.0f, mix);
+                ApplyStage(input, output, frame, decayFrames, 1.0f, decayFrames ? -(1.0f - float(sustain)) / float(decayFrames) : 0.0f, mix);
+                ApplyStage(input, output, frame, sustainFrames, float(sustain), 0.0f, mix);
+                ApplyStage(input, output, frame, releaseFrames, float(sustain), releaseFrames ? -float(sustain) / float(releaseFrames) : 0.0f, mix);
+            }
+
           private:
+            /// @brief Applies a linear volume ramp to one envelope stage and advances frame past it.
+            static void ApplyStage(const float *input, float *output, ma_uint64 &frame, ma_uint64 frames, float start, float slope, bool mix) {
+                static const auto RAMP_FRAMES = 4096; // the ramp is restarted every RAMP_FRAMES to keep float(i) exact
+
+                input += frame;
+                output += frame;
+                frame += frames;
+
+                for (ma_uint64 offset = 0; offset < frames; offset += RAMP_FRAMES) {
+                    auto count = int32_t(std::min<ma_uint64>(frames - offset, RAMP_FRAMES));
+                    auto gain = start + slope * float(offset);
+                    auto src = input + offset;
+                    auto dst = output + offset;
+
+                    if (mix) {
+                        for (int32_t i = 0; i < count; i++) {
+                            dst[i] += src[i] * (gain + slope * float(i));
+                        }
+                    } else {
+                        for (int32_t i = 0; i < count; i++) {
+                            dst[i] = src[i] * (gain + slope * float(i));
+                        }
+                    }
+                }
+            }
+
             void UpdateEnvelope() {
                 // Ensure that the sum of attack, decay, and release is not greater than 1.0
                 auto total = attack + decay + release;
@@ -887,6 +1154,170 @@ class AudioEngine {
             }
         };
 
+        /// @brief Oscillator for the square, sawtooth, triangle, sine and pulse waveforms. Samples are generated BLOCK_FRAMES at a time with the waveform
+        /// selection hoisted out of the inner loops, so that the compiler can vectorize them. The band-limited square and sawtooth use PolyBLEP to reduce
+        /// aliasing at high frequencies.
+        class Oscillator {
+          private:
+            static const auto BLOCK_FRAMES = 256;
+
+          public:
+            Oscillator() = delete;
+            Oscillator(const Oscillator &) = delete;
+            Oscillator &operator=(const Oscillator &) = delete;
+            Oscillator &operator=(Oscillator &&) = delete;
+            Oscillator(Oscillator &&) = delete;
+
+            Oscillator(ma_uint32 systemSampleRate)
+                : type(WaveformType::SQUARE), frequency(FREQUENCY_DEFAULT), amplitude(VOLUME_DEFAULT), dutyCycle(PULSE_WAVE_DUTY_CYCLE_DEFAULT),
+                  sampleRate(systemSampleRate), phase(0.0) {
+                UpdatePhaseIncrement();
+            }
+
+            void SetType(WaveformType type) {
+                this->type = type;
+            }
+
+            void SetFrequency(double frequency) {
+                this->frequency = std::max(frequency, 0.0);
+                UpdatePhaseIncrement();
+            }
+
+            double GetFrequency() const {
+                return frequency;
+            }
+
+            void SetAmplitude(float amplitude) {
+                this->amplitude = std::clamp(amplitude, VOLUME_MIN, VOLUME_MAX);
+            }
+
+            float GetAmplitude() const {
+                return amplitude;
+            }
+
+            void SetDutyCycle(float dutyCycle) {
+                this->dutyCycle = std::clamp(dutyCycle, PULSE_WAVE_DUTY_CYCLE_MIN, PULSE_WAVE_DUTY_CYCLE_MAX);
+            }
+
+            uint32_t GetSampleRate() const {
+                return sampleRate;
+            }
+
+            /// @brief Generates frames of the selected waveform.
+            /// @param output The destination buffer.
+            /// @param frames The number of frames to generate.
+            void Generate(float *output, ma_uint64 frames) {
+                while (frames) {
+                    auto blockFrames = std::min<ma_uint64>(frames, BLOCK_FRAMES);
+                    alignas(16) float phases[BLOCK_FRAMES];
+
+                    // The phase of each frame is computed from the block start so that there is no dependency between frames
+                    auto start = float(phase);
+                    auto increment = float(phaseIncrement);
+                    for (auto i = 0; i < BLOCK_FRAMES; i++) {
+                        auto p = start + increment * float(i);
+                        phases[i] = p - float(int32_t(p)); // p is never negative, so truncation is floor
+                    }
+
+                    GenerateBlock(phases, output, blockFrames);
+
+                    phase += phaseIncrement * double(blockFrames);
+                    phase -= std::floor(phase);
+                    output += blockFrames;
+                    frames -= blockFrames;
+                }
+            }
+
+          private:
+            WaveformType type;     // the selected waveform type
+            double frequency;      // frequency of the generated waveform
+            float amplitude;       // amplitude of the generated waveform
+            float dutyCycle;       // duty cycle of the pulse waveform
+            ma_uint32 sampleRate;  // system sample rate
+            double phaseIncrement; // phase increment per sample (cycles)
+            double phase;          // current phase position (0.0 - 1.0)
+
+            void UpdatePhaseIncrement() {
+                phaseIncrement = frequency / double(sampleRate);
+            }
+
+            /// @brief PolyBLEP residual that smooths a unit step at phase 0. See https://www.martin-finke.de/articles/audio-plugins-018-polyblep-oscillator/.
+            /// Both sides are always computed and selected using multiplication so that this is branch free (dt is at most 0.5, so they never overlap).
+            static float PolyBLEP(float t, float dt, float inverseDt) {
+                auto a = t * inverseDt;
+                auto b = (t - 1.0f) * inverseDt;
+
+                return float(t < dt) * (a + a - a * a - 1.0f) + float(t > 1.0f - dt) * (b * b + b + b + 1.0f);
+            }
+
+            /// @brief sin(2 * pi * p) for p in [0, 1) using a polynomial. Unlike std::sin(), this can be vectorized.
+            static float Sine(float p) {
+                auto x = float(2.0 * M_PI) * (0.5f - p);      // sin(2 * pi * p) = sin(pi - 2 * pi * p), x is in (-pi, pi]
+                auto folded = std::copysign(float(M_PI), x) - x; // sin(x) = sin(pi - x) = sin(-pi - x), this is in [-pi / 2, pi / 2] for |x| > pi / 2
+                x += float(std::fabs(x) > float(M_PI_2)) * (folded - x);
+                auto x2 = x * x;
+
+                return x * (1.0f + x2 * (-1.0f / 6.0f + x2 * (1.0f / 120.0f + x2 * (-1.0f / 5040.0f + x2 * (1.0f / 362880.0f + x2 * (-1.0f / 39916800.0f))))));
+            }
+
+            void GenerateBlock(const float *phases, float *output, ma_uint64 frames) const {
+                auto dt = std::clamp(float(phaseIncrement), std::numeric_limits<float>::min(), 0.5f);
+                auto inverseDt = 1.0f / dt;
+
+                switch (type) {
+                case WaveformType::SQUARE:
+                    for (ma_uint64 i = 0; i < frames; i++) {
+                        output[i] = phases[i] < 0.5f ? amplitude : -amplitude;
+                    }
+                    break;
+
+                case WaveformType::PULSE:
+                    for (ma_uint64 i = 0; i < frames; i++) {
+                        output[i] = phases[i] < dutyCycle ? amplitude : -amplitude;
+                    }
+                    break;
+
+                case WaveformType::SAWTOOTH:
+                    for (ma_uint64 i = 0; i < frames; i++) {
+                        output[i] = amplitude * (2.0f * phases[i] - 1.0f);
+                    }
+                    break;
+
+                case WaveformType::TRIANGLE:
+                    for (ma_uint64 i = 0; i < frames; i++) {
+                        output[i] = amplitude * (2.0f * std::fabs(2.0f * (phases[i] - 0.5f)) - 1.0f);
+                    }
+                    break;
+
+                case WaveformType::SINE:
+                    for (ma_uint64 i = 0; i < frames; i++) {
+                        output[i] = amplitude * Sine(phases[i]);
+                    }
+                    break;
+
+                case WaveformType::SQUARE_BANDLIMITED:
+                    for (ma_uint64 i = 0; i < frames; i++) {
+                        auto p = phases[i];
+                        auto high = float(p >= 0.5f);
+                        auto q = p + 0.5f - high; // the phase of the falling edge
+                        output[i] = amplitude * (1.0f - high - high + PolyBLEP(p, dt, inverseDt) - PolyBLEP(q, dt, inverseDt));
+                    }
+                    break;
+
+                case WaveformType::SAWTOOTH_BANDLIMITED:
+                    for (ma_uint64 i = 0; i < frames; i++) {
+                        auto p = phases[i];
+                        output[i] = amplitude * (2.0f * p - 1.0f - PolyBLEP(p, dt, inverseDt));
+                    }
+                    break;
+
+                default:
+                    std::fill(output, output + frames, SILENCE_SAMPLE_F32);
+                    break;
+                }
+            }
+        };
+
         /// @brief Custom waveform generator class using a user-defined waveform shape.
         class CustomWaveform {
           private:
@@ -979,8 +1410,7 @@ class AudioEngine {
         };
 
         RawStream *rawStream;                     // this is the RawStream where the samples data will be pushed to
-        ma_waveform_config maWaveformConfig;      // miniaudio waveform configuration
-        ma_waveform maWaveform;                   // miniaudio waveform
+        Oscillator *oscillator;                   // square, sawtooth, triangle, sine and pulse wave generator
         ma_noise_config maWhiteNoiseConfig;       // miniaudio white noise configuration
         ma_noise maWhiteNoise;                    // miniaudio white noise
         ma_noise_config maPinkNoiseConfig;        // miniaudio pink noise configuration
@@ -989,8 +1419,6 @@ class AudioEngine {
         ma_noise maBrownianNoise;                 // miniaudio brownian noise
         NoiseGenerator *noise;                    // LFSR noise generator
         CustomWaveform *customWaveform;           // custom waveform generator
-        ma_pulsewave_config maPulseWaveConfig;    // miniaudio pulse wave configuration
-        ma_pulsewave maPulseWave;                 // miniaudio pulse wave
         ma_result maResult;                       // result of the last miniaudio operation
         std::vector<float> noteBuffer;            // note frames are rendered here temporarily before it is mixed to waveBuffer
         std::vector<float> waveBuffer;            // this is where the waveform is rendered / mixed before being pushed to RawStream
@@ -1021,7 +1449,7 @@ class AudioEngine {
         void GenerateWaveform(double waveDuration, bool mix = false) {
             auto neededFrames = ma_uint64(waveDuration * ma_engine_get_sample_rate(rawStream->maEngine));
 
-            if (!neededFrames || maWaveform.config.frequency >= FREQUENCY_LIMIT || mixCursor + neededFrames > waveBuffer.size()) {
+            if (!neededFrames || oscillator->GetFrequency() >= FREQUENCY_LIMIT || mixCursor + neededFrames > waveBuffer.size()) {
                 return; // nothing to do
             }
 
@@ -1039,7 +1467,10 @@ class AudioEngine {
             case WaveformType::SAWTOOTH:
             case WaveformType::TRIANGLE:
             case WaveformType::SINE:
-                maResult = ma_waveform_read_pcm_frames(&maWaveform, noteBuffer.data(), neededFrames, &generatedFrames);
+            case WaveformType::PULSE:
+            case WaveformType::SQUARE_BANDLIMITED:
+            case WaveformType::SAWTOOTH_BANDLIMITED:
+                oscillator->Generate(noteBuffer.data(), neededFrames);
                 break;
 
             case WaveformType::NOISE_WHITE:
@@ -1060,10 +1491,6 @@ class AudioEngine {
                 }
                 break;
 
-            case WaveformType::PULSE:
-                maResult = ma_pulsewave_read_pcm_frames(&maPulseWave, noteBuffer.data(), neededFrames, &generatedFrames);
-                break;
-
             case WaveformType::CUSTOM:
                 for (ma_uint64 i = 0; i < neededFrames; i++) {
                     noteBuffer[i] = customWaveform->GenerateSample();
@@ -1081,27 +1508,15 @@ class AudioEngine {
                 return; // something went wrong
             }
 
+            // Apply the envelope volume and copy or mix the samples to the buffer
             envelope.SetSampleFrames(generatedFrames);
-            auto destination = waveBuffer.data() + mixCursor;
-
-            if (mix) {
-                // Mix the samples to the buffer
-                for (ma_uint64 i = 0; i < generatedFrames; i++) {
-                    destination[i] = std::fmaf(noteBuffer[i], envelope.GetVolume(i), destination[i]);
-                }
-            } else {
-                // Copy the samples to the buffer
-                for (ma_uint64 i = 0; i < generatedFrames; i++) {
-                    destination[i] = noteBuffer[i] * envelope.GetVolume(i); // apply the envelope volume
-                }
-            }
+            envelope.Apply(noteBuffer.data(), waveBuffer.data() + mixCursor, mix);
         }
 
         /// @brief Sets the frequency of the waveform.
         /// @param frequency The frequency of the waveform.
         void SetFrequency(double frequency) {
-            maResult = ma_waveform_set_frequency(&maWaveform, frequency);
-            maResult = ma_pulsewave_set_frequency(&maPulseWave, frequency);
+            oscillator->SetFrequency(frequency);
             noise->SetFrequency(uint32_t(frequency));
             customWaveform->SetFrequency(frequency);
         }
@@ -1127,7 +1542,7 @@ class AudioEngine {
         /// @brief Gets MML friendly amplitude value.
         /// @return A value from 0 to 100.
         long GetMMLAmplitude() {
-            return std::lround(maWaveform.config.amplitude * MML_VOLUME_MAX);
+            return std::lround(oscillator->GetAmplitude() * MML_VOLUME_MAX);
         }
 
         /// @brief Accumulates the samples into the paused buffer until the PSG is unpaused.
@@ -1157,8 +1572,8 @@ class AudioEngine {
 
         /// @brief Waits for any playback to complete.
         void AwaitPlaybackCompletion() {
-            if (background || isPaused) {
-                return; // no need to wait
+            if (background || isPaused || !ma_engine_get_device(rawStream->maEngine)) {
+                return; // no need to wait (offline engines only play when the program renders)
             }
 
             auto timeSec = rawStream->GetTimeRemaining() * 0.95 - 0.25; // per original QB64 behavior
@@ -1192,10 +1607,8 @@ class AudioEngine {
             currentState = {};
             SetPanPosition(PAN_CENTER);
 
-            maWaveformConfig = ma_waveform_config_init(ma_format::ma_format_f32, 1, ma_engine_get_sample_rate(rawStream->maEngine),
-                                                       ma_waveform_type::ma_waveform_type_square, VOLUME_DEFAULT, FREQUENCY_DEFAULT);
-            maResult = ma_waveform_init(&maWaveformConfig, &maWaveform);
-            AUDIO_DEBUG_CHECK(maResult == MA_SUCCESS);
+            oscillator = new Oscillator(ma_engine_get_sample_rate(rawStream->maEngine));
+            AUDIO_DEBUG_CHECK(oscillator != nullptr);
 
             maWhiteNoiseConfig = ma_noise_config_init(ma_format::ma_format_f32, 1, ma_noise_type::ma_noise_type_white, 0, VOLUME_DEFAULT);
             maResult = ma_noise_init(&maWhiteNoiseConfig, NULL, &maWhiteNoise);
@@ -1209,11 +1622,6 @@ class AudioEngine {
             maResult = ma_noise_init(&maBrownianNoiseConfig, NULL, &maBrownianNoise);
             AUDIO_DEBUG_CHECK(maResult == MA_SUCCESS);
 
-            maPulseWaveConfig = ma_pulsewave_config_init(ma_format::ma_format_f32, 1, ma_engine_get_sample_rate(rawStream->maEngine),
-                                                         PULSE_WAVE_DUTY_CYCLE_DEFAULT, VOLUME_DEFAULT, FREQUENCY_DEFAULT);
-            maResult = ma_pulsewave_init(&maPulseWaveConfig, &maPulseWave);
-            AUDIO_DEBUG_CHECK(maResult == MA_SUCCESS);
-
             noise = new NoiseGenerator(ma_engine_get_sample_rate(rawStream->maEngine));
             AUDIO_DEBUG_CHECK(noise != nullptr);
             noise->SetAmplitude(VOLUME_DEFAULT);
@@ -1226,18 +1634,17 @@ class AudioEngine {
 
             SetWaveformType(WAVEFORM_TYPE_DEFAULT);
 
-            audio_log_trace("PSG initialized @ %uHz", maWaveform.config.sampleRate);
+            audio_log_trace("PSG initialized @ %uHz", oscillator->GetSampleRate());
         }
 
         /// @brief Frees the waveform buffer and cleans up the waveform resources.
         ~PSG() {
             delete customWaveform;
             delete noise;
-            ma_pulsewave_uninit(&maPulseWave);
+            delete oscillator;
             ma_noise_uninit(&maBrownianNoise, NULL);
             ma_noise_uninit(&maPinkNoise, NULL);
             ma_noise_uninit(&maWhiteNoise, NULL);
-            ma_waveform_uninit(&maWaveform);
 
             audio_log_trace("PSG destroyed");
         }
@@ -1245,38 +1652,7 @@ class AudioEngine {
         /// @brief Sets the waveform type.
         /// @param type The waveform type. See Waveform::Type enum.
         void SetWaveformType(WaveformType waveType) {
-            switch (waveType) {
-            case WaveformType::NONE:
-                // NOP
-                break;
-
-            case WaveformType::SQUARE:
-                maResult = ma_waveform_set_type(&maWaveform, ma_waveform_type::ma_waveform_type_square);
-                break;
-
-            case WaveformType::SAWTOOTH:
-                maResult = ma_waveform_set_type(&maWaveform, ma_waveform_type::ma_waveform_type_sawtooth);
-                break;
-
-            case WaveformType::TRIANGLE:
-                maResult = ma_waveform_set_type(&maWaveform, ma_waveform_type::ma_waveform_type_triangle);
-                break;
-
-            case WaveformType::SINE:
-                maResult = ma_waveform_set_type(&maWaveform, ma_waveform_type::ma_waveform_type_sine);
-                break;
-
-            case WaveformType::NOISE_WHITE:
-            case WaveformType::NOISE_PINK:
-            case WaveformType::NOISE_BROWNIAN:
-            case WaveformType::NOISE_LFSR:
-            case WaveformType::PULSE:
-            case WaveformType::CUSTOM:
-            case WaveformType::COUNT:
-            default:
-                // NOP
-                break;
-            }
+            oscillator->SetType(waveType);
 
             waveformType = waveType;
         }
@@ -1290,10 +1666,12 @@ class AudioEngine {
                 break;
 
             case WaveformType::SQUARE:
+            case WaveformType::SQUARE_BANDLIMITED:
                 envelope.SetAttack(value);
                 break;
 
             case WaveformType::SAWTOOTH:
+            case WaveformType::SAWTOOTH_BANDLIMITED:
                 envelope.SetDecay(value);
                 break;
 
@@ -1322,7 +1700,7 @@ class AudioEngine {
                 break;
 
             case WaveformType::PULSE:
-                maResult = ma_pulsewave_set_duty_cycle(&maPulseWave, value);
+                oscillator->SetDutyCycle(value);
                 break;
 
             case WaveformType::CUSTOM:
@@ -1337,11 +1715,10 @@ class AudioEngine {
         /// @param amplitude The amplitude of the waveform.
         void SetAmplitude(double amplitude) {
             amplitude = std::clamp<double>(amplitude, VOLUME_MIN, VOLUME_MAX);
-            maResult = ma_waveform_set_amplitude(&maWaveform, amplitude);
+            oscillator->SetAmplitude(float(amplitude));
             maResult = ma_noise_set_amplitude(&maWhiteNoise, amplitude);
             maResult = ma_noise_set_amplitude(&maPinkNoise, amplitude);
             maResult = ma_noise_set_amplitude(&maBrownianNoise, amplitude);
-            maResult = ma_pulsewave_set_amplitude(&maPulseWave, amplitude);
             noise->SetAmplitude(float(amplitude));
             customWaveform->SetAmplitude(float(amplitude));
         }
@@ -2142,34 +2519,879 @@ class AudioEngine {
         }
     };
 
-    /// @brief A QB64-PE audio engine sound handle internal struct. Describes every sound the system will ever play (including raw streams).
-    struct SoundHandle {
-        /// @brief Type of sound.
-        /// NONE: No sound or internal sound whose buffer is managed by the QB64-PE audio engine.
-        /// STATIC: Static sounds that are completely managed by miniaudio.
-        /// RAW: Raw sound stream that is managed by the QB64-PE audio engine.
-        enum class Type { NONE, STATIC, RAW };
+    /// @brief An audio effect node that can be placed on the effect chain of a sound handle or on the master effect chain. Filters use the miniaudio biquad
+    /// filter nodes. Echo, reverb and the compressor are custom nodes. Parameters are changed from the program thread while the node is being processed by
+    /// the miniaudio thread, so the custom nodes keep them in atomics.
+    class Effect {
+      public:
+        /// @brief Effect types. The values are what is passed to _SNDEFFECT.
+        enum class Type : int32_t { NONE, LOWPASS, HIGHPASS, BANDPASS, PEAK, ECHO, REVERB, COMPRESSOR, COUNT };
+
+        static const auto PARAMETERS = 3;                // number of effect parameters
+        static const auto FILTER_ORDER = 2;              // low-pass, high-pass and band-pass filter order
+        static constexpr auto ECHO_DELAY_MAX = 10.0f;    // maximum echo delay in seconds
+        static constexpr auto REVERB_INPUT_GAIN = 0.03f; // reverb comb filter input gain
+        static constexpr auto COMPRESSOR_ATTACK = 0.01f; // compressor attack time in seconds
+        static constexpr auto COMPRESSOR_RELEASE = 0.1f; // compressor release time in seconds
+
+        Effect(const Effect &) = delete;
+        Effect &operator=(const Effect &) = delete;
+        Effect &operator=(Effect &&) = delete;
+        Effect(Effect &&) = delete;
+
+        /// @brief Gets the default parameters for an effect type.
+        /// @param type The effect type.
+        /// @param parameters Receives PARAMETERS values.
+        static void GetDefaultParameters(Type type, float *parameters) {
+            static const float defaults[size_t(Type::COUNT)][PARAMETERS] = {
+                {0.0f, 0.0f, 0.0f},      // NONE
+                {1000.0f, 0.0f, 0.0f},   // LOWPASS: cutoff frequency
+                {1000.0f, 0.0f, 0.0f},   // HIGHPASS: cutoff frequency
+                {1000.0f, 0.0f, 0.0f},   // BANDPASS: center frequency
+                {1000.0f, 6.0f, 0.707f}, // PEAK: center frequency, gain (dB), Q
+                {0.25f, 0.5f, 0.5f},     // ECHO: delay (seconds), feedback, wet level
+                {0.5f, 0.5f, 0.33f},     // REVERB: room size, damping, wet level
+                {-20.0f, 4.0f, 0.0f},    // COMPRESSOR: threshold (dB), ratio, makeup gain (dB)
+            };
+
+            std::copy_n(defaults[size_t(type)], PARAMETERS, parameters);
+        }
 
-        bool isUsed;                                // Is this handle in active use?
-        Type type;                                  // Type of sound (see Type enum above)
-        bool autoKill;                              // Do we need to auto-clean this sample / stream after playback is done?
-        ma_sound maSound;                           // miniaudio sound
-        ma_uint32 maFlags;                          // miniaudio flags that were used when initializing the sound
-        uint64_t bufferKey;                         // a key that will uniquely identify the data the sound will use
-        ma_audio_buffer_config maAudioBufferConfig; // miniaudio buffer configuration
-        ma_audio_buffer *maAudioBuffer;             // this is used for user created audio buffers (memory is managed by miniaudio)
-        RawStream *rawStream;                       // Raw sample frame queue
-        PSG *psg;                                   // PSG object (if any) linked to this sound
-        void *memLockOffset;                        // This is a pointer from new_mem_lock()
-        uint64_t memLockId;                         // This is mem_lock_id created by new_mem_lock()
+        /// @brief Checks if the parameters are in range for an effect type.
+        /// @param type The effect type.
+        /// @param parameters PARAMETERS values.
+        /// @param sampleRate The engine sample rate.
+        /// @return True if the parameters can be used.
+        static bool IsValid(Type type, const float *parameters, ma_uint32 sampleRate) {
+            auto nyquist = float(sampleRate) / 2.0f;
 
-        // Delete copy and move constructors and assignments
-        SoundHandle(const SoundHandle &) = delete;
-        SoundHandle &operator=(const SoundHandle &) = delete;
-        SoundHandle(SoundHandle &&) = delete;
-        SoundHandle &operator=(SoundHandle &&) = delete;
+            switch (type) {
+            case Type::LOWPASS:
+            case Type::HIGHPASS:
+            case Type::BANDPASS:
+                return parameters[0] > 0.0f && parameters[0] < nyquist;
 
-        /// @brief Just initializes some important members. 'inUse' will be set to true by CreateHandle(). This is done here, as well as slightly differently in
+            case Type::PEAK:
+                return parameters[0] > 0.0f && parameters[0] < nyquist && std::abs(parameters[1]) <= 48.0f && parameters[2] > 0.0f;
+
+            case Type::ECHO:
+                return parameters[0] > 0.0f && parameters[0] <= ECHO_DELAY_MAX && parameters[1] >= 0.0f && parameters[1] < 1.0f && parameters[2] >= 0.0f &&
+                       parameters[2] <= 1.0f;
+
+            case Type::REVERB:
+                return parameters[0] >= 0.0f && parameters[0] <= 1.0f && parameters[1] >= 0.0f && parameters[1] <= 1.0f && parameters[2] >= 0.0f &&
+                       parameters[2] <= 1.0f;
+
+            case Type::COMPRESSOR:
+                return parameters[0] <= 0.0f && parameters[0] >= -96.0f && parameters[1] >= 1.0f && std::abs(parameters[2]) <= 48.0f;
+
+            default:
+                return false;
+            }
+        }
+
+        /// @brief Creates and initializes an effect node. The node is not attached to anything.
+        /// @param pmaEngine The engine whose node graph the node will belong to.
+        /// @param type The effect type (other than NONE).
+        /// @param parameters PARAMETERS values that have been checked with IsValid().
+        /// @return The effect or nullptr on failure.
+        static Effect *Create(ma_engine *pmaEngine, Type type, const float *parameters) {
+            auto effect = new Effect(pmaEngine, type);
+
+            auto result = effect->Initialize(ma_engine_get_node_graph(pmaEngine), parameters);
+            if (result != MA_SUCCESS) {
+                audio_log_warn("Error %i: failed to initialize effect %i", result, int32_t(type));
+
+                effect->type = Type::NONE; // nothing to uninitialize
+                delete effect;
+
+                return nullptr;
+            }
+
+            audio_log_trace("Effect %i created", int32_t(type));
+
+            return effect;
+        }
+
+        ~Effect() {
+            switch (type) {
+            case Type::LOWPASS:
+                ma_lpf_node_uninit(&node.lpf, nullptr);
+                break;
+
+            case Type::HIGHPASS:
+                ma_hpf_node_uninit(&node.hpf, nullptr);
+                break;
+
+            case Type::BANDPASS:
+                ma_bpf_node_uninit(&node.bpf, nullptr);
+                break;
+
+            case Type::PEAK:
+                ma_peak_node_uninit(&node.peak, nullptr);
+                break;
+
+            case Type::ECHO:
+            case Type::REVERB:
+            case Type::COMPRESSOR:
+                ma_node_uninit(&node.custom.base, nullptr);
+                break;
+
+            default:
+                break;
+            }
+        }
+
+        Type GetType() const {
+            return type;
+        }
+
+        ma_node *GetNode() {
+            return &node;
+        }
+
+        /// @brief Gets the current parameters.
+        /// @param parameters Receives PARAMETERS values.
+        void GetParameters(float *parameters) const {
+            std::copy_n(this->parameters, PARAMETERS, parameters);
+        }
+
+        /// @brief Changes the parameters without rebuilding the node, so that the filter state (and any echo or reverb tail) is kept.
+        /// @param parameters PARAMETERS values that have been checked with IsValid().
+        /// @return False if the node must be rebuilt (the echo delay length changed).
+        bool Update(const float *parameters) {
+            if (type == Type::ECHO && GetEchoFrames(parameters[0]) != echoFrames) {
+                return false;
+            }
+
+            auto result = Configure(parameters);
+            if (result != MA_SUCCESS) {
+                audio_log_warn("Error %i: failed to update effect %i", result, int32_t(type));
+
+                return false;
+            }
+
+            return true;
+        }
+
+      private:
+        static const auto REVERB_COMBS = 4;      // comb filters per channel
+        static const auto REVERB_ALLPASSES = 2;  // all-pass filters per channel
+        static const auto REVERB_STEREO_SPREAD = 23;
+
+        /// @brief Node header used by the custom effects. miniaudio passes this back to the process callback.
+        struct CustomNode {
+            ma_node_base base; // this must be the first member
+            Effect *effect;
+        };
+
+        /// @brief A delay line used by the reverb comb and all-pass filters.
+        struct DelayLine {
+            std::vector<float> buffer;
+            size_t cursor;
+            float store; // comb filter damping state
+        };
+
+        Type type;
+        ma_uint32 channels;
+        ma_uint32 sampleRate;
+        float parameters[PARAMETERS];
+
+        union Node {
+            ma_lpf_node lpf;
+            ma_hpf_node hpf;
+            ma_bpf_node bpf;
+            ma_peak_node peak;
+            CustomNode custom;
+        } node;
+
+        // Values used by the custom nodes on the miniaudio thread
+        std::atomic<float> feedback; // echo feedback or reverb comb feedback
+        std::atomic<float> damping;  // reverb damping
+        std::atomic<float> wet;      // echo and reverb wet level
+        std::atomic<float> threshold; // compressor threshold (linear)
+        std::atomic<float> slope;     // compressor gain slope (1 / ratio - 1)
+        std::atomic<float> makeup;    // compressor makeup gain (linear)
+
+        std::vector<float> echoBuffer; // interleaved echo delay line
+        size_t echoFrames;
+        size_t echoCursor;
+        std::vector<DelayLine> combs;     // REVERB_COMBS per channel
+        std::vector<DelayLine> allpasses; // REVERB_ALLPASSES per channel
+        float envelope;                   // compressor envelope
+        float attackCoefficient;
+        float releaseCoefficient;
+
+        static void ProcessNode(ma_node *pNode, const float **ppFramesIn, ma_uint32 *pFrameCountIn, float **ppFramesOut, ma_uint32 *pFrameCountOut) {
+            (void)pFrameCountIn;
+
+            auto effect = reinterpret_cast<CustomNode *>(pNode)->effect;
+
+            switch (effect->type) {
+            case Type::ECHO:
+                effect->ProcessEcho(ppFramesIn[0], ppFramesOut[0], *pFrameCountOut);
+                break;
+
+            case Type::REVERB:
+                effect->ProcessReverb(ppFramesIn[0], ppFramesOut[0], *pFrameCountOut);
+                break;
+
+            default:
+                effect->ProcessCompressor(ppFramesIn[0], ppFramesOut[0], *pFrameCountOut);
+                break;
+            }
+        }
+
+        /// @brief Echo and reverb keep producing their tail after the input goes silent.
+        static constexpr ma_node_vtable tailNodeVtable = {ProcessNode, nullptr, 1, 1, MA_NODE_FLAG_CONTINUOUS_PROCESSING};
+        static constexpr ma_node_vtable nodeVtable = {ProcessNode, nullptr, 1, 1, 0};
+
+        Effect(ma_engine *pmaEngine, Type type) {
+            this->type = type;
+            channels = ma_engine_get_channels(pmaEngine);
+            sampleRate = ma_engine_get_sample_rate(pmaEngine);
+            std::fill_n(parameters, PARAMETERS, 0.0f);
+            node = {};
+            feedback = 0.0f;
+            damping = 0.0f;
+            wet = 0.0f;
+            threshold = 1.0f;
+            slope = 0.0f;
+            makeup = 1.0f;
+            echoFrames = 0;
+            echoCursor = 0;
+            envelope = 0.0f;
+            attackCoefficient = std::exp(-1.0f / (COMPRESSOR_ATTACK * float(sampleRate)));
+            releaseCoefficient = std::exp(-1.0f / (COMPRESSOR_RELEASE * float(sampleRate)));
+        }
+
+        size_t GetEchoFrames(float delay) const {
+            return std::max<size_t>(size_t(delay * float(sampleRate) + 0.5f), 1);
+        }
+
+        /// @brief Initializes the node for the effect type.
+        ma_result Initialize(ma_node_graph *pNodeGraph, const float *parameters) {
+            std::copy_n(parameters, PARAMETERS, this->parameters);
+
+            switch (type) {
+            case Type::LOWPASS: {
+                auto config = ma_lpf_node_config_init(channels, sampleRate, parameters[0], FILTER_ORDER);
+                return ma_lpf_node_init(pNodeGraph, &config, nullptr, &node.lpf);
+            }
+
+            case Type::HIGHPASS: {
+                auto config = ma_hpf_node_config_init(channels, sampleRate, parameters[0], FILTER_ORDER);
+                return ma_hpf_node_init(pNodeGraph, &config, nullptr, &node.hpf);
+            }
+
+            case Type::BANDPASS: {
+                auto config = ma_bpf_node_config_init(channels, sampleRate, parameters[0], FILTER_ORDER);
+                return ma_bpf_node_init(pNodeGraph, &config, nullptr, &node.bpf);
+            }
+
+            case Type::PEAK: {
+                auto config = ma_peak_node_config_init(channels, sampleRate, parameters[1], parameters[2], parameters[0]);
+                return ma_peak_node_init(pNodeGraph, &config, nullptr, &node.peak);
+            }
+
+            case Type::ECHO:
+                echoFrames = GetEchoFrames(parameters[0]);
+                echoBuffer.assign(echoFrames * channels, 0.0f);
+                break;
+
+            case Type::REVERB: {
+                // Freeverb tunings (at 44.1 kHz), the right channels get slightly longer lines to decorrelate them
+                static const size_t combTunings[REVERB_COMBS] = {1116, 1188, 1277, 1356};
+                static const size_t allpassTunings[REVERB_ALLPASSES] = {556, 441};
+
+                for (ma_uint32 c = 0; c < channels; c++) {
+                    for (auto tuning : combTunings) {
+                        combs.push_back({std::vector<float>(std::max<size_t>((tuning + c * REVERB_STEREO_SPREAD) * sampleRate / 44100, 1), 0.0f), 0, 0.0f});
+                    }
+
+                    for (auto tuning : allpassTunings) {
+                        allpasses.push_back({std::vector<float>(std::max<size_t>((tuning + c * REVERB_STEREO_SPREAD) * sampleRate / 44100, 1), 0.0f), 0, 0.0f});
+                    }
+                }
+            } break;
+
+            case Type::COMPRESSOR:
+                break;
+
+            default:
+                return MA_INVALID_ARGS;
+            }
+
+            Configure(parameters);
+
+            node.custom.effect = this;
+
+            auto config = ma_node_config_init();
+            config.vtable = type == Type::COMPRESSOR ? &nodeVtable : &tailNodeVtable;
+            config.pInputChannels = &channels;
+            config.pOutputChannels = &channels;
+
+            return ma_node_init(pNodeGraph, &config, nullptr, &node.custom.base);
+        }
+
+        /// @brief Applies parameters to an initialized node (or to the custom node values before the node is initialized).
+        ma_result Configure(const float *parameters) {
+            std::copy_n(parameters, PARAMETERS, this->parameters);
+
+            switch (type) {
+            case Type::LOWPASS: {
+                auto config = ma_lpf_config_init(ma_format_f32, channels, sampleRate, parameters[0], FILTER_ORDER);
+                return ma_lpf_node_reinit(&config, &node.lpf);
+            }
+
+            case Type::HIGHPASS: {
+                auto config = ma_hpf_config_init(ma_format_f32, channels, sampleRate, parameters[0], FILTER_ORDER);
+                return ma_hpf_node_reinit(&config, &node.hpf);
+            }
+
+            case Type::BANDPASS: {
+                auto config = ma_bpf_config_init(ma_format_f32, channels, sampleRate, parameters[0], FILTER_ORDER);
+                return ma_bpf_node_reinit(&config, &node.bpf);
+            }
+
+            case Type::PEAK: {
+                auto config = ma_peak2_config_init(ma_format_f32, channels, sampleRate, parameters[1], parameters[2], parameters[0]);
+                return ma_peak_node_reinit(&config, &node.peak);
+            }
+
+            case Type::ECHO:
+                feedback.store(parameters[1], std::memory_order_relaxed);
+                wet.store(parameters[2], std::memory_order_relaxed);
+                break;
+
+            case Type::REVERB:
+                feedback.store(0.7f + 0.28f * parameters[0], std::memory_order_relaxed); // Freeverb room size scaling
+                damping.store(0.4f * parameters[1], std::memory_order_relaxed);
+                wet.store(parameters[2], std::memory_order_relaxed);
+                break;
+
+            case Type::COMPRESSOR:
+                threshold.store(std::pow(10.0f, parameters[0] / 20.0f), std::memory_order_relaxed);
+                slope.store(1.0f / parameters[1] - 1.0f, std::memory_order_relaxed);
+                makeup.store(std::pow(10.0f, parameters[2] / 20.0f), std::memory_order_relaxed);
+                break;
+
+            default:
+                return MA_INVALID_ARGS;
+            }
+
+            return MA_SUCCESS;
+        }
+
+        /// @brief Feedback echo. The dry signal is passed through and the delayed signal is mixed in at the wet level.
+        void ProcessEcho(const float *input, float *output, ma_uint32 frameCount) {
+            auto feedback = this->feedback.load(std::memory_order_relaxed);
+            auto wet = this->wet.load(std::memory_order_relaxed);
+
+            for (ma_uint32 i = 0; i < frameCount; i++) {
+                auto line = &echoBuffer[echoCursor * channels];
+
+                for (ma_uint32 c = 0; c < channels; c++) {
+                    auto delayed = line[c];
+                    line[c] = input[c] + delayed * feedback;
+                    output[c] = input[c] + delayed * wet;
+                }
+
+                input += channels;
+                output += channels;
+                echoCursor = echoCursor + 1 == echoFrames ? 0 : echoCursor + 1;
+            }
+        }
+
+        /// @brief Schroeder / Freeverb style reverb. The mono sum feeds parallel damped comb filters followed by serial all-pass filters for each channel.
+        void ProcessReverb(const float *input, float *output, ma_uint32 frameCount) {
+            auto feedback = this->feedback.load(std::memory_order_relaxed);
+            auto damping = this->damping.load(std::memory_order_relaxed);
+            auto wet = this->wet.load(std::memory_order_relaxed);
+            auto dry = 1.0f - wet;
+            auto inputGain = REVERB_INPUT_GAIN / float(channels);
+
+            for (ma_uint32 i = 0; i < frameCount; i++) {
+                auto mono = 0.0f;
+                for (ma_uint32 c = 0; c < channels; c++) {
+                    mono += input[c];
+                }
+                mono *= inputGain;
+
+                for (ma_uint32 c = 0; c < channels; c++) {
+                    auto reverb = 0.0f;
+
+                    for (auto comb = &combs[c * REVERB_COMBS], end = comb + REVERB_COMBS; comb < end; comb++) {
+                        auto delayed = comb->buffer[comb->cursor];
+                        comb->store = delayed * (1.0f - damping) + comb->store * damping;
+                        comb->buffer[comb->cursor] = mono + comb->store * feedback;
+                        comb->cursor = comb->cursor + 1 == comb->buffer.size() ? 0 : comb->cursor + 1;
+                        reverb += delayed;
+                    }
+
+                    for (auto allpass = &allpasses[c * REVERB_ALLPASSES], end = allpass + REVERB_ALLPASSES; allpass < end; allpass++) {
+                        auto delayed = allpass->buffer[allpass->cursor];
+                        allpass->buffer[allpass->cursor] = reverb + delayed * 0.5f;
+                        allpass->cursor = allpass->cursor + 1 == allpass->buffer.size() ? 0 : allpass->cursor + 1;
+                        reverb = delayed - reverb;
+                    }
+
+                    output[c] = input[c] * dry + reverb * wet;
+                }
+
+                input += channels;
+                output += channels;
+            }
+        }
+
+        /// @brief Feed-forward peak compressor. The channels are linked so that the stereo image does not shift.
+        void ProcessCompressor(const float *input, float *output, ma_uint32 frameCount) {
+            auto threshold = this->threshold.load(std::memory_order_relaxed);
+            auto slope = this->slope.load(std::memory_order_relaxed);
+            auto makeup = this->makeup.load(std::memory_order_relaxed);
+
+            for (ma_uint32 i = 0; i < frameCount; i++) {
+                auto peak = 0.0f;
+                for (ma_uint32 c = 0; c < channels; c++) {
+                    peak = std::max(peak, std::abs(input[c]));
+                }
+
+                auto coefficient = peak > envelope ? attackCoefficient : releaseCoefficient;
+                envelope = peak + coefficient * (envelope - peak);
+
+                auto gain = envelope > threshold ? std::pow(envelope / threshold, slope) * makeup : makeup;
+
+                for (ma_uint32 c = 0; c < channels; c++) {
+                    output[c] = input[c] * gain;
+                }
+
+                input += channels;
+                output += channels;
+            }
+        }
+    };
+
+    /// @brief A fixed number of effect slots between a source node and a destination node. Empty slots are skipped when the chain is wired.
+    class EffectChain {
+      public:
+        static const auto SLOTS = 8; // number of effect slots per chain
+
+        EffectChain(const EffectChain &) = delete;
+        EffectChain &operator=(const EffectChain &) = delete;
+        EffectChain &operator=(EffectChain &&) = delete;
+        EffectChain(EffectChain &&) = delete;
+
+        EffectChain() {
+            slots.fill(nullptr);
+        }
+
+        ~EffectChain() {
+            Clear();
+        }
+
+        /// @brief Returns the effect in a slot (0 based) or nullptr if the slot is empty.
+        Effect *Get(size_t slot) const {
+            return slots[slot];
+        }
+
+        /// @brief Puts an effect in a slot, wires source -> effects -> destination and then frees the effect that was in the slot.
+        /// @param slot The slot (0 based).
+        /// @param effect The new effect. This can be nullptr to empty the slot.
+        /// @param source The node that feeds the chain (a sound or the master group).
+        /// @param destination The node that the chain feeds.
+        void Replace(size_t slot, Effect *effect, ma_node *source, ma_node *destination) {
+            auto oldEffect = slots[slot];
+            slots[slot] = effect;
+
+            // Re-attaching an output bus detaches it from its old input, so the old effect is out of the graph once this is done
+            for (auto e : slots) {
+                if (e) {
+                    ma_node_attach_output_bus(source, 0, e->GetNode(), 0);
+                    source = e->GetNode();
+                }
+            }
+            ma_node_attach_output_bus(source, 0, destination, 0);
+
+            delete oldEffect;
+        }
+
+        /// @brief Frees all effects. Use this once the source node has been uninitialized.
+        void Clear() {
+            for (auto &e : slots) {
+                delete e;
+                e = nullptr;
+            }
+        }
+
+      private:
+        std::array<Effect *, SLOTS> slots;
+    };
+
+    /// @brief Decodes frame ranges of a sound that is not completely decoded in memory, so that _MEMSOUND can be used on streamed sounds. The sound's own
+    /// data source is busy playing, so the window has a decoder of its own that outputs the same format as the sound. Every request is decoded with some
+    /// read-ahead, so that walking through a sound from start to end decodes it once and never seeks. Only the requested frames plus the read-ahead are
+    /// kept in memory.
+    class SoundWindow {
+      public:
+        static const auto READ_AHEAD_DIVISOR = 2; // read-ahead in fractions of a second
+
+        SoundWindow(const SoundWindow &) = delete;
+        SoundWindow &operator=(const SoundWindow &) = delete;
+        SoundWindow &operator=(SoundWindow &&) = delete;
+        SoundWindow(SoundWindow &&) = delete;
+
+        /// @brief Creates a window from a file on disk or from an in-memory sound file.
+        /// @param fileName The file name (used if data is NULL).
+        /// @param data The sound file data or NULL.
+        /// @param dataSize The size of data in bytes.
+        /// @param format The output sample format.
+        /// @param channels The output channel count.
+        /// @param sampleRate The output sample rate.
+        /// @return The window or nullptr if the file could not be opened.
+        static SoundWindow *Create(const std::string &fileName, const void *data, size_t dataSize, ma_format format, ma_uint32 channels,
+                                   ma_uint32 sampleRate) {
+            auto window = new SoundWindow(format, channels, sampleRate);
+
+            auto config = ma_decoder_config_init(format, channels, sampleRate);
+            config.ppCustomBackendVTables = maCustomBackendVTables;
+            config.customBackendCount = maCustomBackendVTablesCount;
+
+            auto result = data ? ma_decoder_init_memory(data, dataSize, &config, &window->decoder)
+                               : ma_decoder_init_file(fileName.c_str(), &config, &window->decoder);
+            if (result != MA_SUCCESS) {
+                audio_log_warn("Error %i: failed to open sound window decoder", result);
+
+                window->isDecoderInitialized = false;
+                delete window;
+
+                return nullptr;
+            }
+
+            // The length is 0 if the decoder cannot tell
+            if (ma_decoder_get_length_in_pcm_frames(&window->decoder, &window->lengthFrames) != MA_SUCCESS) {
+                window->lengthFrames = 0;
+            }
+
+            audio_log_trace("Sound window created (%llu frames)", (unsigned long long)window->lengthFrames);
+
+            return window;
+        }
+
+        ~SoundWindow() {
+            if (isDecoderInitialized) {
+                ma_decoder_uninit(&decoder);
+            }
+        }
+
+        /// @brief Makes the frames [startFrame, startFrame + frameCount) available. Frames already in the window are kept and the rest is decoded.
+        /// @param startFrame The first frame.
+        /// @param frameCount The number of frames.
+        /// @param frames Receives the number of frames available (this is less than frameCount near the end of the sound).
+        /// @return A pointer to the first frame or nullptr if startFrame is past the end of the sound or the frames do not fit in memory. This stays valid
+        /// until the next call.
+        const void *Get(uint64_t startFrame, uint64_t frameCount, ma_uint64 *frames) {
+            if (lengthFrames) {
+                if (startFrame >= lengthFrames) {
+                    audio_log_warn("Frame %llu is past the end of the sound", (unsigned long long)startFrame);
+                    return nullptr;
+                }
+
+                // Never allocate more than the rest of the sound
+                frameCount = std::min<uint64_t>(frameCount, lengthFrames - startFrame);
+            }
+
+            auto readAhead = uint64_t(sampleRate / READ_AHEAD_DIVISOR);
+            auto capacity = frameCount + readAhead;
+
+            if (startFrame >= firstFrame && startFrame + frameCount <= firstFrame + frameTotal) {
+                // Everything is in the window already
+            } else if (startFrame >= firstFrame && startFrame < firstFrame + frameTotal && decoderCursor == firstFrame + frameTotal) {
+                // Keep the overlap and continue decoding from where the decoder is
+                auto keep = firstFrame + frameTotal - startFrame;
+                std::memmove(buffer.data(), buffer.data() + (startFrame - firstFrame) * bytesPerFrame, keep * bytesPerFrame);
+                if (!Resize(capacity)) {
+                    return nullptr;
+                }
+                firstFrame = startFrame;
+                frameTotal = keep + Decode(buffer.data() + keep * bytesPerFrame, capacity - keep);
+            } else {
+                if (decoderCursor != startFrame) {
+                    auto result = ma_decoder_seek_to_pcm_frame(&decoder, startFrame);
+                    if (result != MA_SUCCESS) {
+                        audio_log_warn("Error %i: failed to seek sound window to frame %llu", result, (unsigned long long)startFrame);
+
+                        Reset();
+
+                        return nullptr;
+                    }
+
+                    decoderCursor = startFrame;
+                    audio_log_trace("Sound window seek to frame %llu", (unsigned long long)startFrame);
+                }
+
+                if (!Resize(capacity)) {
+                    return nullptr;
+                }
+                firstFrame = startFrame;
+                frameTotal = Decode(buffer.data(), capacity);
+            }
+
+            if (startFrame >= firstFrame + frameTotal) {
+                audio_log_warn("Frame %llu is past the end of the sound", (unsigned long long)startFrame);
+                return nullptr;
+            }
+
+            *frames = std::min(frameCount, firstFrame + frameTotal - startFrame);
+
+            return buffer.data() + (startFrame - firstFrame) * bytesPerFrame;
+        }
+
+      private:
+        ma_decoder decoder;
+        bool isDecoderInitialized;
+        ma_uint32 sampleRate;
+        ma_uint32 bytesPerFrame;
+        std::vector<uint8_t> buffer; // decoded frames
+        uint64_t firstFrame;         // sound frame index of the first frame in the buffer
+        uint64_t frameTotal;         // number of decoded frames in the buffer
+        uint64_t decoderCursor;      // sound frame index of the next frame that the decoder will output
+        ma_uint64 lengthFrames;      // length of the sound in frames (0 if unknown)
+
+        SoundWindow(ma_format format, ma_uint32 channels, ma_uint32 sampleRate) {
+            decoder = {};
+            isDecoderInitialized = true;
+            this->sampleRate = sampleRate;
+            bytesPerFrame = ma_get_bytes_per_frame(format, channels);
+            firstFrame = 0;
+            frameTotal = 0;
+            decoderCursor = 0;
+            lengthFrames = 0;
+        }
+
+        /// @brief Sizes the buffer for a number of frames. Memory is given back when a much smaller window follows a large one.
+        /// @return False if the memory could not be allocated. The window is empty then.
+        bool Resize(uint64_t frames) {
+            try {
+                if (frames > std::numeric_limits<size_t>::max() / bytesPerFrame) {
+                    throw std::length_error("window too large");
+                }
+
+                auto bytes = size_t(frames * bytesPerFrame);
+
+                buffer.resize(bytes);
+                if (buffer.capacity() > 2 * bytes) {
+                    buffer.shrink_to_fit();
+                }
+            } catch (const std::exception &e) {
+                audio_log_warn("Failed to allocate %llu frames for the sound window: %s", (unsigned long long)frames, e.what());
+
+                Reset();
+
+                return false;
+            }
+
+            return true;
+        }
+
+        /// @brief Empties the window. The decoder position is unknown after a failed seek.
+        void Reset() {
+            firstFrame = 0;
+            frameTotal = 0;
+            decoderCursor = ~uint64_t(0);
+        }
+
+        /// @brief Decodes frames at the decoder cursor.
+        uint64_t Decode(uint8_t *output, uint64_t frameCount) {
+            ma_uint64 framesRead = 0;
+
+            ma_decoder_read_pcm_frames(&decoder, output, frameCount, &framesRead); // MA_AT_END is expected near the end
+            decoderCursor += framesRead;
+
+            return framesRead;
+        }
+    };
+
+    /// @brief Mixer counters that can be queried using _SNDSTAT. These are written by the miniaudio thread (or by RenderSound() in offline mode) and read by
+    /// the program thread, so everything is a relaxed atomic.
+    struct Statistics {
+        static const auto HISTOGRAM_BUCKETS = 12;         // mixing time histogram buckets
+        static const auto HISTOGRAM_FIRST_BUCKET_US = 32; // bucket 0 counts callbacks under 32 us, each following bucket doubles and the last one is open
+        static const auto LOG_INTERVAL_MS = 1000;         // how often Update() looks for new problems to log
+
+        /// @brief Statistics that can be queried using _SNDSTAT.
+        enum class Type : int32_t { CALLBACKS, HISTOGRAM, LONGEST_CALLBACK, LATE_CALLBACKS, UNDERRUNS, OVERRUNS, VOICES, DECODE_TIME, COUNT };
+
+        std::atomic<uint64_t> callbacks;                                // the number of mixing callbacks
+        std::array<std::atomic<uint64_t>, HISTOGRAM_BUCKETS> histogram; // the number of callbacks per mixing time bucket
+        std::atomic<uint64_t> longestCallback;                          // the longest mixing time in microseconds
+        std::atomic<uint64_t> lateCallbacks;                            // callbacks that took longer than the audio they produced
+        std::atomic<uint64_t> underruns;                                // underruns of raw streams that were already destroyed
+        std::atomic<uint64_t> overruns;                                 // overruns of raw streams that were already destroyed
+        uint64_t lastLogTicks;                                          // when Update() last checked (program thread only)
+        uint64_t lastLateCallbacks;                                     // values that were last logged (program thread only)
+        uint64_t lastUnderruns;
+        uint64_t lastOverruns;
+
+        Statistics() {
+            Reset();
+        }
+
+        /// @brief Clears all counters. This is done when the engine is initialized.
+        void Reset() {
+            callbacks.store(0, std::memory_order_relaxed);
+            for (auto &bucket : histogram) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            longestCallback.store(0, std::memory_order_relaxed);
+            lateCallbacks.store(0, std::memory_order_relaxed);
+            underruns.store(0, std::memory_order_relaxed);
+            overruns.store(0, std::memory_order_relaxed);
+            lastLogTicks = 0;
+            lastLateCallbacks = lastUnderruns = lastOverruns = 0;
+        }
+
+        /// @brief Records one mixing callback.
+        /// @param duration The time it took to mix in microseconds.
+        /// @param period The duration of the mixed audio in microseconds.
+        void AddCallback(uint64_t duration, uint64_t period) {
+            size_t bucket = 0;
+            for (auto limit = uint64_t(HISTOGRAM_FIRST_BUCKET_US); bucket < HISTOGRAM_BUCKETS - 1 && duration >= limit; limit <<= 1) {
+                bucket++;
+            }
+
+            histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+            callbacks.fetch_add(1, std::memory_order_relaxed);
+
+            if (duration > period) {
+                lateCallbacks.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            // Only the mixing thread writes this, so a plain compare is enough
+            if (duration > longestCallback.load(std::memory_order_relaxed)) {
+                longestCallback.store(duration, std::memory_order_relaxed);
+            }
+        }
+
+        /// @brief Mixes audio using the engine and times it.
+        /// @param pmaEngine The engine.
+        /// @param pFramesOut Output sample frames.
+        /// @param frameCount The number of sample frames to mix.
+        /// @param pFramesRead The number of sample frames mixed (can be NULL).
+        /// @return The miniaudio result.
+        ma_result Mix(ma_engine *pmaEngine, void *pFramesOut, ma_uint64 frameCount, ma_uint64 *pFramesRead) {
+            auto start = std::chrono::steady_clock::now();
+            auto result = ma_engine_read_pcm_frames(pmaEngine, pFramesOut, frameCount, pFramesRead);
+            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+            AddCallback(uint64_t(duration), frameCount * 1000000 / ma_engine_get_sample_rate(pmaEngine));
+
+            return result;
+        }
+
+        /// @brief Replaces the miniaudio engine device callback, so that every mixing callback is timed.
+        static void OnDeviceData(ma_device *pDevice, void *pFramesOut, const void *pFramesIn, ma_uint32 frameCount) {
+            (void)pFramesIn;
+
+            statistics.Mix(reinterpret_cast<ma_engine *>(pDevice->pUserData), pFramesOut, frameCount, NULL);
+        }
+    };
+
+    /// @brief Measures how long miniaudio takes to load a sound (until it is completely decoded, or until the first pages of a stream are ready). This is
+    /// passed to miniaudio as the "done" notification, which may be signaled on a resource manager job thread after the sound handle was closed. So, it is
+    /// reference counted and freed by whoever lets go of it last.
+    struct DecodeTimer {
+        ma_async_notification_callbacks maCallbacks; // miniaudio notification callbacks (this must be the first member of our struct)
+        std::chrono::steady_clock::time_point start; // when loading started
+        std::atomic<uint64_t> elapsed;               // the loading time in microseconds (valid once isDone is true)
+        std::atomic_bool isDone;                     // set once miniaudio is done
+        std::atomic<int32_t> references;             // the sound handle and miniaudio
+
+        // Delete copy and move constructors and assignments
+        DecodeTimer(const DecodeTimer &) = delete;
+        DecodeTimer &operator=(const DecodeTimer &) = delete;
+        DecodeTimer(DecodeTimer &&) = delete;
+        DecodeTimer &operator=(DecodeTimer &&) = delete;
+
+        /// @brief Starts the timer. One reference belongs to the sound handle and the other to miniaudio.
+        DecodeTimer() {
+            maCallbacks.onSignal = OnSignal;
+            start = std::chrono::steady_clock::now();
+            elapsed.store(0, std::memory_order_relaxed);
+            isDone.store(false, std::memory_order_relaxed);
+            references.store(2, std::memory_order_relaxed);
+        }
+
+        /// @brief Drops a reference and frees the object once both owners are done with it.
+        void Release() {
+            if (references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                delete this;
+            }
+        }
+
+        /// @brief Returns the loading time. If miniaudio is still loading, then this is the time so far.
+        /// @return Time in microseconds.
+        uint64_t GetTime() const {
+            if (isDone.load(std::memory_order_acquire)) {
+                return elapsed.load(std::memory_order_relaxed);
+            }
+
+            return uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        /// @brief Called by miniaudio when the sound is loaded.
+        static void OnSignal(ma_async_notification *pNotification) {
+            auto decodeTimer = reinterpret_cast<DecodeTimer *>(pNotification);
+
+            decodeTimer->elapsed.store(
+                uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - decodeTimer->start).count()),
+                std::memory_order_relaxed);
+            decodeTimer->isDone.store(true, std::memory_order_release);
+
+            decodeTimer->Release();
+        }
+    };
+
+    /// @brief A QB64-PE audio engine sound handle internal struct. Describes every sound the system will ever play (including raw streams).
+    struct SoundHandle {
+        /// @brief Type of sound.
+        /// NONE: No sound or internal sound whose buffer is managed by the QB64-PE audio engine.
+        /// STATIC: Static sounds that are completely managed by miniaudio.
+        /// RAW: Raw sound stream that is managed by the QB64-PE audio engine.
+        enum class Type { NONE, STATIC, RAW };
+
+        /// @brief Loading state of sounds opened with the "nowait" requirement. Everything else is READY right away.
+        enum class LoadState { READY, LOADING, FAILED };
+
+        bool isUsed;                                // Is this handle in active use?
+        Type type;                                  // Type of sound (see Type enum above)
+        bool autoKill;                              // Do we need to auto-clean this sample / stream after playback is done?
+        ma_sound maSound;                           // miniaudio sound
+        ma_uint32 maFlags;                          // miniaudio flags that were used when initializing the sound
+        uint64_t bufferKey;                         // a key that will uniquely identify the data the sound will use
+        ma_audio_buffer_config maAudioBufferConfig; // miniaudio buffer configuration
+        ma_audio_buffer *maAudioBuffer;             // this is used for user created audio buffers (memory is managed by miniaudio)
+        RawStream *rawStream;                       // Raw sample frame queue
+        PSG *psg;                                   // PSG object (if any) linked to this sound
+        void *memLockOffset;                        // This is a pointer from new_mem_lock()
+        uint64_t memLockId;                         // This is mem_lock_id created by new_mem_lock()
+        int32_t id;                                 // the index of this object in the handle vector
+        SoundHandle *nextFree;                      // next handle in the free list
+        SoundHandle *nextFinished;                  // next handle in the finished sound queue
+        std::atomic_bool isFinishedQueued;          // set while the handle is in the finished sound queue
+        std::atomic<LoadState> loadState;           // set by the loader thread once a "nowait" sound is loaded
+        EffectChain effects;                        // effects between the sound and the master group (see _SNDEFFECT)
+        SoundWindow *window;                        // decoded frame range of a sound that is not completely decoded (see GetSoundMem())
+        std::string streamFileName;                 // the file that a streamed sound is read from (empty for buffer map sounds)
+        DecodeTimer *decodeTimer;                   // how long miniaudio took to load the sound (set by LoadSound())
+        uint64_t windowDecodeTime;                  // time spent decoding sound windows in microseconds
+
+        // Delete copy and move constructors and assignments
+        SoundHandle(const SoundHandle &) = delete;
+        SoundHandle &operator=(const SoundHandle &) = delete;
+        SoundHandle(SoundHandle &&) = delete;
+        SoundHandle &operator=(SoundHandle &&) = delete;
+
+        /// @brief Just initializes some important members. 'inUse' will be set to true by CreateHandle(). This is done here, as well as slightly differently in
         /// CreateHandle() for safety.
         SoundHandle() {
             isUsed = false;
@@ -2184,12 +3406,22 @@ class AudioEngine {
             psg = nullptr;
             memLockOffset = nullptr;
             memLockId = INVALID_MEM_LOCK;
+            id = -1;
+            nextFree = nullptr;
+            nextFinished = nullptr;
+            isFinishedQueued = false;
+            loadState = LoadState::READY;
+            window = nullptr;
+            decodeTimer = nullptr;
+            windowDecodeTime = 0;
         }
     };
 
     static const auto INVALID_SOUND_HANDLE_INTERNAL = -1; // this is what is returned to the caller by CreateHandle() if handle allocation fails
     static const auto INVALID_SOUND_HANDLE = 0; // this should be returned to the caller by top-level sound APIs if a handle allocation fails with a -1
     static const auto PSG_VOICES = 4;           // this is the number of PSG objects that we will use
+    static const auto OFFLINE_SAMPLE_RATE = 44100;  // default sample rate in offline mode (QB64PE_AUDIO_OFFLINE)
+    static const auto OFFLINE_RENDER_FRAMES = 1024; // offline rendering chunk size in sample frames
 
     static ma_decoding_backend_vtable *maCustomBackendVTables[]; // list of custom decoding backends
     static const size_t maCustomBackendVTablesCount;             // number of custom decoding backends
@@ -2199,13 +3431,24 @@ class AudioEngine {
     ma_resource_manager maResourceManager;              // miniaudio resource manager
     ma_engine_config maEngineConfig;                    // miniaudio engine configuration (will be used to pass in the resource manager)
     ma_engine maEngine;                                 // this is the primary miniaudio engine 'context'. Everything happens using this!
+    ma_sound_group maMasterGroup;                       // every sound is mixed here before going through the master effects to the endpoint
+    EffectChain masterEffects;                          // effects between the master group and the engine endpoint (handle 0 for _SNDEFFECT)
     ma_result maResult;                                 // this is the result of the last miniaudio operation (used for trapping errors)
     std::array<int32_t, PSG_VOICES> psgVoices;          // internal sound handles that we will use for Play() and Sound()
     int32_t internalSndRaw;                             // internal sound handle that we will use for the QB64 'handle-less' raw stream
     std::vector<SoundHandle *> soundHandles;            // this is the audio handle list used by the engine and by everything else
-    int32_t lowestFreeHandle;                           // this is the lowest handle then was recently freed. We'll start checking for free handles from here
+    std::atomic<SoundHandle *> freeHandles;             // lock-free stack of recycled handles (only CreateHandle() pops from this)
+    std::atomic<SoundHandle *> finishedHandles;         // lock-free stack of auto-kill handles that may have finished playing (drained by Update())
+    std::vector<RawStream *> rawStreams;                // all raw streams, so that Update() can feed them without scanning the handles
+    libqb_mutex *rawStreamsMutex;                       // protects rawStreams
+    std::deque<std::pair<SoundHandle *, std::string>> loadQueue; // sounds waiting to be loaded by the loader thread (handle object and file name)
+    libqb_mutex *loadMutex;                                      // protects loadQueue and loadThreadQuit
+    libqb_condvar *loadCondvar;                                  // wakes up the loader thread
+    libqb_thread *loadThread;                                    // loads "nowait" sounds (created on first use)
+    bool loadThreadQuit;                                         // tells the loader thread to exit
     BufferMap bufferMap;                                // this is used to keep track of and manage memory used by 'in-memory' sound files
     ma_vfs *vfs;                                        // this is an ma_vfs backed by the BufferMap
+    static Statistics statistics;                       // mixer counters (static, because the device callback only knows about the ma_engine)
 
     // Delete copy and move constructors and assignments
     AudioEngine(const AudioEngine &) = delete;
@@ -2220,10 +3463,17 @@ class AudioEngine {
         maResourceManager = {};
         maEngineConfig = {};
         maEngine = {};
+        maMasterGroup = {};
         maResult = ma_result::MA_SUCCESS;
         psgVoices.fill(INVALID_SOUND_HANDLE_INTERNAL);  // should not use INVALID_SOUND_HANDLE here
         internalSndRaw = INVALID_SOUND_HANDLE_INTERNAL; // should not use INVALID_SOUND_HANDLE here
-        lowestFreeHandle = 0;
+        freeHandles = nullptr;
+        finishedHandles = nullptr;
+        rawStreamsMutex = libqb_mutex_new();
+        loadMutex = libqb_mutex_new();
+        loadCondvar = libqb_condvar_new();
+        loadThread = nullptr;
+        loadThreadQuit = false;
         vfs = nullptr;
 
         Initialize();
@@ -2232,48 +3482,187 @@ class AudioEngine {
     /// @brief Safely shuts down the audio engine and releases all allocated resources.
     ~AudioEngine() {
         ShutDown();
+
+        libqb_mutex_free(rawStreamsMutex);
+        libqb_condvar_free(loadCondvar);
+        libqb_mutex_free(loadMutex);
     }
 
-    /// @brief Allocates a sound handle. It will return -1 on error. Handle 0 is used internally for Sound and Play and thus cannot be used by the user.
-    /// Basically, we go through the vector and find an object pointer were 'isUsed' is set as false and return the index. If such an object pointer is not
-    /// found, then we add a pointer to a new object at the end of the vector and return the index. We are using pointers because miniaudio keeps using stuff
-    /// from ma_sound and these cannot move in memory when the vector is resized. The handle is put-up for recycling simply by setting the 'isUsed' member to
-    /// false. Note that this means the vector will keep growing until the largest handle (index) and never shrink.
-    /// @return Returns a non-negative handle if successful.
-    int32_t CreateHandle() {
-        if (!isInitialized) {
-            return INVALID_SOUND_HANDLE_INTERNAL; // We cannot return 0 here. Since 0 is a valid internal handle
+    /// @brief Puts a handle on the free list. This can be called from the program thread and from Update().
+    /// @param soundHandle The handle object to recycle.
+    void PushFreeHandle(SoundHandle *soundHandle) {
+        auto head = freeHandles.load(std::memory_order_relaxed);
+
+        do {
+            soundHandle->nextFree = head;
+        } while (!freeHandles.compare_exchange_weak(head, soundHandle, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    /// @brief Takes a handle from the free list. Only CreateHandle() calls this, and a single consumer is what keeps the stack safe from ABA.
+    /// @return A handle object or nullptr if the free list is empty.
+    SoundHandle *PopFreeHandle() {
+        auto head = freeHandles.load(std::memory_order_acquire);
+
+        while (head && !freeHandles.compare_exchange_weak(head, head->nextFree, std::memory_order_acquire, std::memory_order_acquire)) {
         }
 
-        size_t h, vectorSize = soundHandles.size(); // Save the vector size
+        return head;
+    }
 
-        // Scan the vector starting from lowestFreeHandle
-        // This will help us quickly allocate a free handle and should be a decent optimization for SndPlayCopy()
-        for (h = lowestFreeHandle; h < vectorSize; h++) {
-            if (!soundHandles[h]->isUsed) {
-                break;
-            }
+    /// @brief Queues an auto-kill handle to be checked by Update(). This is lock-free and is called from the miniaudio thread when a sound ends.
+    /// @param soundHandle The handle object to queue.
+    void PushFinishedHandle(SoundHandle *soundHandle) {
+        if (soundHandle->isFinishedQueued.exchange(true, std::memory_order_acq_rel)) {
+            return; // already queued
         }
 
-        if (h >= vectorSize) {
-            // Scan through the entire vector and return a slot that is not being used
-            // Ideally this should execute in extremely few (if at all) scenarios
-            // Also, this loop should not execute if size is 0
-            for (h = 0; h < vectorSize; h++) {
-                if (!soundHandles[h]->isUsed) {
-                    break;
+        auto head = finishedHandles.load(std::memory_order_relaxed);
+
+        do {
+            soundHandle->nextFinished = head;
+        } while (!finishedHandles.compare_exchange_weak(head, soundHandle, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    /// @brief miniaudio end-of-sound callback for auto-kill sounds.
+    /// @param pUserData The SoundHandle object.
+    /// @param pSound The sound that ended (unused).
+    static void OnSoundEnd(void *pUserData, ma_sound *pSound) {
+        (void)pSound;
+
+        Instance().PushFinishedHandle(reinterpret_cast<SoundHandle *>(pUserData));
+    }
+
+    /// @brief Marks a handle for disposal once it finishes playing. The handle is queued right away so that Update() can pick up sounds that are already
+    /// done, and the end callback queues it again when playback reaches the end.
+    /// @param handle A sound handle.
+    void SetAutoKill(int32_t handle) {
+        soundHandles[handle]->autoKill = true;
+
+        if ((soundHandles[handle]->type == SoundHandle::Type::STATIC || soundHandles[handle]->type == SoundHandle::Type::RAW) &&
+            soundHandles[handle]->loadState.load(std::memory_order_acquire) == SoundHandle::LoadState::READY) {
+            ma_sound_set_end_callback(&soundHandles[handle]->maSound, OnSoundEnd, soundHandles[handle]);
+        }
+
+        PushFinishedHandle(soundHandles[handle]);
+    }
+
+    /// @brief Creates a raw stream and registers it so that Update() can move any backlog to the stream's ring buffer.
+    /// @param pmaSound A pointer to an ma_sound object from a QB64-PE sound handle.
+    /// @return Returns a pointer to a raw stream if successful, NULL otherwise.
+    RawStream *CreateRawStream(ma_sound *pmaSound) {
+        auto rawStream = RawStream::Create(&maEngine, pmaSound, &maMasterGroup);
+
+        if (rawStream) {
+            libqb_mutex_guard lock(rawStreamsMutex);
+
+            rawStreams.push_back(rawStream);
+        }
+
+        return rawStream;
+    }
+
+    /// @brief Unregisters and destroys a raw stream created with CreateRawStream().
+    /// @param rawStream Pointer to the raw stream (can be NULL).
+    void DestroyRawStream(RawStream *rawStream) {
+        if (rawStream) {
+            libqb_mutex_guard lock(rawStreamsMutex);
+
+            rawStreams.erase(std::remove(rawStreams.begin(), rawStreams.end(), rawStream), rawStreams.end());
+
+            // Keep the counts of closed streams for _SNDSTAT
+            statistics.underruns.fetch_add(rawStream->underruns.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            statistics.overruns.fetch_add(rawStream->overruns.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+
+        RawStream::Destroy(rawStream);
+    }
+
+    /// @brief Returns the underrun and overrun counts of all raw streams, including the ones that were already destroyed.
+    /// @return An std::pair of the underrun and overrun counts.
+    std::pair<uint64_t, uint64_t> GetRawStreamProblems() {
+        auto underruns = statistics.underruns.load(std::memory_order_relaxed);
+        auto overruns = statistics.overruns.load(std::memory_order_relaxed);
+
+        libqb_mutex_guard lock(rawStreamsMutex);
+
+        for (auto rawStream : rawStreams) {
+            underruns += rawStream->underruns.load(std::memory_order_relaxed);
+            overruns += rawStream->overruns.load(std::memory_order_relaxed);
+        }
+
+        return {underruns, overruns};
+    }
+
+    /// @brief Counts the sounds that are currently producing audio. Raw streams (including the ones used by PLAY and SOUND) are always playing, so these
+    /// only count while they have sample frames queued.
+    /// @return The number of active voices.
+    int64_t GetActiveVoices() {
+        int64_t voices = 0;
+
+        for (auto soundHandle : soundHandles) {
+            if (!soundHandle->isUsed || soundHandle->loadState.load(std::memory_order_acquire) != SoundHandle::LoadState::READY) {
+                continue;
+            }
+
+            if (soundHandle->rawStream) {
+                if (!soundHandle->rawStream->pause_ && soundHandle->rawStream->GetSampleFramesRemaining()) {
+                    voices++;
                 }
+            } else if (soundHandle->type == SoundHandle::Type::STATIC && ma_sound_is_playing(&soundHandle->maSound)) {
+                voices++;
             }
         }
 
-        if (h >= vectorSize) {
-            // If we have reached here then either the vector is empty or there are no empty slots
-            // Simply create a new SoundHandle at the back of the vector
+        return voices;
+    }
+
+    /// @brief Logs mixing problems that happened since the last call.
+    void LogNewProblems() {
+        auto lateCallbacks = statistics.lateCallbacks.load(std::memory_order_relaxed);
+        auto [underruns, overruns] = GetRawStreamProblems();
+
+        if (lateCallbacks != statistics.lastLateCallbacks) {
+            audio_log_warn("%llu mixing callback(s) took longer than the audio they produced (longest: %llu us)",
+                           (unsigned long long)(lateCallbacks - statistics.lastLateCallbacks),
+                           (unsigned long long)statistics.longestCallback.load(std::memory_order_relaxed));
+        }
+
+        if (underruns != statistics.lastUnderruns) {
+            audio_log_warn("%llu raw sound stream underrun(s)", (unsigned long long)(underruns - statistics.lastUnderruns));
+        }
+
+        if (overruns != statistics.lastOverruns) {
+            audio_log_warn("%llu raw sound stream overrun(s)", (unsigned long long)(overruns - statistics.lastOverruns));
+        }
+
+        statistics.lastLateCallbacks = lateCallbacks;
+        statistics.lastUnderruns = underruns;
+        statistics.lastOverruns = overruns;
+    }
+
+    /// @brief Allocates a sound handle. It will return -1 on error. Handle 0 is used internally for Sound and Play and thus cannot be used by the user.
+    /// Recycled handles are taken from the free list in O(1). If the free list is empty, then we add a pointer to a new object at the end of the vector and
+    /// return the index. We are using pointers because miniaudio keeps using stuff from ma_sound and these cannot move in memory when the vector is resized.
+    /// Note that this means the vector will keep growing until the largest handle (index) and never shrink.
+    /// @return Returns a non-negative handle if successful.
+    int32_t CreateHandle() {
+        if (!isInitialized) {
+            return INVALID_SOUND_HANDLE_INTERNAL; // We cannot return 0 here. Since 0 is a valid internal handle
+        }
+
+        size_t h;
+
+        auto freeHandle = PopFreeHandle();
+        if (freeHandle) {
+            h = freeHandle->id;
+        } else {
+            // The free list is empty, so simply create a new SoundHandle at the back of the vector
             auto newHandle = new SoundHandle;
 
             if (!newHandle)
                 return INVALID_SOUND_HANDLE_INTERNAL; // We cannot return 0 here. Since 0 is a valid internal handle
 
+            auto vectorSize = soundHandles.size();
             soundHandles.push_back(newHandle);
             auto newVectorSize = soundHandles.size();
 
@@ -2284,6 +3673,7 @@ class AudioEngine {
             }
 
             h = newVectorSize - 1; // The handle is simply newVectorSize - 1
+            newHandle->id = int32_t(h);
         }
 
         // Initializes a sound handle that was just allocated.
@@ -2300,28 +3690,47 @@ class AudioEngine {
         soundHandles[h]->psg = nullptr;
         soundHandles[h]->memLockId = INVALID_MEM_LOCK;
         soundHandles[h]->memLockOffset = nullptr;
+        soundHandles[h]->loadState = SoundHandle::LoadState::READY;
+        soundHandles[h]->window = nullptr;
+        soundHandles[h]->streamFileName.clear();
+        soundHandles[h]->decodeTimer = nullptr;
+        soundHandles[h]->windowDecodeTime = 0;
         soundHandles[h]->isUsed = true;
 
-        lowestFreeHandle = h + 1; // Set lowestFreeHandle to allocated handle + 1
-
         return int32_t(h);
     }
 
+    /// @brief Puts a handle that holds no resources up for recycling.
+    /// @param handle A sound handle.
+    void RecycleHandle(int32_t handle) {
+        soundHandles[handle]->isUsed = false;
+        soundHandles[handle]->type = SoundHandle::Type::NONE;
+
+        if (soundHandles[handle]->decodeTimer) {
+            soundHandles[handle]->decodeTimer->Release();
+            soundHandles[handle]->decodeTimer = nullptr;
+        }
+
+        PushFreeHandle(soundHandles[handle]);
+    }
+
     /// @brief Frees and unloads an open sound. If the sound is playing or looping, it will be stopped. If the sound is a stream of raw samples then it is
-    /// stopped and freed. Finally the handle is invalidated and put-up for recycling. If the handle being freed is lower than 'lowestFreeHandle' then this
-    /// saves the handle to 'lowestFreeHandle'.
+    /// stopped and freed. Finally the handle is invalidated and put-up for recycling.
     /// @param handle A sound handle.
     void ReleaseHandle(int32_t handle) {
         if (isInitialized && handle >= 0 && handle < soundHandles.size() && soundHandles[handle]->isUsed) {
-            // Free any initialized miniaudio sound
-            if (soundHandles[handle]->type == SoundHandle::Type::STATIC) {
+            // Free any initialized miniaudio sound ("nowait" sounds that are still loading or failed to load do not have one)
+            if (soundHandles[handle]->type == SoundHandle::Type::STATIC && soundHandles[handle]->loadState == SoundHandle::LoadState::READY) {
                 ma_sound_uninit(&soundHandles[handle]->maSound);
             }
 
             // Free any initialized raw stream
-            RawStream::Destroy(soundHandles[handle]->rawStream);
+            DestroyRawStream(soundHandles[handle]->rawStream);
             soundHandles[handle]->rawStream = nullptr;
 
+            // Free any effects (the sound is no longer feeding them)
+            soundHandles[handle]->effects.Clear();
+
             // Free any initialized PSG
             delete soundHandles[handle]->psg;
             soundHandles[handle]->psg = nullptr;
@@ -2339,28 +3748,33 @@ class AudioEngine {
                 soundHandles[handle]->memLockOffset = nullptr;
             }
 
+            // Free any sound window (this may be reading from the buffer below)
+            delete soundHandles[handle]->window;
+            soundHandles[handle]->window = nullptr;
+
             // Release buffer added by _SNDOPEN
             if (soundHandles[handle]->bufferKey) {
                 bufferMap.ReleaseBuffer(soundHandles[handle]->bufferKey);
                 soundHandles[handle]->bufferKey = 0;
             }
 
-            // Now simply set the 'isUsed' member to false so that the handle can be recycled
-            soundHandles[handle]->isUsed = false;
-            soundHandles[handle]->type = SoundHandle::Type::NONE;
-
-            // Save the free handle to lowestFreeHandle if it is lower than lowestFreeHandle
-            if (handle < lowestFreeHandle) {
-                lowestFreeHandle = handle;
-            }
+            // Now put the handle on the free list so that it can be recycled
+            RecycleHandle(handle);
         }
     }
 
-    /// @brief Checks if a user sound handle is valid.
+    /// @brief Checks if a user sound handle is open. The sound may still be loading in the background.
+    /// @param handle A sound handle.
+    /// @return Returns true if the handle is open.
+    bool IsHandleOpen(int32_t handle) {
+        return handle > 0 && handle < int32_t(soundHandles.size()) && soundHandles[handle]->isUsed && !soundHandles[handle]->autoKill;
+    }
+
+    /// @brief Checks if a user sound handle is valid and the sound is ready to be used.
     /// @param handle A sound handle.
     /// @return Returns true if the handle is valid.
     bool IsHandleValid(int32_t handle) {
-        return handle > 0 && handle < int32_t(soundHandles.size()) && soundHandles[handle]->isUsed && !soundHandles[handle]->autoKill;
+        return IsHandleOpen(handle) && soundHandles[handle]->loadState.load(std::memory_order_acquire) == SoundHandle::LoadState::READY;
     }
 
     /// @brief Initializes the first PSG object and it's RawStream object. This only happens once. Subsequent calls to this will return true.
@@ -2414,7 +3828,7 @@ class AudioEngine {
                 // Special case: create and kickstart the primary raw stream and PSG if it is not already
                 audio_log_trace("Creating rawStream object for primary PSG");
 
-                soundHandles[psgVoices[0]]->rawStream = RawStream::Create(&maEngine, &soundHandles[psgVoices[0]]->maSound);
+                soundHandles[psgVoices[0]]->rawStream = CreateRawStream(&soundHandles[psgVoices[0]]->maSound);
 
                 if (!soundHandles[psgVoices[0]]->rawStream) {
                     audio_log_warn("Failed to create rawStream object for primary PSG");
@@ -2433,7 +3847,7 @@ class AudioEngine {
                         audio_log_warn("Failed to create primary PSG object");
 
                         // Cleanup
-                        RawStream::Destroy(soundHandles[psgVoices[0]]->rawStream);
+                        DestroyRawStream(soundHandles[psgVoices[0]]->rawStream);
                         soundHandles[psgVoices[0]]->rawStream = nullptr;
                         soundHandles[psgVoices[0]]->type = SoundHandle::Type::NONE;
 
@@ -2533,12 +3947,37 @@ class AudioEngine {
         maEngineConfig = ma_engine_config_init();
         maEngineConfig.pResourceManager = &maResourceManager;
 
+        // In offline mode there is no playback device and the mix is only produced when the program calls _SNDRENDER
+        auto offline = getenv("QB64PE_AUDIO_OFFLINE");
+        if (offline && *offline && strcmp(offline, "0")) {
+            auto sampleRate = atoi(offline);
+
+            maEngineConfig.noDevice = MA_TRUE;
+            maEngineConfig.channels = 2;
+            maEngineConfig.sampleRate = sampleRate >= ma_standard_sample_rate_min && sampleRate <= ma_standard_sample_rate_max ? sampleRate : OFFLINE_SAMPLE_RATE;
+
+            audio_log_info("Offline audio rendering enabled");
+        } else {
+            maEngineConfig.dataCallback = Statistics::OnDeviceData; // time every mixing callback
+        }
+
+        statistics.Reset();
+
         // Attempt to initialize with miniaudio defaults
         maResult = ma_engine_init(&maEngineConfig, &maEngine);
         // If failed, then set the global flag so that we don't attempt to initialize again
         if (maResult != MA_SUCCESS) {
             ma_resource_manager_uninit(&maResourceManager);
-            audio_log_warn("miniaudio initialization failed");
+            audio_log_warn("miniaudio initialization failed");
+            return;
+        }
+
+        // All sounds go to the master group so that master effects can be placed between it and the endpoint
+        maResult = ma_sound_group_init(&maEngine, MA_SOUND_FLAG_NO_PITCH | MA_SOUND_FLAG_NO_SPATIALIZATION, NULL, &maMasterGroup);
+        if (maResult != MA_SUCCESS) {
+            ma_engine_uninit(&maEngine);
+            ma_resource_manager_uninit(&maResourceManager);
+            audio_log_warn("Failed to initialize master sound group");
             return;
         }
 
@@ -2560,6 +3999,9 @@ class AudioEngine {
     /// @brief Shuts down the audio engine and frees any resources used.
     void ShutDown() {
         if (isInitialized) {
+            // Stop loading sounds in the background
+            StopLoadThread();
+
             // Shut down all PSGs
             ShutDownPSGs();
 
@@ -2571,17 +4013,40 @@ class AudioEngine {
 
             // Now that all sounds are closed and SoundHandle objects are freed, clear the vector
             soundHandles.clear();
+            freeHandles = nullptr;
+            finishedHandles = nullptr;
 
             // Invalidate internal handles
             psgVoices.fill(INVALID_SOUND_HANDLE_INTERNAL);
             internalSndRaw = INVALID_SOUND_HANDLE_INTERNAL;
 
+            // Free the master effects and the master group
+            masterEffects.Clear();
+            ma_sound_group_uninit(&maMasterGroup);
+
             // Shutdown miniaudio
             ma_engine_uninit(&maEngine);
 
+            // All raw streams are gone now, so their counts are in the totals
+            std::string histogram;
+            for (auto &bucket : statistics.histogram) {
+                histogram += ' ' + std::to_string(bucket.load(std::memory_order_relaxed));
+            }
+
+            audio_log_info("Mixer: %llu callback(s), %llu late, longest: %llu us, raw stream underruns: %llu, overruns: %llu",
+                           (unsigned long long)statistics.callbacks.load(std::memory_order_relaxed),
+                           (unsigned long long)statistics.lateCallbacks.load(std::memory_order_relaxed),
+                           (unsigned long long)statistics.longestCallback.load(std::memory_order_relaxed),
+                           (unsigned long long)statistics.underruns.load(std::memory_order_relaxed),
+                           (unsigned long long)statistics.overruns.load(std::memory_order_relaxed));
+            audio_log_info("Mixing time histogram (%d us buckets, doubling):%s", Statistics::HISTOGRAM_FIRST_BUCKET_US, histogram.c_str());
+
             // Shutdown the miniaudio resource manager
             ma_resource_manager_uninit(&maResourceManager);
 
+            // All MIDI decoders are gone now, so write the cache files that they left in the queue
+            MIDICache_Finish();
+
             audio_log_info("Audio engine shutdown");
 
             // Destroy VFS
@@ -2819,6 +4284,166 @@ class AudioEngine {
         return ma_engine_get_sample_rate(&maEngine);
     }
 
+    /// @brief Initializes the ma_sound of a handle using the resource manager and starts timing the load.
+    /// @param soundHandle The sound handle object.
+    /// @param fileName The file name or the buffer map key as a string.
+    /// @return MA_SUCCESS if the sound was initialized.
+    ma_result InitSoundFromFile(SoundHandle *soundHandle, const char *fileName) {
+        soundHandle->decodeTimer = new DecodeTimer;
+
+        auto maSoundConfig = ma_sound_config_init_2(&maEngine);
+        maSoundConfig.pFilePath = fileName;
+        maSoundConfig.flags = soundHandle->maFlags;
+        maSoundConfig.pInitialAttachment = &maMasterGroup;
+        maSoundConfig.initNotifications.done.pNotification = soundHandle->decodeTimer; // signaled when loading is done or has failed
+
+        return ma_sound_init_ex(&maEngine, &maSoundConfig, &soundHandle->maSound);
+    }
+
+    /// @brief Initializes the ma_sound of a handle from a file or from a buffer that is already in the buffer map. This is used by OpenSound() and by the
+    /// loader thread.
+    /// @param soundHandle The sound handle object. The buffer key is saved here and is released along with the handle.
+    /// @param fileName The file name or the buffer map key as a string (if isBufferKey is true).
+    /// @param isBufferKey True if fileName is a buffer map key.
+    /// @return MA_SUCCESS if the sound was loaded.
+    ma_result LoadSound(SoundHandle *soundHandle, const std::string &fileName, bool isBufferKey) {
+        if (isBufferKey || soundHandle->maFlags & MA_SOUND_FLAG_STREAM) {
+            audio_log_trace("%s sound '%s'", isBufferKey ? "Loading" : "Streaming", fileName.c_str());
+
+            if (!isBufferKey) {
+                // Save the absolute path, so that _MEMSOUND ranges still read the same file after CHDIR
+                soundHandle->streamFileName = FS_GetFQN(fileName.c_str());
+            }
+
+            return InitSoundFromFile(soundHandle, fileName.c_str());
+        }
+
+        audio_log_trace("Loading sound from file '%s'", fileName.c_str());
+
+        // If this file is already open and has not changed, then simply share its buffer
+        // This also makes miniaudio reuse the decoded sound data because the resource manager file name is the same
+        // The absolute path is used, so that a relative name opened again after CHDIR does not match a different file
+        AudioFileInfo fileInfo;
+        auto hasFileInfo = AudioFile_GetInfo(fileName.c_str(), &fileInfo);
+        auto fullPath = hasFileInfo ? FS_GetFQN(fileName.c_str()) : std::string();
+
+        if (hasFileInfo) {
+            soundHandle->bufferKey = bufferMap.AcquireFileBuffer(fullPath, fileInfo);
+        }
+
+        if (soundHandle->bufferKey) {
+            audio_log_trace("Sharing already loaded sound data");
+        } else {
+            auto contents = AudioFile_Load<std::vector<uint8_t>>(fileName.c_str());
+
+            if (contents.empty()) {
+                audio_log_warn("Failed to open sound file '%s'", fileName.c_str());
+
+                return MA_DOES_NOT_EXIST;
+            }
+
+            audio_log_trace("Sound length: %zu", contents.size());
+
+            // Make a unique key and save it
+            auto key = std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char *>(contents.data()), contents.size()));
+
+            // Make a copy of the buffer
+            if (!bufferMap.AddBuffer(std::move(contents), key)) {
+                audio_log_warn("Failed to add buffer to buffer map");
+
+                return MA_OUT_OF_MEMORY;
+            }
+
+            soundHandle->bufferKey = key;
+
+            if (hasFileInfo) {
+                bufferMap.SetFileKey(fullPath, fileInfo, key);
+            }
+        }
+
+        // Create the ma_sound using the buffer key as the file name
+        return InitSoundFromFile(soundHandle, std::to_string(soundHandle->bufferKey).c_str());
+    }
+
+    /// @brief Loads queued "nowait" sounds. miniaudio still does the decoding on the resource manager job thread.
+    /// @param arg The audio engine.
+    static void LoadThread(void *arg) {
+        auto engine = reinterpret_cast<AudioEngine *>(arg);
+
+        audio_log_trace("Loader thread started");
+
+        while (true) {
+            std::pair<SoundHandle *, std::string> request;
+
+            {
+                libqb_mutex_guard lock(engine->loadMutex);
+
+                while (engine->loadQueue.empty() && !engine->loadThreadQuit) {
+                    libqb_condvar_wait(engine->loadCondvar, engine->loadMutex);
+                }
+
+                if (engine->loadThreadQuit) {
+                    break;
+                }
+
+                request = std::move(engine->loadQueue.front());
+                engine->loadQueue.pop_front();
+            }
+
+            auto soundHandle = request.first;
+            auto result = engine->LoadSound(soundHandle, request.second, soundHandle->bufferKey != 0);
+
+            if (result != MA_SUCCESS) {
+                audio_log_warn("Error %i: failed to load sound in the background", result);
+            }
+
+            // This publishes the initialized ma_sound to the program thread
+            soundHandle->loadState.store(result == MA_SUCCESS ? SoundHandle::LoadState::READY : SoundHandle::LoadState::FAILED, std::memory_order_release);
+        }
+
+        audio_log_trace("Loader thread stopped");
+    }
+
+    /// @brief Queues a sound for the loader thread. The thread is started on first use.
+    /// @param soundHandle The sound handle object.
+    /// @param fileName The file name or the buffer map key as a string (if the handle already has a buffer key).
+    void QueueLoadSound(SoundHandle *soundHandle, std::string &&fileName) {
+        soundHandle->loadState = SoundHandle::LoadState::LOADING;
+
+        if (!loadThread) {
+            loadThreadQuit = false;
+            loadThread = libqb_thread_new();
+            libqb_thread_start(loadThread, LoadThread, this);
+        }
+
+        libqb_mutex_guard lock(loadMutex);
+
+        loadQueue.emplace_back(soundHandle, std::move(fileName));
+        libqb_condvar_signal(loadCondvar);
+    }
+
+    /// @brief Stops the loader thread. Sounds that were not loaded yet are marked as failed.
+    void StopLoadThread() {
+        if (loadThread) {
+            {
+                libqb_mutex_guard lock(loadMutex);
+
+                loadThreadQuit = true;
+                libqb_condvar_signal(loadCondvar);
+            }
+
+            libqb_thread_join(loadThread);
+            libqb_thread_free(loadThread);
+            loadThread = nullptr;
+
+            for (auto &request : loadQueue) {
+                request.first->loadState = SoundHandle::LoadState::FAILED;
+            }
+
+            loadQueue.clear();
+        }
+    }
+
     /// @brief Loads a sound file into memory and returns a LONG handle value above 0.
     /// @param qbsFileName The is the pathname for the sound file. This can be any format that miniaudio or a miniaudio plugin supports.
     /// @param qbsRequirements This is leftover from the old QB64-SDL days. But we use this to pass some parameters like 'stream'.
@@ -2838,6 +4463,7 @@ class AudioEngine {
         soundHandles[handle]->maFlags |= MA_SOUND_FLAG_DECODE;               // set the sound to decode completely first before playing (QB64 default)
         soundHandles[handle]->maFlags |= MA_SOUND_FLAG_ASYNC;                // set the sound to decode asynchronously by default
         auto fromMemory = false;                                             // we'll assume we are loading the sound from disk
+        auto noWait = false;                                                 // we'll wait for the sound to load by default
 
         audio_log_trace("Sound set to fully decode asynchronously");
 
@@ -2869,66 +4495,50 @@ class AudioEngine {
                 fromMemory = true;
                 audio_log_trace("Sound will be loaded from memory");
             }
+
+            // Check if the user does not want to wait for the sound to load
+            if (requirements.find("nowait") != std::string::npos) {
+                noWait = true;
+                audio_log_trace("Sound will be loaded in the background");
+            }
         }
 
+        std::string fileName;
+
         // Load the file from file or memory based on the requirements string
         if (fromMemory) {
-            // Make a unique key and save it
-            soundHandles[handle]->bufferKey =
-                std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char *>(qbsFileName->chr), qbsFileName->len));
+            // Make a unique key
+            auto key = std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char *>(qbsFileName->chr), qbsFileName->len));
 
             // Make a copy of the buffer
-            if (!bufferMap.AddBuffer(qbsFileName->chr, qbsFileName->len, soundHandles[handle]->bufferKey)) {
+            if (!bufferMap.AddBuffer(qbsFileName->chr, qbsFileName->len, key)) {
                 audio_log_warn("Failed to add buffer to buffer map");
 
                 goto handle_cleanup;
             }
 
-            // Convert the buffer key to a string
-            auto fname = std::to_string(soundHandles[handle]->bufferKey);
+            soundHandles[handle]->bufferKey = key; // save the key so that the buffer is released with the handle
 
-            // Create the ma_sound
-            maResult = ma_sound_init_from_file(&maEngine, fname.c_str(), soundHandles[handle]->maFlags, NULL, NULL, &soundHandles[handle]->maSound);
+            // Convert the buffer key to a string
+            fileName = std::to_string(key);
         } else {
-            std::string fileName(reinterpret_cast<char const *>(qbsFileName->chr), qbsFileName->len);
-
-            if (soundHandles[handle]->maFlags & MA_SOUND_FLAG_STREAM) {
-                audio_log_trace("Streaming sound from file '%s'", fileName.c_str());
-
-                maResult = ma_sound_init_from_file(&maEngine, fileName.c_str(), soundHandles[handle]->maFlags, NULL, NULL,
-                                                   &soundHandles[handle]->maSound); // create the ma_sound
-            } else {
-                audio_log_trace("Loading sound from file '%s'", fileName.c_str());
-
-                auto contents = AudioFile_Load<std::vector<uint8_t>>(fileName.c_str());
-
-                if (contents.empty()) {
-                    audio_log_warn("Failed to open sound file '%s'", fileName.c_str());
-
-                    goto handle_cleanup;
-                }
-
-                audio_log_trace("Sound length: %zu", contents.size());
-
-                // Make a unique key and save it
-                soundHandles[handle]->bufferKey =
-                    std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char *>(contents.data()), contents.size()));
-
-                // Make a copy of the buffer
-                if (!bufferMap.AddBuffer(std::move(contents), soundHandles[handle]->bufferKey)) {
-                    audio_log_warn("Failed to add buffer to buffer map");
+            fileName.assign(reinterpret_cast<char const *>(qbsFileName->chr), qbsFileName->len);
+        }
 
-                    goto handle_cleanup;
-                }
+        if (noWait) {
+            // The handle is returned right away. _SNDREADY tells when the sound can be used
+            // The path is made absolute here, because the program may change the current directory before the loader thread gets to it
+            if (!fromMemory) {
+                fileName = FS_GetFQN(fileName.c_str());
+            }
 
-                // Convert the buffer key to a string
-                auto fname = std::to_string(soundHandles[handle]->bufferKey);
+            QueueLoadSound(soundHandles[handle], std::move(fileName));
 
-                // Create the ma_sound
-                maResult = ma_sound_init_from_file(&maEngine, fname.c_str(), soundHandles[handle]->maFlags, NULL, NULL, &soundHandles[handle]->maSound);
-            }
+            return handle;
         }
 
+        maResult = LoadSound(soundHandles[handle], fileName, fromMemory);
+
         // If the sound failed to initialize, then free the handle and return INVALID_SOUND_HANDLE
         if (maResult != MA_SUCCESS) {
             audio_log_warn("Error %i: failed to open sound", maResult);
@@ -2941,24 +4551,66 @@ class AudioEngine {
         return handle;
 
     handle_cleanup:
-        soundHandles[handle]->isUsed = false;
+        if (soundHandles[handle]->bufferKey) {
+            bufferMap.ReleaseBuffer(soundHandles[handle]->bufferKey);
+            soundHandles[handle]->bufferKey = 0;
+        }
+
+        RecycleHandle(handle);
 
         return AudioEngine::INVALID_SOUND_HANDLE;
     }
 
+    /// @brief Returns the loading state of a sound. Sounds opened with the "nowait" requirement are loaded in the background. Sounds that are decoded
+    /// asynchronously (the default) are reported as loading until they are completely decoded.
+    /// @param handle A sound handle.
+    /// @return -1 if the sound is ready, 0 if it is still loading or 1 if loading failed (or the handle is invalid).
+    int32_t GetSoundLoadState(int32_t handle) {
+        if (!isInitialized || !IsHandleOpen(handle)) {
+            return 1;
+        }
+
+        switch (soundHandles[handle]->loadState.load(std::memory_order_acquire)) {
+        case SoundHandle::LoadState::LOADING:
+            return 0;
+
+        case SoundHandle::LoadState::FAILED:
+            return 1;
+
+        default:
+            break;
+        }
+
+        // Sounds from _SNDOPEN are resource manager data sources and may still be decoding
+        if (soundHandles[handle]->type == SoundHandle::Type::STATIC && !soundHandles[handle]->maAudioBuffer) {
+            auto result = ma_resource_manager_data_source_result(
+                reinterpret_cast<ma_resource_manager_data_source *>(ma_sound_get_data_source(&soundHandles[handle]->maSound)));
+
+            if (result == MA_BUSY) {
+                return 0;
+            }
+
+            if (result != MA_SUCCESS) {
+                return 1;
+            }
+        }
+
+        return QB_TRUE;
+    }
+
     /// @brief Frees and unloads an open sound.
     /// If the sound is playing, it'll let it finish. Looping sounds will loop until the program is closed.
     /// If the sound is a stream of raw samples then any remaining samples pending for playback will be sent to miniaudio and then the handle will be freed.
     /// @param handle A valid sound handle.
     void CloseSound(int32_t handle) {
-        if (isInitialized && IsHandleValid(handle)) {
+        if (isInitialized && IsHandleOpen(handle)) {
             if (soundHandles[handle]->rawStream) {
                 soundHandles[handle]->rawStream->Pause(false); // unpause the stream
                 soundHandles[handle]->rawStream->stop = true;  // signal miniaudio thread that we are going to end playback
             }
 
-            // Simply set the autokill flag to true and let the sound loop handle disposing the sound
-            soundHandles[handle]->autoKill = true;
+            // Simply set the autokill flag to true and let Update() dispose the sound once it is done
+            SetAutoKill(handle);
         }
     }
 
@@ -3001,11 +4653,12 @@ class AudioEngine {
 
             // Initialize a new copy of the sound
             maResult =
-                ma_sound_init_copy(&maEngine, &soundHandles[src_handle]->maSound, soundHandles[dst_handle]->maFlags, NULL, &soundHandles[dst_handle]->maSound);
+                ma_sound_init_copy(&maEngine, &soundHandles[src_handle]->maSound, soundHandles[dst_handle]->maFlags, &maMasterGroup,
+                                              &soundHandles[dst_handle]->maSound);
 
             // If the sound failed to copy, then free the handle and return INVALID_SOUND_HANDLE
             if (maResult != MA_SUCCESS) {
-                soundHandles[dst_handle]->isUsed = false;
+                RecycleHandle(dst_handle);
                 audio_log_warn("Error %i: failed to copy sound", maResult);
 
                 return AudioEngine::INVALID_SOUND_HANDLE;
@@ -3069,8 +4722,8 @@ class AudioEngine {
                 ma_sound_set_pan(&soundHandles[dst_handle]->maSound, x);                           // Just use stereo panning
             }
 
-            PlaySound(dst_handle);                     // play the sound
-            soundHandles[dst_handle]->autoKill = true; // must be set after PlaySound
+            PlaySound(dst_handle);   // play the sound
+            SetAutoKill(dst_handle); // must be set after PlaySound
         }
     }
 
@@ -3099,8 +4752,8 @@ class AudioEngine {
             if (passed & 2)
                 ma_sound_set_volume(&soundHandles[handle]->maSound, volume);
 
-            PlaySound(handle);                     // play the sound
-            soundHandles[handle]->autoKill = true; // must be set after PlaySound
+            PlaySound(handle);   // play the sound
+            SetAutoKill(handle); // must be set after PlaySound
         }
     }
 
@@ -3208,6 +4861,86 @@ class AudioEngine {
         }
     }
 
+    /// @brief Places, changes or removes an effect on the effect chain of a sound or on the master effect chain. Changing the parameters of an effect that
+    /// is already in the slot keeps its state, so this can be used to sweep a filter while the sound is playing.
+    /// @param handle A sound handle or 0 for the master effect chain (this affects every sound, including SOUND and PLAY).
+    /// @param slot The effect slot (1 to EffectChain::SLOTS). Effects are applied in slot order.
+    /// @param type The effect type (see Effect::Type). NONE empties the slot.
+    /// @param param1 First effect parameter (optional).
+    /// @param param2 Second effect parameter (optional).
+    /// @param param3 Third effect parameter (optional).
+    /// @param passed Optional parameter flags.
+    void SetSoundEffect(int32_t handle, int32_t slot, int32_t type, float param1, float param2, float param3, int32_t passed) {
+        if (is_error_pending()) {
+            return;
+        }
+
+        if (slot < 1 || slot > EffectChain::SLOTS || type < int32_t(Effect::Type::NONE) || type >= int32_t(Effect::Type::COUNT)) {
+            error(QB_ERROR_ILLEGAL_FUNCTION_CALL);
+
+            return;
+        }
+
+        EffectChain *chain;
+        ma_node *source;
+
+        if (!isInitialized) {
+            return;
+        } else if (handle == 0) {
+            chain = &masterEffects;
+            source = &maMasterGroup;
+        } else if (IsHandleValid(handle) &&
+                   (soundHandles[handle]->type == AudioEngine::SoundHandle::Type::STATIC || soundHandles[handle]->type == AudioEngine::SoundHandle::Type::RAW)) {
+            chain = &soundHandles[handle]->effects;
+            source = &soundHandles[handle]->maSound;
+        } else {
+            return;
+        }
+
+        auto destination = handle ? &maMasterGroup : ma_engine_get_endpoint(&maEngine);
+        auto effectType = Effect::Type(type);
+        auto effect = chain->Get(slot - 1);
+
+        if (effectType == Effect::Type::NONE) {
+            if (effect) {
+                chain->Replace(slot - 1, nullptr, source, destination);
+            }
+
+            return;
+        }
+
+        // Parameters that are not passed keep their current values (or get the defaults for a new effect)
+        float parameters[Effect::PARAMETERS];
+        if (effect && effect->GetType() == effectType) {
+            effect->GetParameters(parameters);
+        } else {
+            effect = nullptr;
+            Effect::GetDefaultParameters(effectType, parameters);
+        }
+
+        if (passed & 1)
+            parameters[0] = param1;
+        if (passed & 2)
+            parameters[1] = param2;
+        if (passed & 4)
+            parameters[2] = param3;
+
+        if (!Effect::IsValid(effectType, parameters, ma_engine_get_sample_rate(&maEngine))) {
+            error(QB_ERROR_ILLEGAL_FUNCTION_CALL);
+
+            return;
+        }
+
+        if (effect && effect->Update(parameters)) {
+            return;
+        }
+
+        effect = Effect::Create(&maEngine, effectType, parameters);
+        if (effect) {
+            chain->Replace(slot - 1, effect, source, destination);
+        }
+    }
+
     /// @brief Returns the length in seconds of a loaded sound using a sound handle.
     /// @param handle A sound handle.
     /// @return Returns the length of a sound in seconds.
@@ -3328,9 +5061,11 @@ class AudioEngine {
         soundHandles[handle]->type = AudioEngine::SoundHandle::Type::RAW;
 
         // Create the raw sound object
-        soundHandles[handle]->rawStream = AudioEngine::RawStream::Create(&maEngine, &soundHandles[handle]->maSound);
-        if (!soundHandles[handle]->rawStream)
+        soundHandles[handle]->rawStream = CreateRawStream(&soundHandles[handle]->maSound);
+        if (!soundHandles[handle]->rawStream) {
+            RecycleHandle(handle);
             return AudioEngine::INVALID_SOUND_HANDLE;
+        }
 
         return handle;
     }
@@ -3508,37 +5243,145 @@ class AudioEngine {
         maResult = ma_audio_buffer_alloc_and_init(&soundHandles[handle]->maAudioBufferConfig, &soundHandles[handle]->maAudioBuffer);
         if (maResult != MA_SUCCESS) {
             audio_log_warn("Error %i: failed to initialize audio buffer", maResult);
-            soundHandles[handle]->isUsed = false;
+            RecycleHandle(handle);
             return AudioEngine::INVALID_SOUND_HANDLE;
         }
 
         // Create a ma_sound from the ma_audio_buffer
         maResult =
-            ma_sound_init_from_data_source(&maEngine, soundHandles[handle]->maAudioBuffer, soundHandles[handle]->maFlags, NULL, &soundHandles[handle]->maSound);
+            ma_sound_init_from_data_source(&maEngine, soundHandles[handle]->maAudioBuffer, soundHandles[handle]->maFlags, &maMasterGroup,
+                                           &soundHandles[handle]->maSound);
         if (maResult != MA_SUCCESS) {
             audio_log_warn("Error %i: failed to initialize data source", maResult);
             ma_audio_buffer_uninit_and_free(soundHandles[handle]->maAudioBuffer);
             soundHandles[handle]->maAudioBuffer = nullptr;
-            soundHandles[handle]->isUsed = false;
+            RecycleHandle(handle);
+            return AudioEngine::INVALID_SOUND_HANDLE;
+        }
+
+        return handle;
+    }
+
+    /// @brief Mixes the next frames of everything that is playing into a new stereo 32-bit sound at the engine sample rate. This only works in offline mode
+    /// (QB64PE_AUDIO_OFFLINE), where the engine does not have a device and the program pulls the mix as fast as it can be computed.
+    /// @param frames The number of sample frames to render.
+    /// @return A new sound handle (like _SNDNEW) or 0 on failure.
+    int32_t RenderSound(uint32_t frames) {
+        if (!isInitialized || ma_engine_get_device(&maEngine)) {
+            audio_log_warn("Audio rendering is only available in offline mode");
             return AudioEngine::INVALID_SOUND_HANDLE;
         }
 
+        auto handle = CreateSound(frames, 2, 32, 0, 3);
+        if (handle < 1) {
+            return AudioEngine::INVALID_SOUND_HANDLE;
+        }
+
+        auto output = (float *)soundHandles[handle]->maAudioBuffer->ref.pData;
+        ma_uint64 framesRendered = 0;
+
+        // Render in small chunks so that raw streams (_SNDRAW, PLAY etc.) can be refilled from their backlogs in between
+        while (framesRendered < frames) {
+            {
+                libqb_mutex_guard lock(rawStreamsMutex);
+
+                for (auto rawStream : rawStreams) {
+                    rawStream->FlushBacklog();
+                }
+            }
+
+            ma_uint64 framesRead = 0;
+            maResult = statistics.Mix(&maEngine, output + framesRendered * 2, std::min<ma_uint64>(frames - framesRendered, OFFLINE_RENDER_FRAMES), &framesRead);
+            if (maResult != MA_SUCCESS || !framesRead) {
+                audio_log_warn("Error %i: failed to render audio", maResult);
+                ReleaseHandle(handle);
+                return AudioEngine::INVALID_SOUND_HANDLE;
+            }
+
+            framesRendered += framesRead;
+        }
+
+        audio_log_trace("Rendered %u sample frames", frames);
+
         return handle;
     }
 
+    /// @brief Returns an audio engine statistic. See Statistics::Type.
+    /// @param statistic The statistic to return.
+    /// @param index The histogram bucket or the sound handle (for HISTOGRAM and DECODE_TIME).
+    /// @param passed Optional parameter flags.
+    /// @return The value of the statistic. Times are in microseconds.
+    int64_t GetStatistic(int32_t statistic, int32_t index, int32_t passed) {
+        if (is_error_pending() || !isInitialized) {
+            return 0;
+        }
+
+        switch (Statistics::Type(statistic)) {
+        case Statistics::Type::CALLBACKS:
+            return int64_t(statistics.callbacks.load(std::memory_order_relaxed));
+
+        case Statistics::Type::HISTOGRAM:
+            if (!passed || index < 0 || index >= Statistics::HISTOGRAM_BUCKETS) {
+                break;
+            }
+
+            return int64_t(statistics.histogram[index].load(std::memory_order_relaxed));
+
+        case Statistics::Type::LONGEST_CALLBACK:
+            return int64_t(statistics.longestCallback.load(std::memory_order_relaxed));
+
+        case Statistics::Type::LATE_CALLBACKS:
+            return int64_t(statistics.lateCallbacks.load(std::memory_order_relaxed));
+
+        case Statistics::Type::UNDERRUNS:
+            return int64_t(GetRawStreamProblems().first);
+
+        case Statistics::Type::OVERRUNS:
+            return int64_t(GetRawStreamProblems().second);
+
+        case Statistics::Type::VOICES:
+            return GetActiveVoices();
+
+        case Statistics::Type::DECODE_TIME:
+            if (!passed || !IsHandleOpen(index)) {
+                break;
+            }
+
+            // "nowait" sounds get their timer once the loader thread is done with them
+            if (soundHandles[index]->loadState.load(std::memory_order_acquire) != SoundHandle::LoadState::LOADING && soundHandles[index]->decodeTimer) {
+                return int64_t(soundHandles[index]->decodeTimer->GetTime() + soundHandles[index]->windowDecodeTime);
+            }
+
+            return int64_t(soundHandles[index]->windowDecodeTime);
+
+        default:
+            break;
+        }
+
+        error(QB_ERROR_ILLEGAL_FUNCTION_CALL);
+
+        return 0;
+    }
+
     /// @brief Returns a _MEM value referring to a sound's raw data in memory using a designated sound handle created by the _SNDOPEN function. miniaudio
     /// supports a
     /// variety of sample and channel formats. Translating all of that to basic 2 channel 16-bit format that MemSound was originally supporting would require
     /// significant overhead both in terms of system resources and code. For now we are just exposing the underlying PCM data directly from miniaudio. This fits
     /// rather well using the existing mem structure. Mono sounds should continue to work just as it was before. Stereo and multi-channel sounds however will be
     /// required to be handled correctly by the user by checking the 'elementsize' (for frame size in bytes) and 'type' (for data type) members.
+    /// If a frame range is passed, then only that part of the sound is returned. This also works for sounds that are streamed or not decoded on load: the
+    /// range is decoded into a window that belongs to the handle (see SoundWindow). The _MEM value of the previous range of such a sound must not be used
+    /// once a new range is requested.
     /// @param handle A sound handle.
     /// @param targetChannel This should be 0 (for interleaved) or 1 (for mono). Anything else will result in failure.
+    /// @param startFrame The first sample frame of the range (optional).
+    /// @param frameCount The number of sample frames in the range (optional, defaults to one second).
     /// @param passed Optional parameter flags.
     /// @return A _MEM value that can be used to access the sound data.
-    mem_block GetSoundMem(int32_t handle, int32_t targetChannel, int32_t passed) {
+    mem_block GetSoundMem(int32_t handle, int32_t targetChannel, int64_t startFrame, int64_t frameCount, int32_t passed) {
         auto maFormat = ma_format::ma_format_unknown;
         ma_uint32 channels = 0;
+        ma_uint32 sampleRate = 0;
         ma_uint64 sampleFrames = 0;
         intptr_t data = NULL;
 
@@ -3554,24 +5397,76 @@ class AudioEngine {
         }
 
         // Simply return an "empty" mem_block if targetChannel is not 0 or 1
-        if (passed && targetChannel != 0 && targetChannel != 1) {
+        if ((passed & 1) && targetChannel != 0 && targetChannel != 1) {
             audio_log_warn("Invalid channel (%i)", targetChannel);
             return mb;
         }
 
+        auto isRange = (passed & 6) != 0;
+        if (isRange) {
+            if (!(passed & 2)) {
+                startFrame = 0;
+            }
+
+            if (!(passed & 4)) {
+                frameCount = GetSampleRate();
+            }
+
+            if (startFrame < 0 || frameCount <= 0) {
+                audio_log_warn("Invalid frame range (%lld, %lld)", (long long)startFrame, (long long)frameCount);
+                return mb;
+            }
+        }
+
         // Check what kind of sound we are dealing with and take appropriate path
         if (soundHandles[handle]->maAudioBuffer) { // we are dealing with a user created audio buffer
             maFormat = soundHandles[handle]->maAudioBuffer->ref.format;
             channels = soundHandles[handle]->maAudioBuffer->ref.channels;
             sampleFrames = soundHandles[handle]->maAudioBuffer->ref.sizeInFrames;
             data = (intptr_t)soundHandles[handle]->maAudioBuffer->ref.pData;
-        } else { // we are dealing with a sound loaded from file or memory
-            // The sound cannot be steaming and must be completely decoded in memory
-            if (soundHandles[handle]->maFlags & MA_SOUND_FLAG_STREAM || !(soundHandles[handle]->maFlags & MA_SOUND_FLAG_DECODE)) {
-                audio_log_warn("Sound data is not completely decoded");
+        } else if (soundHandles[handle]->maFlags & MA_SOUND_FLAG_STREAM || !(soundHandles[handle]->maFlags & MA_SOUND_FLAG_DECODE)) {
+            // The sound is not completely decoded in memory, so only a range can be decoded
+            if (!isRange) {
+                audio_log_warn("Sound data is not completely decoded, a frame range is required");
+                return mb;
+            }
+
+            if (ma_sound_get_data_format(&soundHandles[handle]->maSound, &maFormat, &channels, &sampleRate, NULL, 0) != MA_SUCCESS) {
+                audio_log_warn("Data format query failed");
+                return mb;
+            }
+
+            if (!soundHandles[handle]->window) {
+                if (soundHandles[handle]->bufferKey) {
+                    auto [buffer, bufferSize] = bufferMap.GetBuffer(soundHandles[handle]->bufferKey);
+                    soundHandles[handle]->window = SoundWindow::Create({}, buffer, bufferSize, maFormat, channels, sampleRate);
+                } else {
+                    soundHandles[handle]->window = SoundWindow::Create(soundHandles[handle]->streamFileName, nullptr, 0, maFormat, channels, sampleRate);
+                }
+
+                if (!soundHandles[handle]->window) {
+                    return mb;
+                }
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            data = (intptr_t)soundHandles[handle]->window->Get(uint64_t(startFrame), uint64_t(frameCount), &sampleFrames);
+            soundHandles[handle]->windowDecodeTime +=
+                uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+            if (!data) {
                 return mb;
             }
 
+            // The window buffer moves with every range, so _MEM values from earlier ranges must no longer pass the lock check
+            if (soundHandles[handle]->memLockOffset) {
+                free_mem_lock((mem_lock *)soundHandles[handle]->memLockOffset);
+                soundHandles[handle]->memLockId = INVALID_MEM_LOCK;
+                soundHandles[handle]->memLockOffset = nullptr;
+            }
+
+            // The window holds exactly the range
+            isRange = false;
+        } else { // we are dealing with a sound loaded from file or memory
             // Get the pointer to the data source
             auto ds = (ma_resource_manager_data_buffer *)ma_sound_get_data_source(&soundHandles[handle]->maSound);
             if (!ds || !ds->pNode) {
@@ -3607,6 +5502,17 @@ class AudioEngine {
             data = (intptr_t)ds->pNode->data.backend.decoded.pData;
         }
 
+        // Narrow decoded data down to the range
+        if (isRange) {
+            if (uint64_t(startFrame) >= sampleFrames) {
+                audio_log_warn("Frame %lld is past the end of the sound", (long long)startFrame);
+                return mb;
+            }
+
+            data += intptr_t(startFrame) * ma_get_bytes_per_frame(maFormat, channels);
+            sampleFrames = std::min<ma_uint64>(frameCount, sampleFrames - startFrame);
+        }
+
         // Setup type: This was not done in the old code
         // But we are doing it here. By examining the type the user can now figure out if they have to use FP32 or integers
         switch (maFormat) {
@@ -3730,37 +5636,51 @@ class AudioEngine {
     }
 
     /// @brief Used for housekeeping and other stuff. Called by the QB64-PE internally at ~60Hz.
+    /// This only looks at raw streams and at handles that were queued by SetAutoKill() or by the end-of-sound callback.
     void Update() {
         if (isInitialized) {
-            // Scan through the whole handle vector to find anything we need to update or close
-            for (size_t handle = 0; handle < soundHandles.size(); handle++) {
-                // Only process handles that are in use
-                if (soundHandles[handle]->isUsed) {
-                    // Look for stuff that is set to auto-destruct
-                    if (soundHandles[handle]->autoKill) {
-                        switch (soundHandles[handle]->type) {
-                        case SoundHandle::Type::STATIC:
-                        case SoundHandle::Type::RAW:
-                            // Dispose the sound if it has finished playing
-                            // Note that this means that temporary looping sounds will never close
-                            // Well that's on the programmer. Probably they want it that way
-                            if (!ma_sound_is_playing(&soundHandles[handle]->maSound))
-                                ReleaseHandle(handle);
+            // Keep raw streams fed with frames that did not fit in the ring buffer
+            {
+                libqb_mutex_guard lock(rawStreamsMutex);
 
-                            break;
+                for (auto rawStream : rawStreams) {
+                    rawStream->FlushBacklog();
+                }
+            }
 
-                        case SoundHandle::Type::NONE:
-                            if (handle != 0) {
-                                audio_log_warn("Sound type is 'None' when handle value is not 0");
-                            }
+            // Look for new mixing problems about once a second, so that the log is not flooded
+            auto ticks = uint64_t(GetTicks());
+            if (ticks - statistics.lastLogTicks >= Statistics::LOG_INTERVAL_MS) {
+                statistics.lastLogTicks = ticks;
+                LogNewProblems();
+            }
 
-                            break;
+            // Take the whole queue at once. New entries pushed from here on will be handled during the next update
+            auto soundHandle = finishedHandles.exchange(nullptr, std::memory_order_acquire);
 
-                        default:
-                            audio_log_warn("Condition not handled"); // It should not come here
-                        }
+            while (soundHandle) {
+                auto next = soundHandle->nextFinished;
+                soundHandle->isFinishedQueued.store(false, std::memory_order_release); // the end callback can queue the handle again after this
+
+                if (soundHandle->isUsed && soundHandle->autoKill) {
+                    auto loadState = soundHandle->loadState.load(std::memory_order_acquire);
+
+                    if (loadState == SoundHandle::LoadState::LOADING) {
+                        // Closed while loading in the background, so check again once loading is done
+                        PushFinishedHandle(soundHandle);
+                    } else if (loadState == SoundHandle::LoadState::FAILED || ma_sound_at_end(&soundHandle->maSound) ||
+                               !ma_sound_is_playing(&soundHandle->maSound)) {
+                        // Dispose the sound if it has finished playing
+                        // Note that this means that temporary looping sounds will never close
+                        // Well that's on the programmer. Probably they want it that way
+                        ReleaseHandle(soundHandle->id);
+                    } else if (ma_node_get_state_time(&soundHandle->maSound, ma_node_state_stopped) != ~(ma_uint64)0) {
+                        // miniaudio does not call the end callback for a scheduled stop (_SNDLIMIT), so keep checking these
+                        PushFinishedHandle(soundHandle);
                     }
                 }
+
+                soundHandle = next;
             }
         }
     }
@@ -3777,6 +5697,9 @@ const ma_data_source_vtable AudioEngine::RawStream::rawStreamDataSourceVtable =
     0                                        // flags
 };
 
+/// @brief Mixer counters for _SNDSTAT.
+AudioEngine::Statistics AudioEngine::statistics;
+
 // External VTables for our custom decoding backend.
 extern ma_decoding_backend_vtable ma_vtable_radv2;
 extern ma_decoding_backend_vtable ma_vtable_hively;
@@ -3814,6 +5737,10 @@ int32_t func__sndopen(qbs *qbsFileName, qbs *qbsRequirements, int32_t passed) {
     return AudioEngine::Instance().OpenSound(qbsFileName, qbsRequirements, passed);
 }
 
+int32_t func__sndready(int32_t handle) {
+    return AudioEngine::Instance().GetSoundLoadState(handle);
+}
+
 void sub__sndclose(int32_t handle) {
     AudioEngine::Instance().CloseSound(handle);
 }
@@ -3858,6 +5785,10 @@ void sub__sndbal(int32_t handle, float x, float y, float z, int32_t channel, int
     AudioEngine::Instance().SetSoundBalance(handle, x, y, z, channel, passed);
 }
 
+void sub__sndeffect(int32_t handle, int32_t slot, int32_t type, float param1, float param2, float param3, int32_t passed) {
+    AudioEngine::Instance().SetSoundEffect(handle, slot, type, param1, param2, param3, passed);
+}
+
 double func__sndlen(int32_t handle) {
     return AudioEngine::Instance().GetSoundDuration(handle);
 }
@@ -3898,8 +5829,16 @@ int32_t func__sndnew(uint32_t frames, int32_t channels, int32_t bits, uint32_t s
     return AudioEngine::Instance().CreateSound(frames, channels, bits, sampleRate, passed);
 }
 
-mem_block func__memsound(int32_t handle, int32_t targetChannel, int32_t passed) {
-    return AudioEngine::Instance().GetSoundMem(handle, targetChannel, passed);
+int32_t func__sndrender(uint32_t frames) {
+    return AudioEngine::Instance().RenderSound(frames);
+}
+
+int64_t func__sndstat(int32_t statistic, int32_t index, int32_t passed) {
+    return AudioEngine::Instance().GetStatistic(statistic, index, passed);
+}
+
+mem_block func__memsound(int32_t handle, int32_t targetChannel, int64_t startFrame, int64_t frameCount, int32_t passed) {
+    return AudioEngine::Instance().GetSoundMem(handle, targetChannel, startFrame, frameCount, passed);
 }
 
 void sub__midisoundbank(qbs *qbsFileName, qbs *qbsRequirements, int32_t passed) {
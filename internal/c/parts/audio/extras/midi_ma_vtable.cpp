@@ -20,8 +20,283 @@
 #ifdef _WIN32
 #    include "foo_midi/VSTiPlayer.h"
 #endif
+#include "condvar.h"
+#include "filepath.h"
+#include "filesystem.h"
 #include "libmidi/MIDIContainer.h"
 #include "libmidi/MIDIProcessor.h"
+#include "mutex.h"
+#include "qoa/qoa.h"
+#include "thread.h"
+#include <ctime>
+#include <deque>
+#include <dirent.h>
+#include <unistd.h>
+
+/// @brief Encodes and writes MIDI cache files on a background thread, so that the decoding thread is never held up by QOA encoding and disk writes. The
+/// thread is started on first use and is stopped by Finish() when the audio engine shuts down.
+class MIDICacheWriter {
+  public:
+    static const auto STALE_TEMPORARY_FILE_SECONDS = 60; // temporary files older than this were left behind by a program that did not finish writing
+
+    /// @brief Returns the writer. This is never destroyed, so that it stays usable no matter in which order the program's static objects are destroyed.
+    static MIDICacheWriter &Instance() {
+        static auto instance = new MIDICacheWriter();
+        return *instance;
+    }
+
+    /// @brief Removes stale temporary files from a cache directory. This is done once per directory.
+    /// @param directory The absolute cache directory.
+    void Open(const std::string &directory) {
+        {
+            libqb_mutex_guard lock(mutex);
+
+            if (std::find(directories.begin(), directories.end(), directory) != directories.end()) {
+                return;
+            }
+
+            directories.push_back(directory);
+        }
+
+        auto dir = opendir(directory.c_str());
+        if (!dir) {
+            return;
+        }
+
+        auto now = std::time(nullptr);
+
+        while (auto entry = readdir(dir)) {
+            std::string_view name(entry->d_name);
+            if (name.size() <= 4 || name.substr(name.size() - 4) != ".tmp") {
+                continue;
+            }
+
+            std::string fileName;
+            filepath_join(fileName, directory, entry->d_name);
+
+            AudioFileInfo info;
+            if (AudioFile_GetInfo(fileName.c_str(), &info) && now - info.modifiedTime / 1000000000 > STALE_TEMPORARY_FILE_SECONDS &&
+                std::remove(fileName.c_str()) == 0) {
+                audio_log_info("Removed stale MIDI cache file '%s'", fileName.c_str());
+            }
+        }
+
+        closedir(dir);
+    }
+
+    /// @brief Queues recorded frames to be written to a cache file.
+    /// @param path The cache file.
+    /// @param frames Interleaved stereo frames. These are moved.
+    void Queue(const std::string &path, std::vector<int16_t> &&frames) {
+        {
+            libqb_mutex_guard lock(mutex);
+
+            if (!thread) {
+                thread = libqb_thread_new();
+                libqb_thread_start(thread, Worker, this);
+            }
+
+            queue.emplace_back(path, std::move(frames));
+        }
+
+        libqb_condvar_signal(condvar);
+    }
+
+    /// @brief Writes all queued cache files and stops the thread. The thread is started again if more files are queued later.
+    void Finish() {
+        libqb_thread *finishing;
+
+        {
+            libqb_mutex_guard lock(mutex);
+
+            finishing = thread;
+            thread = nullptr;
+            isFinishing = finishing != nullptr;
+        }
+
+        if (!finishing) {
+            return;
+        }
+
+        libqb_condvar_signal(condvar);
+        libqb_thread_join(finishing);
+        libqb_thread_free(finishing);
+
+        libqb_mutex_guard lock(mutex);
+        isFinishing = false;
+    }
+
+  private:
+    libqb_mutex *mutex;
+    libqb_condvar *condvar;
+    libqb_thread *thread;
+    bool isFinishing;                                               // tells the worker to exit once the queue is empty
+    std::deque<std::pair<std::string, std::vector<int16_t>>> queue; // cache files waiting to be written (path and frames)
+    std::vector<std::string> directories;                           // cache directories that were cleaned up by Open()
+    uint64_t fileCount;                                             // used to make unique temporary file names (only used by the worker)
+
+    MIDICacheWriter() : mutex(libqb_mutex_new()), condvar(libqb_condvar_new()), thread(nullptr), isFinishing(false), fileCount(0) {}
+
+    /// @brief Writes queued cache files.
+    static void Worker(void *arg) {
+        auto writer = reinterpret_cast<MIDICacheWriter *>(arg);
+
+        while (true) {
+            std::pair<std::string, std::vector<int16_t>> job;
+
+            {
+                libqb_mutex_guard lock(writer->mutex);
+
+                while (writer->queue.empty() && !writer->isFinishing) {
+                    libqb_condvar_wait(writer->condvar, writer->mutex);
+                }
+
+                if (writer->queue.empty()) {
+                    return;
+                }
+
+                job = std::move(writer->queue.front());
+                writer->queue.pop_front();
+            }
+
+            writer->Save(job.first, job.second);
+        }
+    }
+
+    /// @brief Writes frames to a cache file. A temporary file is renamed so that other programs never see a partial cache file.
+    void Save(const std::string &path, const std::vector<int16_t> &frames) {
+        qoa_desc desc = {};
+        desc.channels = 2;
+        desc.samplerate = MA_DEFAULT_SAMPLE_RATE;
+        desc.samples = unsigned(frames.size() / 2);
+
+        unsigned int size = 0;
+        auto bytes = qoa_encode(frames.data(), &desc, &size);
+
+        if (bytes) {
+            // The process ID keeps programs that share a cache directory from writing to the same temporary file
+            auto temporaryPath = path + "." + std::to_string(getpid()) + "." + std::to_string(++fileCount) + ".tmp";
+
+            if (AudioFile_Save(temporaryPath.c_str(), std::string_view(reinterpret_cast<const char *>(bytes), size)) &&
+                std::rename(temporaryPath.c_str(), path.c_str()) == 0) {
+                audio_log_info("Saved rendered MIDI music to cache '%s'", path.c_str());
+            } else {
+                std::remove(temporaryPath.c_str());
+                audio_log_warn("Failed to save MIDI cache file '%s'", path.c_str());
+            }
+
+            free(bytes);
+        }
+    }
+};
+
+/// @brief Rendered MIDI music can be cached on disk as QOA files. This is enabled by setting QB64PE_MIDI_CACHE to a directory. A cached tune is played back
+/// like any other decoded sound and the synthesizer is never created for it.
+struct MIDICache {
+    static const auto VERSION = 1; // change this when the rendered output changes to invalidate old cache files
+
+    std::string path;           // the cache file for this tune and sound bank
+    std::vector<int16_t> frames; // interleaved stereo frames loaded from the cache or recorded while rendering
+    ma_uint64 cursor;           // the playback position when playing from the cache
+    bool isCached;              // true if frames are played from the cache instead of the sequencer
+    bool isRecording;           // true while rendered frames are recorded to be written to the cache at the end
+
+    MIDICache(std::string &&cachePath) : path(std::move(cachePath)), cursor(0), isCached(false), isRecording(false) {}
+
+    /// @brief Returns the cache directory or nullptr if caching is disabled.
+    static const char *GetDirectory() {
+        auto directory = getenv("QB64PE_MIDI_CACHE");
+
+        return directory && *directory ? directory : nullptr;
+    }
+
+    /// @brief Makes a cache key from the tune, the selected sound bank and the sample rate.
+    static uint64_t GetKey(const std::vector<uint8_t> &tune) {
+        auto &bank = InstrumentBankManager::Instance();
+        auto key = std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char *>(tune.data()), tune.size()));
+
+        auto combine = [&key](uint64_t value) { key ^= value + 0x9e3779b97f4a7c15ull + (key << 6) + (key >> 2); };
+
+        combine(VERSION);
+        combine(MA_DEFAULT_SAMPLE_RATE);
+        combine(uint64_t(bank.GetType()));
+
+        if (bank.GetLocation() == InstrumentBankManager::Location::File) {
+            // Hashing a large sound font on every load would defeat the purpose, so the absolute path and the file identity are used
+            AudioFileInfo info;
+            combine(std::hash<std::string>{}(FS_GetFQN(bank.GetPath())));
+
+            if (AudioFile_GetInfo(bank.GetPath(), &info)) {
+                combine(info.device);
+                combine(info.inode);
+                combine(info.size);
+                combine(uint64_t(info.modifiedTime));
+            }
+        } else {
+            combine(std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char *>(bank.GetData()), bank.GetDataSize())));
+        }
+
+        return key;
+    }
+
+    /// @brief Loads the cached frames if the cache file exists, otherwise starts recording.
+    void Load() {
+        auto bytes = AudioFile_Load<std::vector<uint8_t>>(path.c_str());
+        if (!bytes.empty()) {
+            qoa_desc desc = {};
+            auto samples = qoa_decode(bytes.data(), int(bytes.size()), &desc);
+
+            if (samples && desc.channels == 2 && desc.samplerate == MA_DEFAULT_SAMPLE_RATE && desc.samples) {
+                frames.assign(samples, samples + size_t(desc.samples) * 2);
+                isCached = true;
+
+                audio_log_info("Playing MIDI music from cache '%s'", path.c_str());
+            } else {
+                audio_log_warn("Ignoring invalid MIDI cache file '%s'", path.c_str());
+            }
+
+            free(samples);
+        }
+
+        isRecording = !isCached;
+    }
+
+    /// @brief Reads cached frames.
+    ma_uint64 Read(float *output, ma_uint64 frameCount) {
+        auto count = std::min<ma_uint64>(frameCount, frames.size() / 2 - cursor);
+        auto input = frames.data() + cursor * 2;
+
+        for (ma_uint64 i = 0; i < count * 2; i++) {
+            output[i] = input[i] / 32768.0f;
+        }
+
+        cursor += count;
+
+        return count;
+    }
+
+    /// @brief Records rendered frames.
+    void Record(const float *input, ma_uint64 frameCount) {
+        auto offset = frames.size();
+        frames.resize(offset + frameCount * 2);
+
+        auto output = frames.data() + offset;
+        for (ma_uint64 i = 0; i < frameCount * 2; i++) {
+            output[i] = int16_t(std::clamp(input[i] * 32768.0f, -32768.0f, 32767.0f));
+        }
+    }
+
+    /// @brief Hands the recorded frames to the background cache writer.
+    void Save() {
+        isRecording = false;
+
+        if (!frames.empty()) {
+            MIDICacheWriter::Instance().Queue(path, std::move(frames));
+        }
+
+        frames = {};
+    }
+};
 
 struct ma_midi {
     // This part is for miniaudio
@@ -38,6 +313,7 @@ struct ma_midi {
     uint32_t trackNumber;        // the MIDI track number to played (this is automatically set to the first playable track)
     ma_int64 totalTime;          // total duration of the MIDI song in frames
     bool isPlaying;              // this holds the playing state
+    MIDICache *cache;            // on-disk render cache (nullptr if caching is disabled)
 #ifdef _WIN32
     DoubleBufferFrameBlock<SampleFrameF32> *frameBlock; // only needed when a player cannot do variable frame size rendering (e.g. VSTiPlayer)
     bool isReallyPlaying;                               // this holds the real playing state and is needed due to the same reason as above
@@ -49,9 +325,20 @@ static ma_result ma_midi_seek_to_pcm_frame(ma_midi *pMIDI, ma_uint64 frameIndex)
         return MA_INVALID_ARGS;
     }
 
+    if (pMIDI->cache && pMIDI->cache->isCached) {
+        pMIDI->cache->cursor = std::min<ma_uint64>(frameIndex, pMIDI->cache->frames.size() / 2);
+        return MA_SUCCESS;
+    }
+
     // We can only reset the player to the beginning
     pMIDI->sequencer->Seek(uint32_t(frameIndex));
 
+    // The recording is only complete if the tune is rendered from start to end
+    if (pMIDI->cache && pMIDI->cache->isRecording) {
+        pMIDI->cache->frames.clear();
+        pMIDI->cache->isRecording = frameIndex == 0;
+    }
+
     return MA_SUCCESS;
 }
 
@@ -106,28 +393,33 @@ static ma_result ma_midi_read_pcm_frames(ma_midi *pMIDI, void *pFramesOut, ma_ui
     auto result = MA_SUCCESS; // Must be initialized to MA_SUCCESS
     ma_uint64 totalFramesRead = 0;
 
+    if (pMIDI->cache && pMIDI->cache->isCached) {
+        totalFramesRead = pMIDI->cache->Read(reinterpret_cast<float *>(pFramesOut), frameCount);
+        pMIDI->isPlaying = totalFramesRead > 0;
+    } else {
 #ifdef _WIN32
-    const auto fixedFrames = pMIDI->sequencer->GetSampleBlockSize();
-
-    if (fixedFrames) {
-        // Only attempt to render if we are actually playing
-        if (pMIDI->isReallyPlaying) {
-            auto dest = reinterpret_cast<float *>(pMIDI->frameBlock->GetWriteBlock(fixedFrames));
-            if (dest) {
-                pMIDI->isReallyPlaying = pMIDI->sequencer->Play(dest, fixedFrames) > 0;
+        const auto fixedFrames = pMIDI->sequencer->GetSampleBlockSize();
+
+        if (fixedFrames) {
+            // Only attempt to render if we are actually playing
+            if (pMIDI->isReallyPlaying) {
+                auto dest = reinterpret_cast<float *>(pMIDI->frameBlock->GetWriteBlock(fixedFrames));
+                if (dest) {
+                    pMIDI->isReallyPlaying = pMIDI->sequencer->Play(dest, fixedFrames) > 0;
+                }
             }
-        }
 
-        // Get partial data from the frame block
-        totalFramesRead = pMIDI->frameBlock->ReadFrames(reinterpret_cast<SampleFrameF32 *>(pFramesOut), frameCount);
+            // Get partial data from the frame block
+            totalFramesRead = pMIDI->frameBlock->ReadFrames(reinterpret_cast<SampleFrameF32 *>(pFramesOut), frameCount);
 
-        // Set the isPlaying flag to true if we still have some data in the buffers
-        pMIDI->isPlaying = !pMIDI->frameBlock->IsEmpty() || pMIDI->isReallyPlaying;
-    } else
+            // Set the isPlaying flag to true if we still have some data in the buffers
+            pMIDI->isPlaying = !pMIDI->frameBlock->IsEmpty() || pMIDI->isReallyPlaying;
+        } else
 #endif
-    {
-        totalFramesRead = pMIDI->sequencer->Play(reinterpret_cast<float *>(pFramesOut), frameCount);
-        pMIDI->isPlaying = totalFramesRead > 0;
+        {
+            totalFramesRead = pMIDI->sequencer->Play(reinterpret_cast<float *>(pFramesOut), frameCount);
+            pMIDI->isPlaying = totalFramesRead > 0;
+        }
     }
 
     // Signal end of stream if we have reached the end
@@ -136,6 +428,15 @@ static ma_result ma_midi_read_pcm_frames(ma_midi *pMIDI, void *pFramesOut, ma_ui
         audio_log_trace("Finished rendering MIDI music");
     }
 
+    // The resource manager stops decoding once it has the number of frames reported by ma_midi_get_length_in_pcm_frames(), so save the cache then
+    if (pMIDI->cache && pMIDI->cache->isRecording) {
+        pMIDI->cache->Record(reinterpret_cast<const float *>(pFramesOut), totalFramesRead);
+
+        if (!pMIDI->isPlaying || pMIDI->cache->frames.size() / 2 >= ma_uint64(pMIDI->totalTime)) {
+            pMIDI->cache->Save();
+        }
+    }
+
     if (pFramesRead != NULL) {
         *pFramesRead = totalFramesRead;
     }
@@ -150,6 +451,11 @@ static ma_result ma_midi_get_cursor_in_pcm_frames(ma_midi *pMIDI, ma_uint64 *pCu
 
     *pCursor = 0; /* Safety. */
 
+    if (pMIDI->cache && pMIDI->cache->isCached) {
+        *pCursor = pMIDI->cache->cursor;
+        return MA_SUCCESS;
+    }
+
     auto offset = ma_int64(pMIDI->sequencer->GetFramePosition());
     if (offset < 0) {
         return MA_INVALID_FILE;
@@ -290,6 +596,9 @@ static ma_result ma_midi_init_internal(const ma_decoding_backend_config *pConfig
 /// @brief Common cleanup routine. Assumes pMIDI is valid
 /// @param pMIDI Valid pointer to a ma_midi object
 static void ma_midi_uninit_common(ma_midi *pMIDI) {
+    delete pMIDI->cache;
+    pMIDI->cache = nullptr;
+
     delete pMIDI->container;
     pMIDI->container = nullptr;
 
@@ -307,6 +616,30 @@ static void ma_midi_uninit_common(ma_midi *pMIDI) {
 /// @param tune The tune to load
 /// @return Result code (MA_SUCCESS on success)
 static auto ma_midi_init_common(ma_midi *pMIDI, const std::vector<uint8_t> &tune, const char *pFilePath) {
+    // Check the render cache first. The synthesizer is not needed at all if the tune was rendered before
+    auto cacheDirectory = MIDICache::GetDirectory();
+    if (cacheDirectory) {
+        // The absolute path is used, because the cache file is written later on another thread and the program may change the current directory
+        auto directory = FS_GetFQN(cacheDirectory);
+        MIDICacheWriter::Instance().Open(directory);
+
+        char fileName[32];
+        snprintf(fileName, sizeof(fileName), "%016llx.qoa", (unsigned long long)MIDICache::GetKey(tune));
+
+        std::string cachePath;
+        filepath_join(cachePath, directory, fileName);
+
+        pMIDI->cache = new MIDICache(std::move(cachePath));
+        pMIDI->cache->Load();
+
+        if (pMIDI->cache->isCached) {
+            pMIDI->totalTime = ma_int64(pMIDI->cache->frames.size() / 2);
+            pMIDI->isPlaying = true;
+
+            return MA_SUCCESS;
+        }
+    }
+
     // Create the synthesizer based on the sound bank
     switch (InstrumentBankManager::Instance().GetType()) {
     case InstrumentBankManager::Type::Primesynth:
@@ -334,6 +667,7 @@ static auto ma_midi_init_common(ma_midi *pMIDI, const std::vector<uint8_t> &tune
 
     if (!pMIDI->sequencer) {
         audio_log_warn("Failed to create sequencer instance");
+        ma_midi_uninit_common(pMIDI);
         return MA_INVALID_FILE; // failure here will be mostly due to bad sound bank
     }
 
@@ -569,3 +903,8 @@ ma_decoding_backend_vtable ma_vtable_midi = {
     ma_decoding_backend_uninit__midi
 };
 // clang-format on
+
+/// @brief Writes the MIDI cache files that are still queued. This is called when the audio engine shuts down.
+void MIDICache_Finish() {
+    MIDICacheWriter::Instance().Finish();
+}
@@ -29,6 +29,7 @@
 #include <limits>
 #include <stack>
 #include <string_view>
+#include <sys/stat.h>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -153,6 +154,44 @@ template <typename SampleFrame> class DoubleBufferFrameBlock {
     }
 };
 
+/// @brief Identifies a file and its state. Files are matched by device, inode, size and modification time (in nanoseconds where the platform has it), so a
+/// file that was rewritten or replaced can be told apart from the one that was seen before.
+struct AudioFileInfo {
+    uint64_t device;
+    uint64_t inode; // always 0 on Windows
+    uint64_t size;
+    int64_t modifiedTime;
+
+    bool operator==(const AudioFileInfo &other) const {
+        return device == other.device && inode == other.inode && size == other.size && modifiedTime == other.modifiedTime;
+    }
+};
+
+/// @brief Gets the identity of a file.
+/// @param fileName The name of the file.
+/// @param info Receives the file identity.
+/// @return True if the file exists.
+inline bool AudioFile_GetInfo(const char *fileName, AudioFileInfo *info) {
+    struct stat fileStat;
+
+    if (!fileName || stat(fileName, &fileStat) != 0) {
+        return false;
+    }
+
+    info->device = uint64_t(fileStat.st_dev);
+    info->inode = uint64_t(fileStat.st_ino);
+    info->size = uint64_t(fileStat.st_size);
+#if defined(_WIN32)
+    info->modifiedTime = int64_t(fileStat.st_mtime) * 1000000000; // whole seconds only
+#elif defined(__APPLE__)
+    info->modifiedTime = int64_t(fileStat.st_mtimespec.tv_sec) * 1000000000 + fileStat.st_mtimespec.tv_nsec;
+#else
+    info->modifiedTime = int64_t(fileStat.st_mtim.tv_sec) * 1000000000 + fileStat.st_mtim.tv_nsec;
+#endif
+
+    return true;
+}
+
 /// @brief Loads a file into memory. If the file cannot be opened or read, an empty container is returned.
 /// @tparam Container The type of the container to load the file into.
 /// @param fileName The name of the file to load.
@@ -222,3 +261,6 @@ template <typename Container> bool AudioFile_Save(const char *fileName, const Co
     std::fclose(file);
     return true;
 }
+
+/// @brief Writes the MIDI cache files that are still queued and stops the cache writer thread (see midi_ma_vtable.cpp).
+void MIDICache_Finish();
@@ -4,11 +4,14 @@
 //-----------------------------------------------------------------------------------------------------
 
 #include "compression.h"
+#include "error_handle.h"
 #include "hashing.h"
 #include "libqb-common.h"
 #include "miniz.h"
 #include "qbs.h"
-#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <limits>
 
 /// @brief Computes the Adler-32 checksum of the given text.
 /// @param text Pointer to the qbs structure containing the text data.
@@ -51,33 +54,63 @@ qbs *func__deflate(qbs *src, int32_t level, int32_t passed) {
     return qbs_left(dest, compSize); // resize the qbs to the actual compressed size
 }
 
-/// @brief Decompresses a string using the INFLATE algorithm.
+/// @brief Decompresses a string using the INFLATE algorithm. The data is decompressed in a single pass directly into the returned string. If the string
+/// is too small, then it is replaced by one twice as large and decompression continues where it stopped.
 /// @param text The qbs object containing the compressed data.
-/// @param originalSize The expected original size of the uncompressed data.
+/// @param originalSize The expected original size of the uncompressed data. This is used as the initial string size.
 /// @param passed Flag indicating if originalSize was passed by the caller.
-/// @return A new qbs object containing the uncompressed data.
+/// @return A new qbs object containing the uncompressed data. This is empty if the data is corrupt or incomplete (and an error is raised).
 qbs *func__inflate(qbs *text, int64_t originalSize, int32_t passed) {
-    if (passed) {
-        // Passing negative values can do bad things to qbs
-        if (originalSize > 0) {
-            auto uncompSize = uLongf(originalSize);
-            auto dest = qbs_new(uncompSize, 1);                               // decompressing directly to the qbs gives us a performance boost
-            uncompress(dest->chr, &uncompSize, text->chr, uLongf(text->len)); // discard result because we do not do any error checking
-            return dest;                                                      // no size adjustment is done assuming the exact original size was passed
-        } else {
-            return qbs_new(0, 1); // simply return an empty qbs if originalSize is zero or negative
+    static const size_t InflateMinimumSize = 64 * 1024;
+    static const size_t InflateMaximumSize = std::numeric_limits<int32_t>::max() - 32; // qbs_new() adds 32 bytes
+
+    if (passed && originalSize <= 0) {
+        return qbs_new(0, 1); // simply return an empty qbs if originalSize is zero or negative (passing negative values can do bad things to qbs)
+    }
+
+    if (!text->len) {
+        return qbs_new(0, 1); // nothing to decompress
+    }
+
+    // Without a size hint, start with a typical compression ratio and let the string grow from there
+    auto capacity = passed ? size_t(std::min<int64_t>(originalSize, InflateMaximumSize))
+                           : std::clamp<size_t>(size_t(text->len) * 4, InflateMinimumSize, InflateMaximumSize);
+    auto dest = qbs_new(int32_t(capacity), 1);
+    size_t srcOffset = 0, destOffset = 0;
+
+    tinfl_decompressor decompressor;
+    tinfl_init(&decompressor);
+
+    while (true) {
+        auto srcSize = size_t(text->len) - srcOffset;
+        auto destSize = size_t(dest->len) - destOffset;
+
+        // The output is one flat buffer, so matches can refer back to anything that was already decompressed
+        auto status = tinfl_decompress(&decompressor, text->chr + srcOffset, &srcSize, dest->chr, dest->chr + destOffset, &destSize,
+                                       TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_COMPUTE_ADLER32 | TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
+        srcOffset += srcSize;
+        destOffset += destSize;
+
+        if (status == TINFL_STATUS_DONE) {
+            break;
+        }
+
+        if (status != TINFL_STATUS_HAS_MORE_OUTPUT) {
+            // Corrupt data, a checksum mismatch or data that ends before the end of the stream
+            error(QB_ERROR_ILLEGAL_FUNCTION_CALL);
+            return qbs_left(dest, 0);
         }
-    } else {
-        static const uLongf InflateChunkSize = 10 * 1024 * 1024;
-        std::vector<Byte> dest; // to get rid of malloc() and free()
-        auto compSize = uLongf(text->len);
-        uLongf uncompSize = 0;
-        do {
-            uncompSize += InflateChunkSize; // 10 mb original buffer, resized by 10 mb each pass until it's large enough to hold the uncompressed data.
-            dest.resize(uncompSize);
-        } while (uncompress(&dest[0], &uncompSize, text->chr, compSize) == Z_BUF_ERROR); // and try again with a larger buffer
-        auto ret = qbs_new(uncompSize, 1);
-        memcpy(ret->chr, &dest[0], uncompSize);
-        return ret;
+
+        if (size_t(dest->len) >= InflateMaximumSize) {
+            error(QB_ERROR_OUT_OF_STRING_SPACE);
+            return qbs_left(dest, 0);
+        }
+
+        auto larger = qbs_new(int32_t(std::min(size_t(dest->len) * 2, InflateMaximumSize)), 1); // this may move string data, so dest->chr is read after it
+        memcpy(larger->chr, dest->chr, destOffset);
+        qbs_free(dest);
+        dest = larger;
     }
+
+    return qbs_left(dest, int32_t(destOffset)); // resize the qbs to the actual uncompressed size
 }
@@ -0,0 +1,13 @@
+
+SCREENIMAGE_SRCS :=
+
+ifeq ($(OS),lnx)
+	SCREENIMAGE_SRCS += screenimage.cpp
+endif
+
+SCREENIMAGE_OBJS := $(patsubst %.cpp,$(PATH_INTERNAL_C)/parts/os/screenimage/%.o,$(SCREENIMAGE_SRCS))
+
+$(PATH_INTERNAL_C)/parts/os/screenimage/%.o: $(PATH_INTERNAL_C)/parts/os/screenimage/%.cpp
+	$(CXX) -O3 $(CXXFLAGS) -DDEPENDENCY_CONSOLE_ONLY -Wall -Wextra $< -c -o $@
+
+CLEAN_LIST += $(SCREENIMAGE_OBJS)
@@ -0,0 +1,322 @@
+//----------------------------------------------------------------------------------------------------------------------
+// QB64-PE desktop capture support (_SCREENIMAGE)
+// X11 implementation using the MIT-SHM extension
+//----------------------------------------------------------------------------------------------------------------------
+
+#include "libqb-common.h"
+
+#include "logging.h"
+#include "screenimage.h"
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <algorithm>
+#include <cstring>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#ifdef __SSE2__
+#    include <emmintrin.h>
+#endif
+
+/// @brief The X connection and the shared memory segment are kept alive between _SCREENIMAGE calls. The segment only ever grows, so
+/// capturing regions of different sizes reuses it. _SCREENIMAGE is only called from the main program thread, so this is not locked
+struct ScreenCapture {
+    bool isInitialized;
+    Display *display; // our own connection, this works with and without a GLUT window
+    Window root;
+    Visual *visual;
+    int depth;
+    bool hasSharedMemory;
+    XShmSegmentInfo segment;
+    size_t segmentSize;
+    XImage *image; // header for the last captured region size, the pixel data lives in the segment
+};
+
+static ScreenCapture g_ScreenCapture;
+
+static bool g_ScreenCaptureXError;
+
+static int screen_capture_error_handler(Display *display, XErrorEvent *event) {
+    (void)display;
+    (void)event;
+
+    g_ScreenCaptureXError = true;
+
+    return 0;
+}
+
+/// @brief Opens the X connection on first use.
+/// @return False if there is no X server to capture from.
+static bool screen_capture_open() {
+    auto &sc = g_ScreenCapture;
+
+    if (sc.isInitialized)
+        return sc.display;
+
+    sc.isInitialized = true;
+
+    sc.display = XOpenDisplay(nullptr);
+    if (!sc.display) {
+        libqb_log_warn("Failed to open the X display, _SCREENIMAGE cannot capture the desktop");
+        return false;
+    }
+
+    auto screen = DefaultScreen(sc.display);
+    sc.root = RootWindow(sc.display, screen);
+    sc.visual = DefaultVisual(sc.display, screen);
+    sc.depth = DefaultDepth(sc.display, screen);
+    sc.hasSharedMemory = XShmQueryExtension(sc.display);
+
+    libqb_log_info("Screen capture opened, depth: %d, MIT-SHM: %s", sc.depth, sc.hasSharedMemory ? "yes" : "no");
+
+    return true;
+}
+
+/// @brief Detaches and frees the shared memory segment.
+static void screen_capture_free_segment() {
+    auto &sc = g_ScreenCapture;
+
+    if (!sc.segmentSize)
+        return;
+
+    XShmDetach(sc.display, &sc.segment);
+    XSync(sc.display, False);
+    shmdt(sc.segment.shmaddr);
+
+    sc.segment = {};
+    sc.segmentSize = 0;
+}
+
+/// @brief Makes sure the shared memory segment can hold at least the given number of bytes.
+/// @return False if the segment could not be created or attached by the X server (for example, the server is remote).
+static bool screen_capture_reserve_segment(size_t bytes) {
+    auto &sc = g_ScreenCapture;
+
+    if (sc.segmentSize >= bytes)
+        return true;
+
+    screen_capture_free_segment();
+
+    auto id = shmget(IPC_PRIVATE, bytes, IPC_CREAT | 0600);
+    if (id < 0) {
+        libqb_log_warn("shmget() failed for %zu bytes", bytes);
+        return false;
+    }
+
+    auto address = shmat(id, nullptr, 0);
+    if (address == (void *)-1) {
+        shmctl(id, IPC_RMID, nullptr);
+        libqb_log_warn("shmat() failed");
+        return false;
+    }
+
+    sc.segment.shmid = id;
+    sc.segment.shmaddr = reinterpret_cast<char *>(address);
+    sc.segment.readOnly = False;
+
+    g_ScreenCaptureXError = false;
+    auto oldHandler = XSetErrorHandler(screen_capture_error_handler);
+    auto attached = XShmAttach(sc.display, &sc.segment);
+    XSync(sc.display, False);
+    XSetErrorHandler(oldHandler);
+
+    // The segment is destroyed once both we and the X server have detached (this includes the program exiting)
+    shmctl(id, IPC_RMID, nullptr);
+
+    if (!attached || g_ScreenCaptureXError) {
+        shmdt(address);
+        sc.segment = {};
+        libqb_log_warn("XShmAttach() failed");
+        return false;
+    }
+
+    sc.segmentSize = bytes;
+
+    libqb_log_trace("Screen capture segment resized to %zu bytes", bytes);
+
+    return true;
+}
+
+/// @brief Destroys the cached XImage header without freeing the pixel data (that belongs to the segment).
+static void screen_capture_free_image() {
+    auto &sc = g_ScreenCapture;
+
+    if (sc.image) {
+        sc.image->data = nullptr;
+        XDestroyImage(sc.image);
+        sc.image = nullptr;
+    }
+}
+
+/// @brief Sets alpha to 255 on BGRX pixels. X11 leaves the padding byte undefined.
+static void screen_capture_convert_bgrx(const uint32_t *src, uint32_t *dst, size_t count) {
+    size_t i = 0;
+
+#ifdef __SSE2__
+    auto alpha = _mm_set1_epi32(int32_t(0xFF000000u));
+
+    for (; i + 8 <= count; i += 8) {
+        auto a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        auto b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_or_si128(a, alpha));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 4), _mm_or_si128(b, alpha));
+    }
+#endif
+
+    for (; i < count; i++)
+        dst[i] = src[i] | 0xFF000000u;
+}
+
+/// @brief Scales a channel extracted with an X11 color mask to 8 bits.
+static uint32_t screen_capture_channel(unsigned long pixel, unsigned long mask) {
+    if (!mask)
+        return 0;
+
+    auto shift = __builtin_ctzl(mask);
+    auto bits = __builtin_popcountl(mask);
+    auto value = uint32_t((pixel & mask) >> shift);
+
+    return bits >= 8 ? value >> (bits - 8) : (value * 255u) / ((1u << bits) - 1u);
+}
+
+/// @brief Copies an XImage to dst as BGRA. The common 32bpp BGRX layout is converted in bulk, anything else goes through XGetPixel().
+static void screen_capture_convert(XImage *image, int32_t width, int32_t height, uint32_t *dst) {
+    auto isBGRX = image->bits_per_pixel == 32 && image->byte_order == LSBFirst && image->red_mask == 0xFF0000 && image->green_mask == 0xFF00 &&
+                  image->blue_mask == 0xFF;
+
+    if (isBGRX) {
+        if (image->bytes_per_line == width * 4) {
+            screen_capture_convert_bgrx(reinterpret_cast<const uint32_t *>(image->data), dst, size_t(width) * height);
+        } else {
+            for (int32_t y = 0; y < height; y++)
+                screen_capture_convert_bgrx(reinterpret_cast<const uint32_t *>(image->data + size_t(y) * image->bytes_per_line), dst + size_t(y) * width,
+                                            width);
+        }
+
+        return;
+    }
+
+    if (!image->red_mask && !image->green_mask && !image->blue_mask) {
+        // Indexed visual (e.g. an 8bpp Xvfb screen), the pixels are looked up in the default colormap
+        auto &sc = g_ScreenCapture;
+        auto count = std::min(sc.visual->map_entries, 256);
+        XColor colors[256];
+        uint32_t palette[256] = {};
+
+        for (int i = 0; i < count; i++)
+            colors[i].pixel = i;
+
+        XQueryColors(sc.display, DefaultColormap(sc.display, DefaultScreen(sc.display)), colors, count);
+
+        for (int i = 0; i < count; i++)
+            palette[i] = ((colors[i].red >> 8) << 16) | ((colors[i].green >> 8) << 8) | (colors[i].blue >> 8);
+
+        for (int32_t y = 0; y < height; y++) {
+            for (int32_t x = 0; x < width; x++)
+                *dst++ = 0xFF000000u | palette[XGetPixel(image, x, y) & 0xFF];
+        }
+
+        return;
+    }
+
+    for (int32_t y = 0; y < height; y++) {
+        for (int32_t x = 0; x < width; x++) {
+            auto pixel = XGetPixel(image, x, y);
+
+            *dst++ = 0xFF000000u | (screen_capture_channel(pixel, image->red_mask) << 16) | (screen_capture_channel(pixel, image->green_mask) << 8) |
+                     screen_capture_channel(pixel, image->blue_mask);
+        }
+    }
+}
+
+/// @brief Captures using the shared memory segment. This avoids sending the pixels through the X socket.
+static bool screen_capture_shared(int32_t x, int32_t y, int32_t width, int32_t height, uint32_t *dst) {
+    auto &sc = g_ScreenCapture;
+
+    if (!sc.image || sc.image->width != width || sc.image->height != height) {
+        screen_capture_free_image();
+
+        sc.image = XShmCreateImage(sc.display, sc.visual, sc.depth, ZPixmap, nullptr, &sc.segment, width, height);
+        if (!sc.image)
+            return false;
+    }
+
+    if (!screen_capture_reserve_segment(size_t(sc.image->bytes_per_line) * height)) {
+        screen_capture_free_image();
+        return false;
+    }
+
+    sc.image->data = sc.segment.shmaddr;
+
+    g_ScreenCaptureXError = false;
+    auto oldHandler = XSetErrorHandler(screen_capture_error_handler);
+    auto success = XShmGetImage(sc.display, sc.root, sc.image, x, y, AllPlanes);
+    XSetErrorHandler(oldHandler);
+
+    if (!success || g_ScreenCaptureXError)
+        return false;
+
+    screen_capture_convert(sc.image, width, height, dst);
+
+    return true;
+}
+
+/// @brief Captures with a plain XGetImage() round trip. Used when MIT-SHM is not available.
+static bool screen_capture_copy(int32_t x, int32_t y, int32_t width, int32_t height, uint32_t *dst) {
+    auto &sc = g_ScreenCapture;
+
+    g_ScreenCaptureXError = false;
+    auto oldHandler = XSetErrorHandler(screen_capture_error_handler);
+    auto image = XGetImage(sc.display, sc.root, x, y, width, height, AllPlanes, ZPixmap);
+    XSync(sc.display, False);
+    XSetErrorHandler(oldHandler);
+
+    if (!image)
+        return false;
+
+    if (!g_ScreenCaptureXError)
+        screen_capture_convert(image, width, height, dst);
+
+    XDestroyImage(image);
+
+    return !g_ScreenCaptureXError;
+}
+
+bool screenimage_get_desktop_size(int32_t *width, int32_t *height) {
+    if (!screen_capture_open())
+        return false;
+
+    // Queried on every call so that resolution changes are picked up
+    Window root;
+    int x, y;
+    unsigned int w, h, border, depth;
+
+    if (!XGetGeometry(g_ScreenCapture.display, g_ScreenCapture.root, &root, &x, &y, &w, &h, &border, &depth))
+        return false;
+
+    *width = w;
+    *height = h;
+
+    return true;
+}
+
+bool screenimage_capture(int32_t x, int32_t y, int32_t width, int32_t height, uint32_t *dst) {
+    auto &sc = g_ScreenCapture;
+
+    if (!screen_capture_open() || width <= 0 || height <= 0)
+        return false;
+
+    if (sc.hasSharedMemory) {
+        if (screen_capture_shared(x, y, width, height, dst))
+            return true;
+
+        // Local X servers can still refuse (e.g. inside some containers), so don't try again
+        libqb_log_warn("MIT-SHM capture failed, falling back to XGetImage()");
+        screen_capture_free_image();
+        screen_capture_free_segment();
+        sc.hasSharedMemory = false;
+    }
+
+    return screen_capture_copy(x, y, width, height, dst);
+}
@@ -6,18 +6,24 @@
 #include "font.h"
 #include "../../../libqb.h"
 #include "error_handle.h"
+#include "filesystem.h"
 #include "graphics.h"
 #include "gui.h"
 #include "image.h"
 #include "libqb-common.h"
 #include "mutex.h"
 #include "rounding.h"
+#include <array>
 #include <codecvt>
 #include <cstdio>
+#include <deque>
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include <list>
 #include <locale>
+#include <memory>
 #include <string>
+#include <sys/stat.h>
 #include <unordered_map>
 #include <vector>
 
@@ -134,10 +140,24 @@ struct FontManager {
     int32_t lowestFreeHandle; // the lowest free handle that can be allocated
     int32_t reservedHandle;   // this is set to handle 0 so that it is not returned to QB64
 
+    /// @brief Raw font file contents. These are shared by all handles that load the same font (e.g. at different sizes)
+    struct FontData {
+        uint8_t *data;    // the font file contents
+        int32_t size;     // size of data in bytes
+        uint64_t hash;    // FNV-1a hash of data
+        int32_t refCount; // number of font handles using data
+
+        // Identity of the file the data was loaded from (path is empty if the font was loaded from memory)
+        std::string path; // absolute path (st_ino is always 0 on Windows, so this is what tells files apart there)
+        dev_t fileDevice;
+        ino_t fileInode;
+        time_t fileTime;
+    };
+
     /// @brief Manages a single font
     struct Font {
         bool isUsed;           // is this handle in use?
-        uint8_t *fontData;     // raw font data (we always store a copy as long as the font is in use)
+        FontData *fontData;    // raw font data (shared with other handles using the same font and kept alive while in use)
         FT_Face face;          // FreeType face object
         FT_Pos monospaceWidth; // the monospace width (if font was loaded as monospace, else zero)
         FT_Pos defaultHeight;  // default (max) pixel height the user wants
@@ -149,16 +169,45 @@ struct FontManager {
             // Usually the bitmap size & metrics returned by FT for mono and gray can be the same
             // But it's a bad idea to assume that is the case every time
             struct Bitmap {
-                uint8_t *data;       // pointer to the raw pixels
+                uint8_t *data;       // pointer to the raw pixels in the font's glyph atlas (NULL for blank glyphs)
+                FT_Pos pitch;        // bytes from one row to the next in the atlas
                 FT_Vector size;      // bitmap width & height in pixels
                 FT_Pos advanceWidth; // glyph advance width in pixels
                 FT_Vector bearing;   // glyph left and top side bearing in pixels
+
+                /// @brief Renders the bitmap to the target bitmap using "alpha blending"
+                /// @param dst The target bitmap to render to
+                /// @param dstW The width of the target bitmap
+                /// @param dstH The height of the target bitmap
+                /// @param dstL The x position on the target bitmap where the rendering should start
+                /// @param dstT The y position on the target bitmap where the rendering should start
+                void Render(uint8_t *dst, FT_Pos dstW, FT_Pos dstH, FT_Pos dstL, FT_Pos dstT) const {
+                    if (!data)
+                        return; // blank glyph
+
+                    // Clip the bitmap rectangle to the target once instead of checking every pixel
+                    auto srcL = std::max<FT_Pos>(0, -dstL);
+                    auto srcT = std::max<FT_Pos>(0, -dstT);
+                    auto srcR = std::min<FT_Pos>(size.x, dstW - dstL);
+                    auto srcB = std::min<FT_Pos>(size.y, dstH - dstT);
+
+                    for (auto sy = srcT; sy < srcB; sy++) {
+                        auto alphaSrc = data + pitch * sy;
+                        auto dstP = dst + dstW * (dstT + sy) + dstL;
+
+                        for (auto sx = srcL; sx < srcR; sx++) {
+                            if (alphaSrc[sx] > dstP[sx]) // blend both alpha and save to dst pointer
+                                dstP[sx] = alphaSrc[sx];
+                        }
+                    }
+                }
             };
 
-            FT_UInt index;  // glyph index
-            Bitmap bmpMono; // monochrome bitmap in 8-bit format
-            Bitmap bmpGray; // anti-aliased bitmap in 8-bit format
-            Bitmap *bitmap; // pointer to the currently selected bitmap (mono / gray)
+            FT_UInt index;     // glyph index
+            Bitmap bmpMono;    // monochrome bitmap in 8-bit format
+            Bitmap bmpGray;    // anti-aliased bitmap in 8-bit format
+            bool isMonoCached; // has the monochrome bitmap been rendered?
+            bool isGrayCached; // has the anti-aliased bitmap been rendered?
 
             // Delete copy and move constructors and assignments
             Glyph(const Glyph &) = delete;
@@ -171,17 +220,17 @@ struct FontManager {
                 index = 0;
                 bmpMono = {};
                 bmpGray = {};
-                bitmap = nullptr;
+                isMonoCached = isGrayCached = false;
             }
 
-            /// @brief Frees any cached glyph bitmap
-            ~Glyph() {
-                // image_log_trace("Freeing bitmaps %p, %p", bmpMono.data, bmpGray.data);
-
-                free(bmpGray.data);
-                free(bmpMono.data);
+            /// @brief Returns the monochrome or anti-aliased bitmap. This must be cached using CacheBitmap() first
+            /// @param isMono True for mono bitmap and false for gray
+            /// @return The bitmap
+            const Bitmap &GetBitmap(bool isMono) const {
+                return isMono ? bmpMono : bmpGray;
             }
 
+
             /// @brief Assuming a glyph was previously loaded and rendered by FreeType, this will prepare an internal bitmap struct
             /// @param bmp A pointer to a bitmap struct to prepare
             /// @param parentFont The parent font object
@@ -213,22 +262,17 @@ struct FontManager {
 
                     // image_log_trace("Creating empty (%i x %i) bitmap for missing glyph", bmp->size.x, bmp->size.y);
 
-                    // Allocate zeroed memory for monochrome bitmap
-                    bmp->data = (uint8_t *)calloc(bmp->size.x, bmp->size.y);
-                    if (!bmp->data) {
-                        image_log_error("Failed to allocate memory for empty glyph bitmap");
-                        *bmp = {};
-                        return false; // memory allocation failed
-                    }
+                    // Blank glyphs do not need any pixels. They only take up space
+                    bmp->data = nullptr;
+                    bmp->pitch = 0;
                 } else {
                     // The bitmap rendered successfully
                     // image_log_trace("(%i x %i) bitmap found", bmp->size.x, bmp->size.y);
 
-                    // So, we have a valid glyph bitmap. We'll use that
-                    // Allocate zeroed memory for the bitmap
-                    bmp->data = (uint8_t *)calloc(bmp->size.x, bmp->size.y);
+                    // So, we have a valid glyph bitmap. We'll copy that to the atlas
+                    bmp->data = parentFont->atlas.Allocate(bmp->size.x, bmp->size.y, &bmp->pitch);
                     if (!bmp->data) {
-                        image_log_error("Failed to allocate memory for glyph bitmap");
+                        image_log_error("Failed to allocate atlas space for glyph bitmap");
                         *bmp = {};
                         return false; // memory allocation failed
                     }
@@ -238,19 +282,18 @@ struct FontManager {
 
                     // Copy the bitmap based on the pixel mode
                     if (parentFont->face->glyph->bitmap.pixel_mode == FT_PIXEL_MODE_MONO) {
-                        for (FT_Pos y = 0; y < bmp->size.y; y++, src += parentFont->face->glyph->bitmap.pitch, dst += bmp->size.x) {
+                        for (FT_Pos y = 0; y < bmp->size.y; y++, src += parentFont->face->glyph->bitmap.pitch, dst += bmp->pitch) {
                             for (FT_Pos x = 0; x < bmp->size.x; x++) {
                                 dst[x] = (((src[x >> 3]) >> (7 - (x & 7))) & 1) * 255; // this looks at each bit and then sets the pixel
                             }
                         }
                     } else if (parentFont->face->glyph->bitmap.pixel_mode == FT_PIXEL_MODE_GRAY) {
-                        for (FT_Pos y = 0; y < bmp->size.y; y++, src += parentFont->face->glyph->bitmap.pitch, dst += bmp->size.x) {
+                        for (FT_Pos y = 0; y < bmp->size.y; y++, src += parentFont->face->glyph->bitmap.pitch, dst += bmp->pitch) {
                             memcpy(dst, src, bmp->size.x); // simply copy the line
                         }
                     } else {
                         image_log_error("Unknown bitmap pixel mode %i", (int)parentFont->face->glyph->bitmap.pixel_mode); // this should never happen
-                        free(bmp->data);
-                        *bmp = {};
+                        *bmp = {}; // the atlas space is not given back
                         return false;
                     }
                 }
@@ -258,92 +301,151 @@ struct FontManager {
                 return true;
             }
 
-            /// @brief Caches a glyph bitmap with a given codepoint and this happens only once
-            /// @param codepoint A valid UTF-32 codepoint
+            /// @brief Renders and caches the glyph bitmap for one mode. Each mode is rendered only once and only when it is first needed
+            /// @param isMono True for mono bitmap and false for gray
             /// @param parentFont The parent font object
             /// @return True if successful or if bitmap is already cached
-            bool CacheBitmap(char32_t codepoint, Font *parentFont) {
-                if (!bitmap) {
-                    // Get the glyph index first and store it
-                    // Note that this can return a valid glyph index but the index need not have any glyph bitmap
-                    index = FT_Get_Char_Index(parentFont->face, codepoint);
-                    if (!index) {
-                        image_log_error("Got glyph index zero for codepoint %lu", codepoint);
-                    }
+            bool CacheBitmap(bool isMono, Font *parentFont) {
+                if (isMono) {
+                    if (!isMonoCached) {
+                        // Load the mono glyph to query details and render
+                        if (FT_Load_Glyph(parentFont->face, index, FT_LOAD_TARGET_MONO)) {
+                            image_log_error("Failed to load mono glyph (%u)", index);
+                        }
 
-                    // Load the mono glyph to query details and render
-                    if (FT_Load_Glyph(parentFont->face, index, FT_LOAD_TARGET_MONO)) {
-                        image_log_error("Failed to load mono glyph for codepoint %lu (%u)", codepoint, index);
-                    }
+                        if (FT_Render_Glyph(parentFont->face->glyph, FT_RENDER_MODE_MONO)) {
+                            image_log_error("Failed to render mono glyph (%u)", index);
+                        }
 
-                    // We'll attempt to render the monochrome font first
-                    if (FT_Render_Glyph(parentFont->face->glyph, FT_RENDER_MODE_MONO)) {
-                        image_log_error("Failed to render mono glyph for codepoint %lu (%u)", codepoint, index);
-                    }
+                        if (!PrepareBitmap(&bmpMono, parentFont)) {
+                            image_log_error("Failed to prepare mono glyph (%u)", index);
+                            return false;
+                        }
 
-                    if (!PrepareBitmap(&bmpMono, parentFont)) {
-                        image_log_error("Failed to prepare mono glyph for codepoint %lu (%u)", codepoint, index);
-                        return false;
+                        isMonoCached = true;
                     }
+                } else {
+                    if (!isGrayCached) {
+                        // Load the gray glyph to query details and render
+                        if (FT_Load_Glyph(parentFont->face, index, FT_LOAD_RENDER)) {
+                            image_log_error("Failed to load gray glyph (%u)", index);
+                        }
+
+                        if (FT_Render_Glyph(parentFont->face->glyph, FT_RENDER_MODE_NORMAL)) {
+                            image_log_error("Failed to render gray glyph (%u)", index);
+                        }
+
+                        if (!PrepareBitmap(&bmpGray, parentFont)) {
+                            image_log_error("Failed to prepare gray glyph (%u)", index);
+                            return false;
+                        }
 
-                    // Load the gray glyph to query details and render
-                    if (FT_Load_Char(parentFont->face, codepoint, FT_LOAD_RENDER)) {
-                        image_log_error("Failed to load gray glyph for codepoint %lu (%u)", codepoint, index);
+                        isGrayCached = true;
                     }
+                }
+
+                return true;
+            }
+        };
+
+        /// @brief Glyph bitmaps of a font packed into a few large alpha pages. Glyphs are placed left to right on shelves and
+        /// the pages are only freed with the font. This avoids an allocation per glyph and keeps glyphs close together in memory
+        struct GlyphAtlas {
+            static constexpr FT_Pos PAGE_SIZE = 256;
+
+            struct Page {
+                std::unique_ptr<uint8_t[]> pixels; // zeroed 8-bit alpha pixels
+                FT_Vector size;                    // page width & height
+                FT_Vector shelf;                   // where the next glyph on the current shelf goes
+                FT_Pos shelfHeight;                // height of the tallest glyph on the current shelf
+            };
 
-                    // Render the gray bitmap
-                    if (FT_Render_Glyph(parentFont->face->glyph, FT_RENDER_MODE_NORMAL)) {
-                        image_log_error("Failed to render gray glyph for codepoint %lu (%u)", codepoint, index);
+            std::vector<Page> pages;
+
+            /// @brief Reserves zeroed space for a glyph bitmap
+            /// @param width The bitmap width in pixels
+            /// @param height The bitmap height in pixels
+            /// @param pitch Out: The pitch of the page the bitmap was placed on
+            /// @return A pointer to the top-left pixel or NULL on failure
+            uint8_t *Allocate(FT_Pos width, FT_Pos height, FT_Pos *pitch) {
+                if (!pages.empty()) {
+                    auto &page = pages.back();
+
+                    // Start a new shelf if the glyph does not fit on the current one
+                    if (page.shelf.x + width > page.size.x) {
+                        page.shelf.x = 0;
+                        page.shelf.y += page.shelfHeight;
+                        page.shelfHeight = 0;
                     }
 
-                    if (!PrepareBitmap(&bmpGray, parentFont)) {
-                        image_log_error("Failed to prepare gray glyph for codepoint %lu (%u)", codepoint, index);
-                        free(bmpMono.data); // free mono bitmap
-                        bmpMono = {};
-                        return false;
+                    if (page.shelf.x + width <= page.size.x && page.shelf.y + height <= page.size.y) {
+                        auto data = page.pixels.get() + page.size.x * page.shelf.y + page.shelf.x;
+                        page.shelf.x += width;
+                        page.shelfHeight = std::max(page.shelfHeight, height);
+                        *pitch = page.size.x;
+                        return data;
                     }
+                }
 
-                    /*
-                    image_log_trace("Bitmap cached (%p, %p) for codepoint %u, index %i", bmpMono.data, bmpGray.data, codepoint, index);
-                    image_log_trace("Mono: W = %i, H = %i, AW = %i, BX = %i, BY = %i", bmpMono.size.x, bmpMono.size.y, bmpMono.advanceWidth, bmpMono.bearing.x,
-                                    bmpMono.bearing.y);
-                    image_log_trace("Gray: W = %i, H = %i, AW = %i, BX = %i, BY = %i", bmpGray.size.x, bmpGray.size.y, bmpGray.advanceWidth, bmpGray.bearing.x,
-                                    bmpGray.bearing.y);
-                    */
+                // Large glyphs get a page of their own
+                Page page = {};
+                page.size.x = std::max(PAGE_SIZE, width);
+                page.size.y = std::max(PAGE_SIZE, height);
+                page.pixels.reset(new (std::nothrow) uint8_t[page.size.x * page.size.y]());
+                if (!page.pixels)
+                    return nullptr;
 
-                    bitmap = &bmpGray; // set bitmap to gray bitmap by default
-                }
+                page.shelf.x = width;
+                page.shelfHeight = height;
+                *pitch = page.size.x;
+                pages.push_back(std::move(page));
+
+                image_log_trace("Glyph atlas page %zu (%li x %li) created", pages.size(), pages.back().size.x, pages.back().size.y);
 
-                return bitmap != nullptr;
+                return pages.back().pixels.get();
             }
 
-            /// @brief Renders the glyph bitmap to the target bitmap using "alpha blending"
-            /// @param dst The target bitmap to render to
-            /// @param dstW The width of the target bitmap
-            /// @param dstH The height of the target bitmap
-            /// @param dstL The x position on the target bitmap where the rendering should start
-            /// @param dstT The y position on the target bitmap where the rendering should start
-            /// @return True if successful
-            void RenderBitmap(uint8_t *dst, FT_Pos dstW, FT_Pos dstH, FT_Pos dstL, FT_Pos dstT) {
-                // IMAGE_DEBUG_CHECK(bitmap && dst);
-
-                auto dstR = dstL + bitmap->size.x; // right of dst + 1 where we will end
-                auto dstB = dstT + bitmap->size.y; // bottom of dst + 1 where we will end
-                auto alphaSrc = bitmap->data;
-                for (FT_Pos dy = dstT; dy < dstB; dy++) {
-                    for (FT_Pos dx = dstL; dx < dstR; dx++) {
-                        if (dx >= 0 && dx < dstW && dy >= 0 && dy < dstH) { // if we are not clipped
-                            auto dstP = (dst + dstW * dy + dx);             // dst pointer
-                            if (*alphaSrc > *dstP)                          // blend both alpha and save to dst pointer
-                                *dstP = *alphaSrc;
-                        }
-                        ++alphaSrc;
-                    }
-                }
+            /// @brief Frees all pages
+            void Clear() {
+                pages.clear();
             }
         };
 
-        std::unordered_map<char32_t, Glyph *> glyphs; // holds pointers to cached glyph data for codepoints
+        /// @brief A laid out string. Glyph lookups and kerning are resolved once and the rendered coverage is kept so that
+        /// printing the same text again is just a copy
+        struct TextRun {
+            struct Item {
+                const Glyph::Bitmap *bitmap; // the mono or gray bitmap of the glyph
+                FT_Pos pen;                  // the pen position before the glyph (and its kerning) was placed
+                FT_Pos left;                 // where the left of the glyph bitmap goes relative to the start of the run
+            };
+
+            std::u32string key;      // mode + codepoints (see GetTextRun())
+            std::vector<Item> items; // one item for each codepoint that has a glyph
+            FT_Pos width;            // the same as GetStringPixelWidth()
+
+            // Coverage from the last time this run was rendered and the parameters it was rendered with
+            std::vector<uint8_t> coverage;
+            FT_Vector coverageSize;
+            FT_Pos coverageBaseline;
+            FT_Pos coverageMaxWidth;
+        };
+
+        static constexpr size_t TEXT_RUN_CACHE_SIZE = 256;      // runs cached per font
+        static constexpr size_t TEXT_RUN_MAX_CODEPOINTS = 1024; // longer strings are laid out but not cached
+
+        GlyphAtlas atlas;                                                            // storage for all glyph bitmaps
+        std::list<TextRun> textRuns;                                                 // most recently used run first
+        std::unordered_map<std::u32string, std::list<TextRun>::iterator> textRunMap; // lookup for textRuns
+        TextRun scratchRun;                                                          // used for strings that are too long to cache
+        std::u32string textRunKey;                                                   // reused to build lookup keys
+
+        static constexpr char32_t GLYPH_TABLE_PAGE_SIZE = 256;    // codepoints per glyph table page
+        static constexpr char32_t GLYPH_TABLE_CODEPOINTS = 65536; // codepoints below this are looked up in the glyph table
+
+        std::deque<Glyph> glyphPool; // all glyphs of the font (addresses stay valid as the pool grows)
+        std::array<std::unique_ptr<Glyph *[]>, GLYPH_TABLE_CODEPOINTS / GLYPH_TABLE_PAGE_SIZE> glyphTable; // direct lookup for the BMP (pages are made on first use)
+        std::unordered_map<char32_t, Glyph *> glyphMap;                                                   // lookup for codepoints beyond the BMP
 
         // Delete copy and move constructors and assignments
         Font(const Font &) = delete;
@@ -368,50 +470,182 @@ struct FontManager {
                 image_log_trace("FreeType face object freed");
             }
 
-            // Free the buffered font data
-            free(fontData);
-            image_log_trace("Raw font data buffer freed");
+        }
 
-            image_log_trace("Freeing cached glyphs");
-            // Free any allocated glyph manager
-            // This should also call the glyphs destructor freeing the bitmap data
-            for (auto &it : glyphs)
-                delete it.second;
+        /// @brief Frees all cached glyphs, glyph bitmaps and text runs
+        void ClearGlyphs() {
+            textRunMap.clear();
+            textRuns.clear();
+            scratchRun = {};
+
+            for (auto &page : glyphTable)
+                page.reset();
+
+            glyphMap.clear();
+            glyphPool.clear();
+            atlas.Clear();
         }
 
-        /// @brief Creates a glyph belonging to a codepoint, caches its bitmap + info and adds it to the hash map
+        /// @brief Finds or creates the glyph belonging to a codepoint and makes sure its bitmap for the requested mode is cached
         /// @param codepoint A valid UTF-32 codepoint
         /// @param isMono True for mono bitmap and false for gray
-        /// @return The glyph pointer if successful or if the glyph is already in the map, nullptr otherwise
+        /// @return The glyph pointer if successful, nullptr otherwise
         Glyph *GetGlyph(char32_t codepoint, bool isMono) {
-            if (glyphs.count(codepoint) == 0) {
-                // The glyph is not cached yet
-                auto newGlyph = new Glyph;
+            Glyph **slot;
+
+            if (codepoint < GLYPH_TABLE_CODEPOINTS) {
+                auto &page = glyphTable[codepoint / GLYPH_TABLE_PAGE_SIZE];
+                if (!page) {
+                    page.reset(new (std::nothrow) Glyph *[GLYPH_TABLE_PAGE_SIZE]());
+                    if (!page) {
+                        image_log_error("Failed to allocate memory");
+                        return nullptr;
+                    }
+                }
+
+                slot = &page[codepoint % GLYPH_TABLE_PAGE_SIZE];
+            } else {
+                slot = &glyphMap[codepoint];
+            }
 
-                if (!newGlyph) {
-                    image_log_error("Failed to allocate memory");
-                    return nullptr; // failed to allocate memory
+            if (!*slot) {
+                // The glyph is not known yet. Get the glyph index and store it
+                // Note that this can return a valid glyph index but the index need not have any glyph bitmap
+                auto &glyph = glyphPool.emplace_back();
+                glyph.index = FT_Get_Char_Index(face, codepoint);
+                if (!glyph.index) {
+                    image_log_error("Got glyph index zero for codepoint %lu", codepoint);
                 }
 
-                // Cache the glyph info and bitmap
-                if (!newGlyph->CacheBitmap(codepoint, this)) {
-                    delete newGlyph;
-                    image_log_error("Failed to cache glyph data");
-                    return nullptr; // failed to cache bitmap
+                *slot = &glyph;
+            }
+
+            if (!(*slot)->CacheBitmap(isMono, this)) {
+                image_log_error("Failed to cache glyph data for codepoint %lu", codepoint);
+                return nullptr;
+            }
+
+            return *slot;
+        }
+
+        /// @brief Lays out a string (or finds it in the run cache). The returned pointer is valid until the next call
+        /// @param codepoint The codepoint array (string)
+        /// @param codepoints The number of codepoints in the array
+        /// @param isMono True for mono bitmaps and false for gray
+        /// @return The laid out run
+        TextRun *GetTextRun(const char32_t *codepoint, size_t codepoints, bool isMono) {
+            TextRun *run;
+
+            if (codepoints <= TEXT_RUN_MAX_CODEPOINTS) {
+                textRunKey.assign(1, char32_t(isMono));
+                textRunKey.append(codepoint, codepoints);
+
+                auto it = textRunMap.find(textRunKey);
+                if (it != textRunMap.end()) {
+                    textRuns.splice(textRuns.begin(), textRuns, it->second); // move to the front of the LRU list
+                    return &textRuns.front();
                 }
 
-                glyphs[codepoint] = newGlyph;                                        // save the Glyph pointer to the map using the codepoint as key
-                newGlyph->bitmap = isMono ? &newGlyph->bmpMono : &newGlyph->bmpGray; // select the correct bitmap
+                // Recycle the least recently used run if the cache is full
+                if (textRuns.size() >= TEXT_RUN_CACHE_SIZE) {
+                    textRunMap.erase(textRuns.back().key);
+                    textRuns.splice(textRuns.begin(), textRuns, std::prev(textRuns.end()));
+                } else {
+                    textRuns.emplace_front();
+                }
+
+                run = &textRuns.front();
+                run->key = textRunKey;
+                textRunMap[run->key] = textRuns.begin();
+            } else {
+                run = &scratchRun;
+            }
 
-                image_log_trace("Glyph data for codepoint %u successfully cached", codepoint);
+            run->items.clear();
+            run->coverage.clear();
+            run->coverageSize = {};
+
+            FT_Pos penX = 0;
+
+            if (monospaceWidth) {
+                for (size_t i = 0; i < codepoints; i++) {
+                    auto glyph = GetGlyph(codepoint[i], isMono);
+                    if (glyph) {
+                        auto &bitmap = glyph->GetBitmap(isMono);
+                        run->items.push_back({&bitmap, penX, penX + bitmap.bearing.x + (monospaceWidth >> 1) - (bitmap.advanceWidth >> 1)});
+                        penX += monospaceWidth;
+                    }
+                }
 
-                return newGlyph; // return the glyph pointer
+                run->width = monospaceWidth * codepoints;
+            } else {
+                auto hasKerning = FT_HAS_KERNING(face); // set to true if font has kerning info
+                Glyph *glyph = nullptr;
+                Glyph *previousGlyph = nullptr;
+
+                for (size_t i = 0; i < codepoints; i++) {
+                    glyph = GetGlyph(codepoint[i], isMono);
+                    if (glyph) {
+                        auto pen = penX;
+
+                        // Add kerning advance width if kerning table is available
+                        if (hasKerning && previousGlyph) {
+                            FT_Vector delta;
+                            FT_Get_Kerning(face, previousGlyph->index, glyph->index, FT_KERNING_DEFAULT, &delta);
+                            penX += delta.x >> 6;
+                        }
+
+                        auto &bitmap = glyph->GetBitmap(isMono);
+                        run->items.push_back({&bitmap, pen, penX + bitmap.bearing.x});
+                        penX += bitmap.advanceWidth; // add advance width
+                        previousGlyph = glyph;       // save the current glyph pointer for use later
+                    }
+                }
+
+                // Adjust for the last glyph
+                if (glyph) {
+                    auto &bitmap = glyph->GetBitmap(isMono);
+                    auto adjust = bitmap.advanceWidth;
+                    if (adjust < bitmap.size.x)
+                        adjust = bitmap.size.x;
+                    if (bitmap.bearing.x > 0 && (bitmap.size.x + bitmap.bearing.x) > adjust)
+                        adjust = bitmap.size.x + bitmap.bearing.x;
+                    if (bitmap.bearing.x < 0)
+                        adjust += -bitmap.bearing.x;
+                    penX = penX - bitmap.advanceWidth + adjust;
+                }
+
+                run->width = penX;
             }
 
-            auto glyph = glyphs[codepoint];                             // we already have the glyph cached, so simply return the pointer
-            glyph->bitmap = isMono ? &glyph->bmpMono : &glyph->bmpGray; // select the correct bitmap
+            return run;
+        }
+
+        /// @brief Renders a run to an 8-bit alpha buffer. If the run was last rendered with the same parameters, the cached coverage is returned as is
+        /// @param run A run returned by GetTextRun()
+        /// @param width The width of the buffer
+        /// @param height The height of the buffer
+        /// @param baseline The baseline position in the buffer
+        /// @param maxPen If not zero, rendering stops at the first glyph that would end beyond this pen position
+        /// @return A pointer to the coverage buffer (width x height). This is owned by the run
+        const uint8_t *RenderTextRun(TextRun *run, FT_Pos width, FT_Pos height, FT_Pos baseline, FT_Pos maxPen) {
+            if (run->coverageSize.x == width && run->coverageSize.y == height && run->coverageBaseline == baseline && run->coverageMaxWidth == maxPen &&
+                !run->coverage.empty())
+                return run->coverage.data();
+
+            run->coverage.assign(size_t(std::max<FT_Pos>(width, 0)) * std::max<FT_Pos>(height, 0), 0);
+            run->coverageSize = {width, height};
+            run->coverageBaseline = baseline;
+            run->coverageMaxWidth = maxPen;
+
+            for (auto &item : run->items) {
+                if (maxPen && item.pen + (monospaceWidth ? monospaceWidth : item.bitmap->size.x) > maxPen)
+                    break;
+
+                item.bitmap->Render(run->coverage.data(), width, height, item.left, baseline - item.bitmap->bearing.y);
+            }
 
-            return glyph;
+            return run->coverage.data();
         }
 
         /// @brief This returns the length of a UTF32 codepoint array in pixels
@@ -422,47 +656,15 @@ struct FontManager {
             if (monospaceWidth) // return monospace width simply by multiplying the fixed width by the codepoints
                 return monospaceWidth * codepoints;
 
-            FT_Pos width = 0;                       // the calculated width in pixel
-            auto hasKerning = FT_HAS_KERNING(face); // set to true if font has kerning info
-            Glyph *glyph = nullptr;
-            Glyph *previousGlyph = nullptr;
             auto isMonochrome = (write_page->bytes_per_pixel == 1) || ((write_page->bytes_per_pixel == 4) && (write_page->alpha_disabled)) ||
                                 (options & FONT_LOAD_DONTBLEND); // monochrome or AA?
 
-            for (size_t i = 0; i < codepoints; i++) {
-                auto cp = codepoint[i];
-
-                glyph = GetGlyph(cp, isMonochrome);
-                if (glyph) {
-                    // Add kerning advance width if kerning table is available
-                    if (hasKerning && previousGlyph && glyph) {
-                        FT_Vector delta;
-                        FT_Get_Kerning(face, previousGlyph->index, glyph->index, FT_KERNING_DEFAULT, &delta);
-                        width += delta.x >> 6;
-                    }
-
-                    width += glyph->bitmap->advanceWidth; // add advance width
-                    previousGlyph = glyph;                // save the current glyph pointer for use later
-                }
-            }
-
-            // Adjust for the last glyph
-            if (glyph) {
-                auto adjust = glyph->bitmap->advanceWidth;
-                if (adjust < glyph->bitmap->size.x)
-                    adjust = glyph->bitmap->size.x;
-                if (glyph->bitmap->bearing.x > 0 && (glyph->bitmap->size.x + glyph->bitmap->bearing.x) > adjust)
-                    adjust = glyph->bitmap->size.x + glyph->bitmap->bearing.x;
-                if (glyph->bitmap->bearing.x < 0)
-                    adjust += -glyph->bitmap->bearing.x;
-                width = width - glyph->bitmap->advanceWidth + adjust;
-            }
-
-            return width;
+            return GetTextRun(codepoint, codepoints, isMonochrome)->width;
         }
     };
 
-    std::vector<Font *> fonts; // vector that holds all font objects
+    std::vector<Font *> fonts;      // vector that holds all font objects
+    std::list<FontData> fontDatas; // font file contents shared by the font handles
     libqb_mutex *m;            // we'll use a mutex to give exclusive access to resources used by multiple threads
 
     FontManager(const FontManager &) = delete;
@@ -575,6 +777,89 @@ struct FontManager {
         return (int32_t)h;
     }
 
+    /// @brief Computes the FNV-1a hash of a buffer
+    /// @param data The data to hash
+    /// @param size The size of the data in bytes
+    /// @return The 64-bit hash
+    static uint64_t HashData(const uint8_t *data, size_t size) {
+        uint64_t hash = 0xcbf29ce484222325ull;
+
+        for (size_t i = 0; i < size; i++)
+            hash = (hash ^ data[i]) * 0x100000001b3ull;
+
+        return hash;
+    }
+
+    /// @brief Finds font data that was loaded from a file that has not changed since
+    /// @param path The absolute path of the file
+    /// @param info The current status of the file
+    /// @return The font data with its reference count incremented or nullptr if the file was not loaded before
+    FontData *FindFileData(const std::string &path, const struct stat &info) {
+        for (auto &fontData : fontDatas) {
+            if (fontData.path == path && fontData.size == info.st_size && fontData.fileTime == info.st_mtime && fontData.fileDevice == info.st_dev &&
+                fontData.fileInode == info.st_ino) {
+                fontData.refCount++;
+
+                image_log_trace("Reusing font data of %s (%i references)", path.c_str(), fontData.refCount);
+
+                return &fontData;
+            }
+        }
+
+        return nullptr;
+    }
+
+    /// @brief Finds font data with the same contents or adds new font data
+    /// @param content The font file contents. This is owned by the font manager after the call (even on failure) and must be allocated with malloc()
+    /// @param bytes The size of content in bytes
+    /// @return The font data with its reference count incremented
+    FontData *AcquireData(uint8_t *content, int32_t bytes) {
+        auto hash = HashData(content, bytes);
+
+        for (auto &fontData : fontDatas) {
+            if (fontData.hash == hash && fontData.size == bytes && !memcmp(fontData.data, content, bytes)) {
+                free(content); // we already have this
+                fontData.refCount++;
+
+                image_log_trace("Reusing font data (%i bytes, %i references)", bytes, fontData.refCount);
+
+                return &fontData;
+            }
+        }
+
+        fontDatas.emplace_back();
+        auto &fontData = fontDatas.back();
+        fontData.data = content;
+        fontData.size = bytes;
+        fontData.hash = hash;
+        fontData.refCount = 1;
+        fontData.fileDevice = 0;
+        fontData.fileInode = 0;
+        fontData.fileTime = 0;
+
+        image_log_trace("Font data (%i bytes) added", bytes);
+
+        return &fontData;
+    }
+
+    /// @brief Drops a reference to font data and frees it when it is no longer used by any font
+    /// @param fontData Font data returned by FindFileData() or AcquireData()
+    void ReleaseData(FontData *fontData) {
+        if (--fontData->refCount > 0)
+            return;
+
+        for (auto it = fontDatas.begin(); it != fontDatas.end(); ++it) {
+            if (&*it == fontData) {
+                free(it->data);
+                fontDatas.erase(it);
+
+                image_log_trace("Raw font data buffer freed");
+
+                break;
+            }
+        }
+    }
+
     /// @brief This will mark a handle as free so that it's put up for recycling
     /// @param handle A font handle
     void ReleaseHandle(int32_t handle) {
@@ -587,20 +872,15 @@ struct FontManager {
             }
             fonts[handle]->face = nullptr;
 
-            // Free the buffered font data
-            free(fonts[handle]->fontData);
+            // Release the font data
+            if (fonts[handle]->fontData)
+                ReleaseData(fonts[handle]->fontData);
             fonts[handle]->fontData = nullptr;
-            image_log_trace("Raw font data buffer freed");
 
             image_log_trace("Freeing cached glyphs");
-            // Free cached glyph data
-            // This should also call the glyphs destructor freeing the bitmap data
-            for (auto &it : fonts[handle]->glyphs)
-                delete it.second;
-
-            // Reset the hash map
-            fonts[handle]->glyphs.clear();
-            image_log_trace("Hash map cleared");
+            // Free cached glyphs, the glyph atlas and all text runs
+            fonts[handle]->ClearGlyphs();
+            image_log_trace("Glyph cache cleared");
 
             // Now simply set the 'isUsed' member to false so that the handle can be recycled
             fonts[handle]->isUsed = false;
@@ -617,12 +897,12 @@ struct FontManager {
 /// @brief Global font manager object
 static FontManager fontManager;
 
-/// @brief Loads a whole font file from disk to memory.
+/// @brief Opens a font file for reading.
 /// This will search for the file in known places if it is not found in the current directory
 /// @param file_path_name The font file name. This can be a relative path
-/// @param out_bytes The size of the data that was loaded. This cannot be NULL
-/// @return A pointer to a buffer with the data. NULL on failure. The caller is responsible for freeing this memory
-uint8_t *FontLoadFileToMemory(const char *file_path_name, int32_t *out_bytes) {
+/// @param opened_path [OUT] Optional. Receives the absolute path of the file that was opened
+/// @return The opened file or NULL on failure
+static FILE *FontOpenFile(const char *file_path_name, std::string *opened_path = nullptr) {
     // This is simply a list of known locations to look for a font
     static const char *const FONT_PATHS[][2] = {
 #ifdef QB64_WINDOWS
@@ -665,8 +945,11 @@ uint8_t *FontLoadFileToMemory(const char *file_path_name, int32_t *out_bytes) {
             image_log_trace("Attempting to load %s", pathName);
 
             fontFile = fopen(pathName, "rb");
-            if (fontFile)
+            if (fontFile) {
+                if (opened_path)
+                    *opened_path = FS_GetFQN(pathName);
                 break; // exit the loop if something worked
+            }
         }
 
         free(pathName);
@@ -676,8 +959,19 @@ uint8_t *FontLoadFileToMemory(const char *file_path_name, int32_t *out_bytes) {
             image_log_trace("No know locations worked");
             return nullptr; // return NULL if all attempts failed
         }
+    } else if (opened_path) {
+        *opened_path = FS_GetFQN(file_path_name);
     }
 
+    return fontFile;
+}
+
+/// @brief Reads the whole font file to memory and closes it
+/// @param fontFile A file opened using FontOpenFile()
+/// @param file_path_name The font file name (for logging)
+/// @param out_bytes The size of the data that was loaded. This cannot be NULL
+/// @return A pointer to a buffer with the data. NULL on failure. The caller is responsible for freeing this memory
+static uint8_t *FontReadFile(FILE *fontFile, const char *file_path_name, int32_t *out_bytes) {
     if (fseek(fontFile, 0, SEEK_END) != 0) {
         image_log_error("Failed to seek end of font file: %s", file_path_name);
         fclose(fontFile);
@@ -717,47 +1011,50 @@ uint8_t *FontLoadFileToMemory(const char *file_path_name, int32_t *out_bytes) {
     return buffer;
 }
 
-/// @brief Loads a FreeType font from memory. The font data is locally copied and is kept alive while in use
-/// @param content_original The original font data in memory that is copied
-/// @param content_bytes The length of the data in bytes
+/// @brief Loads a whole font file from disk to memory.
+/// This will search for the file in known places if it is not found in the current directory
+/// @param file_path_name The font file name. This can be a relative path
+/// @param out_bytes The size of the data that was loaded. This cannot be NULL
+/// @return A pointer to a buffer with the data. NULL on failure. The caller is responsible for freeing this memory
+uint8_t *FontLoadFileToMemory(const char *file_path_name, int32_t *out_bytes) {
+    auto fontFile = FontOpenFile(file_path_name);
+    if (!fontFile)
+        return nullptr;
+
+    return FontReadFile(fontFile, file_path_name, out_bytes);
+}
+
+/// @brief Creates a font handle using font data from the font manager. The font manager mutex must be locked
+/// @param fontData Font data with a reference for the new font. The reference is released on failure
 /// @param default_pixel_height The maximum rendering height of the font
 /// @param which_font The font index in a font collection (< 0 means default)
 /// @param options [IN/OUT] 16=monospace (all old flags are ignored like it always was since forever)
 /// @return A valid font handle (> 0) or 0 on failure
-int32_t FontLoad(const uint8_t *content_original, int32_t content_bytes, int32_t default_pixel_height, int32_t which_font, int32_t &options) {
-    libqb_mutex_guard lock(fontManager.m);
-
+static int32_t FontCreate(FontManager::FontData *fontData, int32_t default_pixel_height, int32_t which_font, int32_t &options) {
     // Allocate a font handle
     auto h = fontManager.CreateHandle();
-    if (h <= INVALID_FONT_HANDLE)
-        return INVALID_FONT_HANDLE;
-
-    // Allocate memory to duplicate content
-    // Note: You must not deallocate the memory before calling FT_Done_Face
-    fontManager.fonts[h]->fontData = (uint8_t *)malloc(content_bytes);
-    // Return invalid handle if memory allocation failed
-    if (!fontManager.fonts[h]->fontData) {
-        fontManager.ReleaseHandle(h);
-        image_log_error("Failed to allocate memory");
+    if (h <= INVALID_FONT_HANDLE) {
+        fontManager.ReleaseData(fontData);
         return INVALID_FONT_HANDLE;
     }
 
-    memcpy(fontManager.fonts[h]->fontData, content_original, content_bytes); // duplicate content
+    // Note: The data must not be released before calling FT_Done_Face
+    fontManager.fonts[h]->fontData = fontData;
 
     // Adjust font index
     if (which_font < 1)
         which_font = 0;
 
     // Attempt to initialize the font for use
-    if (FT_New_Memory_Face(fontManager.library, fontManager.fonts[h]->fontData, content_bytes, which_font, &fontManager.fonts[h]->face)) {
-        fontManager.ReleaseHandle(h); // this will also free the memory allocated above
+    if (FT_New_Memory_Face(fontManager.library, fontData->data, fontData->size, which_font, &fontManager.fonts[h]->face)) {
+        fontManager.ReleaseHandle(h); // this will also release the font data
         image_log_error("FT_New_Memory_Face() failed");
         return INVALID_FONT_HANDLE;
     }
 
     // Set the font pixel height
     if (FT_Set_Pixel_Sizes(fontManager.fonts[h]->face, 0, default_pixel_height)) {
-        fontManager.ReleaseHandle(h); // this will also free the memory allocated above
+        fontManager.ReleaseHandle(h); // this will also release the font data
         image_log_error("FT_Set_Pixel_Sizes() failed");
         return INVALID_FONT_HANDLE;
     }
@@ -814,6 +1111,77 @@ int32_t FontLoad(const uint8_t *content_original, int32_t content_bytes, int32_t
     return h;
 }
 
+/// @brief Loads a FreeType font from memory. The font data is copied (unless another font already uses the same data) and is kept alive while in use
+/// @param content_original The original font data in memory that is copied
+/// @param content_bytes The length of the data in bytes
+/// @param default_pixel_height The maximum rendering height of the font
+/// @param which_font The font index in a font collection (< 0 means default)
+/// @param options [IN/OUT] 16=monospace (all old flags are ignored like it always was since forever)
+/// @return A valid font handle (> 0) or 0 on failure
+int32_t FontLoad(const uint8_t *content_original, int32_t content_bytes, int32_t default_pixel_height, int32_t which_font, int32_t &options) {
+    // Allocate memory to duplicate content
+    auto content = (uint8_t *)malloc(content_bytes);
+    if (!content) {
+        image_log_error("Failed to allocate memory");
+        return INVALID_FONT_HANDLE;
+    }
+
+    memcpy(content, content_original, content_bytes); // duplicate content
+
+    libqb_mutex_guard lock(fontManager.m);
+
+    return FontCreate(fontManager.AcquireData(content, content_bytes), default_pixel_height, which_font, options);
+}
+
+/// @brief Loads a FreeType font from a file. The file is only read if no other font is using the same unchanged file (or the same data)
+/// This will search for the file in known places if it is not found in the current directory
+/// @param file_path_name The font file name. This can be a relative path
+/// @param default_pixel_height The maximum rendering height of the font
+/// @param which_font The font index in a font collection (< 0 means default)
+/// @param options [IN/OUT] 16=monospace (all old flags are ignored like it always was since forever)
+/// @return A valid font handle (> 0) or 0 on failure
+int32_t FontLoadFile(const char *file_path_name, int32_t default_pixel_height, int32_t which_font, int32_t &options) {
+    // The absolute path is used to find the file again, so that a relative path used after CHDIR does not match a different file
+    std::string fullPath;
+    auto fontFile = FontOpenFile(file_path_name, &fullPath);
+    if (!fontFile)
+        return INVALID_FONT_HANDLE;
+
+    struct stat info;
+    auto hasInfo = fstat(fileno(fontFile), &info) == 0;
+
+    {
+        libqb_mutex_guard lock(fontManager.m);
+
+        if (hasInfo) {
+            auto fontData = fontManager.FindFileData(fullPath, info);
+            if (fontData) {
+                fclose(fontFile);
+                return FontCreate(fontData, default_pixel_height, which_font, options);
+            }
+        }
+    }
+
+    int32_t bytes;
+    auto content = FontReadFile(fontFile, file_path_name, &bytes);
+    if (!content)
+        return INVALID_FONT_HANDLE;
+
+    libqb_mutex_guard lock(fontManager.m);
+
+    auto fontData = fontManager.AcquireData(content, bytes);
+
+    // Remember where the data came from so that the file does not need to be read again
+    if (hasInfo && fontData->path.empty()) {
+        fontData->path = fullPath;
+        fontData->fileDevice = info.st_dev;
+        fontData->fileInode = info.st_ino;
+        fontData->fileTime = info.st_mtime;
+    }
+
+    return FontCreate(fontData, default_pixel_height, which_font, options);
+}
+
 /// @brief Frees the font and any locally cached data
 /// @param fh A valid font handle
 void FontFree(int32_t fh) {
@@ -900,55 +1268,19 @@ bool FontRenderTextUTF32(int32_t fh, const char32_t *codepoint, int32_t codepoin
         return codepoints == 0; // true if zero, false if -ve
 
     auto isMonochrome = bool(options & FONT_RENDER_MONOCHROME); // do we need to do monochrome rendering?
+    auto run = fnt->GetTextRun(codepoint, codepoints, isMonochrome);
     FT_Vector strPixSize = {
-        fnt->GetStringPixelWidth(codepoint, codepoints), // get the total buffer width
-        fnt->defaultHeight                               // height is always set by the QB64
+        run->width,        // get the total buffer width
+        fnt->defaultHeight // height is always set by the QB64
     };
-    auto outBuf = (uint8_t *)calloc(strPixSize.x, strPixSize.y);
+    auto outBuf = (uint8_t *)malloc(strPixSize.x * strPixSize.y);
     if (!outBuf)
         return false;
 
     // image_log_trace("Allocated (%lu x %lu) buffer", strPixSize.x, strPixSize.y);
 
-    FT_Pos penX = 0;
-
-    if (fnt->monospaceWidth) {
-        for (size_t i = 0; i < codepoints; i++) {
-            auto cp = codepoint[i];
-
-            auto glyph = fnt->GetGlyph(cp, isMonochrome);
-            if (glyph) {
-                glyph->RenderBitmap(outBuf, strPixSize.x, strPixSize.y,
-                                    penX + glyph->bitmap->bearing.x + (fnt->monospaceWidth >> 1) - (glyph->bitmap->advanceWidth >> 1),
-                                    fnt->baseline - glyph->bitmap->bearing.y);
-                penX += fnt->monospaceWidth;
-            }
-        }
-    } else {
-        auto hasKerning = FT_HAS_KERNING(fnt->face); // set to true if font has kerning info
-        FontManager::Font::Glyph *glyph = nullptr;
-        FontManager::Font::Glyph *previousGlyph = nullptr;
-
-        for (size_t i = 0; i < codepoints; i++) {
-            auto cp = codepoint[i];
-
-            glyph = fnt->GetGlyph(cp, isMonochrome);
-            if (glyph) {
-                // Add kerning advance width if kerning table is available
-                if (hasKerning && previousGlyph && glyph) {
-                    FT_Vector delta;
-                    FT_Get_Kerning(fnt->face, previousGlyph->index, glyph->index, FT_KERNING_DEFAULT, &delta);
-                    penX += delta.x >> 6;
-                }
-
-                glyph->RenderBitmap(outBuf, strPixSize.x, strPixSize.y, penX + glyph->bitmap->bearing.x, fnt->baseline - glyph->bitmap->bearing.y);
-                penX += glyph->bitmap->advanceWidth; // add advance width
-                previousGlyph = glyph;               // save the current glyph pointer for use later
-            }
-        }
-    }
-
-    // image_log_trace("Buffer width = %li, render width = %li", strPixSize.x, penX);
+    // Repeated strings are only rendered once. After that this is just a copy
+    memcpy(outBuf, fnt->RenderTextRun(run, strPixSize.x, strPixSize.y, fnt->baseline, 0), strPixSize.x * strPixSize.y);
 
     *out_data = outBuf;
     *out_x = strPixSize.x;
@@ -1225,8 +1557,11 @@ void sub__UPrintString(int32_t start_x, int32_t start_y, const qbs *text, int32_
     }
 
     FontManager::Font *fnt = nullptr;
+    FontManager::Font::TextRun *run = nullptr;
     FT_Face face = nullptr;
     FT_Vector strPixSize, pen;
+    auto isMonochrome = (write_page->bytes_per_pixel == 1) || ((write_page->bytes_per_pixel == 4) && (write_page->alpha_disabled)) ||
+                        (fontflags[qb64_fh] & FONT_LOAD_DONTBLEND); // do we need to do monochrome rendering?
 
     if (qb64_fh < 32) {
         strPixSize.x = codepoints * 8;
@@ -1238,7 +1573,8 @@ void sub__UPrintString(int32_t start_x, int32_t start_y, const qbs *text, int32_
         // IMAGE_DEBUG_CHECK(IS_VALID_FONT_HANDLE(font[qb64_fh]));
         fnt = fontManager.fonts[font[qb64_fh]];
         face = fnt->face;
-        strPixSize.x = fnt->GetStringPixelWidth(str32, codepoints);
+        run = fnt->GetTextRun(str32, codepoints, isMonochrome);
+        strPixSize.x = run->width;
         pen.x = 0;
         if (FT_IS_SCALABLE(face)) {
             strPixSize.y = FT_MulDiv(((FT_Long)face->ascender - (FT_Long)face->descender), (FT_Long)fnt->defaultHeight, (FT_Long)face->units_per_EM);
@@ -1255,22 +1591,21 @@ void sub__UPrintString(int32_t start_x, int32_t start_y, const qbs *text, int32_
     if (max_width && max_width < strPixSize.x)
         strPixSize.x = max_width;
 
-    auto drawBuf = (uint8_t *)calloc(strPixSize.x, strPixSize.y);
-    if (!drawBuf) {
-        if (passed & 8)
-            sub__dest(old_dst_img);
-        return;
-    }
-
-    // image_log_trace("Allocated (%lu x %lu) buffer", strPixSize.x, strPixSize.y);
-
-    auto isMonochrome = (write_page->bytes_per_pixel == 1) || ((write_page->bytes_per_pixel == 4) && (write_page->alpha_disabled)) ||
-                        (fontflags[qb64_fh] & FONT_LOAD_DONTBLEND); // do we need to do monochrome rendering?
+    const uint8_t *drawBuf;
 
     if (qb64_fh < 32) {
         // Render using a built-in font
         // image_log_trace("Rendering using built-in font");
 
+        auto builtinBuf = (uint8_t *)calloc(strPixSize.x, strPixSize.y);
+        if (!builtinBuf) {
+            if (passed & 8)
+                sub__dest(old_dst_img);
+            return;
+        }
+
+        // image_log_trace("Allocated (%lu x %lu) buffer", strPixSize.x, strPixSize.y);
+
         FT_Vector draw, pixmap;
         uint8_t const *builtinFont = nullptr;
 
@@ -1297,60 +1632,18 @@ void sub__UPrintString(int32_t start_x, int32_t start_y, const qbs *text, int32_
 
             for (draw.y = pen.y, pixmap.y = 0; pixmap.y < qb64_fh; draw.y++, pixmap.y++) {
                 for (draw.x = pen.x, pixmap.x = 0; pixmap.x < 8; draw.x++, pixmap.x++) {
-                    *(drawBuf + strPixSize.x * draw.y + draw.x) = *builtinFont++;
+                    *(builtinBuf + strPixSize.x * draw.y + draw.x) = *builtinFont++;
                 }
             }
 
             pen.x += 8;
         }
+
+        drawBuf = builtinBuf;
     } else {
-        // Render using custom font
+        // Render using custom font. The coverage is cached with the run, so redrawing the same text is just the blit below
         // image_log_trace("Rendering using TrueType font");
-
-        if (fnt->monospaceWidth) {
-            // Monospace rendering
-            for (size_t i = 0; i < codepoints; i++) {
-                auto cp = str32[i];
-
-                auto glyph = fnt->GetGlyph(cp, isMonochrome);
-                if (glyph) {
-                    if (max_width && pen.x + fnt->monospaceWidth > start_x + max_width)
-                        break;
-
-                    glyph->RenderBitmap(drawBuf, strPixSize.x, strPixSize.y,
-                                        pen.x + glyph->bitmap->bearing.x + (fnt->monospaceWidth >> 1) - (glyph->bitmap->advanceWidth >> 1),
-                                        pen.y - glyph->bitmap->bearing.y);
-                    pen.x += fnt->monospaceWidth;
-                }
-            }
-        } else {
-            // Variable width rendering
-            auto hasKerning = FT_HAS_KERNING(fnt->face); // set to true if font has kerning info
-            FontManager::Font::Glyph *glyph = nullptr;
-            FontManager::Font::Glyph *previousGlyph = nullptr;
-
-            for (size_t i = 0; i < codepoints; i++) {
-                auto cp = str32[i];
-
-                glyph = fnt->GetGlyph(cp, isMonochrome);
-                if (glyph) {
-
-                    if (max_width && pen.x + glyph->bitmap->size.x > start_x + max_width)
-                        break;
-
-                    // Add kerning advance width if kerning table is available
-                    if (hasKerning && previousGlyph && glyph) {
-                        FT_Vector delta;
-                        FT_Get_Kerning(fnt->face, previousGlyph->index, glyph->index, FT_KERNING_DEFAULT, &delta);
-                        pen.x += delta.x >> 6;
-                    }
-
-                    glyph->RenderBitmap(drawBuf, strPixSize.x, strPixSize.y, pen.x + glyph->bitmap->bearing.x, pen.y - glyph->bitmap->bearing.y);
-                    pen.x += glyph->bitmap->advanceWidth; // add advance width
-                    previousGlyph = glyph;                // save the current glyph pointer for use later
-                }
-            }
-        }
+        drawBuf = fnt->RenderTextRun(run, strPixSize.x, strPixSize.y, pen.y, max_width ? start_x + max_width : 0);
     }
 
     // Resolve coordinates based on current viewport settings
@@ -1459,7 +1752,8 @@ void sub__UPrintString(int32_t start_x, int32_t start_y, const qbs *text, int32_
         }
     }
 
-    free(drawBuf);
+    if (qb64_fh < 32)
+        free((void *)drawBuf);
 
     if (passed & 8)
         sub__dest(old_dst_img);
@@ -1591,8 +1885,8 @@ int32_t func__UCharPos(const qbs *text, void *arr, int32_t utf_encoding, int32_t
                     penX += delta.x >> 6;
                 }
 
-                penX += glyph->bitmap->advanceWidth; // add advance width
-                previousGlyph = glyph;               // save the current glyph pointer for use later
+                penX += glyph->GetBitmap(isMonochrome).advanceWidth; // add advance width
+                previousGlyph = glyph;                               // save the current glyph pointer for use later
             }
         }
 
@@ -17,6 +17,14 @@ int32_t FontLoad(const uint8_t *content_original, int32_t content_bytes, int32_t
     return 0;
 }
 
+int32_t FontLoadFile(const char *file_path_name, int32_t default_pixel_height, int32_t which_font, int32_t &options) {
+    (void)file_path_name;
+    (void)default_pixel_height;
+    (void)which_font;
+    (void)options;
+    return 0;
+}
+
 void FontFree(int32_t fh) {
     (void)fh;
 }
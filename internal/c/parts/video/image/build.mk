@@ -22,7 +22,8 @@ IMAGE_LIB := $(PATH_INTERNAL_C)/parts/video/image/image.a
 $(IMAGE_LIB): $(IMAGE_OBJS)
 	$(AR) rcs $@ $(IMAGE_OBJS)
 
-ifdef DEP_IMAGE_CODEC
+# libqb references the image library whenever DEPENDENCY_IMAGE_CODEC is defined (see the main Makefile)
+ifneq ($(filter y,$(DEP_IMAGE_CODEC) $(DEP_SCREENIMAGE)),)
     EXE_LIBS += $(IMAGE_LIB)
 endif
 
@@ -14,16 +14,20 @@
 //      jo_gif (https://www.jonolick.com/code)
 //      pixelscalers (https://github.com/janert/pixelscalers)
 //      mmpx (https://github.com/ITotalJustice/mmpx)
+//      miniz (https://github.com/richgel999/miniz)
 //
 //-----------------------------------------------------------------------------------------------------
 
 #include "image.h"
 #include "../../../libqb.h"
+#include "../../data/miniz.h"
+#include "condvar.h"
 #include "error_handle.h"
 #include "filepath.h"
 #include "graphics.h"
 #include "jo_gif/jo_gif.h"
 #include "libqb-common.h"
+#include "mutex.h"
 #include "nanosvg/nanosvg.h"
 #include "nanosvg/nanosvgrast.h"
 #include "pixelscalers/pixelscalers.h"
@@ -33,10 +37,18 @@
 #include "sg_pcx/sg_pcx.h"
 #include "stb/stb_image.h"
 #include "stb/stb_image_write.h"
+#include "thread.h"
 #include "tiny_webp/tiny_webp.h"
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <cmath>
+#include <deque>
+#include <list>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -44,7 +56,7 @@ extern const img_struct *img;                 // used by func__loadimage
 extern const img_struct *write_page;          // used by func__loadimage
 extern const uint32_t palette_256[];          // used by func__loadimage
 extern const int32_t *page;                   // used by func__saveimage
-extern const int32_t nextimg;                 // used by func__saveimage
+extern const int32_t nextimg;                 // used by func__saveimage & func__imageready
 extern const uint8_t charset8x8[256][8][8];   // used by func__saveimage
 extern const uint8_t charset8x16[256][16][8]; // used by func__saveimage
 
@@ -55,6 +67,54 @@ static const int g_ImageScaleFactor[] = {1, 2, 3, 4, 2, 2, 2, 3, 3};
 /// @brief Pixel scaler names for ImageScaler enum
 static const char *g_ImageScalerName[] = {"NONE", "SXBR2", "SXBR3", "SXBR4", "MMPX2", "HQ2XA", "HQ2XB", "HQ3XA", "HQ3XB"};
 
+/// @brief Band arguments for image_parallel_for_rows()
+template <typename Func> struct ImageRowBand {
+    Func *func;
+    int32_t rowStart;
+    int32_t rowEnd;
+};
+
+/// @brief Thread entry point for image_parallel_for_rows()
+template <typename Func> static void image_row_band_worker(void *arg) {
+    auto band = reinterpret_cast<ImageRowBand<Func> *>(arg);
+    (*band->func)(band->rowStart, band->rowEnd);
+}
+
+/// @brief Splits the rows of an image into horizontal bands and processes them in parallel. Small images are processed on the calling thread
+/// @param height The number of rows to process
+/// @param func A callable taking (rowStart, rowEnd). This is called once per band and must only touch the rows it was given
+/// @param minRowsPerBand The minimum number of rows that makes it worth using another thread
+template <typename Func> static void image_parallel_for_rows(int32_t height, Func func, int32_t minRowsPerBand = 64) {
+    auto bands = std::clamp<int32_t>(height / std::max(minRowsPerBand, 1), 1, std::max<int32_t>(std::thread::hardware_concurrency(), 1));
+
+    if (bands <= 1) {
+        func(0, height);
+        return;
+    }
+
+    image_log_trace("Processing %i rows in %i bands", height, bands);
+
+    std::vector<ImageRowBand<Func>> bandArgs(bands);
+    std::vector<libqb_thread *> threads(bands - 1, nullptr);
+
+    for (int32_t i = 0; i < bands; i++) {
+        bandArgs[i] = {&func, int32_t((int64_t(height) * i) / bands), int32_t((int64_t(height) * (i + 1)) / bands)};
+    }
+
+    // The last band is processed on the calling thread
+    for (int32_t i = 0; i < bands - 1; i++) {
+        threads[i] = libqb_thread_new();
+        libqb_thread_start(threads[i], image_row_band_worker<Func>, &bandArgs[i]);
+    }
+
+    image_row_band_worker<Func>(&bandArgs[bands - 1]);
+
+    for (auto thread : threads) {
+        libqb_thread_join(thread);
+        libqb_thread_free(thread);
+    }
+}
+
 /// @brief Runs a pixel scaler algorithm on raw image pixels. It will free 'data' if scaling occurs!
 /// @param data In + Out: The source raw image data in RGBA format
 /// @param xOut In + Out: The image width
@@ -63,6 +123,11 @@ static const char *g_ImageScalerName[] = {"NONE", "SXBR2", "SXBR3", "SXBR4", "MM
 /// @return A pointer to the scaled image or 'data' if there is no change
 static uint32_t *image_scale(uint32_t *data, int32_t *xOut, int32_t *yOut, ImageScaler scaler) {
     if (scaler > ImageScaler::NONE) {
+        if (size_t(scaler) >= _countof(g_ImageScaleFactor)) {
+            image_log_warn("Unsupported scaler %i", (int)scaler);
+            return data;
+        }
+
         auto newX = *xOut * g_ImageScaleFactor[size_t(scaler)];
         auto newY = *yOut * g_ImageScaleFactor[size_t(scaler)];
 
@@ -70,44 +135,48 @@ static uint32_t *image_scale(uint32_t *data, int32_t *xOut, int32_t *yOut, Image
         if (pixels) {
             image_log_info("Scaler %i: (%i x %i) -> (%i x %i)", (int)scaler, *xOut, *yOut, newX, newY);
 
-            switch (scaler) {
-            case ImageScaler::SXBR2:
-                scaleSuperXBR2(data, *xOut, *yOut, pixels);
-                break;
-
-            case ImageScaler::SXBR3:
-                scaleSuperXBR3(data, *xOut, *yOut, pixels);
-                break;
-
-            case ImageScaler::SXBR4:
-                scaleSuperXBR4(data, *xOut, *yOut, pixels);
-                break;
-
-            case ImageScaler::MMPX2:
-                mmpx_scale2x(data, pixels, *xOut, *yOut);
-                break;
-
-            case ImageScaler::HQ2XA:
-                hq2xA(data, *xOut, *yOut, pixels);
-                break;
-
-            case ImageScaler::HQ2XB:
-                hq2xB(data, *xOut, *yOut, pixels);
-                break;
-
-            case ImageScaler::HQ3XA:
-                hq3xA(data, *xOut, *yOut, pixels);
-                break;
-
-            case ImageScaler::HQ3XB:
-                hq3xB(data, *xOut, *yOut, pixels);
-                break;
-
-            default:
-                image_log_warn("Unsupported scaler %i", (int)scaler);
-                free(pixels);
-                return data;
-            }
+            // Every scaler only reads the source image and writes the output rows of its own band, so bands can be scaled in parallel
+            image_parallel_for_rows(
+                *yOut,
+                [=](int32_t rowStart, int32_t rowEnd) {
+                    switch (scaler) {
+                    case ImageScaler::SXBR2:
+                        scaleSuperXBR2(data, *xOut, *yOut, pixels, rowStart, rowEnd);
+                        break;
+
+                    case ImageScaler::SXBR3:
+                        scaleSuperXBR3(data, *xOut, *yOut, pixels, rowStart, rowEnd);
+                        break;
+
+                    case ImageScaler::SXBR4:
+                        scaleSuperXBR4(data, *xOut, *yOut, pixels, rowStart, rowEnd);
+                        break;
+
+                    case ImageScaler::MMPX2:
+                        mmpx_scale2x(data, pixels, *xOut, *yOut, rowStart, rowEnd);
+                        break;
+
+                    case ImageScaler::HQ2XA:
+                        hq2xA(data, *xOut, *yOut, pixels, rowStart, rowEnd);
+                        break;
+
+                    case ImageScaler::HQ2XB:
+                        hq2xB(data, *xOut, *yOut, pixels, rowStart, rowEnd);
+                        break;
+
+                    case ImageScaler::HQ3XA:
+                        hq3xA(data, *xOut, *yOut, pixels, rowStart, rowEnd);
+                        break;
+
+                    case ImageScaler::HQ3XB:
+                        hq3xB(data, *xOut, *yOut, pixels, rowStart, rowEnd);
+                        break;
+
+                    default:
+                        break;
+                    }
+                },
+                32);
 
             free(data);
             data = pixels;
@@ -119,100 +188,118 @@ static uint32_t *image_scale(uint32_t *data, int32_t *xOut, int32_t *yOut, Image
     return data;
 }
 
-/// @brief This is internally used by image_svg_load_from_file() and image_svg_load_fron_memory(). It always frees 'image' once done!
-/// @param image nanosvg image object pointer
-/// @param xOut Out: width in pixels. This cannot be NULL
-/// @param yOut Out: height in pixels. This cannot be NULL
-/// @param scaler An optional pixel scaler to use (it just used this to scale internally)
-/// @param components Out: color channels. This cannot be NULL
-/// @param isVG Out: vector graphics? Always set to true
-/// @return A pointer to the raw pixel data in RGBA format or NULL on failure
-static uint32_t *image_svg_load(NSVGimage *image, int32_t *xOut, int32_t *yOut, ImageScaler scaler, int *components, bool *isVG) {
-    auto rast = nsvgCreateRasterizer();
-    if (!rast) {
+/// @brief A parsed SVG document. Documents are cached so that the same SVG is parsed only once and so that images loaded from SVG can be rasterized
+/// again at any size
+struct ImageVector {
+    NSVGimage *image = nullptr; // the parsed document
+    std::string source;         // the SVG source the document was parsed from
+    size_t hash = 0;            // hash of source
+
+    ImageVector() = default;
+    ImageVector(const ImageVector &) = delete;
+    ImageVector &operator=(const ImageVector &) = delete;
+
+    ~ImageVector() {
         nsvgDelete(image);
-        return nullptr;
     }
+};
 
-    auto w = (int32_t)image->width * g_ImageScaleFactor[size_t(scaler)];
-    auto h = (int32_t)image->height * g_ImageScaleFactor[size_t(scaler)];
+/// @brief Recently parsed SVG documents and the documents that images were rasterized from
+struct ImageVectorCache {
+    static constexpr size_t CACHE_SIZE = 16; // number of recently parsed documents that are kept even if no image uses them
 
-    auto pixels = (uint32_t *)malloc(sizeof(uint32_t) * w * h);
-    if (!pixels) {
-        nsvgDeleteRasterizer(rast);
-        nsvgDelete(image);
-        return nullptr;
+    libqb_mutex *lock;                                                // documents are also parsed by the asynchronous loader threads
+    std::list<std::shared_ptr<ImageVector>> documents;                // most recently used first
+    std::unordered_map<int32_t, std::shared_ptr<ImageVector>> images; // image handle -> the document the image was rasterized from
+
+    ImageVectorCache() {
+        lock = libqb_mutex_new();
     }
+};
 
-    nsvgRasterize(rast, image, 0, 0, g_ImageScaleFactor[size_t(scaler)], reinterpret_cast<unsigned char *>(pixels), w, h, sizeof(uint32_t) * w);
-    nsvgDeleteRasterizer(rast);
-    nsvgDelete(image);
+static ImageVectorCache g_ImageVectorCache;
 
-    *xOut = w;
-    *yOut = h;
-    *components = sizeof(uint32_t);
-    *isVG = true;
-    return pixels;
-}
+/// @brief Parses an SVG document or returns the cached document if the same SVG was parsed recently
+/// @param buffer The raw pointer to the file in memory
+/// @param size The size of the file in memory
+/// @return The parsed document or nullptr on failure
+static std::shared_ptr<ImageVector> image_vector_parse(const uint8_t *buffer, size_t size) {
+    auto cache = &g_ImageVectorCache;
+    std::string_view source(reinterpret_cast<const char *>(buffer), size);
+    auto hash = std::hash<std::string_view>{}(source);
+
+    {
+        libqb_mutex_guard guard(cache->lock);
+
+        for (auto it = cache->documents.begin(); it != cache->documents.end(); ++it) {
+            if ((*it)->hash == hash && (*it)->source == source) {
+                cache->documents.splice(cache->documents.begin(), cache->documents, it); // move to the front of the LRU list
+                image_log_trace("Using cached SVG document");
+                return cache->documents.front();
+            }
+        }
+    }
 
-/// @brief Loads an SVG image file from disk
-/// @param fileName The file path name to load
-/// @param xOut Out: width in pixels. This cannot be NULL
-/// @param yOut Out: height in pixels. This cannot be NULL
-/// @param scaler An optional pixel scaler to use (it just used this to scale internally)
-/// @param components Out: color channels. This cannot be NULL
-/// @param isVG Out: vector graphics? Always set to true
-/// @return A pointer to the raw pixel data in RGBA format or NULL on failure
-static uint32_t *image_svg_load_from_file(const char *fileName, int32_t *xOut, int32_t *yOut, ImageScaler scaler, int *components, bool *isVG) {
-    if (!filepath_has_extension(fileName, "svg"))
-        return nullptr;
+    std::string svgString(source); // nsvgParse() changes the string, so it gets a copy
 
-    auto fp = fopen(fileName, "rb");
-    if (!fp)
+    // Check if it has a valid SVG start tag
+    if (!strstr(svgString.c_str(), "<svg"))
         return nullptr;
 
-    if (fseek(fp, 0, SEEK_END)) {
-        fclose(fp);
+    auto image = nsvgParse(svgString.data(), "px", 96.0f);
+    if (!image)
         return nullptr;
-    }
 
-    auto size = ftell(fp);
-    if (size < 0) {
-        fclose(fp);
-        return nullptr;
-    }
+    auto vector = std::make_shared<ImageVector>();
+    vector->image = image;
+    vector->source = source;
+    vector->hash = hash;
 
-    rewind(fp);
+    libqb_mutex_guard guard(cache->lock);
 
-    auto svgString = (char *)malloc(size + 1);
-    if (!svgString) {
-        fclose(fp);
+    cache->documents.push_front(vector);
+    if (cache->documents.size() > ImageVectorCache::CACHE_SIZE)
+        cache->documents.pop_back(); // images rasterized from this document keep it alive
+
+    return vector;
+}
+
+/// @brief Rasterizes an SVG document. Large images are rasterized in horizontal bands by multiple threads
+/// @param vector The parsed document
+/// @param w The width of the image to render
+/// @param h The height of the image to render
+/// @param tx The x offset of the document (applied after scaling)
+/// @param ty The y offset of the document (applied after scaling)
+/// @param scale The document scale
+/// @return A pointer to the raw pixel data in RGBA format or NULL on failure
+static uint32_t *image_vector_rasterize(const ImageVector *vector, int32_t w, int32_t h, float tx, float ty, float scale) {
+    if (w < 1 || h < 1)
         return nullptr;
-    }
 
-    if (long(fread(svgString, sizeof(uint8_t), size, fp)) != size) {
-        free(svgString);
-        fclose(fp);
+    auto pixels = (uint32_t *)malloc(sizeof(uint32_t) * w * h);
+    if (!pixels)
         return nullptr;
-    }
-    svgString[size] = '\0'; // must be null terminated
 
-    fclose(fp);
+    std::atomic<bool> isOk = true;
 
-    // Check if it has a valid SVG start tag
-    if (!strstr(svgString, "<svg")) {
-        free(svgString);
-        return nullptr;
-    }
+    // Every band gets its own rasterizer. The alpha is unpremultiplied once all bands are done because the defringing looks at neighboring rows
+    image_parallel_for_rows(h, [&](int32_t rowStart, int32_t rowEnd) {
+        auto rast = nsvgCreateRasterizer();
+        if (!rast) {
+            isOk = false;
+            return;
+        }
 
-    auto image = nsvgParse(svgString, "px", 96.0f); // important note: changes the string
-    if (!image) {
-        free(svgString);
+        nsvgRasterizeRows(rast, vector->image, tx, ty, scale, reinterpret_cast<unsigned char *>(pixels), w, h, sizeof(uint32_t) * w, rowStart, rowEnd);
+        nsvgDeleteRasterizer(rast);
+    });
+
+    if (!isOk) {
+        free(pixels);
         return nullptr;
     }
 
-    auto pixels = image_svg_load(image, xOut, yOut, scaler, components, isVG); // this is where everything else is freed
-    free(svgString);
+    nsvgUnpremultiplyAlpha(reinterpret_cast<unsigned char *>(pixels), w, h, sizeof(uint32_t) * w);
 
     return pixels;
 }
@@ -225,48 +312,57 @@ static uint32_t *image_svg_load_from_file(const char *fileName, int32_t *xOut, i
 /// @param scaler An optional pixel scaler to use (it just used this to scale internally)
 /// @param components Out: color channels. This cannot be NULL
 /// @param isVG Out: vector graphics? Always set to true
+/// @param vectorOut Out: The parsed document. This can be NULL
 /// @return A pointer to the raw pixel data in RGBA format or NULL on failure
-static uint32_t *image_svg_load_from_memory(const uint8_t *buffer, size_t size, int32_t *xOut, int32_t *yOut, ImageScaler scaler, int *components, bool *isVG) {
-    auto svgString = (char *)malloc(size + 1);
-    if (!svgString)
+static uint32_t *image_svg_load_from_memory(const uint8_t *buffer, size_t size, int32_t *xOut, int32_t *yOut, ImageScaler scaler, int *components, bool *isVG,
+                                            std::shared_ptr<ImageVector> *vectorOut) {
+    auto vector = image_vector_parse(buffer, size);
+    if (!vector)
         return nullptr;
 
-    memcpy(svgString, buffer, size);
-    svgString[size] = '\0'; // must be null terminated
+    auto w = (int32_t)vector->image->width * g_ImageScaleFactor[size_t(scaler)];
+    auto h = (int32_t)vector->image->height * g_ImageScaleFactor[size_t(scaler)];
 
-    // Check if it has a valid SVG start tag
-    if (!strstr(svgString, "<svg")) {
-        free(svgString);
+    auto pixels = image_vector_rasterize(vector.get(), w, h, 0.0f, 0.0f, g_ImageScaleFactor[size_t(scaler)]);
+    if (!pixels)
         return nullptr;
-    }
 
-    auto image = nsvgParse(svgString, "px", 96.0f); // important note: changes the string
-    if (!image) {
-        free(svgString);
-        return nullptr;
-    }
+    *xOut = w;
+    *yOut = h;
+    *components = sizeof(uint32_t);
+    *isVG = true;
 
-    auto pixels = image_svg_load(image, xOut, yOut, scaler, components, isVG); // this is where everything else is freed
-    free(svgString);
+    if (vectorOut)
+        *vectorOut = std::move(vector);
 
     return pixels;
 }
 
-/// @brief Loads a QOI image file from disk
-/// @param fileName The file path name to load
-/// @param xOut Out: width in pixels. This cannot be NULL
-/// @param yOut Out: height in pixels. This cannot be NULL
-/// @param components Out: color channels. This cannot be NULL
-/// @return A pointer to the raw pixel data in RGBA format or NULL on failure
-static uint32_t *image_qoi_load_from_file(const char *fileName, int32_t *xOut, int32_t *yOut, int *components) {
-    qoi_desc desc;
-    auto pixels = reinterpret_cast<uint32_t *>(qoi_read(fileName, &desc, sizeof(uint32_t)));
-    if (pixels) {
-        *xOut = desc.width;
-        *yOut = desc.height;
-        *components = desc.channels;
-    }
-    return pixels;
+/// @brief Makes an image remember the SVG document it was rasterized from so that _SCALEIMAGE can rasterize it again
+/// @param handle The image handle
+/// @param vector The parsed document
+static void image_vector_attach(int32_t handle, std::shared_ptr<ImageVector> vector) {
+    libqb_mutex_guard guard(g_ImageVectorCache.lock);
+
+    g_ImageVectorCache.images[handle] = std::move(vector);
+}
+
+/// @brief Returns the SVG document an image was rasterized from
+/// @param handle The image handle
+/// @return The parsed document or nullptr if the image was not loaded from an SVG
+static std::shared_ptr<ImageVector> image_vector_find(int32_t handle) {
+    libqb_mutex_guard guard(g_ImageVectorCache.lock);
+
+    auto it = g_ImageVectorCache.images.find(handle);
+    return it != g_ImageVectorCache.images.end() ? it->second : nullptr;
+}
+
+/// @brief Drops the SVG document of an image. This is used by _FREEIMAGE
+/// @param handle The image handle
+void image_vector_release(int32_t handle) {
+    libqb_mutex_guard guard(g_ImageVectorCache.lock);
+
+    g_ImageVectorCache.images.erase(handle);
 }
 
 /// @brief Loads a QOI image file from memory
@@ -287,20 +383,6 @@ static uint32_t *image_qoi_load_from_memory(const uint8_t *buffer, size_t size,
     return pixels;
 }
 
-/// @brief Loads a tiny_webp image file from disk.
-/// @param fileName The file path name to load.
-/// @param xOut Out: width in pixels. This cannot be NULL.
-/// @param yOut Out: height in pixels. This cannot be NULL.
-/// @param components Out: color channels. This cannot be NULL.
-/// @return A pointer to the raw pixel data in RGBA format or NULL on failure.
-static uint32_t *image_tiny_webp_load_from_file(const char *fileName, int32_t *xOut, int32_t *yOut, int *components) {
-    auto pixels = reinterpret_cast<uint32_t *>(twp_read(fileName, xOut, yOut, twp_FORMAT_RGBA, 0));
-    if (pixels) {
-        *components = sizeof(uint32_t);
-    }
-    return pixels;
-}
-
 /// @brief Loads a tiny_webp image file from memory.
 /// @param buffer The raw pointer to the file in memory.
 /// @param size The size of the file in memory.
@@ -316,49 +398,139 @@ static uint32_t *image_tiny_webp_load_from_memory(const uint8_t *buffer, size_t
     return pixels;
 }
 
-/// @brief Decodes an image file from a file using the sg_pcx & stb_image libraries.
-/// @param fileName A valid filename
+/// @brief Image file formats that can be identified by image_detect_format(). The order is also the order in which decoders are tried when the format is
+/// unknown
+enum class ImageFormat { UNKNOWN = 0, STB, WEBP, PCX, QOI, CURICO, SVG };
+/// @brief Decoder names for ImageFormat enum (used for logging)
+static const char *g_ImageFormatName[] = {"unknown", "stb_image", "tiny_webp", "sg_pcx", "qoi", "sg_curico", "nanosvg"};
+
+/// @brief Identifies the image format using the file signature and optionally the file extension (for formats that do not have a signature)
+/// @param data The raw pointer to the file in memory
+/// @param size The size of the file in memory
+/// @param fileName An optional file name. This can be NULL
+/// @return The detected format or ImageFormat::UNKNOWN
+static ImageFormat image_detect_format(const uint8_t *data, size_t size, const char *fileName) {
+    auto matches = [data, size](size_t offset, const char *magic) {
+        auto len = strlen(magic);
+        return size >= offset + len && !memcmp(data + offset, magic, len);
+    };
+
+    if (matches(0, "\x89PNG") || matches(0, "\xFF\xD8\xFF") || matches(0, "GIF8") || matches(0, "BM") || matches(0, "8BPS") || matches(0, "#?RADIANCE") ||
+        matches(0, "#?RGBE") || matches(0, "\x53\x80\xF6\x34") || (size > 2 && data[0] == 'P' && (data[1] == '5' || data[1] == '6') && isspace(data[2])))
+        return ImageFormat::STB;
+
+    if (matches(0, "RIFF") && matches(8, "WEBP"))
+        return ImageFormat::WEBP;
+
+    if (matches(0, "qoif"))
+        return ImageFormat::QOI;
+
+    // ICONDIR: reserved = 0, type = 1 (icon) or 2 (cursor), count > 0
+    if (size >= 6 && !data[0] && !data[1] && (data[2] == 1 || data[2] == 2) && !data[3] && (data[4] || data[5]))
+        return ImageFormat::CURICO;
+
+    // ZSoft PCX: manufacturer = 10, version <= 5, encoding <= 1, bpp = 1, 2, 4 or 8
+    if (size >= 128 && data[0] == 0x0A && data[1] <= 5 && data[2] <= 1 && (data[3] == 1 || data[3] == 2 || data[3] == 4 || data[3] == 8))
+        return ImageFormat::PCX;
+
+    // Skip any leading whitespace or UTF-8 BOM and check for an XML start
+    size_t i = matches(0, "\xEF\xBB\xBF") ? 3 : 0;
+    while (i < size && isspace(data[i]))
+        ++i;
+    if (i < size && data[i] == '<')
+        return ImageFormat::SVG;
+
+    if (fileName) {
+        if (filepath_has_extension(fileName, "tga"))
+            return ImageFormat::STB;
+
+        if (filepath_has_extension(fileName, "svg"))
+            return ImageFormat::SVG;
+    }
+
+    return ImageFormat::UNKNOWN;
+}
+
+/// @brief Decodes an image from memory using a specific decoder
+/// @param format The decoder to use. This cannot be ImageFormat::UNKNOWN
+/// @param data The raw pointer to the file in memory
+/// @param size The size of the file in memory
 /// @param xOut Out: width in pixels. This cannot be NULL
 /// @param yOut Out: height in pixels. This cannot be NULL
-/// @param scaler An optional pixel scaler to use
+/// @param scaler An optional pixel scaler to use (only used by the vector graphics decoder)
+/// @param components Out: color channels. This cannot be NULL
+/// @param isVG Out: vector graphics? This cannot be NULL
+/// @param vectorOut Out: The parsed SVG document for vector graphics. This can be NULL
 /// @return A pointer to the raw pixel data in RGBA format or NULL on failure
-static uint32_t *image_decode_from_file(const char *fileName, int32_t *xOut, int32_t *yOut, ImageScaler scaler) {
-    auto compOut = 0;
-    auto isVG = false; // we will not use scalers for vector graphics
+static uint32_t *image_decode_format(ImageFormat format, const uint8_t *data, size_t size, int32_t *xOut, int32_t *yOut, ImageScaler scaler, int *components,
+                                     bool *isVG, std::shared_ptr<ImageVector> *vectorOut) {
+    uint32_t *pixels = nullptr;
 
-    image_log_info("Loading image from file %s", fileName);
+    switch (format) {
+    case ImageFormat::STB:
+        pixels = reinterpret_cast<uint32_t *>(stbi_load_from_memory(reinterpret_cast<const stbi_uc *>(data), size, xOut, yOut, components, 4));
+        break;
 
-    auto pixels = reinterpret_cast<uint32_t *>(stbi_load(fileName, xOut, yOut, &compOut, 4));
-    image_log_trace("Image dimensions (stb_image) = (%i, %i)", *xOut, *yOut);
+    case ImageFormat::WEBP:
+        pixels = image_tiny_webp_load_from_memory(data, size, xOut, yOut, components);
+        break;
 
-    if (!pixels) {
-        pixels = image_tiny_webp_load_from_file(fileName, xOut, yOut, &compOut);
-        image_log_trace("Image dimensions (tiny_webp) = (%i, %i)", *xOut, *yOut);
+    case ImageFormat::PCX:
+        pixels = pcx_load_memory(data, size, xOut, yOut, components);
+        break;
 
-        if (!pixels) {
-            pixels = pcx_load_file(fileName, xOut, yOut, &compOut);
-            image_log_trace("Image dimensions (sg_pcx) = (%i, %i)", *xOut, *yOut);
+    case ImageFormat::QOI:
+        pixels = image_qoi_load_from_memory(data, size, xOut, yOut, components);
+        break;
 
-            if (!pixels) {
-                pixels = image_qoi_load_from_file(fileName, xOut, yOut, &compOut);
-                image_log_trace("Image dimensions (qoi) = (%i, %i)", *xOut, *yOut);
+    case ImageFormat::CURICO:
+        pixels = curico_load_memory(data, size, xOut, yOut, components);
+        break;
 
-                if (!pixels) {
-                    pixels = curico_load_file(fileName, xOut, yOut, &compOut);
-                    image_log_trace("Image dimensions (sg_curico) = (%i, %i)", *xOut, *yOut);
+    case ImageFormat::SVG:
+        pixels = image_svg_load_from_memory(data, size, xOut, yOut, scaler, components, isVG, vectorOut);
+        break;
 
-                    if (!pixels) {
-                        pixels = image_svg_load_from_file(fileName, xOut, yOut, scaler, &compOut, &isVG);
-                        image_log_trace("Image dimensions (nanosvg) = (%i, %i)", *xOut, *yOut);
+    default:
+        IMAGE_DEBUG_CHECK(false);
+    }
 
-                        if (!pixels)
-                            return nullptr; // Return NULL if all attempts failed
-                    }
-                }
-            }
-        }
+    image_log_trace("Image dimensions (%s) = (%i, %i)", g_ImageFormatName[size_t(format)], *xOut, *yOut);
+
+    return pixels;
+}
+
+/// @brief Decodes an image file from memory. The format is identified using image_detect_format() and only the matching decoder is used. All other decoders
+/// are tried only if the format is unknown or the matching decoder fails
+/// @param data The raw pointer to the file in memory
+/// @param size The size of the file in memory
+/// @param xOut Out: width in pixels. This cannot be NULL
+/// @param yOut Out: height in pixels. This cannot be NULL
+/// @param scaler An optional pixel scaler to use
+/// @param fileName An optional file name that is used to identify formats that do not have a signature. This can be NULL
+/// @param vectorOut Out: The parsed SVG document if the image is vector graphics. This can be NULL
+/// @return A pointer to the raw pixel data in RGBA format or NULL on failure
+static uint32_t *image_decode_from_memory(const uint8_t *data, size_t size, int32_t *xOut, int32_t *yOut, ImageScaler scaler, const char *fileName = nullptr,
+                                          std::shared_ptr<ImageVector> *vectorOut = nullptr) {
+    auto compOut = 0;
+    auto isVG = false; // we will not use scalers for vector graphics
+    uint32_t *pixels = nullptr;
+
+    auto format = image_detect_format(data, size, fileName);
+    image_log_trace("Detected image format: %s", g_ImageFormatName[size_t(format)]);
+
+    if (format != ImageFormat::UNKNOWN)
+        pixels = image_decode_format(format, data, size, xOut, yOut, scaler, &compOut, &isVG, vectorOut);
+
+    // Fallback for formats without a signature (e.g. TGA) and files with misleading signatures
+    for (auto i = size_t(ImageFormat::STB); !pixels && i < _countof(g_ImageFormatName); i++) {
+        if (ImageFormat(i) != format)
+            pixels = image_decode_format(ImageFormat(i), data, size, xOut, yOut, scaler, &compOut, &isVG, vectorOut);
     }
 
+    if (!pixels)
+        return nullptr; // Return NULL if all attempts failed
+
     IMAGE_DEBUG_CHECK(compOut > 2);
 
     if (!isVG)
@@ -367,56 +539,185 @@ static uint32_t *image_decode_from_file(const char *fileName, int32_t *xOut, int
     return pixels;
 }
 
-/// @brief Decodes an image file from memory using the sg_pcx & stb_image libraries
-/// @param data The raw pointer to the file in memory
-/// @param size The size of the file in memory
+/// @brief Decodes an image file from disk. The whole file is read once and then decoded from memory
+/// @param fileName A valid filename
 /// @param xOut Out: width in pixels. This cannot be NULL
 /// @param yOut Out: height in pixels. This cannot be NULL
 /// @param scaler An optional pixel scaler to use
+/// @param vectorOut Out: The parsed SVG document if the image is vector graphics. This can be NULL
 /// @return A pointer to the raw pixel data in RGBA format or NULL on failure
-static uint32_t *image_decode_from_memory(const uint8_t *data, size_t size, int32_t *xOut, int32_t *yOut, ImageScaler scaler) {
-    auto compOut = 0;
-    auto isVG = false; // we will not use scalers for vector graphics
+static uint32_t *image_decode_from_file(const char *fileName, int32_t *xOut, int32_t *yOut, ImageScaler scaler, std::shared_ptr<ImageVector> *vectorOut = nullptr) {
+    image_log_info("Loading image from file %s", fileName);
 
-    image_log_info("Loading image from memory");
+    auto fp = fopen(fileName, "rb");
+    if (!fp) {
+        image_log_error("Failed to open %s", fileName);
+        return nullptr;
+    }
 
-    auto pixels = reinterpret_cast<uint32_t *>(stbi_load_from_memory(reinterpret_cast<const stbi_uc *>(data), size, xOut, yOut, &compOut, 4));
-    image_log_trace("Image dimensions (stb_image) = (%i, %i)", *xOut, *yOut);
+    if (fseek(fp, 0, SEEK_END)) {
+        fclose(fp);
+        return nullptr;
+    }
 
-    if (!pixels) {
-        pixels = image_tiny_webp_load_from_memory(data, size, xOut, yOut, &compOut);
-        image_log_trace("Image dimensions (tiny_webp) = (%i, %i)", *xOut, *yOut);
+    auto size = ftell(fp);
+    if (size <= 0) {
+        fclose(fp);
+        return nullptr;
+    }
 
-        if (!pixels) {
-            pixels = pcx_load_memory(data, size, xOut, yOut, &compOut);
-            image_log_trace("Image dimensions (sg_pcx) = (%i, %i)", *xOut, *yOut);
+    rewind(fp);
 
-            if (!pixels) {
-                pixels = image_qoi_load_from_memory(data, size, xOut, yOut, &compOut);
-                image_log_trace("Image dimensions (qoi) = (%i, %i)", *xOut, *yOut);
+    std::vector<uint8_t> buffer(size);
+    if (fread(buffer.data(), size, 1, fp) != 1) {
+        image_log_error("Failed to read %s", fileName);
+        fclose(fp);
+        return nullptr;
+    }
+
+    fclose(fp);
 
-                if (!pixels) {
-                    pixels = curico_load_memory(data, size, xOut, yOut, &compOut);
-                    image_log_trace("Image dimensions (sg_curico) = (%i, %i)", *xOut, *yOut);
+    return image_decode_from_memory(buffer.data(), buffer.size(), xOut, yOut, scaler, fileName, vectorOut);
+}
 
-                    if (!pixels) {
-                        pixels = image_svg_load_from_memory(data, size, xOut, yOut, scaler, &compOut, &isVG);
-                        image_log_trace("Image dimensions (nanosvg) = (%i, %i)", *xOut, *yOut);
+/// @brief Dithering methods used when converting 32bpp images to 8bpp
+enum class ImageDither { NONE = 0, FLOYD_STEINBERG, ORDERED };
+/// @brief Dithering method names for ImageDither enum (as used in the _LOADIMAGE requirements string)
+static const char *g_ImageDitherName[] = {"NODITHER", "FSDITHER", "ORDERED"};
 
-                        if (!pixels)
-                            return nullptr; // Return NULL if all attempts failed
-                    }
-                }
+/// @brief Generates an adaptive palette using median-cut over a histogram of the whole image. Colors are binned to RGB 5:6:5 for the histogram.
+/// @param src32 The source raw image data. This must be in BGRA format and not NULL.
+/// @param w The width of the image in pixels.
+/// @param h The height of the image in pixels.
+/// @param dstPalette The generated 256 color palette. This cannot be NULL.
+static void image_generate_adaptive_palette(const uint32_t *src32, int32_t w, int32_t h, uint32_t *dstPalette) {
+    static constexpr auto HISTOGRAM_BINS = size_t{1} << 16;
+
+    struct HistogramBin {
+        uint32_t count;
+        uint64_t r, g, b;
+    };
+
+    struct ColorBox {
+        size_t begin, end; // range in the colors vector
+        uint64_t population;
+        int axis;     // longest axis (0 = red, 1 = green, 2 = blue)
+        double score; // population weighted length of the longest axis; 0 if the box cannot be split
+    };
+
+    auto bin_of = [](uint8_t r, uint8_t g, uint8_t b) { return (size_t(r >> 3) << 11) | (size_t(g >> 2) << 5) | size_t(b >> 3); };
+
+    // Build the full histogram; bins also accumulate the real color sums so that the final palette is not limited to 5:6:5 colors
+    std::vector<HistogramBin> histogram(HISTOGRAM_BINS, HistogramBin{});
+    auto imageSize = size_t(w) * size_t(h);
+
+    for (size_t i = 0; i < imageSize; i++) {
+        auto c = src32[i];
+        auto r = image_get_bgra_red(c), g = image_get_bgra_green(c), b = image_get_bgra_blue(c);
+        auto &bin = histogram[bin_of(r, g, b)];
+        bin.count++;
+        bin.r += r;
+        bin.g += g;
+        bin.b += b;
+    }
+
+    // Collect the used bins as average colors with their population
+    struct BinColor {
+        uint8_t c[3]; // r, g, b
+        uint32_t count;
+    };
+
+    std::vector<BinColor> colors;
+    for (auto &bin : histogram) {
+        if (bin.count) {
+            colors.push_back({{uint8_t(bin.r / bin.count), uint8_t(bin.g / bin.count), uint8_t(bin.b / bin.count)}, bin.count});
+        }
+    }
+
+    image_log_trace("Histogram colors = %llu", colors.size());
+
+    if (colors.empty()) {
+        for (size_t i = 0; i < IMAGE_8BPP_MAX_COLORS; i++) {
+            auto gray = uint8_t((255u * i) / (IMAGE_8BPP_MAX_COLORS - 1u));
+            dstPalette[i] = image_make_bgr_gray(gray);
+        }
+
+        return;
+    }
+
+    // Creates a box and finds its longest axis
+    auto make_box = [&colors](size_t begin, size_t end, uint64_t population) {
+        uint8_t lo[3] = {255, 255, 255}, hi[3] = {0, 0, 0};
+        for (auto i = begin; i < end; i++) {
+            for (auto k = 0; k < 3; k++) {
+                lo[k] = std::min(lo[k], colors[i].c[k]);
+                hi[k] = std::max(hi[k], colors[i].c[k]);
             }
         }
+
+        auto axis = 0;
+        for (auto k = 1; k < 3; k++) {
+            if (hi[k] - lo[k] > hi[axis] - lo[axis])
+                axis = k;
+        }
+
+        auto score = end - begin < 2 ? 0.0 : double(hi[axis] - lo[axis]) * double(population);
+
+        return ColorBox{begin, end, population, axis, score};
+    };
+
+    std::vector<ColorBox> boxes;
+    boxes.reserve(IMAGE_8BPP_MAX_COLORS);
+    {
+        uint64_t population = 0;
+        for (auto &c : colors)
+            population += c.count;
+        boxes.push_back(make_box(0, colors.size(), population));
     }
 
-    IMAGE_DEBUG_CHECK(compOut > 2);
+    // Keep splitting the box with the largest population weighted range at its population median
+    while (boxes.size() < IMAGE_8BPP_MAX_COLORS) {
+        auto bestBox = std::max_element(boxes.begin(), boxes.end(), [](const ColorBox &a, const ColorBox &b) { return a.score < b.score; });
+        if (bestBox->score <= 0.0)
+            break; // nothing left to split
+
+        auto box = *bestBox;
+        auto axis = box.axis;
+        std::sort(colors.begin() + box.begin, colors.begin() + box.end, [axis](const BinColor &a, const BinColor &b) { return a.c[axis] < b.c[axis]; });
+
+        uint64_t half = 0;
+        auto split = box.begin;
+        while (split < box.end - 1 && half + colors[split].count <= box.population / 2) {
+            half += colors[split].count;
+            ++split;
+        }
+        if (split == box.begin) {
+            half += colors[split].count;
+            ++split;
+        }
 
-    if (!isVG)
-        pixels = image_scale(pixels, xOut, yOut, scaler);
+        *bestBox = make_box(box.begin, split, half);
+        boxes.push_back(make_box(split, box.end, box.population - half));
+    }
 
-    return pixels;
+    // Each box contributes its population weighted average color
+    size_t paletteUsed = 0;
+    for (auto &box : boxes) {
+        uint64_t r = 0, g = 0, b = 0;
+        for (auto i = box.begin; i < box.end; i++) {
+            r += uint64_t(colors[i].c[0]) * colors[i].count;
+            g += uint64_t(colors[i].c[1]) * colors[i].count;
+            b += uint64_t(colors[i].c[2]) * colors[i].count;
+        }
+
+        dstPalette[paletteUsed++] = image_make_bgra(uint8_t(r / box.population), uint8_t(g / box.population), uint8_t(b / box.population));
+    }
+
+    image_log_trace("Adaptive palette colors = %llu", paletteUsed);
+
+    for (auto i = paletteUsed; i < IMAGE_8BPP_MAX_COLORS; i++) {
+        dstPalette[i] = dstPalette[paletteUsed - 1];
+    }
 }
 
 /// @brief This takes in a 32bpp (BGRA) image raw data and spits out an 8bpp raw image along with it's 256 color (BGRA) palette.
@@ -426,7 +727,9 @@ static uint32_t *image_decode_from_memory(const uint8_t *data, size_t size, int3
 /// @param h The height of the image in pixels.
 /// @param dst A pointer to the destination 8bpp raw image data. This cannot be NULL.
 /// @param dstPalette A 256 color palette if the operation was successful. This cannot be NULL.
-static void image_convert_8bpp(const uint32_t *src32, const uint32_t *srcPalette, int32_t w, int32_t h, uint8_t *dst, uint32_t *dstPalette) {
+/// @param dither The dithering method to use.
+static void image_convert_8bpp(const uint32_t *src32, const uint32_t *srcPalette, int32_t w, int32_t h, uint8_t *dst, uint32_t *dstPalette,
+                               ImageDither dither = ImageDither::FLOYD_STEINBERG) {
     image_log_info("Converting 32bpp image (%i, %i) to 8bpp", w, h);
 
     if (srcPalette) {
@@ -436,118 +739,52 @@ static void image_convert_8bpp(const uint32_t *src32, const uint32_t *srcPalette
     } else {
         image_log_trace("Generating adaptive palette");
 
-        const size_t maxUnique = 4096u;
-        std::vector<uint32_t> histColors;
-        histColors.reserve(maxUnique);
-        std::vector<size_t> histCounts;
-        histCounts.reserve(maxUnique);
-        std::unordered_map<uint32_t, size_t> uniqueColorMap;
-
-        auto stepX = std::max(w / 64, 1);
-        auto stepY = std::max(h / 64, 1);
-
-        for (int32_t y = 0; y < h; y += stepY) {
-            for (int32_t x = 0; x < w; x += stepX) {
-                auto c = src32[size_t(y) * size_t(w) + size_t(x)];
-                auto it = uniqueColorMap.find(c);
-                if (it != uniqueColorMap.end()) {
-                    histCounts[it->second]++;
-                } else if (uniqueColorMap.size() < maxUnique) {
-                    auto newIndex = uniqueColorMap.size();
-                    uniqueColorMap[c] = newIndex;
-                    histColors.push_back(c);
-                    histCounts.push_back(1);
-                }
-            }
-        }
-
-        auto uniqueCount = uniqueColorMap.size();
-        if (uniqueCount == 0) {
-            for (size_t i = 0; i < IMAGE_8BPP_MAX_COLORS; i++) {
-                auto gray = uint8_t((255u * i) / (IMAGE_8BPP_MAX_COLORS - 1u));
-                dstPalette[i] = image_make_bgr_gray(gray);
-            }
-        } else {
-            size_t maxCount = 1;
-            for (size_t i = 0; i < uniqueCount; i++) {
-                if (histCounts[i] > maxCount) {
-                    maxCount = histCounts[i];
-                }
-            }
-
-            std::vector<bool> chosen(uniqueCount, false);
-            std::vector<float> minDist2(uniqueCount, -1.0f);
-
-            size_t firstIdx = 0;
-            for (size_t i = 1; i < uniqueCount; i++) {
-                if (histCounts[i] > histCounts[firstIdx]) {
-                    firstIdx = i;
-                }
-            }
-
-            dstPalette[0] = histColors[firstIdx];
-            chosen[firstIdx] = true;
-            size_t paletteUsed = 1;
-
-            auto r1 = image_get_bgra_red(histColors[firstIdx]);
-            auto g1 = image_get_bgra_green(histColors[firstIdx]);
-            auto b1 = image_get_bgra_blue(histColors[firstIdx]);
-
-            for (size_t j = 0; j < uniqueCount; j++) {
-                if (!chosen[j]) {
-                    minDist2[j] = image_get_rgb_redmean_dist_sq(r1, g1, b1, image_get_bgra_red(histColors[j]), image_get_bgra_green(histColors[j]),
-                                                                image_get_bgra_blue(histColors[j]));
-                }
-            }
-
-            while (paletteUsed < IMAGE_8BPP_MAX_COLORS) {
-                auto bestScore = -1.0f;
-                int32_t bestIdx = -1;
-
-                for (size_t j = 0; j < uniqueCount; j++) {
-                    if (!chosen[j]) {
-                        auto popWeight = 1 + (histCounts[j] * 255) / maxCount;
-                        auto d2 = minDist2[j] < 0.0f ? 0.0f : minDist2[j];
-                        auto score = d2 * popWeight;
+        image_generate_adaptive_palette(src32, w, h, dstPalette);
+    }
 
-                        if (score > bestScore) {
-                            bestScore = score;
-                            bestIdx = int32_t(j);
-                        }
+    using LookupCache = ImagePaletteLookupCache<decltype(&image_get_rgb_redmean_dist_sq)>;
+
+    if (dither != ImageDither::FLOYD_STEINBERG) {
+        // Without error diffusion every pixel is independent, so rows can be mapped in parallel
+        image_log_trace("Applying %s", dither == ImageDither::ORDERED ? "ordered dithering" : "nearest color mapping");
+
+        // 8x8 Bayer threshold matrix
+        static const uint8_t bayerMatrix[8][8] = {{0, 32, 8, 40, 2, 34, 10, 42},  {48, 16, 56, 24, 50, 18, 58, 26}, {12, 44, 4, 36, 14, 46, 6, 38},
+                                                  {60, 28, 52, 20, 62, 30, 54, 22}, {3, 35, 11, 43, 1, 33, 9, 41},  {51, 19, 59, 27, 49, 17, 57, 25},
+                                                  {15, 47, 7, 39, 13, 45, 5, 37},   {63, 31, 55, 23, 61, 29, 53, 21}};
+        static constexpr auto ORDERED_DITHER_SPREAD = 32; // roughly the distance between colors of a uniform 256 color palette
+
+        image_parallel_for_rows(h, [=](int32_t rowStart, int32_t rowEnd) {
+            auto lookupCache = std::make_unique<LookupCache>(image_get_rgb_redmean_dist_sq);
+            lookupCache->Reset(dstPalette);
+
+            for (int32_t y = rowStart; y < rowEnd; y++) {
+                for (int32_t x = 0; x < w; x++) {
+                    auto i = size_t(y) * size_t(w) + size_t(x);
+                    auto srcPixel = src32[i];
+                    int r = image_get_bgra_red(srcPixel), g = image_get_bgra_green(srcPixel), b = image_get_bgra_blue(srcPixel);
+
+                    if (dither == ImageDither::ORDERED) {
+                        auto offset = ((bayerMatrix[y & 7][x & 7] * 2 - 63) * ORDERED_DITHER_SPREAD) / 128;
+                        r += offset;
+                        g += offset;
+                        b += offset;
                     }
-                }
 
-                if (bestIdx < 0) {
-                    break;
-                }
-
-                dstPalette[paletteUsed] = histColors[bestIdx];
-                chosen[bestIdx] = true;
-                ++paletteUsed;
-
-                r1 = image_get_bgra_red(histColors[bestIdx]);
-                g1 = image_get_bgra_green(histColors[bestIdx]);
-                b1 = image_get_bgra_blue(histColors[bestIdx]);
-
-                for (size_t j = 0; j < uniqueCount; j++) {
-                    if (!chosen[j]) {
-                        float d2 = image_get_rgb_redmean_dist_sq(r1, g1, b1, image_get_bgra_red(histColors[j]), image_get_bgra_green(histColors[j]),
-                                                                 image_get_bgra_blue(histColors[j]));
-                        if (minDist2[j] < 0 || d2 < minDist2[j]) {
-                            minDist2[j] = d2;
-                        }
-                    }
+                    dst[i] = uint8_t(
+                        lookupCache->FindClosest(image_clamp_color_component(r), image_clamp_color_component(g), image_clamp_color_component(b)));
                 }
             }
+        });
 
-            for (size_t i = paletteUsed; i < IMAGE_8BPP_MAX_COLORS; i++) {
-                dstPalette[i] = dstPalette[paletteUsed - 1];
-            }
-        }
+        return;
     }
 
     image_log_trace("Applying Floyd-Steinberg dithering");
 
+    auto lookupCache = std::make_unique<LookupCache>(image_get_rgb_redmean_dist_sq);
+    lookupCache->Reset(dstPalette);
+
     struct ErrorPixel {
         float r, g, b;
     };
@@ -571,7 +808,7 @@ static void image_convert_8bpp(const uint32_t *src32, const uint32_t *srcPalette
             auto g = std::clamp(float(image_get_bgra_green(srcPixel)) + err[x].g, 0.0f, 255.0f);
             auto b = std::clamp(float(image_get_bgra_blue(srcPixel)) + err[x].b, 0.0f, 255.0f);
 
-            auto closestIndex = image_find_closest_palette_color(uint8_t(r), uint8_t(g), uint8_t(b), dstPalette, image_get_rgb_redmean_dist_sq);
+            auto closestIndex = lookupCache->FindClosest(uint8_t(r), uint8_t(g), uint8_t(b));
 
             dst[i] = uint8_t(closestIndex);
 
@@ -672,20 +909,306 @@ static bool image_extract_8bpp(const uint32_t *src32, const uint32_t *srcPalette
     return true;
 }
 
+/// @brief Settings and results of a single _LOADIMAGE request. Everything but the final image creation is thread-safe
+struct ImageLoadRequest {
+    std::string fileName;                              // the file name if the image is loaded from disk
+    bool isLoadFromMemory = false;                     // should the image be loaded from memory?
+    const uint8_t *data = nullptr;                     // the file data if isLoadFromMemory is true
+    size_t dataSize = 0;                               // the size of data
+    std::string dataCopy;                              // owned copy of the file data for asynchronous requests
+    int32_t bpp = 32;                                  // 32 or 256
+    const uint32_t *srcPalette = palette_256;          // use the QB64 256 color palette by default for 8bpp images
+    ImageScaler scaler = ImageScaler::NONE;            // default to no scaling
+    ImageDither dither = ImageDither::FLOYD_STEINBERG; // default dithering for 8bpp conversion
+    uint8_t *pixels = nullptr;                         // decoded BGRA pixels (32bpp) or palette indices (8bpp); allocated using malloc()
+    uint32_t palette[256];                             // palette of 8bpp images
+    std::shared_ptr<ImageVector> vector;               // the parsed document if the image is an SVG
+    int32_t width = 0;
+    int32_t height = 0;
+};
+
+/// @brief Decodes the image described by request and converts it to the requested format. This does not touch any QB64 image state
+/// @param request The load request. On success, pixels, width, height and (for 8bpp) palette are set
+/// @return true if successful
+static bool image_load_request_decode(ImageLoadRequest *request) {
+    auto x = 0, y = 0;
+    uint32_t *pixels;
+
+    if (request->isLoadFromMemory) {
+        pixels = image_decode_from_memory(request->data, request->dataSize, &x, &y, request->scaler, nullptr, &request->vector);
+    } else {
+        pixels = image_decode_from_file(filepath_fix_directory(request->fileName), &x, &y, request->scaler, &request->vector);
+    }
+
+    if (!pixels)
+        return false;
+
+    // Convert RGBA to BGRA
+    size_t size = x * y;
+    image_swap_red_blue_buffer(pixels, size);
+
+    // Convert image to 8bpp if requested by the user
+    if (request->bpp == 256) {
+        auto dst = reinterpret_cast<uint8_t *>(malloc(size));
+        if (!dst) {
+            free(pixels);
+            return false;
+        }
+
+        memcpy(request->palette, palette_256, sizeof(request->palette));
+
+        // Try to simply 'extract' the 8bpp image first. If that fails, then 'convert' it to 8bpp
+        if (!image_extract_8bpp(pixels, request->srcPalette, x, y, dst, request->palette)) {
+            image_convert_8bpp(pixels, request->srcPalette, x, y, dst, request->palette, request->dither);
+        }
+
+        // Free pixel memory. We can do this because all image loader as know to use malloc()
+        free(pixels);
+        request->pixels = dst;
+    } else {
+        request->pixels = reinterpret_cast<uint8_t *>(pixels); // the decoded buffer becomes the image memory
+    }
+
+    request->width = x;
+    request->height = y;
+
+    return true;
+}
+
+/// @brief Creates the QB64 image from a decoded request. This must be called from the main thread
+/// @param request A successfully decoded request. The pixel memory is owned by the image after this call
+/// @param handle A handle reserved using image_reserve_handle() or 0 to create a new handle
+/// @return Valid LONG image handle values that are less than -1 or -1 on failure
+static int32_t image_load_request_finish(ImageLoadRequest *request, int32_t handle) {
+    auto i = image_new_from_buffer(request->pixels, request->width, request->height, request->bpp, handle);
+    if (i == INVALID_IMAGE_HANDLE) {
+        free(request->pixels);
+        request->pixels = nullptr;
+        return INVALID_IMAGE_HANDLE;
+    }
+    request->pixels = nullptr;
+
+    if (request->bpp == 256)
+        memcpy(img[-i].pal, request->palette, sizeof(request->palette));
+
+    if (request->vector)
+        image_vector_attach(i, std::move(request->vector));
+
+    return i;
+}
+
+/// @brief A pending asynchronous _LOADIMAGE request
+struct ImageAsyncJob {
+    ImageLoadRequest request;
+    int32_t handle = 0;       // the reserved image handle that will receive the image
+    bool isDone = false;      // set by the worker when decoding is complete
+    bool isOk = false;        // did decoding succeed?
+    bool isCancelled = false; // set when the handle was freed before decoding completed
+};
+
+/// @brief Worker pool and job bookkeeping for asynchronous image loading
+struct ImageAsyncLoader {
+    libqb_mutex *lock = nullptr;
+    libqb_condvar *jobQueued = nullptr;                // signaled when a job is added to the queue
+    libqb_condvar *jobFinished = nullptr;              // signaled when a worker completes a job
+    std::deque<ImageAsyncJob *> queue;                 // jobs waiting for a worker
+    std::unordered_map<int32_t, ImageAsyncJob *> jobs; // all jobs that have not been collected yet, keyed by image handle
+    std::vector<libqb_thread *> workers;
+};
+
+static ImageAsyncLoader g_ImageAsyncLoader;
+
+/// @brief Worker thread for asynchronous image loading. Workers run for the lifetime of the program
+/// @param arg Unused
+static void image_async_worker(void *arg) {
+    (void)arg;
+
+    auto loader = &g_ImageAsyncLoader;
+
+    for (;;) {
+        ImageAsyncJob *job;
+
+        {
+            libqb_mutex_guard guard(loader->lock);
+
+            while (loader->queue.empty())
+                libqb_condvar_wait(loader->jobQueued, loader->lock);
+
+            job = loader->queue.front();
+            loader->queue.pop_front();
+        }
+
+        auto isOk = image_load_request_decode(&job->request);
+
+        libqb_mutex_guard guard(loader->lock);
+
+        if (job->isCancelled) {
+            free(job->request.pixels);
+            delete job;
+            continue;
+        }
+
+        job->isOk = isOk;
+        job->isDone = true;
+        libqb_condvar_broadcast(loader->jobFinished);
+    }
+}
+
+/// @brief Queues an asynchronous load and returns the pending image handle
+/// @param request The load settings. This is moved into the job
+/// @return A pending image handle (less than -1) or -1 on failure
+static int32_t image_async_load(ImageLoadRequest &&request) {
+    auto loader = &g_ImageAsyncLoader;
+
+    if (loader->workers.empty()) {
+        loader->lock = libqb_mutex_new();
+        loader->jobQueued = libqb_condvar_new();
+        loader->jobFinished = libqb_condvar_new();
+
+        auto count = std::clamp<unsigned>(std::thread::hardware_concurrency(), 1u, 4u);
+        image_log_trace("Starting %u image loader threads", count);
+
+        for (unsigned i = 0; i < count; i++) {
+            auto thread = libqb_thread_new();
+            libqb_thread_start(thread, image_async_worker, nullptr);
+            loader->workers.push_back(thread);
+        }
+    }
+
+    auto job = new ImageAsyncJob();
+    job->request = std::move(request);
+
+    // The caller's string may not outlive the job, so memory loads work on a private copy
+    if (job->request.isLoadFromMemory) {
+        job->request.dataCopy.assign(reinterpret_cast<const char *>(job->request.data), job->request.dataSize);
+        job->request.data = reinterpret_cast<const uint8_t *>(job->request.dataCopy.data());
+    }
+
+    job->handle = image_reserve_handle();
+    if (job->handle == INVALID_IMAGE_HANDLE) {
+        delete job;
+        return INVALID_IMAGE_HANDLE;
+    }
+
+    {
+        libqb_mutex_guard guard(loader->lock);
+
+        loader->jobs[job->handle] = job;
+        loader->queue.push_back(job);
+    }
+
+    libqb_condvar_signal(loader->jobQueued);
+
+    image_log_trace("Queued asynchronous load for handle %i", job->handle);
+
+    return job->handle;
+}
+
+/// @brief Cancels a pending asynchronous load. This is used by _FREEIMAGE for handles that are still loading
+/// @param handle The pending image handle
+/// @return true if handle was a pending asynchronous load
+bool image_async_cancel(int32_t handle) {
+    auto loader = &g_ImageAsyncLoader;
+
+    if (loader->workers.empty())
+        return false;
+
+    {
+        libqb_mutex_guard guard(loader->lock);
+
+        auto it = loader->jobs.find(handle);
+        if (it == loader->jobs.end())
+            return false;
+
+        auto job = it->second;
+        loader->jobs.erase(it);
+
+        auto queued = std::find(loader->queue.begin(), loader->queue.end(), job);
+        if (queued != loader->queue.end()) {
+            loader->queue.erase(queued);
+            delete job;
+        } else if (job->isDone) {
+            free(job->request.pixels);
+            delete job;
+        } else {
+            job->isCancelled = true; // the worker will clean up
+        }
+    }
+
+    image_release_handle(handle);
+
+    image_log_trace("Cancelled asynchronous load for handle %i", handle);
+
+    return true;
+}
+
+/// @brief Checks if an image handle returned by _LOADIMAGE with the "async" requirement is ready for use
+/// @param handle The image handle
+/// @param wait If true, this blocks until loading is complete
+/// @param passed Optional parameters
+/// @return -1 if the image is ready, 0 if it is still loading and 1 if loading failed (the handle is then released)
+int32_t func__imageready(int32_t handle, int32_t wait, int32_t passed) {
+    if (is_error_pending())
+        return 0;
+
+    auto loader = &g_ImageAsyncLoader;
+    ImageAsyncJob *job = nullptr;
+
+    if (!loader->workers.empty()) {
+        libqb_mutex_guard guard(loader->lock);
+
+        auto it = loader->jobs.find(handle);
+        if (it != loader->jobs.end()) {
+            if ((passed & 1) && wait) {
+                while (!it->second->isDone)
+                    libqb_condvar_wait(loader->jobFinished, loader->lock);
+            }
+
+            if (!it->second->isDone)
+                return 0;
+
+            job = it->second;
+            loader->jobs.erase(it);
+        }
+    }
+
+    if (!job) {
+        // Not an asynchronous load; report regular images as ready
+        if (handle >= -1 || -handle >= nextimg || !img[-handle].valid) {
+            error(QB_ERROR_INVALID_HANDLE);
+            return 0;
+        }
+
+        return QB_TRUE;
+    }
+
+    auto i = job->isOk ? image_load_request_finish(&job->request, handle) : INVALID_IMAGE_HANDLE;
+    delete job;
+
+    if (i == INVALID_IMAGE_HANDLE) {
+        image_release_handle(handle);
+        image_log_trace("Asynchronous load failed for handle %i", handle);
+        return 1;
+    }
+
+    image_log_trace("Asynchronous load completed for handle %i", handle);
+
+    return QB_TRUE;
+}
+
 /// @brief This function loads an image into memory and returns valid LONG image handle values that are less than -1
 /// @param qbsFileName The filename or memory buffer (see requirements below) of the image
 /// @param bpp 32 = 32bpp, 33 = 32bpp (hardware accelerated), 256=8bpp or 257=8bpp (without palette remap)
-/// @param qbsRequirements A qbs that can contain one or more of: hardware, memory, adaptive
+/// @param qbsRequirements A qbs that can contain one or more of: hardware, memory, async, adaptive, a scaler name and nodither, fsdither or ordered
 /// @param passed How many parameters were passed?
 /// @return Valid LONG image handle values that are less than -1 or -1 on failure
 int32_t func__loadimage(qbs *qbsFileName, int32_t bpp, qbs *qbsRequirements, int32_t passed) {
     if (new_error || !qbsFileName->len) // leave if we do not have a file name, data or there was an error
         return INVALID_IMAGE_HANDLE;
 
-    auto isLoadFromMemory = false;   // should the image be loaded from memory?
-    auto isHardwareImage = false;    // should the image be converted to a hardware image?
-    auto srcPalette = palette_256;   // use the QB64 256 color palette by default for 8bpp images
-    auto scaler = ImageScaler::NONE; // default to no scaling
+    ImageLoadRequest request;
+    auto isHardwareImage = false; // should the image be converted to a hardware image?
+    auto isAsync = false;         // should the image be decoded in the background?
 
     // Handle special cases and set the above flags if required
     image_log_trace("bpp = %i, passed = 0x%X", bpp, passed);
@@ -695,7 +1218,7 @@ int32_t func__loadimage(qbs *qbsFileName, int32_t bpp, qbs *qbsRequirements, int
             bpp = 32;
             image_log_trace("bpp = %i", bpp);
         } else if (bpp == 257) { // adaptive palette?
-            srcPalette = nullptr;
+            request.srcPalette = nullptr;
             bpp = 256;
             image_log_trace("bpp = %i", bpp);
         }
@@ -715,6 +1238,8 @@ int32_t func__loadimage(qbs *qbsFileName, int32_t bpp, qbs *qbsRequirements, int
         }
     }
 
+    request.bpp = bpp;
+
     // Check requirements string and set appropriate flags
     if ((passed & 2) && qbsRequirements->len) {
         // Parse the requirements string and setup save settings
@@ -727,61 +1252,60 @@ int32_t func__loadimage(qbs *qbsFileName, int32_t bpp, qbs *qbsRequirements, int
             isHardwareImage = true;
             image_log_trace("Hardware image selected");
         } else if (requirements.find("ADAPTIVE") != std::string::npos && bpp == 256) {
-            srcPalette = nullptr;
+            request.srcPalette = nullptr;
             image_log_trace("Adaptive palette selected");
         }
 
         if (requirements.find("MEMORY") != std::string::npos) {
-            isLoadFromMemory = true;
+            request.isLoadFromMemory = true;
             image_log_trace("Loading image from memory");
         }
 
+        if (requirements.find("ASYNC") != std::string::npos) {
+            isAsync = true;
+            image_log_trace("Asynchronous loading selected");
+        }
+
         // Parse scaler string
         for (size_t i = 0; i < _countof(g_ImageScalerName); i++) {
             image_log_trace("Checking for: %s", g_ImageScalerName[i]);
             if (requirements.find(g_ImageScalerName[i]) != std::string::npos) {
-                scaler = (ImageScaler)i;
-                image_log_trace("%s scaler selected", g_ImageScalerName[size_t(scaler)]);
+                request.scaler = (ImageScaler)i;
+                image_log_trace("%s scaler selected", g_ImageScalerName[size_t(request.scaler)]);
                 break;
             }
         }
-    }
 
-    auto x = 0, y = 0;
-    uint32_t *pixels;
+        // Parse dithering string
+        for (size_t i = 0; i < _countof(g_ImageDitherName); i++) {
+            if (requirements.find(g_ImageDitherName[i]) != std::string::npos) {
+                request.dither = (ImageDither)i;
+                image_log_trace("%s dithering selected", g_ImageDitherName[size_t(request.dither)]);
+                break;
+            }
+        }
+    }
 
-    if (isLoadFromMemory) {
-        pixels = image_decode_from_memory(qbsFileName->chr, qbsFileName->len, &x, &y, scaler);
+    if (request.isLoadFromMemory) {
+        request.data = qbsFileName->chr;
+        request.dataSize = qbsFileName->len;
     } else {
-        std::string fileName(reinterpret_cast<char *>(qbsFileName->chr), qbsFileName->len);
-        pixels = image_decode_from_file(filepath_fix_directory(fileName), &x, &y, scaler);
+        request.fileName.assign(reinterpret_cast<char *>(qbsFileName->chr), qbsFileName->len);
     }
 
-    if (!pixels)
-        return INVALID_IMAGE_HANDLE; // Return invalid handle if loading the image failed
-
-    // Convert RGBA to BGRA
-    size_t size = x * y;
-    image_swap_red_blue_buffer(pixels, size);
+    if (isAsync) {
+        if (isHardwareImage)
+            image_log_warn("Hardware images cannot be loaded asynchronously; loading as a software image");
 
-    auto i = func__newimage(x, y, bpp, 1);
-    if (i == INVALID_IMAGE_HANDLE) {
-        free(pixels);
-        return INVALID_IMAGE_HANDLE;
+        return image_async_load(std::move(request));
     }
 
-    // Convert image to 8bpp if requested by the user
-    if (bpp == 256) {
-        // Try to simply 'extract' the 8bpp image first. If that fails, then 'convert' it to 8bpp
-        if (!image_extract_8bpp(pixels, srcPalette, x, y, img[-i].offset, img[-i].pal)) {
-            image_convert_8bpp(pixels, srcPalette, x, y, img[-i].offset, img[-i].pal);
-        }
-    } else {
-        memcpy(img[-i].offset32, pixels, size * sizeof(uint32_t));
-    }
+    if (!image_load_request_decode(&request))
+        return INVALID_IMAGE_HANDLE; // Return invalid handle if loading the image failed
 
-    // Free pixel memory. We can do this because all image loader as know to use malloc()
-    free(pixels);
+    auto i = image_load_request_finish(&request, 0);
+    if (i == INVALID_IMAGE_HANDLE)
+        return INVALID_IMAGE_HANDLE;
 
     // This only executes if bpp is 32
     if (isHardwareImage) {
@@ -797,10 +1321,241 @@ int32_t func__loadimage(qbs *qbsFileName, int32_t bpp, qbs *qbsRequirements, int
     return i;
 }
 
+/// @brief Runs a pixel scaler on an existing image and returns the result as a new 32bpp image. Images that were loaded from SVG files are rasterized
+/// again from the cached document instead (at the scale factor of the scaler or at any size)
+/// @param imageHandle A valid software image handle (text surfaces are not supported)
+/// @param qbsScaler The scaler name. This is the same set of names that _LOADIMAGE accepts. This can be empty if a width is passed
+/// @param width The new width (only for images loaded from SVG files)
+/// @param height The new height (only for images loaded from SVG files). If this is omitted, the aspect ratio is kept
+/// @param passed Optional parameters
+/// @return A new image handle that is less than -1 or -1 on failure
+int32_t func__scaleimage(int32_t imageHandle, qbs *qbsScaler, int32_t width, int32_t height, int32_t passed) {
+    if (new_error)
+        return INVALID_IMAGE_HANDLE;
+
+    image_log_trace("Validating handle %i", imageHandle);
+
+    if (imageHandle >= 0) {
+        validatepage(imageHandle);
+        imageHandle = page[imageHandle];
+    } else {
+        imageHandle = -imageHandle;
+
+        if (imageHandle >= nextimg || !img[imageHandle].valid) {
+            error(QB_ERROR_INVALID_HANDLE);
+            return INVALID_IMAGE_HANDLE;
+        }
+    }
+
+    if (img[imageHandle].text) {
+        image_log_error("Text surfaces cannot be scaled");
+        error(QB_ERROR_ILLEGAL_FUNCTION_CALL);
+        return INVALID_IMAGE_HANDLE;
+    }
+
+    std::string scalerName(reinterpret_cast<char *>(qbsScaler->chr), qbsScaler->len);
+    std::transform(scalerName.begin(), scalerName.end(), scalerName.begin(), ::toupper);
+
+    auto scaler = ImageScaler::NONE;
+    for (size_t i = 1; i < _countof(g_ImageScalerName); i++) {
+        if (scalerName.find(g_ImageScalerName[i]) != std::string::npos) {
+            scaler = (ImageScaler)i;
+            break;
+        }
+    }
+
+    if (scaler == ImageScaler::NONE && !(passed & 1)) {
+        image_log_error("Unknown scaler: %s", scalerName.c_str());
+        error(QB_ERROR_ILLEGAL_FUNCTION_CALL);
+        return INVALID_IMAGE_HANDLE;
+    }
+
+    auto vector = image_vector_find(-imageHandle);
+
+    if (vector) {
+        auto vectorWidth = vector->image->width, vectorHeight = vector->image->height;
+        if (vectorWidth <= 0.0f || vectorHeight <= 0.0f) {
+            error(QB_ERROR_ILLEGAL_FUNCTION_CALL);
+            return INVALID_IMAGE_HANDLE;
+        }
+
+        float scale, tx = 0.0f, ty = 0.0f;
+
+        if (passed & 1) {
+            if (!(passed & 2))
+                height = std::max<int32_t>(std::lround(vectorHeight * width / vectorWidth), 1);
+
+            if (width < 1 || height < 1) {
+                image_log_error("Invalid size (%i x %i)", width, height);
+                error(QB_ERROR_ILLEGAL_FUNCTION_CALL);
+                return INVALID_IMAGE_HANDLE;
+            }
+
+            // Keep the aspect ratio and center the drawing if the size does not match it
+            scale = std::min(width / vectorWidth, height / vectorHeight);
+            tx = (width - vectorWidth * scale) / 2.0f;
+            ty = (height - vectorHeight * scale) / 2.0f;
+        } else {
+            // Same as loading the SVG with the scaler
+            scale = g_ImageScaleFactor[size_t(scaler)];
+            width = (int32_t)vectorWidth * g_ImageScaleFactor[size_t(scaler)];
+            height = (int32_t)vectorHeight * g_ImageScaleFactor[size_t(scaler)];
+        }
+
+        image_log_trace("Rasterizing SVG document at %i x %i", width, height);
+
+        auto pixels = image_vector_rasterize(vector.get(), width, height, tx, ty, scale);
+        if (!pixels) {
+            error(QB_ERROR_OUT_OF_MEMORY);
+            return INVALID_IMAGE_HANDLE;
+        }
+
+        image_swap_red_blue_buffer(pixels, size_t(width) * height);
+
+        auto handle = image_new_from_buffer(pixels, width, height, 32, 0);
+        if (handle == INVALID_IMAGE_HANDLE)
+            free(pixels);
+        else
+            image_vector_attach(handle, std::move(vector));
+
+        return handle;
+    }
+
+    if (passed & 1) {
+        image_log_error("Only images loaded from SVG files can be rasterized at a new size");
+        error(QB_ERROR_ILLEGAL_FUNCTION_CALL);
+        return INVALID_IMAGE_HANDLE;
+    }
+
+    width = img[imageHandle].width;
+    height = img[imageHandle].height;
+    auto pixelCount = size_t(width) * height;
+
+    auto pixels = (uint32_t *)malloc(pixelCount * sizeof(uint32_t));
+    if (!pixels) {
+        error(QB_ERROR_OUT_OF_MEMORY);
+        return INVALID_IMAGE_HANDLE;
+    }
+
+    if (img[imageHandle].bits_per_pixel == 32)
+        memcpy(pixels, img[imageHandle].offset32, pixelCount * sizeof(uint32_t));
+    else
+        image_expand_palette(img[imageHandle].offset, pixels, pixelCount, img[imageHandle].pal);
+
+    // The scalers are tuned for RGBA (hqx weighs the channels differently), so match what _LOADIMAGE feeds them
+    image_swap_red_blue_buffer(pixels, pixelCount);
+
+    auto scaled = image_scale(pixels, &width, &height, scaler);
+    if (scaled == pixels) { // the scaler could not allocate the output
+        free(pixels);
+        error(QB_ERROR_OUT_OF_MEMORY);
+        return INVALID_IMAGE_HANDLE;
+    }
+
+    image_swap_red_blue_buffer(scaled, size_t(width) * height);
+
+    auto handle = image_new_from_buffer(scaled, width, height, 32, 0);
+    if (handle == INVALID_IMAGE_HANDLE)
+        free(scaled);
+
+    return handle;
+}
+
+/// @brief Set by sub__saveimage() to let image_zlib_compress() deflate large PNGs as independent chunks in parallel
+static auto g_ImageZlibParallel = false;
+
+/// @brief miniz output callback used by image_zlib_compress()
+static mz_bool image_zlib_put_buffer(const void *buffer, int len, void *user) {
+    auto output = reinterpret_cast<std::vector<uint8_t> *>(user);
+    output->insert(output->end(), reinterpret_cast<const uint8_t *>(buffer), reinterpret_cast<const uint8_t *>(buffer) + len);
+    return MZ_TRUE;
+}
+
+/// @brief zlib compressor used by stb_image_write for PNG data (see stb/stb_image.cpp). When g_ImageZlibParallel is set, the data
+/// is split into chunks that are deflated on separate threads and joined using sync flushes. This compresses slightly worse since
+/// matches cannot cross chunks
+/// @param data The data to compress
+/// @param dataLen The size of the data in bytes
+/// @param outLen Out: The size of the zlib stream in bytes
+/// @param level The compression level (0 = store, 1 = fastest ... 10 = best)
+/// @return A zlib stream allocated with malloc() or NULL on failure. stb_image_write frees this
+unsigned char *image_zlib_compress(unsigned char *data, int dataLen, int *outLen, int level) {
+    static constexpr size_t PARALLEL_CHUNK_SIZE = 256 * 1024;
+
+    level = std::clamp(level, 0, int(MZ_UBER_COMPRESSION));
+    auto flags = int(tdefl_create_comp_flags_from_zip_params(level, -MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY)); // raw deflate
+
+    auto chunkCount = (g_ImageZlibParallel && level > 0) ? std::max<size_t>((size_t(dataLen) + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE, 1) : 1;
+    auto chunkSize = (size_t(dataLen) + chunkCount - 1) / chunkCount;
+
+    std::vector<std::vector<uint8_t>> chunks(chunkCount);
+    std::vector<uint8_t> chunkOk(chunkCount, false);
+
+    image_parallel_for_rows(
+        int32_t(chunkCount),
+        [&](int32_t chunkStart, int32_t chunkEnd) {
+            auto compressor = reinterpret_cast<tdefl_compressor *>(malloc(sizeof(tdefl_compressor)));
+            if (!compressor)
+                return;
+
+            for (auto i = size_t(chunkStart); i < size_t(chunkEnd); i++) {
+                auto start = std::min(i * chunkSize, size_t(dataLen));
+                auto size = std::min(chunkSize, size_t(dataLen) - start);
+                auto isLast = i == chunkCount - 1;
+
+                chunks[i].reserve(size / 2 + 64);
+                tdefl_init(compressor, image_zlib_put_buffer, &chunks[i], flags);
+                chunkOk[i] = tdefl_compress_buffer(compressor, data + start, size, isLast ? TDEFL_FINISH : TDEFL_SYNC_FLUSH) ==
+                             (isLast ? TDEFL_STATUS_DONE : TDEFL_STATUS_OKAY);
+            }
+
+            free(compressor);
+        },
+        1);
+
+    size_t totalSize = 2 + 4; // zlib header + Adler-32
+    for (size_t i = 0; i < chunkCount; i++) {
+        if (!chunkOk[i]) {
+            image_log_error("Failed to deflate chunk %llu", uint64_t(i));
+            return nullptr;
+        }
+
+        totalSize += chunks[i].size();
+    }
+
+    auto output = reinterpret_cast<uint8_t *>(malloc(totalSize));
+    if (!output)
+        return nullptr;
+
+    // zlib header: 32K window deflate, the level hint and the check bits
+    auto flagLevel = level < 2 ? 0 : (level < 6 ? 1 : (level == 6 ? 2 : 3));
+    output[0] = 0x78;
+    output[1] = uint8_t(flagLevel << 6);
+    output[1] += 31 - ((output[0] << 8) | output[1]) % 31;
+
+    auto p = output + 2;
+    for (auto &chunk : chunks) {
+        memcpy(p, chunk.data(), chunk.size());
+        p += chunk.size();
+    }
+
+    auto adler = uint32_t(mz_adler32(MZ_ADLER32_INIT, data, size_t(dataLen)));
+    p[0] = uint8_t(adler >> 24);
+    p[1] = uint8_t(adler >> 16);
+    p[2] = uint8_t(adler >> 8);
+    p[3] = uint8_t(adler);
+
+    image_log_trace("Deflated %i bytes to %llu bytes (level %i, %llu chunks)", dataLen, uint64_t(totalSize), level, uint64_t(chunkCount));
+
+    *outLen = int(totalSize);
+    return output;
+}
+
 /// @brief Saves an image to the disk from a QB64-PE image handle
 /// @param qbsFileName The file path name to save to
 /// @param imageHandle Optional: The image handle. If omitted, then this is _DISPLAY()
-/// @param qbsRequirements Optional: Extra format and setting arguments
+/// @param qbsRequirements Optional: Extra format and setting arguments. Besides a format name, PNG accepts store, fast, best, level0 - level9,
+/// filter0 - filter4 (force a PNG row filter) and parallel (multithreaded deflate). fast also makes QOI the default format when none is given
 /// @param passed Optional parameters
 void sub__saveimage(qbs *qbsFileName, int32_t imageHandle, qbs *qbsRequirements, int32_t passed) {
     enum struct SaveFormat { PNG = 0, QOI, BMP, TGA, JPG, HDR, GIF, ICO };
@@ -854,6 +1609,11 @@ void sub__saveimage(qbs *qbsFileName, int32_t imageHandle, qbs *qbsRequirements,
     image_log_trace("Using image handle %i", imageHandle);
 
     auto format = SaveFormat::PNG; // we always default to PNG
+    auto isFormatSpecified = false;
+    auto isFast = false;
+    auto pngLevel = int(MZ_DEFAULT_LEVEL);
+    auto pngFilter = -1; // let stb_image_write pick the best filter for each row
+    g_ImageZlibParallel = false;
 
     if ((passed & 2) && qbsRequirements->len) {
         // Parse the requirements string and setup save settings
@@ -866,12 +1626,39 @@ void sub__saveimage(qbs *qbsFileName, int32_t imageHandle, qbs *qbsRequirements,
             image_log_trace("Checking for: %s", formatName[i]);
             if (requirements.find(formatName[i]) != std::string::npos) {
                 format = (SaveFormat)i;
+                isFormatSpecified = true;
                 image_log_trace("Found: %s", formatName[size_t(format)]);
                 break;
             }
         }
+
+        // PNG compression settings
+        if (requirements.find("store") != std::string::npos) {
+            pngLevel = MZ_NO_COMPRESSION;
+        } else if (requirements.find("fast") != std::string::npos) {
+            pngLevel = MZ_BEST_SPEED;
+            isFast = true;
+        } else if (requirements.find("best") != std::string::npos) {
+            pngLevel = MZ_UBER_COMPRESSION;
+        }
+
+        auto pos = requirements.find("level");
+        if (pos != std::string::npos && pos + 5 < requirements.length() && isdigit(requirements[pos + 5]))
+            pngLevel = requirements[pos + 5] - '0';
+
+        pos = requirements.find("filter");
+        if (pos != std::string::npos && pos + 6 < requirements.length() && requirements[pos + 6] >= '0' && requirements[pos + 6] <= '4')
+            pngFilter = requirements[pos + 6] - '0';
+
+        g_ImageZlibParallel = requirements.find("parallel") != std::string::npos;
+
+        image_log_trace("PNG level = %i, filter = %i, parallel = %i", pngLevel, pngFilter, g_ImageZlibParallel);
     }
 
+    // QOI is much faster to encode than PNG, so it is the default for quick frame dumps
+    if (isFast && !isFormatSpecified)
+        format = SaveFormat::QOI;
+
     image_log_trace("Format selected: %s", formatName[size_t(format)]);
 
     std::string fileName(reinterpret_cast<char *>(qbsFileName->chr), qbsFileName->len);
@@ -996,7 +1783,8 @@ void sub__saveimage(qbs *qbsFileName, int32_t imageHandle, qbs *qbsRequirements,
 
     switch (format) {
     case SaveFormat::PNG: {
-        stbi_write_png_compression_level = 100;
+        stbi_write_png_compression_level = pngLevel;
+        stbi_write_force_png_filter = pngFilter;
         if (!stbi_write_png(fileName.c_str(), width, height, sizeof(uint32_t), pixels.data(), 0)) {
             image_log_error("stbi_write_png() failed");
             error(QB_ERROR_ILLEGAL_FUNCTION_CALL);
@@ -64,6 +64,16 @@ void nsvgRasterize(NSVGrasterizer* r,
 				   NSVGimage* image, float tx, float ty, float scale,
 				   unsigned char* dst, int w, int h, int stride);
 
+// QB64-PE: Same as nsvgRasterize() but only renders the rows from rowStart to rowEnd - 1 and leaves them premultiplied
+// (and not defringed). Separate threads (each with its own rasterizer) can render horizontal bands of the same image.
+// nsvgUnpremultiplyAlpha() must then be called on the whole image to get the same result as nsvgRasterize().
+void nsvgRasterizeRows(NSVGrasterizer* r,
+				   NSVGimage* image, float tx, float ty, float scale,
+				   unsigned char* dst, int w, int h, int stride, int rowStart, int rowEnd);
+
+// QB64-PE: Converts the premultiplied result of nsvgRasterizeRows() to non-premultiplied alpha
+void nsvgUnpremultiplyAlpha(unsigned char* image, int w, int h, int stride);
+
 // Deletes rasterizer context.
 void nsvgDeleteRasterizer(NSVGrasterizer*);
 
@@ -148,6 +158,7 @@ struct NSVGrasterizer
 
 	unsigned char* bitmap;
 	int width, height, stride;
+	int rowStart, rowEnd; // QB64-PE: rows to render
 };
 
 NSVGrasterizer* nsvgCreateRasterizer(void)
@@ -1127,7 +1138,8 @@ static void nsvg__rasterizeSortedEdges(NSVGrasterizer *r, float tx, float ty, fl
 	int maxWeight = (255 / NSVG__SUBSAMPLES);  // weight per vertical scanline
 	int xmin, xmax;
 
-	for (y = 0; y < r->height; y++) {
+	// QB64-PE: Rows above rowStart still advance the active edges so that every band gets exactly the same edge positions
+	for (y = 0; y < r->rowEnd; y++) {
 		memset(r->scanline, 0, r->width);
 		xmin = r->width;
 		xmax = 0;
@@ -1194,9 +1206,11 @@ static void nsvg__rasterizeSortedEdges(NSVGrasterizer *r, float tx, float ty, fl
 			}
 
 			// now process all active edges in non-zero fashion
-			if (active != NULL)
+			if (active != NULL && y >= r->rowStart)
 				nsvg__fillActiveEdges(r->scanline, r->width, active, maxWeight, &xmin, &xmax, fillRule);
 		}
+		if (y < r->rowStart) continue;
+
 		// Blit
 		if (xmin < 0) xmin = 0;
 		if (xmax > r->width-1) xmax = r->width-1;
@@ -1370,9 +1384,9 @@ static void dumpEdges(NSVGrasterizer* r, const char* name)
 }
 */
 
-void nsvgRasterize(NSVGrasterizer* r,
+void nsvgRasterizeRows(NSVGrasterizer* r,
 				   NSVGimage* image, float tx, float ty, float scale,
-				   unsigned char* dst, int w, int h, int stride)
+				   unsigned char* dst, int w, int h, int stride, int rowStart, int rowEnd)
 {
 	NSVGshape *shape = NULL;
 	NSVGedge *e = NULL;
@@ -1385,6 +1399,8 @@ void nsvgRasterize(NSVGrasterizer* r,
 	r->width = w;
 	r->height = h;
 	r->stride = stride;
+	r->rowStart = rowStart < 0 ? 0 : rowStart;
+	r->rowEnd = rowEnd > h ? h : rowEnd;
 
 	if (w > r->cscanline) {
 		r->cscanline = w;
@@ -1392,7 +1408,7 @@ void nsvgRasterize(NSVGrasterizer* r,
 		if (r->scanline == NULL) return;
 	}
 
-	for (i = 0; i < h; i++)
+	for (i = r->rowStart; i < r->rowEnd; i++)
 		memset(&dst[i*stride], 0, w*4);
 
 	for (shape = image->shapes; shape != NULL; shape = shape->next) {
@@ -1457,14 +1473,25 @@ void nsvgRasterize(NSVGrasterizer* r,
         }
 	}
 
-	nsvg__unpremultiplyAlpha(dst, w, h, stride);
-
 	r->bitmap = NULL;
 	r->width = 0;
 	r->height = 0;
 	r->stride = 0;
 }
 
+void nsvgRasterize(NSVGrasterizer* r,
+				   NSVGimage* image, float tx, float ty, float scale,
+				   unsigned char* dst, int w, int h, int stride)
+{
+	nsvgRasterizeRows(r, image, tx, ty, scale, dst, w, h, stride, 0, h);
+	nsvg__unpremultiplyAlpha(dst, w, h, stride);
+}
+
+void nsvgUnpremultiplyAlpha(unsigned char* image, int w, int h, int stride)
+{
+	nsvg__unpremultiplyAlpha(image, w, h, stride);
+}
+
 #endif // NANOSVGRAST_IMPLEMENTATION
 
 #endif // NANOSVGRAST_H
@@ -17,8 +17,14 @@
  * and modified by Philipp K. Janert, September 2022
  */
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdlib>
+#include <vector>
+
+#if defined(__SSE2__)
+#    include <emmintrin.h>
+#endif
 
 #define MASK_RB 0x00FF00FF
 #define MASK_G 0x0000FF00
@@ -154,11 +160,9 @@ static inline constexpr uint32_t ARGBtoAYUV(uint32_t value) {
 
 /*
  * Use this function for sharper images (good for cartoon style, used by DOSBOX)
+ * Both colors must already be converted using ARGBtoAYUV()
  */
 static inline bool isDifferentA(uint32_t color1, uint32_t color2, uint32_t trY, uint32_t trU, uint32_t trV, uint32_t trA) {
-    color1 = ARGBtoAYUV(color1);
-    color2 = ARGBtoAYUV(color2);
-
     uint32_t value;
 
     value = abs(int(color1 & HQX_YMASK) - int(color2 & HQX_YMASK));
@@ -182,17 +186,96 @@ static inline bool isDifferentA(uint32_t color1, uint32_t color2, uint32_t trY,
 
 /*
  * Use this function for smoothed images (good for complex graphics)
+ * Both colors must already be converted using ARGBtoAYUV()
  */
-static inline bool isDifferentB(uint32_t color1, uint32_t color2, uint32_t trY, uint32_t trU, uint32_t trV, uint32_t trA) {
-    uint32_t yuv1 = ARGBtoAYUV(color1);
-    uint32_t yuv2 = ARGBtoAYUV(color2);
-
+static inline bool isDifferentB(uint32_t yuv1, uint32_t yuv2, uint32_t trY, uint32_t trU, uint32_t trV, uint32_t trA) {
     return abs(int(yuv1 & HQX_YMASK) - int(yuv2 & HQX_YMASK)) > trY || abs(int(yuv1 & HQX_UMASK) - int(yuv2 & HQX_UMASK)) > trU ||
            abs(int(yuv1 & HQX_VMASK) - int(yuv2 & HQX_VMASK)) > trV || abs(int(yuv1 & HQX_AMASK) - int(yuv2 & HQX_AMASK)) > trA;
 }
 
+/*
+ * Converts the rows needed by a band of output rows to AYUV. Every source pixel is compared up to a dozen times, so converting
+ * once up front is much cheaper than converting inside isDifferent(). The returned pointer points to the AYUV value of the first
+ * pixel of row yFirst and can be used with the same offsets as the source image.
+ */
+static const uint32_t *hqx_convert_rows(const uint32_t *image, uint32_t width, uint32_t height, uint32_t yFirst, uint32_t yLast, bool wrapY,
+                                        std::vector<uint32_t> &yuvRows) {
+    // Rows above and below the band are needed for the 3x3 window (or the whole image when wrapping)
+    uint32_t rowFirst = wrapY ? 0 : (yFirst > 0 ? yFirst - 1 : 0);
+    uint32_t rowLast = wrapY ? height : std::min(yLast + 1, height);
+
+    yuvRows.resize(size_t(width) * (rowLast - rowFirst));
+
+    const uint32_t *src = image + size_t(rowFirst) * width;
+    for (size_t i = 0; i < yuvRows.size(); i++)
+        yuvRows[i] = ARGBtoAYUV(src[i]);
+
+    return yuvRows.data() + size_t(yFirst - rowFirst) * width;
+}
+
+#if defined(__SSE2__)
+/*
+ * Compares 4 AYUV colors against the center color and returns a 4-bit mask of the ones that are different. This produces the same
+ * result as isDifferentA() / isDifferentB(): Y, U and V are compared as unsigned bytes and alpha as a signed byte difference (the
+ * scalar code subtracts the alpha bits as signed integers).
+ */
+static inline int hqx_different4(__m128i colors, __m128i center, __m128i thresholds) {
+    const __m128i alphaMask = _mm_set1_epi32(int32_t(HQX_AMASK));
+
+    __m128i absDiff = _mm_or_si128(_mm_subs_epu8(colors, center), _mm_subs_epu8(center, colors));
+    __m128i diff = _mm_sub_epi8(colors, center);
+    __m128i sign = _mm_cmpgt_epi8(_mm_setzero_si128(), diff);
+    __m128i absDiffSigned = _mm_sub_epi8(_mm_xor_si128(diff, sign), sign);
+
+    diff = _mm_or_si128(_mm_andnot_si128(alphaMask, absDiff), _mm_and_si128(alphaMask, absDiffSigned));
+
+    // Bytes are non-zero where the difference is above the threshold
+    __m128i same = _mm_cmpeq_epi32(_mm_subs_epu8(diff, thresholds), _mm_setzero_si128());
+
+    return ~_mm_movemask_ps(_mm_castsi128_ps(same)) & 0xF;
+}
+#endif
+
+/*
+ * Computes the pattern of neighbors that are different from the center pixel of the 3x3 AYUV window.
+ * The thresholds are packed as bytes in AYUV order.
+ */
+static inline int hqx_pattern(const uint32_t *wy, uint32_t thresholds) {
+#if defined(__SSE2__)
+    __m128i center = _mm_set1_epi32(int32_t(wy[4]));
+    __m128i thr = _mm_set1_epi32(int32_t(thresholds));
+
+    return hqx_different4(_mm_setr_epi32(int32_t(wy[0]), int32_t(wy[1]), int32_t(wy[2]), int32_t(wy[3])), center, thr) |
+           (hqx_different4(_mm_setr_epi32(int32_t(wy[5]), int32_t(wy[6]), int32_t(wy[7]), int32_t(wy[8])), center, thr) << 4);
+#else
+    int pattern = 0;
+
+    for (int k = 0, flag = 1; k < 9; k++) {
+        // ignores the central pixel
+        if (k == 4)
+            continue;
+
+        if (wy[k] != wy[4]) {
+            // Same per-byte comparison as the SSE2 path. The alpha difference wraps like the signed subtraction in isDifferentA()
+            for (int shift = 0; shift < 32; shift += 8) {
+                int a = (wy[k] >> shift) & 0xFF, b = (wy[4] >> shift) & 0xFF;
+                int diff = shift == 24 ? abs(int(int8_t(uint8_t(a - b)))) : abs(a - b);
+
+                if (diff > int((thresholds >> shift) & 0xFF)) {
+                    pattern |= flag;
+                    break;
+                }
+            }
+        }
+        flag <<= 1;
+    }
+
+    return pattern;
+#endif
+}
+
 static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, uint32_t height, uint32_t *output, uint32_t trY, uint32_t trU, uint32_t trV,
-                             uint32_t trA, bool wrapX, bool wrapY) {
+                             uint32_t trA, bool wrapX, bool wrapY, uint32_t yFirst, uint32_t yLast) {
     bool (*isDifferent)(uint32_t color1, uint32_t color2, uint32_t trY, uint32_t trU, uint32_t trV, uint32_t trA) = &isDifferentA;
     if (mode == 'B') {
         isDifferent = &isDifferentB;
@@ -201,14 +284,26 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
     int lineSize = width * 2;
 
     int previous, next;
-    uint32_t w[9];
+    uint32_t w[9], wy[9];
 
+    uint32_t thresholds = (trA << 24) | (trY << 16) | (trU << 8) | trV;
     trY <<= 16;
     trU <<= 8;
     trA <<= 24;
 
+    // Only process the rows of the requested band
+    yLast = std::min(yLast, height);
+    if (yFirst >= yLast)
+        return output;
+
+    std::vector<uint32_t> yuvRows;
+    const uint32_t *yuv = hqx_convert_rows(image, width, height, yFirst, yLast, wrapY, yuvRows);
+
+    image += size_t(yFirst) * width;
+    output += size_t(yFirst) * lineSize * 2;
+
     // iterates between the lines
-    for (uint32_t row = 0; row < height; row++) {
+    for (uint32_t row = yFirst; row < yLast; row++) {
         /*
          * Note: this function uses a 3x3 sliding window over the original image.
          *
@@ -245,54 +340,64 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
         // iterates between the columns
         for (uint32_t col = 0; col < width; col++) {
             w[1] = *(image + previous);
+            wy[1] = *(yuv + previous);
             w[4] = *image;
+            wy[4] = *yuv;
             w[7] = *(image + next);
+            wy[7] = *(yuv + next);
 
             if (col > 0) {
                 w[0] = *(image + previous - 1);
+                wy[0] = *(yuv + previous - 1);
                 w[3] = *(image - 1);
+                wy[3] = *(yuv - 1);
                 w[6] = *(image + next - 1);
+                wy[6] = *(yuv + next - 1);
             } else {
                 if (wrapX) {
                     w[0] = *(image + previous + width - 1);
+                    wy[0] = *(yuv + previous + width - 1);
                     w[3] = *(image + width - 1);
+                    wy[3] = *(yuv + width - 1);
                     w[6] = *(image + next + width - 1);
+                    wy[6] = *(yuv + next + width - 1);
                 } else {
                     w[0] = w[1];
+                    wy[0] = wy[1];
                     w[3] = w[4];
+                    wy[3] = wy[4];
                     w[6] = w[7];
+                    wy[6] = wy[7];
                 }
             }
 
             if (col < width - 1) {
                 w[2] = *(image + previous + 1);
+                wy[2] = *(yuv + previous + 1);
                 w[5] = *(image + 1);
+                wy[5] = *(yuv + 1);
                 w[8] = *(image + next + 1);
+                wy[8] = *(yuv + next + 1);
             } else {
                 if (wrapX) {
                     w[2] = *(image + previous - width + 1);
+                    wy[2] = *(yuv + previous - width + 1);
                     w[5] = *(image - width + 1);
+                    wy[5] = *(yuv - width + 1);
                     w[8] = *(image + next - width + 1);
+                    wy[8] = *(yuv + next - width + 1);
                 } else {
                     w[2] = w[1];
+                    wy[2] = wy[1];
                     w[5] = w[4];
+                    wy[5] = wy[4];
                     w[8] = w[7];
+                    wy[8] = wy[7];
                 }
             }
 
-            int pattern = 0;
-
             // computes the pattern to be used considering the neighbor pixels
-            for (int k = 0, flag = 1; k < 9; k++) {
-                // ignores the central pixel
-                if (k == 4)
-                    continue;
-
-                if (w[k] != w[4])
-                    if (isDifferent(w[4], w[k], trY, trU, trV, trA))
-                        pattern |= flag;
-                flag <<= 1;
-            }
+            int pattern = hqx_pattern(wy, thresholds);
 
             switch (pattern) {
             case 0:
@@ -427,7 +532,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 18:
             case 50:
                 MIX_00_4_0_3_2_1_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4_2_3_1
                 } else {
                     MIX_01_4_1_5_2_1_1
@@ -440,7 +545,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_00_4_3_1_2_1_1
                 MIX_01_4_2_1_2_1_1
                 MIX_10_4_6_3_2_1_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4_8_3_1
                 } else {
                     MIX_11_4_5_7_2_1_1
@@ -450,7 +555,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 76:
                 MIX_00_4_0_1_2_1_1
                 MIX_01_4_1_5_2_1_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4_6_3_1
                 } else {
                     MIX_10_4_7_3_2_1_1
@@ -459,7 +564,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 10:
             case 138:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_2_1_1
@@ -515,7 +620,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 22:
             case 54:
                 MIX_00_4_0_3_2_1_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                 } else {
                     MIX_01_4_1_5_2_1_1
@@ -528,7 +633,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_00_4_3_1_2_1_1
                 MIX_01_4_2_1_2_1_1
                 MIX_10_4_6_3_2_1_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4
                 } else {
                     MIX_11_4_5_7_2_1_1
@@ -538,7 +643,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 108:
                 MIX_00_4_0_1_2_1_1
                 MIX_01_4_1_5_2_1_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                 } else {
                     MIX_10_4_7_3_2_1_1
@@ -547,7 +652,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 11:
             case 139:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_2_1_1
@@ -558,7 +663,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 19:
             case 51:
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_00_4_3_3_1
                     MIX_01_4_2_3_1
                 } else {
@@ -571,7 +676,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 146:
             case 178:
                 MIX_00_4_0_3_2_1_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4_2_3_1
                     MIX_11_4_7_3_1
                 } else {
@@ -583,7 +688,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 84:
             case 85:
                 MIX_00_4_3_1_2_1_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_01_4_1_3_1
                     MIX_11_4_8_3_1
                 } else {
@@ -596,7 +701,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 113:
                 MIX_00_4_3_1_2_1_1
                 MIX_01_4_2_1_2_1_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_10_4_3_3_1
                     MIX_11_4_8_3_1
                 } else {
@@ -608,7 +713,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 204:
                 MIX_00_4_0_1_2_1_1
                 MIX_01_4_1_5_2_1_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4_6_3_1
                     MIX_11_4_5_3_1
                 } else {
@@ -618,7 +723,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 73:
             case 77:
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_00_4_1_3_1
                     MIX_10_4_6_3_1
                 } else {
@@ -630,7 +735,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 42:
             case 170:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                     MIX_10_4_7_3_1
                 } else {
@@ -642,7 +747,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 14:
             case 142:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                     MIX_01_4_5_3_1
                 } else {
@@ -702,12 +807,12 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 26:
             case 31:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_2_1_1
                 }
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                 } else {
                     MIX_01_4_1_5_2_1_1
@@ -718,13 +823,13 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 82:
             case 214:
                 MIX_00_4_0_3_2_1_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                 } else {
                     MIX_01_4_1_5_2_1_1
                 }
                 MIX_10_4_6_3_2_1_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4
                 } else {
                     MIX_11_4_5_7_2_1_1
@@ -734,12 +839,12 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 248:
                 MIX_00_4_0_1_2_1_1
                 MIX_01_4_2_1_2_1_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                 } else {
                     MIX_10_4_7_3_2_1_1
                 }
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4
                 } else {
                     MIX_11_4_5_7_2_1_1
@@ -747,13 +852,13 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 74:
             case 107:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_2_1_1
                 }
                 MIX_01_4_2_5_2_1_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                 } else {
                     MIX_10_4_7_3_2_1_1
@@ -761,7 +866,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_11_4_8_5_2_1_1
                 break;
             case 27:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_2_1_1
@@ -772,7 +877,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 86:
                 MIX_00_4_0_3_2_1_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                 } else {
                     MIX_01_4_1_5_2_1_1
@@ -784,7 +889,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_00_4_0_1_2_1_1
                 MIX_01_4_2_1_2_1_1
                 MIX_10_4_6_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4
                 } else {
                     MIX_11_4_5_7_2_1_1
@@ -793,7 +898,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 106:
                 MIX_00_4_0_3_1
                 MIX_01_4_2_5_2_1_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                 } else {
                     MIX_10_4_7_3_2_1_1
@@ -802,7 +907,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 30:
                 MIX_00_4_0_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                 } else {
                     MIX_01_4_1_5_2_1_1
@@ -814,7 +919,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_00_4_0_3_2_1_1
                 MIX_01_4_2_3_1
                 MIX_10_4_6_3_2_1_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4
                 } else {
                     MIX_11_4_5_7_2_1_1
@@ -823,7 +928,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 120:
                 MIX_00_4_0_1_2_1_1
                 MIX_01_4_2_1_2_1_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                 } else {
                     MIX_10_4_7_3_2_1_1
@@ -831,7 +936,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_11_4_8_3_1
                 break;
             case 75:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_2_1_1
@@ -913,12 +1018,12 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_11_4_7_3_1
                 break;
             case 58:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_6_1_1
                 }
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4_2_3_1
                 } else {
                     MIX_01_4_1_5_6_1_1
@@ -928,13 +1033,13 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 83:
                 MIX_00_4_3_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4_2_3_1
                 } else {
                     MIX_01_4_1_5_6_1_1
                 }
                 MIX_10_4_6_3_2_1_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4_8_3_1
                 } else {
                     MIX_11_4_5_7_6_1_1
@@ -943,25 +1048,25 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 92:
                 MIX_00_4_0_1_2_1_1
                 MIX_01_4_1_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4_6_3_1
                 } else {
                     MIX_10_4_7_3_6_1_1
                 }
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4_8_3_1
                 } else {
                     MIX_11_4_5_7_6_1_1
                 }
                 break;
             case 202:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_6_1_1
                 }
                 MIX_01_4_2_5_2_1_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4_6_3_1
                 } else {
                     MIX_10_4_7_3_6_1_1
@@ -969,13 +1074,13 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_11_4_5_3_1
                 break;
             case 78:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_6_1_1
                 }
                 MIX_01_4_5_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4_6_3_1
                 } else {
                     MIX_10_4_7_3_6_1_1
@@ -983,12 +1088,12 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_11_4_8_5_2_1_1
                 break;
             case 154:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_6_1_1
                 }
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4_2_3_1
                 } else {
                     MIX_01_4_1_5_6_1_1
@@ -998,13 +1103,13 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 114:
                 MIX_00_4_0_3_2_1_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4_2_3_1
                 } else {
                     MIX_01_4_1_5_6_1_1
                 }
                 MIX_10_4_3_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4_8_3_1
                 } else {
                     MIX_11_4_5_7_6_1_1
@@ -1013,34 +1118,34 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 89:
                 MIX_00_4_1_3_1
                 MIX_01_4_2_1_2_1_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4_6_3_1
                 } else {
                     MIX_10_4_7_3_6_1_1
                 }
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4_8_3_1
                 } else {
                     MIX_11_4_5_7_6_1_1
                 }
                 break;
             case 90:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_6_1_1
                 }
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4_2_3_1
                 } else {
                     MIX_01_4_1_5_6_1_1
                 }
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4_6_3_1
                 } else {
                     MIX_10_4_7_3_6_1_1
                 }
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4_8_3_1
                 } else {
                     MIX_11_4_5_7_6_1_1
@@ -1048,7 +1153,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 55:
             case 23:
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_00_4_3_3_1
                     MIX_01_4
                 } else {
@@ -1061,7 +1166,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 182:
             case 150:
                 MIX_00_4_0_3_2_1_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                     MIX_11_4_7_3_1
                 } else {
@@ -1073,7 +1178,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 213:
             case 212:
                 MIX_00_4_3_1_2_1_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_01_4_1_3_1
                     MIX_11_4
                 } else {
@@ -1086,7 +1191,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 240:
                 MIX_00_4_3_1_2_1_1
                 MIX_01_4_2_1_2_1_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_10_4_3_3_1
                     MIX_11_4
                 } else {
@@ -1098,7 +1203,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 232:
                 MIX_00_4_0_1_2_1_1
                 MIX_01_4_1_5_2_1_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                     MIX_11_4_5_3_1
                 } else {
@@ -1108,7 +1213,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 109:
             case 105:
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_00_4_1_3_1
                     MIX_10_4
                 } else {
@@ -1120,7 +1225,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 171:
             case 43:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_10_4_7_3_1
                 } else {
@@ -1132,7 +1237,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 143:
             case 15:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_01_4_5_3_1
                 } else {
@@ -1145,7 +1250,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 124:
                 MIX_00_4_0_1_2_1_1
                 MIX_01_4_1_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                 } else {
                     MIX_10_4_7_3_2_1_1
@@ -1153,7 +1258,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_11_4_8_3_1
                 break;
             case 203:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_2_1_1
@@ -1164,7 +1269,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 62:
                 MIX_00_4_0_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                 } else {
                     MIX_01_4_1_5_2_1_1
@@ -1176,7 +1281,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_00_4_3_3_1
                 MIX_01_4_2_3_1
                 MIX_10_4_6_3_2_1_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4
                 } else {
                     MIX_11_4_5_7_2_1_1
@@ -1184,7 +1289,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 118:
                 MIX_00_4_0_3_2_1_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                 } else {
                     MIX_01_4_1_5_2_1_1
@@ -1196,7 +1301,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_00_4_1_3_1
                 MIX_01_4_2_1_2_1_1
                 MIX_10_4_6_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4
                 } else {
                     MIX_11_4_5_7_2_1_1
@@ -1205,7 +1310,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 110:
                 MIX_00_4_0_3_1
                 MIX_01_4_5_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                 } else {
                     MIX_10_4_7_3_2_1_1
@@ -1213,7 +1318,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_11_4_8_5_2_1_1
                 break;
             case 155:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_2_1_1
@@ -1273,24 +1378,24 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 220:
                 MIX_00_4_0_1_2_1_1
                 MIX_01_4_1_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4_6_3_1
                 } else {
                     MIX_10_4_7_3_6_1_1
                 }
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4
                 } else {
                     MIX_11_4_5_7_2_1_1
                 }
                 break;
             case 158:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_6_1_1
                 }
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                 } else {
                     MIX_01_4_1_5_2_1_1
@@ -1299,13 +1404,13 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_11_4_7_3_1
                 break;
             case 234:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_6_1_1
                 }
                 MIX_01_4_2_5_2_1_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                 } else {
                     MIX_10_4_7_3_2_1_1
@@ -1314,25 +1419,25 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 242:
                 MIX_00_4_0_3_2_1_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4_2_3_1
                 } else {
                     MIX_01_4_1_5_6_1_1
                 }
                 MIX_10_4_3_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4
                 } else {
                     MIX_11_4_5_7_2_1_1
                 }
                 break;
             case 59:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_2_1_1
                 }
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4_2_3_1
                 } else {
                     MIX_01_4_1_5_6_1_1
@@ -1343,12 +1448,12 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 121:
                 MIX_00_4_1_3_1
                 MIX_01_4_2_1_2_1_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                 } else {
                     MIX_10_4_7_3_2_1_1
                 }
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4_8_3_1
                 } else {
                     MIX_11_4_5_7_6_1_1
@@ -1356,26 +1461,26 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 87:
                 MIX_00_4_3_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                 } else {
                     MIX_01_4_1_5_2_1_1
                 }
                 MIX_10_4_6_3_2_1_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4_8_3_1
                 } else {
                     MIX_11_4_5_7_6_1_1
                 }
                 break;
             case 79:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_2_1_1
                 }
                 MIX_01_4_5_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4_6_3_1
                 } else {
                     MIX_10_4_7_3_6_1_1
@@ -1383,88 +1488,88 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_11_4_8_5_2_1_1
                 break;
             case 122:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_6_1_1
                 }
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4_2_3_1
                 } else {
                     MIX_01_4_1_5_6_1_1
                 }
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                 } else {
                     MIX_10_4_7_3_2_1_1
                 }
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4_8_3_1
                 } else {
                     MIX_11_4_5_7_6_1_1
                 }
                 break;
             case 94:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_6_1_1
                 }
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                 } else {
                     MIX_01_4_1_5_2_1_1
                 }
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4_6_3_1
                 } else {
                     MIX_10_4_7_3_6_1_1
                 }
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4_8_3_1
                 } else {
                     MIX_11_4_5_7_6_1_1
                 }
                 break;
             case 218:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_6_1_1
                 }
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4_2_3_1
                 } else {
                     MIX_01_4_1_5_6_1_1
                 }
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4_6_3_1
                 } else {
                     MIX_10_4_7_3_6_1_1
                 }
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4
                 } else {
                     MIX_11_4_5_7_2_1_1
                 }
                 break;
             case 91:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_2_1_1
                 }
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4_2_3_1
                 } else {
                     MIX_01_4_1_5_6_1_1
                 }
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4_6_3_1
                 } else {
                     MIX_10_4_7_3_6_1_1
                 }
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4_8_3_1
                 } else {
                     MIX_11_4_5_7_6_1_1
@@ -1495,12 +1600,12 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_11_4_7_3_1
                 break;
             case 186:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_6_1_1
                 }
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4_2_3_1
                 } else {
                     MIX_01_4_1_5_6_1_1
@@ -1510,13 +1615,13 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 115:
                 MIX_00_4_3_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4_2_3_1
                 } else {
                     MIX_01_4_1_5_6_1_1
                 }
                 MIX_10_4_3_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4_8_3_1
                 } else {
                     MIX_11_4_5_7_6_1_1
@@ -1525,25 +1630,25 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 93:
                 MIX_00_4_1_3_1
                 MIX_01_4_1_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4_6_3_1
                 } else {
                     MIX_10_4_7_3_6_1_1
                 }
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4_8_3_1
                 } else {
                     MIX_11_4_5_7_6_1_1
                 }
                 break;
             case 206:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_6_1_1
                 }
                 MIX_01_4_5_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4_6_3_1
                 } else {
                     MIX_10_4_7_3_6_1_1
@@ -1554,7 +1659,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 201:
                 MIX_00_4_1_3_1
                 MIX_01_4_1_5_2_1_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4_6_3_1
                 } else {
                     MIX_10_4_7_3_6_1_1
@@ -1563,7 +1668,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 174:
             case 46:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_6_1_1
@@ -1575,7 +1680,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 179:
             case 147:
                 MIX_00_4_3_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4_2_3_1
                 } else {
                     MIX_01_4_1_5_6_1_1
@@ -1588,7 +1693,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_00_4_3_1_2_1_1
                 MIX_01_4_1_3_1
                 MIX_10_4_3_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4_8_3_1
                 } else {
                     MIX_11_4_5_7_6_1_1
@@ -1608,12 +1713,12 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 126:
                 MIX_00_4_0_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                 } else {
                     MIX_01_4_1_5_2_1_1
                 }
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                 } else {
                     MIX_10_4_7_3_2_1_1
@@ -1621,21 +1726,21 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_11_4_8_3_1
                 break;
             case 219:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_2_1_1
                 }
                 MIX_01_4_2_3_1
                 MIX_10_4_6_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4
                 } else {
                     MIX_11_4_5_7_2_1_1
                 }
                 break;
             case 125:
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_00_4_1_3_1
                     MIX_10_4
                 } else {
@@ -1647,7 +1752,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 221:
                 MIX_00_4_1_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_01_4_1_3_1
                     MIX_11_4
                 } else {
@@ -1657,7 +1762,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4_6_3_1
                 break;
             case 207:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_01_4_5_3_1
                 } else {
@@ -1670,7 +1775,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 238:
                 MIX_00_4_0_3_1
                 MIX_01_4_5_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                     MIX_11_4_5_3_1
                 } else {
@@ -1680,7 +1785,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 190:
                 MIX_00_4_0_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                     MIX_11_4_7_3_1
                 } else {
@@ -1690,7 +1795,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4_7_3_1
                 break;
             case 187:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_10_4_7_3_1
                 } else {
@@ -1703,7 +1808,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 243:
                 MIX_00_4_3_3_1
                 MIX_01_4_2_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_10_4_3_3_1
                     MIX_11_4
                 } else {
@@ -1712,7 +1817,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 }
                 break;
             case 119:
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_00_4_3_3_1
                     MIX_01_4
                 } else {
@@ -1726,7 +1831,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 233:
                 MIX_00_4_1_3_1
                 MIX_01_4_1_5_2_1_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                 } else {
                     MIX_10_4_7_3_e_1_1
@@ -1735,7 +1840,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 175:
             case 47:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_e_1_1
@@ -1747,7 +1852,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 183:
             case 151:
                 MIX_00_4_3_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                 } else {
                     MIX_01_4_1_5_e_1_1
@@ -1760,7 +1865,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_00_4_3_1_2_1_1
                 MIX_01_4_1_3_1
                 MIX_10_4_3_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4
                 } else {
                     MIX_11_4_5_7_e_1_1
@@ -1769,25 +1874,25 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 250:
                 MIX_00_4_0_3_1
                 MIX_01_4_2_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                 } else {
                     MIX_10_4_7_3_2_1_1
                 }
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4
                 } else {
                     MIX_11_4_5_7_2_1_1
                 }
                 break;
             case 123:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_2_1_1
                 }
                 MIX_01_4_2_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                 } else {
                     MIX_10_4_7_3_2_1_1
@@ -1795,12 +1900,12 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_11_4_8_3_1
                 break;
             case 95:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_2_1_1
                 }
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                 } else {
                     MIX_01_4_1_5_2_1_1
@@ -1810,13 +1915,13 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 222:
                 MIX_00_4_0_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                 } else {
                     MIX_01_4_1_5_2_1_1
                 }
                 MIX_10_4_6_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4
                 } else {
                     MIX_11_4_5_7_2_1_1
@@ -1825,12 +1930,12 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 252:
                 MIX_00_4_0_1_2_1_1
                 MIX_01_4_1_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                 } else {
                     MIX_10_4_7_3_2_1_1
                 }
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4
                 } else {
                     MIX_11_4_5_7_e_1_1
@@ -1839,25 +1944,25 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 249:
                 MIX_00_4_1_3_1
                 MIX_01_4_2_1_2_1_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                 } else {
                     MIX_10_4_7_3_e_1_1
                 }
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4
                 } else {
                     MIX_11_4_5_7_2_1_1
                 }
                 break;
             case 235:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_2_1_1
                 }
                 MIX_01_4_2_5_2_1_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                 } else {
                     MIX_10_4_7_3_e_1_1
@@ -1865,13 +1970,13 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_11_4_5_3_1
                 break;
             case 111:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_e_1_1
                 }
                 MIX_01_4_5_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                 } else {
                     MIX_10_4_7_3_2_1_1
@@ -1879,12 +1984,12 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_11_4_8_5_2_1_1
                 break;
             case 63:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_e_1_1
                 }
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                 } else {
                     MIX_01_4_1_5_2_1_1
@@ -1893,12 +1998,12 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_11_4_8_7_2_1_1
                 break;
             case 159:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_2_1_1
                 }
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                 } else {
                     MIX_01_4_1_5_e_1_1
@@ -1908,13 +2013,13 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 215:
                 MIX_00_4_3_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                 } else {
                     MIX_01_4_1_5_e_1_1
                 }
                 MIX_10_4_6_3_2_1_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4
                 } else {
                     MIX_11_4_5_7_2_1_1
@@ -1922,13 +2027,13 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 246:
                 MIX_00_4_0_3_2_1_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                 } else {
                     MIX_01_4_1_5_2_1_1
                 }
                 MIX_10_4_3_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4
                 } else {
                     MIX_11_4_5_7_e_1_1
@@ -1936,17 +2041,17 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 254:
                 MIX_00_4_0_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                 } else {
                     MIX_01_4_1_5_2_1_1
                 }
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                 } else {
                     MIX_10_4_7_3_2_1_1
                 }
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4
                 } else {
                     MIX_11_4_5_7_e_1_1
@@ -1955,43 +2060,43 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 253:
                 MIX_00_4_1_3_1
                 MIX_01_4_1_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                 } else {
                     MIX_10_4_7_3_e_1_1
                 }
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4
                 } else {
                     MIX_11_4_5_7_e_1_1
                 }
                 break;
             case 251:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_2_1_1
                 }
                 MIX_01_4_2_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                 } else {
                     MIX_10_4_7_3_e_1_1
                 }
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4
                 } else {
                     MIX_11_4_5_7_2_1_1
                 }
                 break;
             case 239:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_e_1_1
                 }
                 MIX_01_4_5_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                 } else {
                     MIX_10_4_7_3_e_1_1
@@ -1999,17 +2104,17 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_11_4_5_3_1
                 break;
             case 127:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_e_1_1
                 }
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                 } else {
                     MIX_01_4_1_5_2_1_1
                 }
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                 } else {
                     MIX_10_4_7_3_2_1_1
@@ -2017,12 +2122,12 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_11_4_8_3_1
                 break;
             case 191:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_e_1_1
                 }
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                 } else {
                     MIX_01_4_1_5_e_1_1
@@ -2031,18 +2136,18 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_11_4_7_3_1
                 break;
             case 223:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_2_1_1
                 }
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                 } else {
                     MIX_01_4_1_5_e_1_1
                 }
                 MIX_10_4_6_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4
                 } else {
                     MIX_11_4_5_7_2_1_1
@@ -2050,31 +2155,32 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 247:
                 MIX_00_4_3_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                 } else {
                     MIX_01_4_1_5_e_1_1
                 }
                 MIX_10_4_3_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_11_4
                 } else {
                     MIX_11_4_5_7_e_1_1
                 }
                 break;
             case 255:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA))
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA))
                     MIX_00_4
                 else
                     MIX_00_4_3_1_e_1_1
 
-                        if (isDifferent(w[1], w[5], trY, trU, trV, trA)) MIX_01_4 else MIX_01_4_1_5_e_1_1
+                        if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) MIX_01_4 else MIX_01_4_1_5_e_1_1
 
-                        if (isDifferent(w[7], w[3], trY, trU, trV, trA)) MIX_10_4 else MIX_10_4_7_3_e_1_1
+                        if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) MIX_10_4 else MIX_10_4_7_3_e_1_1
 
-                        if (isDifferent(w[5], w[7], trY, trU, trV, trA)) MIX_11_4 else MIX_11_4_5_7_e_1_1 break;
+                        if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) MIX_11_4 else MIX_11_4_5_7_e_1_1 break;
             }
             image++;
+            yuv++;
             output += 2;
         }
         output += lineSize;
@@ -2084,7 +2190,7 @@ static uint32_t *hq2x_resize(char mode, const uint32_t *image, uint32_t width, u
 }
 
 static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, uint32_t height, uint32_t *output, uint32_t trY, uint32_t trU, uint32_t trV,
-                             uint32_t trA, bool wrapX, bool wrapY) {
+                             uint32_t trA, bool wrapX, bool wrapY, uint32_t yFirst, uint32_t yLast) {
     bool (*isDifferent)(uint32_t color1, uint32_t color2, uint32_t trY, uint32_t trU, uint32_t trV, uint32_t trA) = &isDifferentA;
     if (mode == 'B') {
         isDifferent = &isDifferentB;
@@ -2093,14 +2199,26 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
     int lineSize = width * 3;
 
     int previous, next;
-    uint32_t w[9];
+    uint32_t w[9], wy[9];
 
+    uint32_t thresholds = (trA << 24) | (trY << 16) | (trU << 8) | trV;
     trY <<= 16;
     trU <<= 8;
     trA <<= 24;
 
+    // Only process the rows of the requested band
+    yLast = std::min(yLast, height);
+    if (yFirst >= yLast)
+        return output;
+
+    std::vector<uint32_t> yuvRows;
+    const uint32_t *yuv = hqx_convert_rows(image, width, height, yFirst, yLast, wrapY, yuvRows);
+
+    image += size_t(yFirst) * width;
+    output += size_t(yFirst) * lineSize * 3;
+
     // iterates between the lines
-    for (uint32_t row = 0; row < height; row++) {
+    for (uint32_t row = yFirst; row < yLast; row++) {
         /*
          * Note: this function uses a 3x3 sliding window over the original image.
          *
@@ -2137,54 +2255,64 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
         // iterates between the columns
         for (uint32_t col = 0; col < width; col++) {
             w[1] = *(image + previous);
+            wy[1] = *(yuv + previous);
             w[4] = *image;
+            wy[4] = *yuv;
             w[7] = *(image + next);
+            wy[7] = *(yuv + next);
 
             if (col > 0) {
                 w[0] = *(image + previous - 1);
+                wy[0] = *(yuv + previous - 1);
                 w[3] = *(image - 1);
+                wy[3] = *(yuv - 1);
                 w[6] = *(image + next - 1);
+                wy[6] = *(yuv + next - 1);
             } else {
                 if (wrapX) {
                     w[0] = *(image + previous + width - 1);
+                    wy[0] = *(yuv + previous + width - 1);
                     w[3] = *(image + width - 1);
+                    wy[3] = *(yuv + width - 1);
                     w[6] = *(image + next + width - 1);
+                    wy[6] = *(yuv + next + width - 1);
                 } else {
                     w[0] = w[1];
+                    wy[0] = wy[1];
                     w[3] = w[4];
+                    wy[3] = wy[4];
                     w[6] = w[7];
+                    wy[6] = wy[7];
                 }
             }
 
             if (col < width - 1) {
                 w[2] = *(image + previous + 1);
+                wy[2] = *(yuv + previous + 1);
                 w[5] = *(image + 1);
+                wy[5] = *(yuv + 1);
                 w[8] = *(image + next + 1);
+                wy[8] = *(yuv + next + 1);
             } else {
                 if (wrapX) {
                     w[2] = *(image + previous - width + 1);
+                    wy[2] = *(yuv + previous - width + 1);
                     w[5] = *(image - width + 1);
+                    wy[5] = *(yuv - width + 1);
                     w[8] = *(image + next - width + 1);
+                    wy[8] = *(yuv + next - width + 1);
                 } else {
                     w[2] = w[1];
+                    wy[2] = wy[1];
                     w[5] = w[4];
+                    wy[5] = wy[4];
                     w[8] = w[7];
+                    wy[8] = wy[7];
                 }
             }
 
-            int pattern = 0;
-
             // computes the pattern to be used considering the neighbor pixels
-            for (int k = 0, flag = 1; k < 9; k++) {
-                // ignores the central pixel
-                if (k == 4)
-                    continue;
-
-                if (w[k] != w[4])
-                    if (isDifferent(w[4], w[k], trY, trU, trV, trA))
-                        pattern |= flag;
-                flag <<= 1;
-            }
+            int pattern = hqx_pattern(wy, thresholds);
 
             switch (pattern) {
             case 0:
@@ -2384,7 +2512,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 18:
             case 50:
                 MIX_00_4_0_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                     MIX_02_4_2_3_1
                     MIX_12_4
@@ -2407,7 +2535,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4_3_3_1
                 MIX_11_4
                 MIX_20_4_6_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_12_4
                     MIX_21_4
                     MIX_22_4_8_3_1
@@ -2424,7 +2552,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_02_4_1_5_2_1_1
                 MIX_11_4
                 MIX_12_4_5_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                     MIX_20_4_6_3_1
                     MIX_21_4
@@ -2437,7 +2565,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 10:
             case 138:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                     MIX_01_4
                     MIX_10_4
@@ -2530,7 +2658,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 22:
             case 54:
                 MIX_00_4_0_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                     MIX_02_4
                     MIX_12_4
@@ -2553,7 +2681,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4_3_3_1
                 MIX_11_4
                 MIX_20_4_6_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_12_4
                     MIX_21_4
                     MIX_22_4
@@ -2570,7 +2698,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_02_4_1_5_2_1_1
                 MIX_11_4
                 MIX_12_4_5_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                     MIX_20_4
                     MIX_21_4
@@ -2583,7 +2711,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 11:
             case 139:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_01_4
                     MIX_10_4
@@ -2601,7 +2729,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 19:
             case 51:
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_00_4_3_3_1
                     MIX_01_4
                     MIX_02_4_2_3_1
@@ -2620,7 +2748,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 146:
             case 178:
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                     MIX_02_4_2_3_1
                     MIX_12_4
@@ -2639,7 +2767,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 84:
             case 85:
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_02_4_1_3_1
                     MIX_12_4
                     MIX_21_4
@@ -2658,7 +2786,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 112:
             case 113:
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_12_4
                     MIX_20_4_3_3_1
                     MIX_21_4
@@ -2677,7 +2805,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 200:
             case 204:
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                     MIX_20_4_6_3_1
                     MIX_21_4
@@ -2696,7 +2824,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 73:
             case 77:
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_00_4_1_3_1
                     MIX_10_4
                     MIX_20_4_6_3_1
@@ -2715,7 +2843,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 42:
             case 170:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                     MIX_01_4
                     MIX_10_4
@@ -2734,7 +2862,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 14:
             case 142:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                     MIX_01_4
                     MIX_02_4_5_3_1
@@ -2841,7 +2969,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 26:
             case 31:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_10_4
                 } else {
@@ -2849,7 +2977,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                     MIX_10_4_3_7_1
                 }
                 MIX_01_4
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_02_4
                     MIX_12_4
                 } else {
@@ -2864,7 +2992,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 82:
             case 214:
                 MIX_00_4_0_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                     MIX_02_4
                 } else {
@@ -2875,7 +3003,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_11_4
                 MIX_12_4
                 MIX_20_4_6_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_21_4
                     MIX_22_4
                 } else {
@@ -2889,7 +3017,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_01_4_1_3_1
                 MIX_02_4_2_3_1
                 MIX_11_4
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                     MIX_20_4
                 } else {
@@ -2897,7 +3025,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                     MIX_20_4_7_3_2_7_7
                 }
                 MIX_21_4
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_12_4
                     MIX_22_4
                 } else {
@@ -2907,7 +3035,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 74:
             case 107:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_01_4
                 } else {
@@ -2918,7 +3046,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4
                 MIX_11_4
                 MIX_12_4_5_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_20_4
                     MIX_21_4
                 } else {
@@ -2928,7 +3056,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_22_4_8_3_1
                 break;
             case 27:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_01_4
                     MIX_10_4
@@ -2946,7 +3074,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 86:
                 MIX_00_4_0_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                     MIX_02_4
                     MIX_12_4
@@ -2968,7 +3096,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4
                 MIX_11_4
                 MIX_20_4_6_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_12_4
                     MIX_21_4
                     MIX_22_4
@@ -2984,7 +3112,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_02_4_2_3_1
                 MIX_11_4
                 MIX_12_4_5_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                     MIX_20_4
                     MIX_21_4
@@ -2997,7 +3125,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 30:
                 MIX_00_4_0_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                     MIX_02_4
                     MIX_12_4
@@ -3019,7 +3147,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4_3_3_1
                 MIX_11_4
                 MIX_20_4_6_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_12_4
                     MIX_21_4
                     MIX_22_4
@@ -3035,7 +3163,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_02_4_2_3_1
                 MIX_11_4
                 MIX_12_4
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                     MIX_20_4
                     MIX_21_4
@@ -3047,7 +3175,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_22_4_8_3_1
                 break;
             case 75:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_01_4
                     MIX_10_4
@@ -3196,13 +3324,13 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_22_4_7_3_1
                 break;
             case 58:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_2_1_1
                 }
                 MIX_01_4
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_02_4_2_3_1
                 } else {
                     MIX_02_4_1_5_2_1_1
@@ -3217,7 +3345,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 83:
                 MIX_00_4_3_3_1
                 MIX_01_4
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_02_4_2_3_1
                 } else {
                     MIX_02_4_1_5_2_1_1
@@ -3227,7 +3355,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_12_4
                 MIX_20_4_6_3_1
                 MIX_21_4
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_22_4_8_3_1
                 } else {
                     MIX_22_4_5_7_2_1_1
@@ -3240,20 +3368,20 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4
                 MIX_11_4
                 MIX_12_4
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_20_4_6_3_1
                 } else {
                     MIX_20_4_7_3_2_1_1
                 }
                 MIX_21_4
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_22_4_8_3_1
                 } else {
                     MIX_22_4_5_7_2_1_1
                 }
                 break;
             case 202:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_2_1_1
@@ -3263,7 +3391,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4
                 MIX_11_4
                 MIX_12_4_5_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_20_4_6_3_1
                 } else {
                     MIX_20_4_7_3_2_1_1
@@ -3272,7 +3400,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_22_4_5_3_1
                 break;
             case 78:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_2_1_1
@@ -3282,7 +3410,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4
                 MIX_11_4
                 MIX_12_4_5_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_20_4_6_3_1
                 } else {
                     MIX_20_4_7_3_2_1_1
@@ -3291,13 +3419,13 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_22_4_8_3_1
                 break;
             case 154:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_2_1_1
                 }
                 MIX_01_4
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_02_4_2_3_1
                 } else {
                     MIX_02_4_1_5_2_1_1
@@ -3312,7 +3440,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 114:
                 MIX_00_4_0_3_1
                 MIX_01_4
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_02_4_2_3_1
                 } else {
                     MIX_02_4_1_5_2_1_1
@@ -3322,7 +3450,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_12_4
                 MIX_20_4_3_3_1
                 MIX_21_4
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_22_4_8_3_1
                 } else {
                     MIX_22_4_5_7_2_1_1
@@ -3335,26 +3463,26 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4
                 MIX_11_4
                 MIX_12_4
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_20_4_6_3_1
                 } else {
                     MIX_20_4_7_3_2_1_1
                 }
                 MIX_21_4
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_22_4_8_3_1
                 } else {
                     MIX_22_4_5_7_2_1_1
                 }
                 break;
             case 90:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_2_1_1
                 }
                 MIX_01_4
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_02_4_2_3_1
                 } else {
                     MIX_02_4_1_5_2_1_1
@@ -3362,13 +3490,13 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4
                 MIX_11_4
                 MIX_12_4
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_20_4_6_3_1
                 } else {
                     MIX_20_4_7_3_2_1_1
                 }
                 MIX_21_4
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_22_4_8_3_1
                 } else {
                     MIX_22_4_5_7_2_1_1
@@ -3376,7 +3504,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 55:
             case 23:
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_00_4_3_3_1
                     MIX_01_4
                     MIX_02_4
@@ -3395,7 +3523,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 182:
             case 150:
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                     MIX_02_4
                     MIX_12_4
@@ -3414,7 +3542,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 213:
             case 212:
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_02_4_1_3_1
                     MIX_12_4
                     MIX_21_4
@@ -3433,7 +3561,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 241:
             case 240:
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_12_4
                     MIX_20_4_3_3_1
                     MIX_21_4
@@ -3452,7 +3580,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 236:
             case 232:
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                     MIX_20_4
                     MIX_21_4
@@ -3471,7 +3599,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 109:
             case 105:
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_00_4_1_3_1
                     MIX_10_4
                     MIX_20_4
@@ -3490,7 +3618,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 171:
             case 43:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_01_4
                     MIX_10_4
@@ -3509,7 +3637,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 143:
             case 15:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_01_4
                     MIX_02_4_5_3_1
@@ -3532,7 +3660,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_02_4_1_3_1
                 MIX_11_4
                 MIX_12_4
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                     MIX_20_4
                     MIX_21_4
@@ -3544,7 +3672,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_22_4_8_3_1
                 break;
             case 203:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_01_4
                     MIX_10_4
@@ -3562,7 +3690,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 62:
                 MIX_00_4_0_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                     MIX_02_4
                     MIX_12_4
@@ -3584,7 +3712,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4_3_3_1
                 MIX_11_4
                 MIX_20_4_6_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_12_4
                     MIX_21_4
                     MIX_22_4
@@ -3596,7 +3724,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 118:
                 MIX_00_4_0_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                     MIX_02_4
                     MIX_12_4
@@ -3618,7 +3746,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4
                 MIX_11_4
                 MIX_20_4_6_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_12_4
                     MIX_21_4
                     MIX_22_4
@@ -3634,7 +3762,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_02_4_5_3_1
                 MIX_11_4
                 MIX_12_4_5_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                     MIX_20_4
                     MIX_21_4
@@ -3646,7 +3774,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_22_4_8_3_1
                 break;
             case 155:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_01_4
                     MIX_10_4
@@ -3756,12 +3884,12 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_02_4_1_3_1
                 MIX_10_4
                 MIX_11_4
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_20_4_6_3_1
                 } else {
                     MIX_20_4_7_3_2_1_1
                 }
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_12_4
                     MIX_21_4
                     MIX_22_4
@@ -3772,12 +3900,12 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 }
                 break;
             case 158:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_2_1_1
                 }
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                     MIX_02_4
                     MIX_12_4
@@ -3793,7 +3921,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_22_4_7_3_1
                 break;
             case 234:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_2_1_1
@@ -3802,7 +3930,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_02_4_2_3_1
                 MIX_11_4
                 MIX_12_4_5_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                     MIX_20_4
                     MIX_21_4
@@ -3816,7 +3944,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 242:
                 MIX_00_4_0_3_1
                 MIX_01_4
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_02_4_2_3_1
                 } else {
                     MIX_02_4_1_5_2_1_1
@@ -3824,7 +3952,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4_3_3_1
                 MIX_11_4
                 MIX_20_4_3_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_12_4
                     MIX_21_4
                     MIX_22_4
@@ -3835,7 +3963,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 }
                 break;
             case 59:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_01_4
                     MIX_10_4
@@ -3844,7 +3972,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                     MIX_01_4_1_7_1
                     MIX_10_4_3_7_1
                 }
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_02_4_2_3_1
                 } else {
                     MIX_02_4_1_5_2_1_1
@@ -3861,7 +3989,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_02_4_2_3_1
                 MIX_11_4
                 MIX_12_4
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                     MIX_20_4
                     MIX_21_4
@@ -3870,7 +3998,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                     MIX_20_4_7_3_2_7_7
                     MIX_21_4_7_7_1
                 }
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_22_4_8_3_1
                 } else {
                     MIX_22_4_5_7_2_1_1
@@ -3878,7 +4006,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 87:
                 MIX_00_4_3_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                     MIX_02_4
                     MIX_12_4
@@ -3891,14 +4019,14 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_11_4
                 MIX_20_4_6_3_1
                 MIX_21_4
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_22_4_8_3_1
                 } else {
                     MIX_22_4_5_7_2_1_1
                 }
                 break;
             case 79:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_01_4
                     MIX_10_4
@@ -3910,7 +4038,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_02_4_5_3_1
                 MIX_11_4
                 MIX_12_4_5_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_20_4_6_3_1
                 } else {
                     MIX_20_4_7_3_2_1_1
@@ -3919,20 +4047,20 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_22_4_8_3_1
                 break;
             case 122:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_2_1_1
                 }
                 MIX_01_4
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_02_4_2_3_1
                 } else {
                     MIX_02_4_1_5_2_1_1
                 }
                 MIX_11_4
                 MIX_12_4
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                     MIX_20_4
                     MIX_21_4
@@ -3941,19 +4069,19 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                     MIX_20_4_7_3_2_7_7
                     MIX_21_4_7_7_1
                 }
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_22_4_8_3_1
                 } else {
                     MIX_22_4_5_7_2_1_1
                 }
                 break;
             case 94:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_2_1_1
                 }
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                     MIX_02_4
                     MIX_12_4
@@ -3964,38 +4092,38 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 }
                 MIX_10_4
                 MIX_11_4
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_20_4_6_3_1
                 } else {
                     MIX_20_4_7_3_2_1_1
                 }
                 MIX_21_4
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_22_4_8_3_1
                 } else {
                     MIX_22_4_5_7_2_1_1
                 }
                 break;
             case 218:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_2_1_1
                 }
                 MIX_01_4
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_02_4_2_3_1
                 } else {
                     MIX_02_4_1_5_2_1_1
                 }
                 MIX_10_4
                 MIX_11_4
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_20_4_6_3_1
                 } else {
                     MIX_20_4_7_3_2_1_1
                 }
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_12_4
                     MIX_21_4
                     MIX_22_4
@@ -4006,7 +4134,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 }
                 break;
             case 91:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_01_4
                     MIX_10_4
@@ -4015,20 +4143,20 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                     MIX_01_4_1_7_1
                     MIX_10_4_3_7_1
                 }
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_02_4_2_3_1
                 } else {
                     MIX_02_4_1_5_2_1_1
                 }
                 MIX_11_4
                 MIX_12_4
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_20_4_6_3_1
                 } else {
                     MIX_20_4_7_3_2_1_1
                 }
                 MIX_21_4
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_22_4_8_3_1
                 } else {
                     MIX_22_4_5_7_2_1_1
@@ -4079,13 +4207,13 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_22_4_7_3_1
                 break;
             case 186:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_2_1_1
                 }
                 MIX_01_4
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_02_4_2_3_1
                 } else {
                     MIX_02_4_1_5_2_1_1
@@ -4100,7 +4228,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 115:
                 MIX_00_4_3_3_1
                 MIX_01_4
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_02_4_2_3_1
                 } else {
                     MIX_02_4_1_5_2_1_1
@@ -4110,7 +4238,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_12_4
                 MIX_20_4_3_3_1
                 MIX_21_4
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_22_4_8_3_1
                 } else {
                     MIX_22_4_5_7_2_1_1
@@ -4123,20 +4251,20 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4
                 MIX_11_4
                 MIX_12_4
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_20_4_6_3_1
                 } else {
                     MIX_20_4_7_3_2_1_1
                 }
                 MIX_21_4
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_22_4_8_3_1
                 } else {
                     MIX_22_4_5_7_2_1_1
                 }
                 break;
             case 206:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_2_1_1
@@ -4146,7 +4274,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4
                 MIX_11_4
                 MIX_12_4_5_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_20_4_6_3_1
                 } else {
                     MIX_20_4_7_3_2_1_1
@@ -4162,7 +4290,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4
                 MIX_11_4
                 MIX_12_4_5_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_20_4_6_3_1
                 } else {
                     MIX_20_4_7_3_2_1_1
@@ -4172,7 +4300,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 174:
             case 46:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4_0_3_1
                 } else {
                     MIX_00_4_3_1_2_1_1
@@ -4190,7 +4318,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 147:
                 MIX_00_4_3_3_1
                 MIX_01_4
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_02_4_2_3_1
                 } else {
                     MIX_02_4_1_5_2_1_1
@@ -4212,7 +4340,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_12_4
                 MIX_20_4_3_3_1
                 MIX_21_4
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_22_4_8_3_1
                 } else {
                     MIX_22_4_5_7_2_1_1
@@ -4242,7 +4370,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 126:
                 MIX_00_4_0_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                     MIX_02_4
                     MIX_12_4
@@ -4252,7 +4380,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                     MIX_12_4_5_7_1
                 }
                 MIX_11_4
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                     MIX_20_4
                     MIX_21_4
@@ -4264,7 +4392,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_22_4_8_3_1
                 break;
             case 219:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_01_4
                     MIX_10_4
@@ -4276,7 +4404,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_02_4_2_3_1
                 MIX_11_4
                 MIX_20_4_6_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_12_4
                     MIX_21_4
                     MIX_22_4
@@ -4287,7 +4415,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 }
                 break;
             case 125:
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_00_4_1_3_1
                     MIX_10_4
                     MIX_20_4
@@ -4305,7 +4433,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_22_4_8_3_1
                 break;
             case 221:
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_02_4_1_3_1
                     MIX_12_4
                     MIX_21_4
@@ -4323,7 +4451,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_20_4_6_3_1
                 break;
             case 207:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_01_4
                     MIX_02_4_5_3_1
@@ -4341,7 +4469,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_22_4_5_3_1
                 break;
             case 238:
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                     MIX_20_4
                     MIX_21_4
@@ -4359,7 +4487,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_12_4_5_3_1
                 break;
             case 190:
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                     MIX_02_4
                     MIX_12_4
@@ -4377,7 +4505,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_21_4_7_3_1
                 break;
             case 187:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_01_4
                     MIX_10_4
@@ -4395,7 +4523,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_22_4_7_3_1
                 break;
             case 243:
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_12_4
                     MIX_20_4_3_3_1
                     MIX_21_4
@@ -4413,7 +4541,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_11_4
                 break;
             case 119:
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_00_4_3_3_1
                     MIX_01_4
                     MIX_02_4
@@ -4438,7 +4566,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4
                 MIX_11_4
                 MIX_12_4_5_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_20_4
                 } else {
                     MIX_20_4_7_3_2_1_1
@@ -4448,7 +4576,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 175:
             case 47:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_2_1_1
@@ -4466,7 +4594,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 151:
                 MIX_00_4_3_3_1
                 MIX_01_4
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_02_4
                 } else {
                     MIX_02_4_1_5_2_1_1
@@ -4488,7 +4616,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_12_4
                 MIX_20_4_3_3_1
                 MIX_21_4
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_22_4
                 } else {
                     MIX_22_4_5_7_2_1_1
@@ -4499,7 +4627,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_01_4
                 MIX_02_4_2_3_1
                 MIX_11_4
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                     MIX_20_4
                 } else {
@@ -4507,7 +4635,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                     MIX_20_4_7_3_2_7_7
                 }
                 MIX_21_4
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_12_4
                     MIX_22_4
                 } else {
@@ -4516,7 +4644,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 }
                 break;
             case 123:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_01_4
                 } else {
@@ -4527,7 +4655,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4
                 MIX_11_4
                 MIX_12_4
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_20_4
                     MIX_21_4
                 } else {
@@ -4537,7 +4665,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_22_4_8_3_1
                 break;
             case 95:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_10_4
                 } else {
@@ -4545,7 +4673,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                     MIX_10_4_3_7_1
                 }
                 MIX_01_4
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_02_4
                     MIX_12_4
                 } else {
@@ -4559,7 +4687,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 222:
                 MIX_00_4_0_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                     MIX_02_4
                 } else {
@@ -4570,7 +4698,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_11_4
                 MIX_12_4
                 MIX_20_4_6_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_21_4
                     MIX_22_4
                 } else {
@@ -4584,7 +4712,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_02_4_1_3_1
                 MIX_11_4
                 MIX_12_4
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                     MIX_20_4
                 } else {
@@ -4592,7 +4720,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                     MIX_20_4_7_3_2_7_7
                 }
                 MIX_21_4
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_22_4
                 } else {
                     MIX_22_4_5_7_2_1_1
@@ -4604,13 +4732,13 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_02_4_2_3_1
                 MIX_10_4
                 MIX_11_4
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_20_4
                 } else {
                     MIX_20_4_7_3_2_1_1
                 }
                 MIX_21_4
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_12_4
                     MIX_22_4
                 } else {
@@ -4619,7 +4747,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 }
                 break;
             case 235:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_01_4
                 } else {
@@ -4630,7 +4758,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4
                 MIX_11_4
                 MIX_12_4_5_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_20_4
                 } else {
                     MIX_20_4_7_3_2_1_1
@@ -4639,7 +4767,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_22_4_5_3_1
                 break;
             case 111:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_2_1_1
@@ -4649,7 +4777,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4
                 MIX_11_4
                 MIX_12_4_5_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_20_4
                     MIX_21_4
                 } else {
@@ -4659,13 +4787,13 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_22_4_8_3_1
                 break;
             case 63:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_2_1_1
                 }
                 MIX_01_4
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_02_4
                     MIX_12_4
                 } else {
@@ -4679,7 +4807,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_22_4_8_3_1
                 break;
             case 159:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_10_4
                 } else {
@@ -4687,7 +4815,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                     MIX_10_4_3_7_1
                 }
                 MIX_01_4
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_02_4
                 } else {
                     MIX_02_4_1_5_2_1_1
@@ -4701,7 +4829,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 215:
                 MIX_00_4_3_3_1
                 MIX_01_4
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_02_4
                 } else {
                     MIX_02_4_1_5_2_1_1
@@ -4710,7 +4838,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_11_4
                 MIX_12_4
                 MIX_20_4_6_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_21_4
                     MIX_22_4
                 } else {
@@ -4720,7 +4848,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 246:
                 MIX_00_4_0_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                     MIX_02_4
                 } else {
@@ -4732,7 +4860,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_12_4
                 MIX_20_4_3_3_1
                 MIX_21_4
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_22_4
                 } else {
                     MIX_22_4_5_7_2_1_1
@@ -4740,7 +4868,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             case 254:
                 MIX_00_4_0_3_1
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                     MIX_02_4
                 } else {
@@ -4748,14 +4876,14 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                     MIX_02_4_1_5_2_7_7
                 }
                 MIX_11_4
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                     MIX_20_4
                 } else {
                     MIX_10_4_3_7_1
                     MIX_20_4_7_3_2_7_7
                 }
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_12_4
                     MIX_21_4
                     MIX_22_4
@@ -4772,20 +4900,20 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4
                 MIX_11_4
                 MIX_12_4
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_20_4
                 } else {
                     MIX_20_4_7_3_2_1_1
                 }
                 MIX_21_4
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_22_4
                 } else {
                     MIX_22_4_5_7_2_1_1
                 }
                 break;
             case 251:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_01_4
                 } else {
@@ -4794,7 +4922,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 }
                 MIX_02_4_2_3_1
                 MIX_11_4
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_10_4
                     MIX_20_4
                     MIX_21_4
@@ -4803,7 +4931,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                     MIX_20_4_7_3_2_1_1
                     MIX_21_4_7_7_1
                 }
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_12_4
                     MIX_22_4
                 } else {
@@ -4812,7 +4940,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 }
                 break;
             case 239:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_2_1_1
@@ -4822,7 +4950,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4
                 MIX_11_4
                 MIX_12_4_5_3_1
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_20_4
                 } else {
                     MIX_20_4_7_3_2_1_1
@@ -4831,7 +4959,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_22_4_5_3_1
                 break;
             case 127:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_01_4
                     MIX_10_4
@@ -4840,7 +4968,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                     MIX_01_4_1_7_1
                     MIX_10_4_3_7_1
                 }
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_02_4
                     MIX_12_4
                 } else {
@@ -4848,7 +4976,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                     MIX_12_4_5_7_1
                 }
                 MIX_11_4
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_20_4
                     MIX_21_4
                 } else {
@@ -4858,13 +4986,13 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_22_4_8_3_1
                 break;
             case 191:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_2_1_1
                 }
                 MIX_01_4
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_02_4
                 } else {
                     MIX_02_4_1_5_2_1_1
@@ -4877,14 +5005,14 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_22_4_7_3_1
                 break;
             case 223:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                     MIX_10_4
                 } else {
                     MIX_00_4_3_1_2_7_7
                     MIX_10_4_3_7_1
                 }
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_01_4
                     MIX_02_4
                     MIX_12_4
@@ -4895,7 +5023,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 }
                 MIX_11_4
                 MIX_20_4_6_3_1
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_21_4
                     MIX_22_4
                 } else {
@@ -4906,7 +5034,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
             case 247:
                 MIX_00_4_3_3_1
                 MIX_01_4
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_02_4
                 } else {
                     MIX_02_4_1_5_2_1_1
@@ -4916,20 +5044,20 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_12_4
                 MIX_20_4_3_3_1
                 MIX_21_4
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_22_4
                 } else {
                     MIX_22_4_5_7_2_1_1
                 }
                 break;
             case 255:
-                if (isDifferent(w[3], w[1], trY, trU, trV, trA)) {
+                if (isDifferent(wy[3], wy[1], trY, trU, trV, trA)) {
                     MIX_00_4
                 } else {
                     MIX_00_4_3_1_2_1_1
                 }
                 MIX_01_4
-                if (isDifferent(w[1], w[5], trY, trU, trV, trA)) {
+                if (isDifferent(wy[1], wy[5], trY, trU, trV, trA)) {
                     MIX_02_4
                 } else {
                     MIX_02_4_1_5_2_1_1
@@ -4937,13 +5065,13 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 MIX_10_4
                 MIX_11_4
                 MIX_12_4
-                if (isDifferent(w[7], w[3], trY, trU, trV, trA)) {
+                if (isDifferent(wy[7], wy[3], trY, trU, trV, trA)) {
                     MIX_20_4
                 } else {
                     MIX_20_4_7_3_2_1_1
                 }
                 MIX_21_4
-                if (isDifferent(w[5], w[7], trY, trU, trV, trA)) {
+                if (isDifferent(wy[5], wy[7], trY, trU, trV, trA)) {
                     MIX_22_4
                 } else {
                     MIX_22_4_5_7_2_1_1
@@ -4951,6 +5079,7 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
                 break;
             }
             image++;
+            yuv++;
             output += 3;
         }
         output += lineSize + lineSize;
@@ -4963,19 +5092,21 @@ static uint32_t *hq3x_resize(char mode, const uint32_t *image, uint32_t width, u
 //
 // The constant values supplied for the trailing arguments were provided
 // as default values in the original impl.
+// yFirst and yLast select a band of source rows, so that bands can be
+// scaled on separate threads.
 
-void hq2xA(uint32_t *img, int w, int h, uint32_t *out) {
-    hq2x_resize('A', img, w, h, out, 0x30, 0x07, 0x06, 0x50, false, false);
+void hq2xA(uint32_t *img, int w, int h, uint32_t *out, int yFirst, int yLast) {
+    hq2x_resize('A', img, w, h, out, 0x30, 0x07, 0x06, 0x50, false, false, std::max(yFirst, 0), std::max(yLast, 0));
 }
 
-void hq2xB(uint32_t *img, int w, int h, uint32_t *out) {
-    hq2x_resize('B', img, w, h, out, 0x30, 0x07, 0x06, 0x50, false, false);
+void hq2xB(uint32_t *img, int w, int h, uint32_t *out, int yFirst, int yLast) {
+    hq2x_resize('B', img, w, h, out, 0x30, 0x07, 0x06, 0x50, false, false, std::max(yFirst, 0), std::max(yLast, 0));
 }
 
-void hq3xA(uint32_t *img, int w, int h, uint32_t *out) {
-    hq3x_resize('A', img, w, h, out, 0x30, 0x07, 0x06, 0x50, false, false);
+void hq3xA(uint32_t *img, int w, int h, uint32_t *out, int yFirst, int yLast) {
+    hq3x_resize('A', img, w, h, out, 0x30, 0x07, 0x06, 0x50, false, false, std::max(yFirst, 0), std::max(yLast, 0));
 }
 
-void hq3xB(uint32_t *img, int w, int h, uint32_t *out) {
-    hq3x_resize('B', img, w, h, out, 0x30, 0x07, 0x06, 0x50, false, false);
+void hq3xB(uint32_t *img, int w, int h, uint32_t *out, int yFirst, int yLast) {
+    hq3x_resize('B', img, w, h, out, 0x30, 0x07, 0x06, 0x50, false, false, std::max(yFirst, 0), std::max(yLast, 0));
 }
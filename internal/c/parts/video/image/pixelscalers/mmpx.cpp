@@ -65,10 +65,14 @@ static struct Meta build_meta(const uint32_t *srcBuffer, uint32_t srcWidth, uint
     };
 }
 
-void mmpx_scale2x(const uint32_t *srcBuffer, uint32_t *dst, uint32_t srcWidth, uint32_t srcHeight) {
+void mmpx_scale2x(const uint32_t *srcBuffer, uint32_t *dst, uint32_t srcWidth, uint32_t srcHeight, int yFirst, int yLast) {
     const struct Meta meta = build_meta(srcBuffer, srcWidth, srcHeight);
 
-    for (uint32_t srcY = 0; srcY < srcHeight; ++srcY) {
+    // Every output row only depends on the source, so bands of rows can be scaled independently
+    const uint32_t srcYFirst = std::max(yFirst, 0);
+    const uint32_t srcYLast = std::min<uint32_t>(std::max(yLast, 0), srcHeight);
+
+    for (uint32_t srcY = srcYFirst; srcY < srcYLast; ++srcY) {
         uint32_t srcX = 0;
 
         // Inputs carried along rows
@@ -1,4 +1,7 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #define STB_IMAGE_WRITE_IMPLEMENTATION
+// PNG data is deflated using miniz (see image_zlib_compress() in image.cpp)
+#define STBIW_ZLIB_COMPRESS image_zlib_compress
+unsigned char *image_zlib_compress(unsigned char *data, int dataLen, int *outLen, int level);
 #include "stb_image_write.h"
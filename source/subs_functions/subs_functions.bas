@@ -282,11 +282,11 @@ SUB reginternal
     id.n = "_MemSound": id.Dependency = DEPENDENCY_MINIAUDIO
     id.subfunc = 1
     id.callname = "func__memsound"
-    id.args = 2
-    id.arg = MKL$(LONGTYPE - ISPOINTER) + MKL$(LONGTYPE - ISPOINTER)
-    id.specialformat = "?[,?]"
+    id.args = 4
+    id.arg = MKL$(LONGTYPE - ISPOINTER) + MKL$(LONGTYPE - ISPOINTER) + MKL$(INTEGER64TYPE - ISPOINTER) + MKL$(INTEGER64TYPE - ISPOINTER)
+    id.specialformat = "?[,[?][,[?][,[?]]]]"
     id.ret = ISUDT + (1) 'the _MEM type is the first TYPE defined
-    id.hr_syntax = "_MEMSOUND(soundHandle)"
+    id.hr_syntax = "_MEMSOUND(soundHandle[, channel&][, startFrame&&][, frames&&])"
     regid
 
     clearid '_MEMCOPY a, aoffset, bytes TO b, boffset
@@ -1176,6 +1176,30 @@ SUB reginternal
     id.hr_syntax = "_LOADIMAGE(fileName$[, [mode&][, requirements$]])"
     regid
 
+    clearid
+    id.n = "_ImageReady"
+    id.Dependency = DEPENDENCY_IMAGE_CODEC
+    id.subfunc = 1
+    id.callname = "func__imageready"
+    id.args = 2
+    id.arg = MKL$(LONGTYPE - ISPOINTER) + MKL$(LONGTYPE - ISPOINTER)
+    id.specialformat = "?[,?]"
+    id.ret = LONGTYPE - ISPOINTER
+    id.hr_syntax = "_IMAGEREADY(imageHandle&[, wait&])"
+    regid
+
+    clearid
+    id.n = "_ScaleImage"
+    id.Dependency = DEPENDENCY_IMAGE_CODEC
+    id.subfunc = 1
+    id.callname = "func__scaleimage"
+    id.args = 4
+    id.arg = MKL$(LONGTYPE - ISPOINTER) + MKL$(STRINGTYPE - ISPOINTER) + MKL$(LONGTYPE - ISPOINTER) + MKL$(LONGTYPE - ISPOINTER)
+    id.specialformat = "?,?[,?[,?]]"
+    id.ret = LONGTYPE - ISPOINTER
+    id.hr_syntax = "_SCALEIMAGE(imageHandle&, scaler$[, width&[, height&]])"
+    regid
+
     clearid
     id.n = "_FreeImage"
     id.subfunc = 2
@@ -2229,6 +2253,16 @@ SUB reginternal
     id.hr_syntax = "_SNDGETPOS(handle&)"
     regid
 
+    clearid
+    id.n = "_SndReady": id.Dependency = DEPENDENCY_MINIAUDIO
+    id.subfunc = 1
+    id.callname = "func__sndready"
+    id.args = 1
+    id.arg = MKL$(LONGTYPE - ISPOINTER)
+    id.ret = LONGTYPE - ISPOINTER
+    id.hr_syntax = "_SNDREADY(handle&)"
+    regid
+
     clearid
     id.n = "_SndPlaying": id.Dependency = DEPENDENCY_MINIAUDIO
     id.subfunc = 1
@@ -2258,6 +2292,16 @@ SUB reginternal
     id.hr_syntax = "_SNDBAL handle&[, x!][, y!][, z!]"
     regid
 
+    clearid
+    id.n = "_SndEffect": id.Dependency = DEPENDENCY_MINIAUDIO
+    id.subfunc = 2
+    id.callname = "sub__sndeffect"
+    id.args = 6
+    id.arg = MKL$(LONGTYPE - ISPOINTER) + MKL$(LONGTYPE - ISPOINTER) + MKL$(LONGTYPE - ISPOINTER) + MKL$(SINGLETYPE - ISPOINTER) + MKL$(SINGLETYPE - ISPOINTER) + MKL$(SINGLETYPE - ISPOINTER)
+    id.specialformat = "?,?,?[,[?][,[?][,[?]]]]"
+    id.hr_syntax = "_SNDEFFECT handle&, slot&, effectType&[, param1!][, param2!][, param3!]"
+    regid
+
     clearid
     id.n = "_SndVol": id.Dependency = DEPENDENCY_MINIAUDIO
     id.subfunc = 2
@@ -2307,6 +2351,27 @@ SUB reginternal
     id.hr_syntax = "_SNDNEW(frames&[, channels&][, bits&][, sampleRate&])"
     regid
 
+    clearid
+    id.n = "_SndRender": id.Dependency = DEPENDENCY_MINIAUDIO
+    id.subfunc = 1
+    id.callname = "func__sndrender"
+    id.args = 1
+    id.arg = MKL$(ULONGTYPE - ISPOINTER)
+    id.ret = LONGTYPE - ISPOINTER
+    id.hr_syntax = "_SNDRENDER(frames&)"
+    regid
+
+    clearid
+    id.n = "_SndStat": id.Dependency = DEPENDENCY_MINIAUDIO
+    id.subfunc = 1
+    id.callname = "func__sndstat"
+    id.args = 2
+    id.arg = MKL$(LONGTYPE - ISPOINTER) + MKL$(LONGTYPE - ISPOINTER)
+    id.specialformat = "?[,?]"
+    id.ret = INTEGER64TYPE - ISPOINTER
+    id.hr_syntax = "_SNDSTAT(statistic&[, index&])"
+    regid
+
     clearid
     id.n = "_MIDISoundBank"
     id.Dependency = DEPENDENCY_MINIAUDIO
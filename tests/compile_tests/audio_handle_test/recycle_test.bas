@@ -0,0 +1,66 @@
+$CONSOLE:ONLY
+OPTION _EXPLICIT
+
+' Checks that closed and finished one-shot handles are recycled instead of growing the handle list
+
+CONST HANDLE_COUNT = 100
+CONST PLAY_COUNT = 1000
+CONST BURST_COUNT = 5
+
+DIM AS LONG i, burst, snd, maxHandle
+DIM handles(1 TO HANDLE_COUNT) AS LONG
+
+' Handles that never played are released after _SNDCLOSE
+FOR i = 1 TO HANDLE_COUNT
+    handles(i) = _SNDNEW(64, 1, 32)
+    IF handles(i) > maxHandle THEN maxHandle = handles(i)
+NEXT
+
+FOR i = 1 TO HANDLE_COUNT
+    _SNDCLOSE handles(i)
+NEXT
+
+WaitForUpdate
+
+FOR i = 1 TO HANDLE_COUNT
+    handles(i) = _SNDNEW(64, 1, 32)
+NEXT
+
+PRINT "Closed handles recycled: "; MaxOf(handles()) <= maxHandle
+
+FOR i = 1 TO HANDLE_COUNT
+    _SNDCLOSE handles(i)
+NEXT
+
+' A very short sound fired many times with _SNDPLAYCOPY, in bursts
+snd = _SNDNEW(32, 1, 32)
+
+FOR burst = 1 TO BURST_COUNT
+    FOR i = 1 TO PLAY_COUNT
+        _SNDPLAYCOPY snd
+    NEXT
+
+    WaitForUpdate
+NEXT
+
+' Without recycling this would be past BURST_COUNT * PLAY_COUNT
+handles(1) = _SNDNEW(64, 1, 32)
+PRINT "Finished copies recycled: "; handles(1) <= PLAY_COUNT + maxHandle + 1
+_SNDCLOSE handles(1)
+
+_SNDCLOSE snd
+
+SYSTEM
+
+SUB WaitForUpdate
+    ' The engine releases auto-kill handles at ~60 Hz
+    _DELAY 0.5
+END SUB
+
+FUNCTION MaxOf& (a() AS LONG)
+    DIM AS LONG i, m
+    FOR i = LBOUND(a) TO UBOUND(a)
+        IF a(i) > m THEN m = a(i)
+    NEXT
+    MaxOf = m
+END FUNCTION
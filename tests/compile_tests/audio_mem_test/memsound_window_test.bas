@@ -0,0 +1,103 @@
+$CONSOLE:ONLY
+OPTION _EXPLICIT
+
+' _MEMSOUND with a frame range must work on streamed sounds and return the same data as a completely decoded copy
+
+CHDIR _STARTDIR$
+
+' Offline mode at the file's sample rate keeps the data free of resampling, so it can be compared exactly
+RunOffline 44100
+
+CONST TEMP_FILE = "memsound_window_test_temp.wav"
+CONST TEMP_DIR = "memsound_window_test_temp"
+CONST FILE_FRAMES = 100000
+CONST WINDOW_FRAMES = 10000
+
+DIM AS LONG decoded, streamed, streamedAgain, matches
+DIM AS _INTEGER64 start, total
+DIM AS _MEM whole, part, earlier
+
+WriteWave TEMP_FILE, 44100, FILE_FRAMES, 10000
+
+decoded = _SNDOPEN(TEMP_FILE, "noasync")
+streamed = _SNDOPEN(TEMP_FILE, "stream")
+whole = _MEMSOUND(decoded)
+
+PRINT "Decoded size:"; whole.SIZE = FILE_FRAMES * 2
+
+' A streamed sound is never decoded completely
+part = _MEMSOUND(streamed)
+PRINT "Whole stream refused:"; part.SIZE = 0
+
+' Walk through the stream
+matches = _TRUE
+FOR start = 0 TO FILE_FRAMES - 1 STEP WINDOW_FRAMES
+    part = _MEMSOUND(streamed, , start, WINDOW_FRAMES)
+    IF NOT SameData(part, whole, start) THEN matches = 0
+    total = total + part.SIZE \ part.ELEMENTSIZE
+NEXT
+PRINT "Windows match:"; matches
+PRINT "Frames walked:"; total
+
+' Jump around
+part = _MEMSOUND(streamed, , 55555, 1000)
+PRINT "Seek forward matches:"; SameData(part, whole, 55555) AND part.SIZE = 2000
+part = _MEMSOUND(streamed, , 1234, 1000)
+PRINT "Seek back matches:"; SameData(part, whole, 1234) AND part.SIZE = 2000
+part = _MEMSOUND(streamed, , 1734, 1000)
+PRINT "Overlap matches:"; SameData(part, whole, 1734) AND part.SIZE = 2000
+
+' Ranges are clipped at the end of the sound
+part = _MEMSOUND(streamed, , FILE_FRAMES - 1000, 5000)
+PRINT "Last range frames:"; part.SIZE \ part.ELEMENTSIZE
+part = _MEMSOUND(streamed, , FILE_FRAMES, 10)
+PRINT "Past the end:"; part.SIZE
+
+' A huge frame count is limited to the length of the sound
+part = _MEMSOUND(streamed, , 0, 1000000000000)
+PRINT "Huge range frames:"; part.SIZE \ part.ELEMENTSIZE
+
+' The window moves with every range, so an earlier range is no longer valid
+earlier = _MEMSOUND(streamed, , 0, 1000)
+part = _MEMSOUND(streamed, , 50000, 1000)
+PRINT "Earlier range invalid:"; _MEMEXISTS(earlier) = 0 AND _MEMEXISTS(part)
+
+' The frame count defaults to one second
+part = _MEMSOUND(streamed, , 0)
+PRINT "Default frames:"; part.SIZE \ part.ELEMENTSIZE
+
+' Changing the directory must not change the file that the stream reads from
+streamedAgain = _SNDOPEN(TEMP_FILE, "stream")
+MKDIR TEMP_DIR
+CHDIR TEMP_DIR
+part = _MEMSOUND(streamedAgain, , 4321, 1000)
+CHDIR ".."
+RMDIR TEMP_DIR
+PRINT "Range after CHDIR matches:"; SameData(part, whole, 4321) AND part.SIZE = 2000
+
+' Ranges of decoded sounds point into the decoded data
+part = _MEMSOUND(decoded, 0, 500, 100)
+PRINT "Decoded range:"; part.OFFSET = whole.OFFSET + 1000 AND part.SIZE = 200
+
+_SNDCLOSE decoded
+_SNDCLOSE streamed
+_SNDCLOSE streamedAgain
+
+KILL TEMP_FILE
+
+SYSTEM
+
+' Compares a sound range with the decoded data starting at a sample frame
+FUNCTION SameData%% (part AS _MEM, whole AS _MEM, startFrame AS _INTEGER64)
+    DIM AS _OFFSET o
+
+    IF part.SIZE = 0 THEN EXIT FUNCTION
+
+    FOR o = 0 TO part.SIZE - 2 STEP 2
+        IF _MEMGET(part, part.OFFSET + o, INTEGER) <> _MEMGET(whole, whole.OFFSET + startFrame * 2 + o, INTEGER) THEN EXIT FUNCTION
+    NEXT
+
+    SameData = _TRUE
+END FUNCTION
+
+'$INCLUDE:'../utilities/audio.bm'
@@ -0,0 +1,80 @@
+$CONSOLE:ONLY
+OPTION _EXPLICIT
+
+' Opening the same sound file more than once must share the decoded sound data
+
+CHDIR _STARTDIR$
+
+CONST TEMP_FILE = "sndopen_share_test_temp.wav"
+CONST TEMP_DIR = "sndopen_share_test_temp"
+
+DIM AS LONG h1, h2, h3, h4, h5, h6, h7, h8
+DIM AS _MEM m1, m2, m3, m4, m5, m6, m7, m8
+
+WriteWave TEMP_FILE, 22050, 1000, 10000
+
+h1 = _SNDOPEN(TEMP_FILE, "noasync")
+h2 = _SNDOPEN(TEMP_FILE, "noasync")
+m1 = _MEMSOUND(h1)
+m2 = _MEMSOUND(h2)
+
+PRINT "Handles:"; h1 > 0 AND h2 > 0 AND h1 <> h2
+PRINT "Size:"; m1.SIZE > 0
+PRINT "Shared:"; m1.OFFSET = m2.OFFSET
+
+' The data stays alive while any handle uses it
+_SNDCLOSE h1
+h3 = _SNDOPEN(TEMP_FILE, "noasync")
+m3 = _MEMSOUND(h3)
+PRINT "Shared after close:"; m3.OFFSET = m2.OFFSET
+
+' A changed file must be loaded again
+WriteWave TEMP_FILE, 22050, 2000, 10000
+h4 = _SNDOPEN(TEMP_FILE, "noasync")
+m4 = _MEMSOUND(h4)
+PRINT "Changed file is larger:"; m4.SIZE > m1.SIZE
+PRINT "Changed file not shared:"; m4.OFFSET <> m2.OFFSET
+
+' Loading the same contents from memory shares the data too
+h5 = _SNDOPEN(_READFILE$(TEMP_FILE), "memory, noasync")
+m5 = _MEMSOUND(h5)
+PRINT "Memory load shared:"; m5.OFFSET = m4.OFFSET
+
+' A file rewritten right away with the same size must be loaded again too
+WriteWave TEMP_FILE, 22050, 2000, 5000
+h6 = _SNDOPEN(TEMP_FILE, "noasync")
+m6 = _MEMSOUND(h6)
+PRINT "Same size rewrite loaded:"; m6.SIZE = m4.SIZE AND SampleAt(m6, 100) <> SampleAt(m4, 100)
+
+' The same relative name in another directory is a different file
+MKDIR TEMP_DIR
+WriteWave TEMP_DIR + "/" + TEMP_FILE, 22050, 2000, 2500
+CHDIR TEMP_DIR
+h7 = _SNDOPEN(TEMP_FILE, "noasync")
+CHDIR ".."
+h8 = _SNDOPEN(TEMP_FILE, "noasync")
+m7 = _MEMSOUND(h7)
+m8 = _MEMSOUND(h8)
+PRINT "Other directory loaded:"; SampleAt(m7, 100) <> SampleAt(m6, 100)
+PRINT "Same directory shared:"; m8.OFFSET = m6.OFFSET
+
+_SNDCLOSE h2
+_SNDCLOSE h3
+_SNDCLOSE h4
+_SNDCLOSE h5
+_SNDCLOSE h6
+_SNDCLOSE h7
+_SNDCLOSE h8
+
+KILL TEMP_FILE
+KILL TEMP_DIR + "/" + TEMP_FILE
+RMDIR TEMP_DIR
+
+SYSTEM
+
+' Returns the raw bytes of a decoded sample frame (the format does not matter for comparisons)
+FUNCTION SampleAt& (m AS _MEM, frame AS LONG)
+    SampleAt = _MEMGET(m, m.OFFSET + frame * m.ELEMENTSIZE, LONG)
+END FUNCTION
+
+'$INCLUDE:'../utilities/audio.bm'
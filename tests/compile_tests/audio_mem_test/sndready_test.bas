@@ -0,0 +1,70 @@
+$CONSOLE:ONLY
+OPTION _EXPLICIT
+
+' Sounds opened with "nowait" are loaded in the background and polled with _SNDREADY
+
+CHDIR _STARTDIR$
+
+CONST TEMP_FILE = "sndready_test_temp.wav"
+CONST TEMP_DIR = "sndready_test_temp"
+
+DIM AS LONG h1, h2, h3, h4
+DIM AS _MEM m1, m2
+
+WriteWave TEMP_FILE, 22050, 20000, 10000
+
+h1 = _SNDOPEN(TEMP_FILE, "nowait")
+h2 = _SNDOPEN("missing_sound_file.wav", "nowait")
+h3 = _SNDOPEN(_READFILE$(TEMP_FILE), "memory, nowait")
+
+PRINT "Handles:"; h1 > 0 AND h2 > 0 AND h3 > 0
+PRINT "Ready:"; WaitReady(h1)
+PRINT "Missing file failed:"; WaitReady(h2) = 1
+PRINT "Memory ready:"; WaitReady(h3)
+
+m1 = _MEMSOUND(h1)
+m2 = _MEMSOUND(h3)
+PRINT "Sound data:"; m1.SIZE > 0 AND m1.SIZE = m2.SIZE
+
+' Sounds opened the usual way are ready once they are decoded
+h4 = _SNDOPEN(TEMP_FILE, "noasync")
+PRINT "Waited sound ready:"; _SNDREADY(h4)
+PRINT "Invalid handle:"; _SNDREADY(0)
+
+_SNDCLOSE h1
+_SNDCLOSE h2
+_SNDCLOSE h3
+_SNDCLOSE h4
+
+' Changing the directory right away must not change the file that is loaded
+MKDIR TEMP_DIR
+h1 = _SNDOPEN(TEMP_FILE, "nowait")
+CHDIR TEMP_DIR
+PRINT "Ready after CHDIR:"; WaitReady(h1)
+CHDIR ".."
+RMDIR TEMP_DIR
+_SNDCLOSE h1
+
+' Closing a sound that is still loading must be safe
+h1 = _SNDOPEN(TEMP_FILE, "nowait")
+_SNDCLOSE h1
+
+KILL TEMP_FILE
+
+SYSTEM
+
+' Polls _SNDREADY until the sound has either loaded or failed to load
+FUNCTION WaitReady& (handle AS LONG)
+    DIM startTime AS DOUBLE: startTime = TIMER(0.001)
+    DIM state AS LONG
+
+    DO
+        state = _SNDREADY(handle)
+        IF state <> 0 OR TIMER(0.001) - startTime > 10 THEN EXIT DO
+        _LIMIT 100
+    LOOP
+
+    WaitReady = state
+END FUNCTION
+
+'$INCLUDE:'../utilities/audio.bm'
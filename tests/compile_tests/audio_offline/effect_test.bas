@@ -0,0 +1,86 @@
+$CONSOLE:ONLY
+OPTION _EXPLICIT
+CHDIR _STARTDIR$
+
+RunOffline 48000
+
+CONST TONE_FRAMES = 4800
+CONST EFFECT_LOWPASS = 1
+CONST EFFECT_ECHO = 5
+CONST EFFECT_REVERB = 6
+CONST EFFECT_COMPRESSOR = 7
+
+DIM AS LONG tone, rendered, i, errorCode
+DIM m AS _MEM
+
+' A 0.1 second 6 kHz tone
+tone = _SNDNEW(TONE_FRAMES, 1, 32)
+m = _MEMSOUND(tone)
+FOR i = 0 TO TONE_FRAMES - 1
+    _MEMPUT m, m.OFFSET + i * 4, 0.5! * SIN(i * 6000 * 2 * _PI / 48000) AS SINGLE
+NEXT
+_MEMFREE m
+
+' Low-pass filter on the sound handle
+_SNDLOOP tone
+rendered = _SNDRENDER(TONE_FRAMES)
+PRINT "Unfiltered:"; Peak(rendered, 1000, 2000) > 0.45
+_SNDCLOSE rendered
+
+_SNDEFFECT tone, 1, EFFECT_LOWPASS, 500
+rendered = _SNDRENDER(TONE_FRAMES)
+PRINT "Low-pass:"; Peak(rendered, 1000, 2000) < 0.01
+_SNDCLOSE rendered
+
+' Sweeping the cutoff changes the filter in place
+_SNDEFFECT tone, 1, EFFECT_LOWPASS, 20000
+rendered = _SNDRENDER(TONE_FRAMES)
+PRINT "Low-pass swept open:"; Peak(rendered, 1000, 2000) > 0.3
+_SNDCLOSE rendered
+
+_SNDEFFECT tone, 1, 0
+_SNDSTOP tone
+
+' Echo: the tone comes back after 0.25 seconds at half the level
+_SNDEFFECT tone, 2, EFFECT_ECHO, 0.25, 0, 0.5
+_SNDSETPOS tone, 0
+_SNDPLAY tone
+rendered = _SNDRENDER(TONE_FRAMES * 4)
+PRINT "Echo gap:"; Peak(rendered, TONE_FRAMES + 100, 6000) < 0.001
+PRINT "Echo level:"; ABS(Peak(rendered, 12100, 4000) - 0.25) < 0.02
+_SNDCLOSE rendered
+_SNDEFFECT tone, 2, 0
+
+' Compressor on the master chain (handle 0)
+_SNDEFFECT 0, 1, EFFECT_COMPRESSOR, -20, 10
+_SNDLOOP tone
+rendered = _SNDRENDER(TONE_FRAMES)
+PRINT "Compressed:"; Peak(rendered, 2400, 2400) > 0.05 AND Peak(rendered, 2400, 2400) < 0.15
+_SNDCLOSE rendered
+_SNDSTOP tone
+_SNDEFFECT 0, 1, 0
+
+' Reverb on the master chain leaves a tail after the tone ends
+_SNDEFFECT 0, 8, EFFECT_REVERB, 0.8, 0.2, 0.5
+_SNDSETPOS tone, 0
+_SNDPLAY tone
+rendered = _SNDRENDER(TONE_FRAMES * 4)
+PRINT "Reverb tail:"; Peak(rendered, TONE_FRAMES * 2, TONE_FRAMES) > 0.001 AND Peak(rendered, TONE_FRAMES * 2, TONE_FRAMES) < 0.25
+_SNDCLOSE rendered
+_SNDEFFECT 0, 8, 0
+
+' Slots go from 1 to 8
+ON ERROR GOTO ErrorHandler
+_SNDEFFECT tone, 9, EFFECT_LOWPASS
+PRINT "Invalid slot error:"; errorCode
+ON ERROR GOTO 0
+
+_SNDCLOSE tone
+
+SYSTEM
+
+ErrorHandler:
+errorCode = ERR
+RESUME NEXT
+
+'$INCLUDE:'../utilities/audio.bm'
@@ -0,0 +1,66 @@
+$CONSOLE:ONLY
+OPTION _EXPLICIT
+CHDIR _STARTDIR$
+
+RunOffline 48000
+
+CONST VOICES = 4
+CONST SECONDS_PER_VOICE = 20
+
+DIM AS LONG naive, bandLimited, i
+DIM AS STRING melody, voice(1 TO VOICES)
+DIM AS DOUBLE startTime, elapsed
+DIM AS SINGLE naivePeak, bandLimitedPeak
+
+' The band-limited square wave (@11) has the same shape as the square wave (@1) but less aliasing
+PLAY "MB T60 L1 O7 V100 @1 B"
+naive = _SNDRENDER(_SNDRATE)
+PLAY "MB T60 L1 O7 V100 @11 B"
+bandLimited = _SNDRENDER(_SNDRATE)
+
+naivePeak = Peak(naive, 0, _SNDRATE)
+bandLimitedPeak = Peak(bandLimited, 0, _SNDRATE)
+
+PRINT "Band-limited square level:"; bandLimitedPeak > naivePeak * 0.8 AND bandLimitedPeak < naivePeak * 1.2
+PRINT "Band-limited square differs:"; Difference(naive, bandLimited) > 0
+
+_SNDCLOSE naive
+_SNDCLOSE bandLimited
+
+' Synthesis benchmark: every voice plays SECONDS_PER_VOICE seconds of half second notes with a different waveform
+FOR i = 1 TO SECONDS_PER_VOICE
+    melody = melody + "CG"
+NEXT
+
+voice(1) = "MB T120 L4 O4 @1 " + melody
+voice(2) = "MB T120 L4 O3 @11 " + melody
+voice(3) = "MB T120 L4 O5 @12 " + melody
+voice(4) = "MB T120 L4 O4 @4 " + melody
+
+startTime = TIMER(0.001)
+PLAY voice(1), voice(2), voice(3), voice(4)
+elapsed = TIMER(0.001) - startTime
+
+IF elapsed > 0 THEN
+    _LogInfo "PSG synthesis:" + STR$(INT(VOICES * SECONDS_PER_VOICE / elapsed)) + " voices per core @ 48 kHz"
+END IF
+
+PRINT "Voices rendered:"; PLAY(0) > 0 AND PLAY(3) > 0
+
+SYSTEM
+
+' Returns the sum of the absolute sample differences of two rendered sounds of the same length
+FUNCTION Difference# (handle1 AS LONG, handle2 AS LONG)
+    DIM AS _MEM m1, m2: m1 = _MEMSOUND(handle1): m2 = _MEMSOUND(handle2)
+    DIM AS _OFFSET o
+    DIM d AS DOUBLE
+
+    FOR o = 0 TO m1.SIZE - 4 STEP 4
+        d = d + ABS(_MEMGET(m1, m1.OFFSET + o, SINGLE) - _MEMGET(m2, m2.OFFSET + o, SINGLE))
+    NEXT
+
+    _MEMFREE m1: _MEMFREE m2
+    Difference = d
+END FUNCTION
+
+'$INCLUDE:'../utilities/audio.bm'
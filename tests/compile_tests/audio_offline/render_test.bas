@@ -0,0 +1,45 @@
+$CONSOLE:ONLY
+OPTION _EXPLICIT
+CHDIR _STARTDIR$
+
+RunOffline 48000
+
+CONST TONE_FRAMES = 4800
+
+DIM AS LONG tone, rendered, i
+DIM m AS _MEM
+DIM startTime AS DOUBLE
+
+PRINT "Sample rate:"; _SNDRATE
+
+' A short tone made with _SNDNEW
+tone = _SNDNEW(TONE_FRAMES, 1, 32)
+m = _MEMSOUND(tone)
+FOR i = 0 TO TONE_FRAMES - 1
+    _MEMPUT m, m.OFFSET + i * 4, 0.5! * SIN(i / 10) AS SINGLE
+NEXT
+_MEMFREE m
+
+' Nothing is mixed until the program renders it
+_SNDPLAY tone
+rendered = _SNDRENDER(TONE_FRAMES)
+PRINT "Tone rendered:"; Peak(rendered, 0, TONE_FRAMES) > 0.1
+_SNDCLOSE rendered
+
+rendered = _SNDRENDER(TONE_FRAMES)
+PRINT "Silence after tone:"; Peak(rendered, 0, TONE_FRAMES) = 0
+_SNDCLOSE rendered
+
+' PLAY does not wait for playback in offline mode, and renders much faster than real time
+startTime = TIMER(0.001)
+PLAY "T240 L8 CDEFGAB>C<BAGFEDC"
+rendered = _SNDRENDER(_SNDRATE * 5)
+PRINT "PLAY rendered:"; Peak(rendered, 0, _SNDRATE * 4) > 0.1
+PRINT "Faster than real time:"; TIMER(0.001) - startTime < 4
+_SNDCLOSE rendered
+
+_SNDCLOSE tone
+
+SYSTEM
+
+'$INCLUDE:'../utilities/audio.bm'
@@ -0,0 +1,97 @@
+$CONSOLE:ONLY
+OPTION _EXPLICIT
+CHDIR _STARTDIR$
+
+RunOffline 48000
+
+CONST STAT_CALLBACKS = 0
+CONST STAT_HISTOGRAM = 1
+CONST STAT_LONGEST = 2
+CONST STAT_LATE = 3
+CONST STAT_UNDERRUNS = 4
+CONST STAT_OVERRUNS = 5
+CONST STAT_VOICES = 6
+CONST STAT_DECODE_TIME = 7
+CONST HISTOGRAM_BUCKETS = 12
+CONST TONE_FRAMES = 4800
+CONST RAW_FRAMES = 20000 ' more than the default raw stream ring buffer holds
+
+DIM AS LONG tone, rendered, rawHandle, loaded, i, errorCode
+DIM AS _INTEGER64 callbacks, total
+DIM m AS _MEM
+DIM buffer AS STRING
+DIM AS DOUBLE startTime, renderTime
+
+' Every 1024 frame chunk rendered is one mixing callback
+callbacks = _SNDSTAT(STAT_CALLBACKS)
+startTime = TIMER(0.001)
+rendered = _SNDRENDER(10240)
+renderTime = TIMER(0.001) - startTime
+PRINT "Callbacks counted:"; _SNDSTAT(STAT_CALLBACKS) - callbacks
+_SNDCLOSE rendered
+
+FOR i = 0 TO HISTOGRAM_BUCKETS - 1
+    total = total + _SNDSTAT(STAT_HISTOGRAM, i)
+NEXT
+PRINT "Histogram adds up:"; total = _SNDSTAT(STAT_CALLBACKS)
+' No callback can take longer than the whole render (the longest callback is in microseconds and TIMER has millisecond resolution)
+PRINT "Longest callback within render:"; _SNDSTAT(STAT_LONGEST) <= (renderTime + 0.002) * 1000000
+PRINT "Late callbacks valid:"; _SNDSTAT(STAT_LATE) >= 0 AND _SNDSTAT(STAT_LATE) <= _SNDSTAT(STAT_CALLBACKS)
+
+' Active voices
+tone = _SNDNEW(TONE_FRAMES, 1, 32)
+m = _MEMSOUND(tone)
+FOR i = 0 TO TONE_FRAMES - 1
+    _MEMPUT m, m.OFFSET + i * 4, 0.5! * SIN(i * 1000 * 2 * _PI / 48000) AS SINGLE
+NEXT
+_MEMFREE m
+
+PRINT "Voices before playing:"; _SNDSTAT(STAT_VOICES)
+_SNDLOOP tone
+PRINT "Voices while playing:"; _SNDSTAT(STAT_VOICES)
+_SNDSTOP tone
+PRINT "Voices after stopping:"; _SNDSTAT(STAT_VOICES)
+
+' Pushing more than the ring buffer holds is one overrun, and running dry after playing is one underrun
+rawHandle = _SNDOPENRAW
+FOR i = 1 TO RAW_FRAMES
+    _SNDRAW 0.1, 0.1, rawHandle
+NEXT
+PRINT "Raw stream voices:"; _SNDSTAT(STAT_VOICES)
+PRINT "Overruns:"; _SNDSTAT(STAT_OVERRUNS)
+PRINT "Underruns before playing:"; _SNDSTAT(STAT_UNDERRUNS)
+rendered = _SNDRENDER(RAW_FRAMES + 4800)
+_SNDCLOSE rendered
+PRINT "Underruns after playing:"; _SNDSTAT(STAT_UNDERRUNS)
+PRINT "Raw stream voices after playing:"; _SNDSTAT(STAT_VOICES)
+
+' Counts of closed raw streams are kept
+_SNDCLOSE rawHandle
+PRINT "Kept after closing:"; _SNDSTAT(STAT_OVERRUNS) = 1 AND _SNDSTAT(STAT_UNDERRUNS) = 1
+
+' Decoding time of a sound loaded from memory
+buffer = MakeWave(44100, 100000, 10000)
+loaded = _SNDOPEN(buffer, "memory, noasync")
+PRINT "Decode time measured:"; _SNDSTAT(STAT_DECODE_TIME, loaded) > 0
+_SNDCLOSE loaded
+
+ON ERROR GOTO ErrorHandler
+total = _SNDSTAT(STAT_DECODE_TIME, loaded)
+PRINT "Closed handle error:"; errorCode
+errorCode = 0
+total = _SNDSTAT(STAT_HISTOGRAM, HISTOGRAM_BUCKETS)
+PRINT "Invalid bucket error:"; errorCode
+errorCode = 0
+total = _SNDSTAT(99)
+PRINT "Invalid statistic error:"; errorCode
+ON ERROR GOTO 0
+
+_SNDCLOSE tone
+
+SYSTEM
+
+ErrorHandler:
+errorCode = ERR
+RESUME NEXT
+
+'$INCLUDE:'../utilities/audio.bm'
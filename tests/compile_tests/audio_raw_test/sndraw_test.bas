@@ -0,0 +1,56 @@
+$CONSOLE:ONLY
+OPTION _EXPLICIT
+
+' Queues much more audio than the raw stream ring buffer holds and checks that all of it is accounted for and played
+
+CONST QUEUE_SECONDS = 2
+
+DIM AS LONG rate, frames, i, handle
+DIM t AS DOUBLE, queued AS DOUBLE
+
+rate = _SNDRATE
+frames = rate * QUEUE_SECONDS
+
+REDIM mono(0 TO frames - 1) AS SINGLE
+FOR i = 0 TO frames - 1
+    mono(i) = SIN(i * 440 * 6.283185 / rate) * 0.1
+NEXT
+
+' Default raw stream: one batch and then single frames
+_SNDRAWBATCH mono()
+FOR i = 0 TO rate \ 2 - 1
+    _SNDRAW mono(i), mono(i)
+NEXT
+
+queued = _SNDRAWLEN
+PRINT "Queued (default stream): "; queued > QUEUE_SECONDS AND queued <= QUEUE_SECONDS + 0.5
+
+' A user raw stream with stereo frames
+handle = _SNDOPENRAW
+PRINT "Raw handle: "; handle > 0
+
+REDIM stereo(0 TO frames * 2 - 1) AS SINGLE
+FOR i = 0 TO frames - 1
+    stereo(i * 2) = mono(i)
+    stereo(i * 2 + 1) = -mono(i)
+NEXT
+
+_SNDRAWBATCH stereo(), 2, handle, rate \ 2
+queued = _SNDRAWLEN(handle)
+PRINT "Queued (frame count): "; queued > 0.45 AND queued <= 0.5
+
+_SNDRAWBATCH stereo(), 2, handle
+queued = _SNDRAWLEN(handle)
+PRINT "Queued (user stream): "; queued > QUEUE_SECONDS AND queued <= QUEUE_SECONDS + 0.5
+
+' Everything must drain, including what did not fit in the ring buffer
+t = TIMER(0.001)
+DO WHILE (_SNDRAWLEN > 0 OR _SNDRAWLEN(handle) > 0) AND TIMER(0.001) - t < 30
+    _LIMIT 60
+LOOP
+
+PRINT "Drained: "; _SNDRAWLEN = 0 AND _SNDRAWLEN(handle) = 0
+
+_SNDCLOSE handle
+
+SYSTEM
@@ -0,0 +1,63 @@
+OPTION _EXPLICIT
+$CONSOLE:ONLY
+CHDIR _STARTDIR$
+
+CONST FONT_FILE = "LiberationSerif-Regular.ttf"
+CONST OTHER_FONT_FILE = "LiberationSans-Regular.ttf"
+CONST TEMP_DIR = "shared_data_test_temp"
+CONST SAMPLE_TEXT = "Sphinx of black quartz, judge my vow"
+CONST SIZES = 8
+
+DIM AS LONG fileFonts(1 TO SIZES), memoryFonts(1 TO SIZES), widths(1 TO SIZES), i
+DIM fontData AS STRING
+DIM startTime AS DOUBLE
+
+' Load the same font at many sizes. Only the first load should read the file
+startTime = TIMER(0.001)
+FOR i = 1 TO SIZES
+    fileFonts(i) = _LOADFONT(FONT_FILE, i * 8)
+    widths(i) = _UPRINTWIDTH(SAMPLE_TEXT, , fileFonts(i))
+    PRINT "Size"; i * 8; ": valid ="; fileFonts(i) > 0; ", height ="; _UFONTHEIGHT(fileFonts(i)); ", width ="; widths(i)
+NEXT
+_LogInfo "Loaded" + STR$(SIZES) + " sizes in" + STR$(TIMER(0.001) - startTime) + " seconds"
+
+' Loading the same data from memory shares the data with the fonts loaded from the file
+fontData = _READFILE$(FONT_FILE)
+FOR i = 1 TO SIZES
+    memoryFonts(i) = _LOADFONT(fontData, i * 8, "memory")
+    IF _UPRINTWIDTH(SAMPLE_TEXT, , memoryFonts(i)) <> widths(i) THEN PRINT "Memory font size"; i * 8; "does not match"
+NEXT
+fontData = ""
+
+' Free the file fonts. The memory fonts must keep working
+FOR i = 1 TO SIZES
+    _FREEFONT fileFonts(i)
+NEXT
+
+FOR i = 1 TO SIZES
+    IF _UPRINTWIDTH(SAMPLE_TEXT, , memoryFonts(i)) <> widths(i) THEN PRINT "Memory font size"; i * 8; "does not match after freeing file fonts"
+    _FREEFONT memoryFonts(i)
+NEXT
+
+' Everything was freed. Loading again must read the file again
+fileFonts(1) = _LOADFONT(FONT_FILE, 8)
+PRINT "Reloaded: width match ="; _UPRINTWIDTH(SAMPLE_TEXT, , fileFonts(1)) = widths(1)
+_FREEFONT fileFonts(1)
+
+' The same relative name in another directory is a different font, even while the first one is loaded
+fileFonts(1) = _LOADFONT(FONT_FILE, 32)
+MKDIR TEMP_DIR
+_WRITEFILE TEMP_DIR + "/" + FONT_FILE, _READFILE$(OTHER_FONT_FILE)
+CHDIR TEMP_DIR
+fileFonts(2) = _LOADFONT(FONT_FILE, 32)
+CHDIR ".."
+PRINT "Other directory: different font ="; _UPRINTWIDTH(SAMPLE_TEXT, , fileFonts(2)) <> _UPRINTWIDTH(SAMPLE_TEXT, , fileFonts(1))
+_FREEFONT fileFonts(1)
+_FREEFONT fileFonts(2)
+KILL TEMP_DIR + "/" + FONT_FILE
+RMDIR TEMP_DIR
+
+' A missing file still fails
+PRINT "Missing file:"; _LOADFONT("missing_font_file.ttf", 16)
+
+SYSTEM
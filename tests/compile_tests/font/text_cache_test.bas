@@ -0,0 +1,100 @@
+OPTION _EXPLICIT
+$CONSOLE:ONLY
+CHDIR _STARTDIR$
+
+CONST FONT_FILE = "LiberationSans-Regular.ttf"
+CONST SAMPLE_TEXT = "The quick brown fox jumps over the lazy dog. AVAWAT 0123456789"
+CONST REDRAW_COUNT = 500
+
+' Cyrillic (beyond the first glyph table page) and an emoji (beyond the BMP) in UTF-8
+DIM SHARED unicodeText AS STRING
+unicodeText = "Latin " + CHR$(&HD0) + CHR$(&H96) + CHR$(&HD0) + CHR$(&HAF) + " " + CHR$(&HF0) + CHR$(&H9F) + CHR$(&H98) + CHR$(&H80)
+
+DIM AS LONG fontHandle, img32, img8, ref32, ref8, refClip, redraw, i
+DIM startTime AS DOUBLE
+
+fontHandle = _LOADFONT(FONT_FILE, 18)
+img32 = _NEWIMAGE(640, 120, 32)
+img8 = _NEWIMAGE(640, 120, 256)
+
+' First draws (nothing is cached yet) are the reference
+ref32 = DrawText(img32, fontHandle, 0)
+ref8 = DrawText(img8, fontHandle, 0)
+refClip = DrawText(img32, fontHandle, 200)
+
+' Redraw the same text many times, switching between anti-aliased, monochrome and clipped rendering
+startTime = TIMER(0.001)
+FOR i = 1 TO REDRAW_COUNT
+    _FREEIMAGE DrawText(img32, fontHandle, 0)
+NEXT
+_LogInfo "Cached redraw time:" + STR$(TIMER(0.001) - startTime) + " seconds"
+
+redraw = DrawText(img32, fontHandle, 0)
+PRINT "32bpp redraw matches: "; CompareImages(ref32, redraw)
+_FREEIMAGE redraw
+
+redraw = DrawText(img8, fontHandle, 0)
+PRINT "8bpp redraw matches: "; CompareImages(ref8, redraw)
+_FREEIMAGE redraw
+
+redraw = DrawText(img32, fontHandle, 200)
+PRINT "Clipped redraw matches: "; CompareImages(refClip, redraw)
+_FREEIMAGE redraw
+
+redraw = DrawText(img32, fontHandle, 0)
+PRINT "32bpp redraw after 8bpp matches: "; CompareImages(ref32, redraw)
+_FREEIMAGE redraw
+
+PRINT "Clipped differs from unclipped: "; NOT CompareImages(ref32, refClip)
+PRINT "Width:"; _PRINTWIDTH(SAMPLE_TEXT, img32); _UPRINTWIDTH(SAMPLE_TEXT, , fontHandle)
+
+_FREEIMAGE ref32
+_FREEIMAGE ref8
+_FREEIMAGE refClip
+_FONT 16, img32
+_FONT 16, img8
+_FREEIMAGE img32
+_FREEIMAGE img8
+_FREEFONT fontHandle
+
+SYSTEM
+
+' Draws the sample text using _PRINTSTRING and _UPRINTSTRING and returns a copy of the result
+FUNCTION DrawText& (img AS LONG, fontHandle AS LONG, maxWidth AS LONG)
+    DIM oldDest AS LONG: oldDest = _DEST
+    _DEST img
+    _FONT fontHandle
+    CLS , 0
+    COLOR _RGB(255, 255, 0), _RGB(0, 0, 128)
+
+    _PRINTSTRING (3, 5), SAMPLE_TEXT
+    _PRINTSTRING (-20, 30), SAMPLE_TEXT
+
+    IF maxWidth > 0 THEN
+        _UPRINTSTRING (3, 60), SAMPLE_TEXT, maxWidth
+    ELSE
+        _UPRINTSTRING (3, 60), SAMPLE_TEXT
+    END IF
+    _UPRINTSTRING (5, 90), SAMPLE_TEXT
+    _UPRINTSTRING (400, 0), unicodeText, , 8
+
+    DrawText = _COPYIMAGE(img)
+    _DEST oldDest
+END FUNCTION
+
+FUNCTION CompareImages%% (img1 AS LONG, img2 AS LONG)
+    IF _WIDTH(img1) <> _WIDTH(img2) OR _HEIGHT(img1) <> _HEIGHT(img2) OR _PIXELSIZE(img1) <> _PIXELSIZE(img2) THEN EXIT FUNCTION
+
+    DIM AS _MEM m1, m2: m1 = _MEMIMAGE(img1): m2 = _MEMIMAGE(img2)
+    DIM AS _OFFSET o
+
+    CompareImages = _TRUE
+    FOR o = 0 TO m1.SIZE - 1
+        IF _MEMGET(m1, m1.OFFSET + o, _UNSIGNED _BYTE) <> _MEMGET(m2, m2.OFFSET + o, _UNSIGNED _BYTE) THEN
+            CompareImages = 0
+            EXIT FOR
+        END IF
+    NEXT
+
+    _MEMFREE m1: _MEMFREE m2
+END FUNCTION
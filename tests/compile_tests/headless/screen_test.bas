@@ -0,0 +1,63 @@
+$CONSOLE
+$SCREENHIDE
+OPTION _EXPLICIT
+CHDIR _STARTDIR$
+
+' QB64PE_HEADLESS is read on startup, so the test runs itself again with it set
+IF ENVIRON$("QB64PE_HEADLESS") = "" THEN
+    ENVIRON "QB64PE_HEADLESS=1"
+    SHELL CHR$(34) + COMMAND$(0) + CHR$(34)
+    SYSTEM
+END IF
+
+CONST TEMP_FILE = "headless_screen_test_temp.png"
+CONST SCREEN_COUNT = 200
+
+DIM AS LONG scr, img, i
+DIM startTime AS DOUBLE
+
+_DEST _CONSOLE
+
+' _SCREENSHOW is ignored, a headless program never gets a window
+_SCREENSHOW
+PRINT "Screen hidden: "; _SCREENHIDE
+PRINT "Screen exists: "; _SCREENEXISTS
+
+SCREEN 12
+LINE (10, 10)-(200, 100), 4, BF
+CIRCLE (320, 240), 100, 14
+_PRINTSTRING (20, 300), "Hello headless world"
+_DEST _CONSOLE
+PRINT "SCREEN 12 pixel: "; POINT(20, 20); POINT(0, 0)
+
+' Changing screens does not wait for the display
+startTime = TIMER(0.001)
+FOR i = 1 TO SCREEN_COUNT
+    scr = _NEWIMAGE(320 + i, 200, 32)
+    SCREEN scr
+    SCREEN 0
+    _FREEIMAGE scr
+NEXT
+_LogInfo "Screen changes:" + STR$(TIMER(0.001) - startTime) + " seconds"
+
+scr = _NEWIMAGE(320, 200, 32)
+SCREEN scr
+CLS , _RGB32(0, 0, 128)
+COLOR _RGB32(255, 255, 0), _RGB32(0, 0, 128)
+LINE (50, 50)-(150, 150), _RGB32(255, 0, 0), BF
+_PRINTSTRING (10, 10), "Report"
+
+_SAVEIMAGE TEMP_FILE, scr
+img = _LOADIMAGE(TEMP_FILE, 32)
+KILL TEMP_FILE
+
+_DEST _CONSOLE
+PRINT "Saved size: "; _WIDTH(img); _HEIGHT(img)
+PRINT "Saved pixel: "; HEX$(POINT(100, 100)); " "; HEX$(POINT(300, 190))
+_SOURCE img
+PRINT "Loaded pixel: "; HEX$(POINT(100, 100)); " "; HEX$(POINT(300, 190))
+
+_SOURCE _CONSOLE
+_FREEIMAGE img
+
+SYSTEM
@@ -0,0 +1,85 @@
+$CONSOLE:ONLY
+OPTION _EXPLICIT
+
+CHDIR _STARTDIR$
+
+CONST FILE_COUNT = 6
+
+DIM fileName(1 TO FILE_COUNT) AS STRING, handle(1 TO FILE_COUNT) AS LONG, state(1 TO FILE_COUNT) AS LONG
+DIM AS LONG i, syncImg
+
+FOR i = 1 TO FILE_COUNT
+    READ fileName(i)
+    handle(i) = _LOADIMAGE(fileName(i), 32, "async")
+NEXT
+
+' Poll the first image until it is ready
+DO
+    state(1) = _IMAGEREADY(handle(1))
+    _LIMIT 1000
+LOOP WHILE state(1) = 0
+ReportImage fileName(1), handle(1), state(1)
+
+' Wait for the rest
+FOR i = 2 TO FILE_COUNT
+    state(i) = _IMAGEREADY(handle(i), _TRUE)
+    ReportImage fileName(i), handle(i), state(i)
+NEXT
+
+' Asynchronous images must be identical to synchronously loaded ones
+syncImg = _LOADIMAGE(fileName(1), 32)
+PRINT "Sync and async images match: "; CompareImages(syncImg, handle(1))
+_FREEIMAGE syncImg
+
+FOR i = 1 TO FILE_COUNT
+    IF state(i) = _TRUE THEN _FREEIMAGE handle(i)
+NEXT
+
+' 8bpp from memory
+DIM memImg AS LONG: memImg = _LOADIMAGE(_READFILE$("lena.bmp"), 256, "memory, async, adaptive")
+ReportImage "lena.bmp (memory)", memImg, _IMAGEREADY(memImg, _TRUE)
+_FREEIMAGE memImg
+
+' Freeing an image that is still loading cancels it
+FOR i = 1 TO FILE_COUNT
+    handle(i) = _LOADIMAGE(fileName(i), 32, "async")
+    IF handle(i) < -1 THEN _FREEIMAGE handle(i)
+NEXT
+PRINT "Cancelled loads freed"
+
+' Regular images are always ready
+syncImg = _NEWIMAGE(8, 8, 32)
+PRINT "Regular image ready:"; _IMAGEREADY(syncImg)
+_FREEIMAGE syncImg
+
+SYSTEM
+
+DATA sample_1280_853.pcx,lena.bmp,1.webp,8bpp.ico,good1.svg,bogus1.svg
+
+SUB ReportImage (fileName AS STRING, h AS LONG, state AS LONG)
+    SELECT CASE state
+        CASE _TRUE
+            PRINT fileName; ": ("; _WIDTH(h); "x"; _HEIGHT(h); ") pixels, pixel size"; _PIXELSIZE(h)
+        CASE 1
+            PRINT fileName; " failed to load!"
+        CASE ELSE
+            PRINT fileName; " is still loading!"
+    END SELECT
+END SUB
+
+FUNCTION CompareImages%% (img1 AS LONG, img2 AS LONG)
+    IF _WIDTH(img1) <> _WIDTH(img2) OR _HEIGHT(img1) <> _HEIGHT(img2) THEN EXIT FUNCTION
+
+    DIM AS _MEM m1, m2: m1 = _MEMIMAGE(img1): m2 = _MEMIMAGE(img2)
+    DIM AS _OFFSET o
+
+    FOR o = 0 TO m1.SIZE - 4 STEP 4
+        IF _MEMGET(m1, m1.OFFSET + o, _UNSIGNED LONG) <> _MEMGET(m2, m2.OFFSET + o, _UNSIGNED LONG) THEN
+            _MEMFREE m1: _MEMFREE m2
+            EXIT FUNCTION
+        END IF
+    NEXT
+
+    _MEMFREE m1: _MEMFREE m2
+    CompareImages = _TRUE
+END FUNCTION
@@ -0,0 +1,59 @@
+OPTION _EXPLICIT
+$CONSOLE:ONLY
+CHDIR _STARTDIR$
+
+CONST TEST_IMAGE = "sample_640_426.bmp"
+CONST ERROR_LIMIT = 16 ' maximum average per-channel error (the fixed default palette is coarse)
+
+DIM reference AS LONG: reference = _LOADIMAGE(TEST_IMAGE, 32)
+
+DoConversion reference, "adaptive"
+DoConversion reference, "adaptive, nodither"
+DoConversion reference, "adaptive, ordered"
+DoConversion reference, "nodither"
+
+_FREEIMAGE reference
+
+SYSTEM
+
+SUB DoConversion (reference AS LONG, requirements AS STRING)
+    PRINT "Converting "; TEST_IMAGE; " to 8bpp ("; requirements; ") ... ";
+
+    DIM handle AS LONG: handle = _LOADIMAGE(TEST_IMAGE, 256, requirements)
+
+    IF handle < -1 THEN
+        PRINT "done."
+    ELSE
+        PRINT "failed!"
+        EXIT SUB
+    END IF
+
+    PRINT "Size ("; _WIDTH(handle); "x"; _HEIGHT(handle); "), pixel size"; _PIXELSIZE(handle)
+
+    DIM AS LONG x, y
+    DIM AS _UNSIGNED LONG c1, c2
+    DIM totalError AS DOUBLE
+
+    FOR y = 0 TO _HEIGHT(handle) - 1
+        FOR x = 0 TO _WIDTH(handle) - 1
+            _SOURCE reference
+            c1 = POINT(x, y)
+            _SOURCE handle
+            c2 = _PALETTECOLOR(POINT(x, y), handle)
+
+            totalError = totalError + ABS(_RED32(c1) - _RED32(c2)) + ABS(_GREEN32(c1) - _GREEN32(c2)) + ABS(_BLUE32(c1) - _BLUE32(c2))
+        NEXT
+    NEXT
+
+    _SOURCE _CONSOLE
+
+    IF totalError / (CDBL(_WIDTH(handle)) * _HEIGHT(handle) * 3) <= ERROR_LIMIT THEN
+        PRINT "Average error is within limit."
+    ELSE
+        PRINT "Average error is too high:"; totalError / (CDBL(_WIDTH(handle)) * _HEIGHT(handle) * 3)
+    END IF
+
+    PRINT
+
+    _FREEIMAGE handle
+END SUB
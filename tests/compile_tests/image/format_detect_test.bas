@@ -0,0 +1,60 @@
+$CONSOLE:ONLY
+OPTION _EXPLICIT
+
+CHDIR _STARTDIR$
+
+CONST LOAD_ITERATIONS = 4
+
+DIM fileName AS STRING, fileData AS STRING
+DIM AS LONG i, fileImg, memImg
+DIM startTime AS DOUBLE, totalTime AS DOUBLE
+
+READ fileName
+WHILE LEN(fileName) > 0
+    fileData = _READFILE$(fileName)
+
+    startTime = TIMER(0.001)
+    FOR i = 1 TO LOAD_ITERATIONS
+        fileImg = _LOADIMAGE(fileName, 32)
+        IF fileImg < -1 AND i < LOAD_ITERATIONS THEN _FREEIMAGE fileImg
+    NEXT
+    totalTime = totalTime + (TIMER(0.001) - startTime)
+
+    memImg = _LOADIMAGE(fileData, 32, "memory")
+
+    IF fileImg < -1 AND memImg < -1 THEN
+        PRINT fileName; ": ("; _WIDTH(fileImg); "x"; _HEIGHT(fileImg); ") pixels";
+
+        IF _WIDTH(fileImg) = _WIDTH(memImg) AND _HEIGHT(fileImg) = _HEIGHT(memImg) THEN
+            PRINT ", file and memory match"
+        ELSE
+            PRINT ", file and memory mismatch!"
+        END IF
+    ELSEIF fileImg >= -1 AND memImg >= -1 THEN
+        PRINT fileName; " is not a valid image file!"
+    ELSE
+        PRINT fileName; ": file and memory loaders disagree!"
+    END IF
+
+    IF fileImg < -1 THEN _FREEIMAGE fileImg
+    IF memImg < -1 THEN _FREEIMAGE memImg
+
+    READ fileName
+WEND
+
+_LogInfo "Mixed format load time:" + STR$(totalTime) + " seconds"
+
+SYSTEM
+
+DATA 1.webp
+DATA 16color1.pcx
+DATA 4bpp.cur
+DATA 8bpp.ico
+DATA good1.svg
+DATA bogus1.svg
+DATA lena.bmp
+DATA sample_1280_853.pcx
+DATA sample_640_426.bmp
+DATA foobar.bmp
+DATA format_detect_test.bas
+DATA
@@ -0,0 +1,79 @@
+$CONSOLE:ONLY
+OPTION _EXPLICIT
+
+CHDIR _STARTDIR$
+
+CONST TEMP_FILE = "save_png_test_temp"
+
+DIM AS LONG img, i
+DIM requirements AS STRING, fileName AS STRING
+DIM startTime AS DOUBLE
+DIM AS _INTEGER64 storeSize, bestSize
+
+' Something that compresses a bit but not too much
+img = _NEWIMAGE(640, 480, 32)
+_DEST img
+FOR i = 0 TO 479
+    LINE (0, i)-(639, i), _RGB32(i MOD 256, (i * 3) MOD 256, 255 - i MOD 256)
+NEXT
+FOR i = 1 TO 200
+    CIRCLE ((i * 37) MOD 640, (i * 91) MOD 480), i MOD 50, _RGBA32((i * 13) MOD 256, (i * 7) MOD 256, (i * 5) MOD 256, 128 + i MOD 128)
+NEXT
+_DEST _CONSOLE
+
+READ requirements
+WHILE LEN(requirements) > 0
+    startTime = TIMER(0.001)
+    _SAVEIMAGE TEMP_FILE, img, requirements
+
+    IF requirements = "fast" THEN fileName = TEMP_FILE + ".qoi" ELSE fileName = TEMP_FILE + ".png"
+
+    _LogInfo requirements + ":" + STR$(TIMER(0.001) - startTime) + " seconds," + STR$(FileSize(fileName)) + " bytes"
+
+    PRINT requirements; " -> "; RIGHT$(fileName, 4); ", round trip: "; RoundTrip(img, fileName)
+
+    IF requirements = "store" THEN storeSize = FileSize(fileName)
+    IF requirements = "best" THEN bestSize = FileSize(fileName)
+
+    KILL fileName
+
+    READ requirements
+WEND
+
+PRINT "best is smaller than store: "; bestSize < storeSize
+
+_FREEIMAGE img
+
+SYSTEM
+
+DATA png,store,"fast png",best,"level6 filter0","level9 filter4","parallel png","fast parallel png",fast
+DATA ""
+
+FUNCTION FileSize&& (fileName AS STRING)
+    DIM f AS LONG: f = FREEFILE
+    OPEN fileName FOR BINARY ACCESS READ AS f
+    FileSize = LOF(f)
+    CLOSE f
+END FUNCTION
+
+FUNCTION RoundTrip%% (img AS LONG, fileName AS STRING)
+    DIM loaded AS LONG: loaded = _LOADIMAGE(fileName, 32)
+    IF loaded >= -1 THEN EXIT FUNCTION
+
+    IF _WIDTH(img) = _WIDTH(loaded) AND _HEIGHT(img) = _HEIGHT(loaded) THEN
+        DIM AS _MEM m1, m2: m1 = _MEMIMAGE(img): m2 = _MEMIMAGE(loaded)
+        DIM AS _OFFSET o
+
+        RoundTrip = _TRUE
+        FOR o = 0 TO m1.SIZE - 4 STEP 4
+            IF _MEMGET(m1, m1.OFFSET + o, _UNSIGNED LONG) <> _MEMGET(m2, m2.OFFSET + o, _UNSIGNED LONG) THEN
+                RoundTrip = 0
+                EXIT FOR
+            END IF
+        NEXT
+
+        _MEMFREE m1: _MEMFREE m2
+    END IF
+
+    _FREEIMAGE loaded
+END FUNCTION
@@ -0,0 +1,62 @@
+$CONSOLE:ONLY
+OPTION _EXPLICIT
+
+CHDIR _STARTDIR$
+
+CONST TEST_FILE = "16color1.pcx"
+
+DIM scalerName AS STRING
+DIM AS LONG srcImg, src8Img, loadImg, scaleImg, scale8Img
+DIM startTime AS DOUBLE, totalTime AS DOUBLE
+
+srcImg = _LOADIMAGE(TEST_FILE, 32)
+src8Img = _LOADIMAGE(TEST_FILE, 257) ' keep the image palette so that the colors are exact
+PRINT TEST_FILE; ": ("; _WIDTH(srcImg); "x"; _HEIGHT(srcImg); ")"
+
+READ scalerName
+WHILE LEN(scalerName) > 0
+    startTime = TIMER(0.001)
+    loadImg = _LOADIMAGE(TEST_FILE, 32, scalerName)
+    totalTime = totalTime + (TIMER(0.001) - startTime)
+
+    ' Scaling an already loaded image must give the same result as scaling during load
+    scaleImg = _SCALEIMAGE(srcImg, scalerName)
+    scale8Img = _SCALEIMAGE(src8Img, scalerName)
+
+    PRINT scalerName; ": ("; _WIDTH(loadImg); "x"; _HEIGHT(loadImg); ")";
+    PRINT ", runtime 32bpp match: "; CompareImages(loadImg, scaleImg);
+    PRINT ", runtime 8bpp match: "; CompareImages(loadImg, scale8Img); _PIXELSIZE(scale8Img)
+
+    _FREEIMAGE loadImg
+    _FREEIMAGE scaleImg
+    _FREEIMAGE scale8Img
+
+    READ scalerName
+WEND
+
+_LogInfo "Scaled load time:" + STR$(totalTime) + " seconds"
+
+_FREEIMAGE srcImg
+_FREEIMAGE src8Img
+
+SYSTEM
+
+DATA SXBR2,SXBR3,SXBR4,MMPX2,HQ2XA,HQ2XB,HQ3XA,HQ3XB
+DATA ""
+
+FUNCTION CompareImages%% (img1 AS LONG, img2 AS LONG)
+    IF _WIDTH(img1) <> _WIDTH(img2) OR _HEIGHT(img1) <> _HEIGHT(img2) THEN EXIT FUNCTION
+
+    DIM AS _MEM m1, m2: m1 = _MEMIMAGE(img1): m2 = _MEMIMAGE(img2)
+    DIM AS _OFFSET o
+
+    FOR o = 0 TO m1.SIZE - 4 STEP 4
+        IF _MEMGET(m1, m1.OFFSET + o, _UNSIGNED LONG) <> _MEMGET(m2, m2.OFFSET + o, _UNSIGNED LONG) THEN
+            _MEMFREE m1: _MEMFREE m2
+            EXIT FUNCTION
+        END IF
+    NEXT
+
+    _MEMFREE m1: _MEMFREE m2
+    CompareImages = _TRUE
+END FUNCTION
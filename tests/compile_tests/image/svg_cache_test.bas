@@ -0,0 +1,87 @@
+$CONSOLE:ONLY
+OPTION _EXPLICIT
+
+ON ERROR GOTO ErrorHandler
+
+CHDIR _STARTDIR$
+
+CONST TEST_FILE = "good1.svg"
+CONST LOAD_COUNT = 20
+
+DIM AS LONG img, img2x, memImg, sized, sized2, rasterImg, scaled, i
+DIM startTime AS DOUBLE
+
+' The first load parses the SVG. Later loads of the same file only rasterize it
+startTime = TIMER(0.001)
+img = _LOADIMAGE(TEST_FILE, 32)
+_LogInfo "First load:" + STR$(TIMER(0.001) - startTime) + " seconds"
+
+startTime = TIMER(0.001)
+FOR i = 1 TO LOAD_COUNT
+    _FREEIMAGE _LOADIMAGE(TEST_FILE, 32)
+NEXT
+_LogInfo "Cached loads:" + STR$((TIMER(0.001) - startTime) / LOAD_COUNT) + " seconds per load"
+
+PRINT TEST_FILE; ": ("; _WIDTH(img); "x"; _HEIGHT(img); ")"
+
+' Loading from memory finds the same document
+memImg = _LOADIMAGE(_READFILE$(TEST_FILE), 32, "memory")
+PRINT "Memory load matches: "; CompareImages(img, memImg)
+
+' Rasterizing again with a scaler is the same as loading with the scaler
+img2x = _LOADIMAGE(TEST_FILE, 32, "sxbr2")
+scaled = _SCALEIMAGE(img, "SXBR2")
+PRINT "SXBR2: ("; _WIDTH(scaled); "x"; _HEIGHT(scaled); "), matches load: "; CompareImages(img2x, scaled)
+_FREEIMAGE scaled
+
+' Rasterize at a new size. The aspect ratio is kept if the height is omitted
+sized = _SCALEIMAGE(img, "", 64)
+PRINT "Width 64: ("; _WIDTH(sized); "x"; _HEIGHT(sized); ")"
+
+sized2 = _SCALEIMAGE(img, "", 100, 50)
+PRINT "100 x 50: ("; _WIDTH(sized2); "x"; _HEIGHT(sized2); ")"
+
+' Rasterized images keep the document after the original image is freed
+_FREEIMAGE img
+scaled = _SCALEIMAGE(sized, "", 300)
+img = _SCALEIMAGE(sized2, "", 300)
+PRINT "Rasterized again from a rasterized image: ("; _WIDTH(scaled); "x"; _HEIGHT(scaled); "), matches: "; CompareImages(scaled, img)
+_FREEIMAGE scaled
+
+' Raster images cannot be rasterized at a new size
+rasterImg = _NEWIMAGE(16, 16, 32)
+scaled = _SCALEIMAGE(rasterImg, "", 32)
+PRINT "Raster image at a new size:"; scaled
+scaled = _SCALEIMAGE(rasterImg, "MMPX2")
+PRINT "Raster image with a scaler: ("; _WIDTH(scaled); "x"; _HEIGHT(scaled); ")"
+_FREEIMAGE scaled
+
+_FREEIMAGE rasterImg
+_FREEIMAGE sized2
+_FREEIMAGE sized
+_FREEIMAGE img2x
+_FREEIMAGE memImg
+_FREEIMAGE img
+
+SYSTEM
+
+ErrorHandler:
+PRINT "Error:"; ERR; ", Line:"; _ERRORLINE
+RESUME NEXT
+
+FUNCTION CompareImages%% (img1 AS LONG, img2 AS LONG)
+    IF _WIDTH(img1) <> _WIDTH(img2) OR _HEIGHT(img1) <> _HEIGHT(img2) THEN EXIT FUNCTION
+
+    DIM AS _MEM m1, m2: m1 = _MEMIMAGE(img1): m2 = _MEMIMAGE(img2)
+    DIM AS _OFFSET o
+
+    FOR o = 0 TO m1.SIZE - 4 STEP 4
+        IF _MEMGET(m1, m1.OFFSET + o, _UNSIGNED LONG) <> _MEMGET(m2, m2.OFFSET + o, _UNSIGNED LONG) THEN
+            _MEMFREE m1: _MEMFREE m2
+            EXIT FUNCTION
+        END IF
+    NEXT
+
+    _MEMFREE m1: _MEMFREE m2
+    CompareImages = _TRUE
+END FUNCTION
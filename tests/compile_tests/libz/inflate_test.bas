@@ -0,0 +1,63 @@
+$CONSOLE:ONLY
+OPTION _EXPLICIT
+
+' _INFLATE$ with and without a size hint, on data much larger than the compressed input, and on damaged data
+
+CONST BIG_SIZE = 30000000
+
+DIM AS LONG i, errorCode
+DIM AS STRING big, packed, unpacked, damaged
+
+big = STRING$(BIG_SIZE, "A")
+FOR i = 1 TO BIG_SIZE STEP 1000003
+    MID$(big, i, 11) = "QB64-PE" + STR$(i MOD 1000)
+NEXT
+
+packed = _DEFLATE$(big)
+unpacked = _INFLATE$(packed)
+PRINT "Large round trip:"; LEN(unpacked) = BIG_SIZE AND _STRCMP(unpacked, big) = _EQUAL
+unpacked = ""
+
+unpacked = _INFLATE$(packed, BIG_SIZE)
+PRINT "Exact size hint:"; _STRCMP(unpacked, big) = _EQUAL
+unpacked = ""
+
+unpacked = _INFLATE$(packed, 1000)
+PRINT "Small size hint:"; _STRCMP(unpacked, big) = _EQUAL
+unpacked = ""
+
+unpacked = _INFLATE$(packed, BIG_SIZE * 2&&)
+PRINT "Large size hint:"; LEN(unpacked) = BIG_SIZE
+unpacked = ""
+
+PRINT "Empty input:"; LEN(_INFLATE$("")) = 0
+PRINT "Empty round trip:"; LEN(_INFLATE$(_DEFLATE$(""))) = 0
+
+ON ERROR GOTO ErrorHandler
+
+damaged = packed
+MID$(damaged, LEN(damaged) \ 2, 4) = "XXXX"
+unpacked = _INFLATE$(damaged)
+PRINT "Corrupt data error:"; errorCode; LEN(unpacked)
+errorCode = 0
+
+damaged = LEFT$(packed, LEN(packed) - 10)
+unpacked = _INFLATE$(damaged)
+PRINT "Truncated data error:"; errorCode; LEN(unpacked)
+errorCode = 0
+
+damaged = LEFT$(packed, LEN(packed) - 1) + CHR$(ASC(RIGHT$(packed, 1)) XOR 1)
+unpacked = _INFLATE$(damaged, BIG_SIZE)
+PRINT "Checksum error:"; errorCode; LEN(unpacked)
+errorCode = 0
+
+unpacked = _INFLATE$("Not compressed")
+PRINT "Not compressed error:"; errorCode; LEN(unpacked)
+
+ON ERROR GOTO 0
+
+SYSTEM
+
+ErrorHandler:
+errorCode = ERR
+RESUME NEXT
@@ -0,0 +1,81 @@
+$CONSOLE:ONLY
+OPTION _EXPLICIT
+CHDIR _STARTDIR$
+
+' Rendered MIDI music is cached in the QB64PE_MIDI_CACHE directory and loaded from there the next time
+
+CONST CACHE_DIR = "midi_cache_test_temp"
+
+DIM AS LONG h1, h2, h3
+DIM AS DOUBLE length1, length2
+
+' The test runs itself again to check that cache files still queued at exit are written
+IF ENVIRON$("MIDI_CACHE_TEST_CHILD") <> "" THEN
+    h1 = _SNDOPEN("midi.mid", "noasync")
+    SYSTEM
+END IF
+
+IF NOT _DIREXISTS(CACHE_DIR) THEN MKDIR CACHE_DIR
+DeleteCache
+ENVIRON "QB64PE_MIDI_CACHE=" + CACHE_DIR
+
+h1 = _SNDOPEN("midi.mid", "noasync")
+length1 = _SNDLEN(h1)
+_SNDCLOSE h1
+_DELAY 0.2 ' closed sounds are released in the background, this makes sure that the next load does not share the sound data
+PRINT "Cache files after first load:"; WaitForCache(1)
+
+h2 = _SNDOPEN("midi.mid", "noasync")
+length2 = _SNDLEN(h2)
+_SNDCLOSE h2
+_DELAY 0.2
+PRINT "Cache files after second load:"; WaitForCache(1)
+PRINT "Cached length matches:"; length1 > 0 AND ABS(length1 - length2) < 0.01
+
+' A different sound bank renders differently, so it gets its own cache file
+_MIDISOUNDBANK "./test-soundfont.sf2"
+h3 = _SNDOPEN("midi.mid", "noasync")
+_SNDCLOSE h3
+PRINT "Cache files after sound bank change:"; WaitForCache(2)
+
+' Cache files are written before a program exits
+DeleteCache
+ENVIRON "MIDI_CACHE_TEST_CHILD=1"
+SHELL CHR$(34) + COMMAND$(0) + CHR$(34)
+PRINT "Cache files after exit:"; CountCache
+
+DeleteCache
+RMDIR CACHE_DIR
+
+SYSTEM
+
+FUNCTION CountCache&
+    DIM entry AS STRING
+    DIM count AS LONG
+
+    entry = _FILES$(CACHE_DIR + "/*.qoa")
+    DO WHILE LEN(entry)
+        count = count + 1
+        entry = _FILES$
+    LOOP
+
+    CountCache = count
+END FUNCTION
+
+' Cache files are written in the background, so give the writer some time
+FUNCTION WaitForCache& (expected AS LONG)
+    DIM startTime AS DOUBLE: startTime = TIMER(0.001)
+    DIM count AS LONG
+
+    DO
+        count = CountCache
+        IF count >= expected OR ABS(TIMER(0.001) - startTime) > 10 THEN EXIT DO
+        _DELAY 0.05
+    LOOP
+
+    WaitForCache = count
+END FUNCTION
+
+SUB DeleteCache
+    IF CountCache > 0 THEN KILL CACHE_DIR + "/*.qoa"
+END SUB
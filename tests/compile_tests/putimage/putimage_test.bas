@@ -30,6 +30,8 @@ TestTextToGraphics32Clipping
 TestGraphicsToGraphics32ViewClip
 TestGraphicsToGraphics32WindowNoScale
 TestGraphicsToGraphics32SourceViewClip
+TestGraphics8ToGraphics32Basic
+TestGraphics8ToGraphics32Flipped
 
 TestTextToGraphics8Basic
 TestTextToGraphics8Mirrored
@@ -625,6 +627,74 @@ SUB TestGraphicsToGraphics32SourceViewClip
     _FREEIMAGE src
 END SUB
 
+SUB TestGraphics8ToGraphics32Basic
+    DIM src AS LONG: src = _NEWIMAGE(40, 20, 256)
+    PrepareGraphicsSource8 src
+    DIM dst AS LONG: dst = _NEWIMAGE(100, 50, 32)
+    PrepareGraphicsDestination32 dst
+
+    _PUTIMAGE (10, 5), src, dst
+
+    DIM ok AS _BYTE: ok = GraphicsMatch8To32(src, dst, 10, 5, 1)
+    _SOURCE dst
+    IF POINT(9, 5) <> POINT(0, 0) OR POINT(50, 24) <> POINT(0, 0) THEN ok = _FALSE
+
+    ReportCheck "graphics 8bpp->graphics 32bpp basic", ok
+
+    _FREEIMAGE dst
+    _FREEIMAGE src
+END SUB
+
+SUB TestGraphics8ToGraphics32Flipped
+    DIM src AS LONG: src = _NEWIMAGE(40, 20, 256)
+    PrepareGraphicsSource8 src
+    DIM dst AS LONG: dst = _NEWIMAGE(100, 50, 32)
+    PrepareGraphicsDestination32 dst
+
+    _PUTIMAGE (10, 24)-(49, 5), src, dst
+
+    DIM ok AS _BYTE: ok = GraphicsMatch8To32(src, dst, 10, 24, -1)
+
+    ReportCheck "graphics 8bpp->graphics 32bpp flipped", ok
+
+    _FREEIMAGE dst
+    _FREEIMAGE src
+END SUB
+
+SUB PrepareGraphicsSource8 (img AS LONG)
+    DIM oldDest AS LONG: oldDest = _DEST
+    DIM AS LONG x, y
+
+    _DEST img
+    FOR y = 0 TO _HEIGHT(img) - 1
+        FOR x = 0 TO _WIDTH(img) - 1
+            PSET (x, y), (x * 7 + y * 3) AND 255
+        NEXT
+    NEXT
+
+    _DEST oldDest
+END SUB
+
+' Checks that every pixel of an 8bpp image was copied to a 32bpp image at (dx, dy), with rows going down (ydir = 1) or up (ydir = -1)
+FUNCTION GraphicsMatch8To32%% (src AS LONG, dst AS LONG, dx AS LONG, dy AS LONG, ydir AS LONG)
+    DIM oldSource AS LONG: oldSource = _SOURCE
+    DIM AS LONG x, y
+    DIM c AS _UNSIGNED LONG
+    DIM ok AS _BYTE: ok = _TRUE
+
+    FOR y = 0 TO _HEIGHT(src) - 1
+        FOR x = 0 TO _WIDTH(src) - 1
+            _SOURCE src
+            c = _PALETTECOLOR(POINT(x, y), src)
+            _SOURCE dst
+            IF POINT(dx + x, dy + y * ydir) <> c THEN ok = _FALSE
+        NEXT
+    NEXT
+
+    _SOURCE oldSource
+    GraphicsMatch8To32 = ok
+END FUNCTION
+
 SUB TestTextToGraphics8Basic
     DIM dst AS LONG: dst = _NEWIMAGE(320, 200, 256)
     PrepareGraphicsDestinationIndexed dst
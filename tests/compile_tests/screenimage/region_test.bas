@@ -0,0 +1,89 @@
+$CONSOLE
+$SCREENHIDE
+OPTION _EXPLICIT
+_DEST _CONSOLE
+
+DIM SHARED captureFailed AS _BYTE
+DIM AS LONG full, region, other, clamped
+DIM regionMatches AS _BYTE, repeatMatches AS _BYTE, opaque AS _BYTE, clampedSize AS _BYTE
+
+$IF LINUX THEN
+    ' The Linux build agents run each test on an Xvfb server. Without an X server there is nothing to capture
+    ON ERROR GOTO capture_error
+
+    full = _SCREENIMAGE
+
+    ON ERROR GOTO 0
+$ELSE
+    ' We can't do _SCREENIMAGE on Mac OS build agents, and Windows is covered by test.bas
+    captureFailed = _TRUE
+$END IF
+
+IF captureFailed THEN
+    regionMatches = _TRUE
+    repeatMatches = _TRUE
+    opaque = _TRUE
+    clampedSize = _TRUE
+ELSE
+    ' Captures of different sizes reuse the same shared memory segment
+    region = _SCREENIMAGE(10, 20, 109, 69)
+    other = _SCREENIMAGE(0, 0, 31, 31)
+    _FREEIMAGE other
+
+    regionMatches = _WIDTH(region) = 100 AND _HEIGHT(region) = 50 AND CompareRegion(full, region, 10, 20)
+    opaque = IsOpaque(full) AND IsOpaque(region)
+
+    other = _SCREENIMAGE(10, 20, 109, 69)
+    repeatMatches = CompareRegion(region, other, 0, 0)
+    _FREEIMAGE other
+
+    clamped = _SCREENIMAGE(-5, -5, 9, 9)
+    clampedSize = _WIDTH(clamped) = 10 AND _HEIGHT(clamped) = 10 AND CompareRegion(full, clamped, 0, 0)
+    _FREEIMAGE clamped
+
+    _FREEIMAGE region
+    _FREEIMAGE full
+END IF
+
+PRINT "Region matches full capture: "; regionMatches
+PRINT "Repeated capture matches: "; repeatMatches
+PRINT "Captures are opaque: "; opaque
+PRINT "Clamped region: "; clampedSize
+
+SYSTEM
+
+capture_error:
+captureFailed = _TRUE
+RESUME NEXT
+
+' Checks that img matches the part of src starting at (x, y)
+FUNCTION CompareRegion%% (src AS LONG, img AS LONG, x AS LONG, y AS LONG)
+    DIM AS LONG w, h, i, j
+    DIM AS _MEM m1, m2: m1 = _MEMIMAGE(src): m2 = _MEMIMAGE(img)
+
+    w = _WIDTH(img): h = _HEIGHT(img)
+
+    CompareRegion = _TRUE
+    FOR j = 0 TO h - 1
+        FOR i = 0 TO w - 1
+            IF _MEMGET(m1, m1.OFFSET + ((y + j) * _WIDTH(src) + x + i) * 4, _UNSIGNED LONG) <> _MEMGET(m2, m2.OFFSET + (j * w + i) * 4, _UNSIGNED LONG) THEN
+                CompareRegion = 0
+                EXIT FOR
+            END IF
+        NEXT
+    NEXT
+
+    _MEMFREE m1: _MEMFREE m2
+END FUNCTION
+
+FUNCTION IsOpaque%% (img AS LONG)
+    DIM m AS _MEM: m = _MEMIMAGE(img)
+    DIM o AS _OFFSET
+
+    IsOpaque = _TRUE
+    FOR o = 3 TO m.SIZE - 1 STEP 4
+        IF _MEMGET(m, m.OFFSET + o, _UNSIGNED _BYTE) <> 255 THEN IsOpaque = 0: EXIT FOR
+    NEXT
+
+    _MEMFREE m
+END FUNCTION